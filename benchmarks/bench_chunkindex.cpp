@@ -0,0 +1,147 @@
+// 10M tile lookups over the chunks of a loaded view, the query behind
+// IsTilePassable, HasNoOcuupyingEntity and the mining drills.
+//
+// Compares the previous std::map<ChunkCoord, Chunk> with float floor division
+// against ChunkMap with integer floor division. Random lookups hit a random
+// chunk each time, walk lookups follow a player stepping across tiles.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Core/Chunk.h"
+#include "Core/ChunkMap.h"
+#include "Core/TileData.h"
+#include "SDL.h"
+
+namespace {
+constexpr int kLookups = 10'000'000;
+// Four players with a view distance of 2, spread over the map
+constexpr int kViewChunks = 5;
+constexpr int kPlayers = 4;
+
+struct Query {
+  int tileX;
+  int tileY;
+};
+
+// What World::GetTileAtTileIndex did for every query
+TileRef MapLookup(std::map<ChunkCoord, Chunk>& chunks, int tileX, int tileY) {
+  int chunkX = std::floor(static_cast<float>(tileX) / CHUNK_WIDTH);
+  int chunkY = std::floor(static_cast<float>(tileY) / CHUNK_HEIGHT);
+  auto it = chunks.find({chunkX, chunkY});
+  if (it == chunks.end()) return TileRef();
+  Vec2 local = it->second.GetLocalTileIndex(tileX, tileY);
+  return TileRef(&it->second, Chunk::GetLocalIndex(local.x, local.y));
+}
+
+TileRef HashLookup(ChunkMap& chunks, int tileX, int tileY) {
+  const int chunkX = tileX >= 0 ? tileX / CHUNK_WIDTH
+                                : (tileX - CHUNK_WIDTH + 1) / CHUNK_WIDTH;
+  const int chunkY = tileY >= 0 ? tileY / CHUNK_HEIGHT
+                                : (tileY - CHUNK_HEIGHT + 1) / CHUNK_HEIGHT;
+  Chunk* chunk = chunks.Find(chunkX, chunkY);
+  if (chunk == nullptr) return TileRef();
+  return TileRef(chunk, Chunk::GetLocalIndex(tileX - chunkX * CHUNK_WIDTH,
+                                             tileY - chunkY * CHUNK_HEIGHT));
+}
+
+std::vector<ChunkCoord> LoadedChunks() {
+  const ChunkCoord centers[kPlayers] = {{0, 0}, {40, -12}, {-25, 30}, {7, 7}};
+  std::vector<ChunkCoord> loaded;
+  for (const ChunkCoord& center : centers) {
+    for (int y = -kViewChunks / 2; y <= kViewChunks / 2; ++y) {
+      for (int x = -kViewChunks / 2; x <= kViewChunks / 2; ++x)
+        loaded.push_back({center.x + x, center.y + y});
+    }
+  }
+  return loaded;
+}
+
+std::vector<Query> RandomQueries(const std::vector<ChunkCoord>& loaded,
+                                 std::mt19937& rng) {
+  std::uniform_int_distribution<std::size_t> pick(0, loaded.size() - 1);
+  std::uniform_int_distribution<int> local(0, CHUNK_WIDTH - 1);
+  std::vector<Query> queries(kLookups);
+  for (Query& query : queries) {
+    const ChunkCoord chunk = loaded[pick(rng)];
+    query = {chunk.x * CHUNK_WIDTH + local(rng),
+             chunk.y * CHUNK_HEIGHT + local(rng)};
+  }
+  return queries;
+}
+
+std::vector<Query> WalkQueries(std::mt19937& rng) {
+  std::uniform_int_distribution<int> step(-1, 1);
+  std::vector<Query> queries(kLookups);
+  int x = 0, y = 0;
+  for (Query& query : queries) {
+    x = std::max(-16, std::min(16, x + step(rng)));
+    y = std::max(-16, std::min(16, y + step(rng)));
+    query = {x, y};
+  }
+  return queries;
+}
+
+template <typename Lookup>
+double Run(const std::vector<Query>& queries, Lookup lookup,
+           uint64_t& checksum) {
+  const auto start = std::chrono::steady_clock::now();
+  for (const Query& query : queries) {
+    const TileRef tile = lookup(query.tileX, query.tileY);
+    checksum += tile ? static_cast<uint64_t>(tile.GetType()) + 1 : 0;
+  }
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::mt19937 rng(1234);
+  const std::vector<ChunkCoord> loaded = LoadedChunks();
+
+  std::map<ChunkCoord, Chunk> mapChunks;
+  ChunkMap hashChunks;
+  std::uniform_int_distribution<int> type(1, 4);
+  for (const ChunkCoord& coord : loaded) {
+    Chunk chunk(coord.x, coord.y);
+    for (int i = 0; i < Chunk::kTileCount; ++i)
+      chunk.SetType(i, static_cast<TileType>(type(rng)));
+    mapChunks.emplace(coord, chunk);
+    hashChunks.Insert(std::make_unique<Chunk>(chunk));
+  }
+
+  const std::vector<Query> random = RandomQueries(loaded, rng);
+  const std::vector<Query> walk = WalkQueries(rng);
+
+  auto map = [&](int x, int y) { return MapLookup(mapChunks, x, y); };
+  auto hash = [&](int x, int y) { return HashLookup(hashChunks, x, y); };
+
+  std::printf("%d tile lookups over %zu loaded chunks\n", kLookups,
+              loaded.size());
+  const struct {
+    const char* name;
+    const std::vector<Query>& queries;
+  } patterns[] = {{"random", random}, {"walk  ", walk}};
+  for (const auto& pattern : patterns) {
+    uint64_t mapSum = 0, hashSum = 0;
+    const double mapNs = Run(pattern.queries, map, mapSum);
+    const double hashNs = Run(pattern.queries, hash, hashSum);
+    if (mapSum != hashSum) {
+      std::fprintf(stderr, "Lookups disagree on %s queries\n", pattern.name);
+      return 1;
+    }
+    std::printf("  %s std::map : %6.2f ns per lookup\n", pattern.name,
+                mapNs / kLookups);
+    std::printf("  %s ChunkMap : %6.2f ns per lookup (%.2fx)\n", pattern.name,
+                hashNs / kLookups, mapNs / hashNs);
+  }
+  return 0;
+}
@@ -0,0 +1,203 @@
+// Reconciliation after a misprediction: 256 pending inputs, the oldest one
+// acknowledged at a different position and the rest replayed.
+//
+// Compares the previous std::deque queue with a std::map chunk lookup per
+// collision query against PendingInputRing with TileCollisionCache.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Components/BuildingComponent.h"
+#include "Core/Chunk.h"
+#include "Core/EventDispatcher.h"
+#include "Core/InputPrediction.h"
+#include "Core/Packet.h"
+#include "Core/Registry.h"
+#include "Core/TileData.h"
+#include "SDL.h"
+
+namespace {
+constexpr std::size_t kPendingInputs = 256;
+constexpr int kIterations = 20000;
+constexpr int kWorldChunks = 8;  // per side, centered on the origin
+constexpr float kSpeed = 300.f;
+constexpr float kDeltaTime = 1.f / 60.f;
+
+using ChunkMap = std::map<std::pair<int, int>, Chunk>;
+
+void BuildWorld(ChunkMap& chunks, Registry& registry, std::mt19937& rng) {
+  EntityID building = registry.CreateEntity();
+  registry.AddComponent<BuildingComponent>(building, BuildingComponent{});
+
+  std::uniform_int_distribution<int> roll(0, 99);
+  for (int cy = -kWorldChunks / 2; cy < kWorldChunks / 2; ++cy) {
+    for (int cx = -kWorldChunks / 2; cx < kWorldChunks / 2; ++cx) {
+      Chunk& chunk =
+          chunks.emplace(std::make_pair(cx, cy), Chunk(cx, cy)).first->second;
+      for (int y = 0; y < CHUNK_HEIGHT; ++y) {
+        for (int x = 0; x < CHUNK_WIDTH; ++x) {
+          const int index = Chunk::GetLocalIndex(x, y);
+          const int r = roll(rng);
+          chunk.SetType(index, r < 5 ? TileType::Water : TileType::Grass);
+          if (r >= 5 && r < 8) chunk.SetOccupyingEntity(index, building);
+        }
+      }
+    }
+  }
+}
+
+// What World::IsTilePassable did for every query
+bool MapPassable(ChunkMap& chunks, Registry& registry, Vec2f pos) {
+  const int tileX = static_cast<int>(std::floor(pos.x / TILE_PIXEL_SIZE));
+  const int tileY = static_cast<int>(std::floor(pos.y / TILE_PIXEL_SIZE));
+  const int chunkX =
+      static_cast<int>(std::floor(static_cast<float>(tileX) / CHUNK_WIDTH));
+  const int chunkY =
+      static_cast<int>(std::floor(static_cast<float>(tileY) / CHUNK_HEIGHT));
+  auto it = chunks.find({chunkX, chunkY});
+  if (it == chunks.end()) return false;
+  const Vec2 local = it->second.GetLocalTileIndex(tileX, tileY);
+  const int index = Chunk::GetLocalIndex(local.x, local.y);
+  const TileType type = it->second.GetType(index);
+  if (type == TileType::Water || type == TileType::Invalid) return false;
+  const EntityID occupant = it->second.GetOccupyingEntity(index);
+  return !(occupant != INVALID_ENTITY &&
+           registry.HasComponent<BuildingComponent>(occupant));
+}
+
+void MapPredict(ChunkMap& chunks, Registry& registry, Vec2f& pos,
+                uint8_t inputBit, float deltaTime) {
+  int ix = 0, iy = 0;
+  if (inputBit & static_cast<uint8_t>(EPlayerInput::RIGHT)) ix++;
+  if (inputBit & static_cast<uint8_t>(EPlayerInput::LEFT)) ix--;
+  if (inputBit & static_cast<uint8_t>(EPlayerInput::UP)) iy++;
+  if (inputBit & static_cast<uint8_t>(EPlayerInput::DOWN)) iy--;
+  if (ix == 0 && iy == 0) return;
+
+  float len = std::sqrt(static_cast<float>(ix * ix + iy * iy));
+  float stepX = ix / len * kSpeed * deltaTime;
+  float stepY = iy / len * kSpeed * deltaTime;
+  Vec2f tryPos{pos.x + stepX, pos.y + stepY};
+  if (MapPassable(chunks, registry, tryPos)) {
+    pos = tryPos;
+    return;
+  }
+  Vec2f tryX{pos.x + stepX, pos.y};
+  if (MapPassable(chunks, registry, tryX)) pos.x = tryX.x;
+  Vec2f tryY{pos.x, pos.y + stepY};
+  if (MapPassable(chunks, registry, tryY)) pos.y = tryY.y;
+}
+
+std::vector<uint8_t> MakeInputs(std::mt19937& rng) {
+  // Held keys that change every few ticks, like a player walking around
+  std::uniform_int_distribution<int> key(0, 15);
+  std::uniform_int_distribution<int> hold(4, 30);
+  std::vector<uint8_t> inputs;
+  while (inputs.size() < kPendingInputs) {
+    const uint8_t bit = static_cast<uint8_t>(key(rng));
+    for (int i = hold(rng); i > 0 && inputs.size() < kPendingInputs; --i)
+      inputs.push_back(bit);
+  }
+  return inputs;
+}
+
+double ElapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::mt19937 rng(1234);
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  registry.RegisterComponent<BuildingComponent>();
+  ChunkMap chunks;
+  BuildWorld(chunks, registry, rng);
+  const std::vector<uint8_t> inputs = MakeInputs(rng);
+  const Vec2f serverPos{0.5f * TILE_PIXEL_SIZE, 0.5f * TILE_PIXEL_SIZE};
+
+  // Previous implementation
+  struct QueuedInput {
+    uint16_t sequence;
+    uint8_t inputBit;
+    float predX;
+    float predY;
+    float deltaTime;
+  };
+  double dequeNs = 0.0;
+  Vec2f dequeResult;
+  uint16_t sequence = 0;
+  for (int iter = 0; iter < kIterations; ++iter) {
+    std::deque<QueuedInput> queue;
+    const uint16_t first = sequence;
+    for (uint8_t bit : inputs)
+      queue.push_back({sequence++, bit, 1e6f, 1e6f, kDeltaTime});
+
+    const auto start = std::chrono::steady_clock::now();
+    Vec2f pos = serverPos;
+    auto it = queue.begin();
+    while (it != queue.end()) {
+      if (it->sequence == first) {
+        for (auto replay = std::next(it); replay != queue.end(); ++replay) {
+          MapPredict(chunks, registry, pos, replay->inputBit,
+                     replay->deltaTime);
+          replay->predX = pos.x;
+          replay->predY = pos.y;
+        }
+        it = queue.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    dequeNs += ElapsedNs(start);
+    dequeResult = pos;
+  }
+
+  // PendingInputRing with the cached chunk
+  double ringNs = 0.0;
+  Vec2f ringResult;
+  std::size_t lookups = 0;
+  PendingInputRing ring;
+  for (int iter = 0; iter < kIterations; ++iter) {
+    ring.Clear();
+    const uint16_t first = sequence;
+    for (uint8_t bit : inputs)
+      ring.Push({sequence++, bit, 1e6f, 1e6f, kDeltaTime});
+
+    const auto start = std::chrono::steady_clock::now();
+    TileCollisionCache collision(&registry, [&chunks](int x, int y) {
+      auto it = chunks.find({x, y});
+      return it != chunks.end() ? &it->second : nullptr;
+    });
+    ring.Ack(first);
+    ringResult = ring.Replay(serverPos, kSpeed, collision);
+    ringNs += ElapsedNs(start);
+    lookups += collision.GetLookupCount();
+  }
+
+  if (dequeResult.x != ringResult.x || dequeResult.y != ringResult.y) {
+    std::fprintf(stderr, "Replays disagree: (%f, %f) vs (%f, %f)\n",
+                 dequeResult.x, dequeResult.y, ringResult.x, ringResult.y);
+    return 1;
+  }
+
+  std::printf("replay of %zu pending inputs, %d iterations\n",
+              kPendingInputs - 1, kIterations);
+  std::printf("  deque + map lookup : %8.0f ns per reconcile\n",
+              dequeNs / kIterations);
+  std::printf("  ring + chunk cache : %8.0f ns per reconcile (%.1f chunk "
+              "lookups)\n",
+              ringNs / kIterations,
+              static_cast<double>(lookups) / kIterations);
+  std::printf("  speedup            : %8.2fx\n", dequeNs / ringNs);
+  return 0;
+}
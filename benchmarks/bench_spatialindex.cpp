@@ -0,0 +1,156 @@
+// 100k entities wandering over 64x64 chunks, 60 frames of moving them all
+// then asking what is on a 1080p screen, what is within a few tiles of a
+// player and which entity is nearest to one.
+//
+// Compares scanning every position, what RenderSystem::RenderEntities did,
+// against SpatialIndex. The index also pays for filing every move.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Core/SpatialIndex.h"
+#include "SDL.h"
+
+namespace {
+constexpr int kEntities = 100'000;
+constexpr int kFrames = 60;
+constexpr int kQueriesPerFrame = 16;
+constexpr float kWorldSize = 64 * kSpatialCellSize;
+constexpr float kScreenWidth = 1920.f;
+constexpr float kScreenHeight = 1080.f;
+constexpr float kRadius = 4 * TILE_PIXEL_SIZE;
+constexpr float kNearestRadius = kSpatialCellSize;
+
+struct Query {
+  Vec2f center;
+};
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+uint64_t ScanRect(const std::vector<Vec2f>& positions, Vec2f min, Vec2f max) {
+  uint64_t sum = 0;
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    const Vec2f& pos = positions[i];
+    if (pos.x >= min.x && pos.x <= max.x && pos.y >= min.y && pos.y <= max.y)
+      sum += i + 1;
+  }
+  return sum;
+}
+
+uint64_t ScanRadius(const std::vector<Vec2f>& positions, Vec2f center,
+                    float radius) {
+  uint64_t sum = 0;
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    const float dx = positions[i].x - center.x;
+    const float dy = positions[i].y - center.y;
+    if (dx * dx + dy * dy <= radius * radius) sum += i + 1;
+  }
+  return sum;
+}
+
+float ScanNearest(const std::vector<Vec2f>& positions, Vec2f center) {
+  float best = kNearestRadius * kNearestRadius;
+  for (const Vec2f& pos : positions) {
+    const float dx = pos.x - center.x;
+    const float dy = pos.y - center.y;
+    best = std::min(best, dx * dx + dy * dy);
+  }
+  return best;
+}
+
+uint64_t Sum(const std::vector<EntityID>& entities) {
+  uint64_t sum = 0;
+  for (EntityID entity : entities) sum += entity;
+  return sum;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::mt19937 rng(99);
+  std::uniform_real_distribution<float> spread(-kWorldSize / 2,
+                                               kWorldSize / 2);
+  std::uniform_real_distribution<float> step(-8.f, 8.f);
+
+  // Entity i + 1 sits at positions[i]
+  std::vector<Vec2f> positions(kEntities);
+  for (Vec2f& pos : positions) pos = {spread(rng), spread(rng)};
+
+  SpatialIndex index;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kEntities; ++i) index.Update(i + 1, positions[i]);
+  const double insertMs = MsSince(start);
+
+  double moveMs = 0, scanMs = 0, indexMs = 0;
+  std::vector<EntityID> found;
+  for (int frame = 0; frame < kFrames; ++frame) {
+    for (Vec2f& pos : positions) pos = pos + Vec2f(step(rng), step(rng));
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kEntities; ++i) index.Update(i + 1, positions[i]);
+    moveMs += MsSince(start);
+
+    std::vector<Query> queries(kQueriesPerFrame);
+    for (Query& query : queries) query.center = {spread(rng), spread(rng)};
+
+    uint64_t scanSum = 0, indexSum = 0;
+    float scanNearest = 0, indexNearest = 0;
+    start = std::chrono::steady_clock::now();
+    for (const Query& query : queries) {
+      const Vec2f min{query.center.x - kScreenWidth / 2,
+                      query.center.y - kScreenHeight / 2};
+      const Vec2f max{query.center.x + kScreenWidth / 2,
+                      query.center.y + kScreenHeight / 2};
+      scanSum += ScanRect(positions, min, max);
+      scanSum += ScanRadius(positions, query.center, kRadius);
+      scanNearest += ScanNearest(positions, query.center);
+    }
+    scanMs += MsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (const Query& query : queries) {
+      const Vec2f min{query.center.x - kScreenWidth / 2,
+                      query.center.y - kScreenHeight / 2};
+      const Vec2f max{query.center.x + kScreenWidth / 2,
+                      query.center.y + kScreenHeight / 2};
+      found.clear();
+      index.QueryRect(min, max, found);
+      indexSum += Sum(found);
+      found.clear();
+      index.QueryRadius(query.center, kRadius, found);
+      indexSum += Sum(found);
+      const EntityID nearest = index.Nearest(query.center, kNearestRadius);
+      if (nearest == INVALID_ENTITY) {
+        indexNearest += kNearestRadius * kNearestRadius;
+      } else {
+        const float dx = positions[nearest - 1].x - query.center.x;
+        const float dy = positions[nearest - 1].y - query.center.y;
+        indexNearest += dx * dx + dy * dy;
+      }
+    }
+    indexMs += MsSince(start);
+
+    if (scanSum != indexSum || scanNearest != indexNearest) {
+      std::fprintf(stderr, "Queries disagree on frame %d\n", frame);
+      return 1;
+    }
+  }
+
+  const int queryCount = kFrames * kQueriesPerFrame;
+  std::printf("%d entities over %zu cells, %d frames\n", kEntities,
+              index.GetCellCount(), kFrames);
+  std::printf("  filing all entities : %8.3f ms\n", insertMs);
+  std::printf("  moving all entities : %8.3f ms per frame\n",
+              moveMs / kFrames);
+  std::printf("  scan  rect+radius+nearest : %8.3f ms per query\n",
+              scanMs / queryCount);
+  std::printf("  index rect+radius+nearest : %8.3f ms per query (%.1fx)\n",
+              indexMs / queryCount, scanMs / indexMs);
+  return 0;
+}
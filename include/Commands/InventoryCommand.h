@@ -5,10 +5,12 @@
 
 #include "Commands/Command.h"
 #include "Components/InventoryComponent.h"
+#include "Components/MiningDrillComponent.h"
 #include "Core/EventDispatcher.h"
 #include "Core/Item.h"
 #include "Core/Registry.h"
 #include "Core/World.h"
+#include "Util/ReplicationUtil.h"
 
 class InventoryCommand : public Command {
  public:
@@ -41,6 +43,10 @@ class InventoryCommand : public Command {
       else
         TryConsumeItem(targetInventory, -amount);
     }
+
+    // Drill output slot is part of the replicated drill state
+    MarkDrillDirty(registry, target);
+    MarkDrillDirty(registry, instigator);
   }
 
  private:
@@ -49,6 +55,13 @@ class InventoryCommand : public Command {
   int amount;
   EntityID instigator;
 
+  static void MarkDrillDirty(Registry *registry, EntityID entity) {
+    if (entity != INVALID_ENTITY &&
+        registry->HasComponent<MiningDrillComponent>(entity))
+      util::MarkReplicationDirty(registry, entity,
+                                 EReplicatedComponent::MiningDrill);
+  }
+
   int TryAddItem(InventoryComponent &inventory, int amount) {
     int actualAddedAmt = 0;
     if (amount <= 0) return actualAddedAmt;
@@ -13,6 +13,7 @@
 #include "Core/EventDispatcher.h"
 #include "Core/Registry.h"
 #include "Core/World.h"
+#include "Util/ReplicationUtil.h"
 
 // A command to execute mining interaction with resource node
 class ResourceMineCommand : public Command {
@@ -33,8 +34,11 @@ class ResourceMineCommand : public Command {
         auto &inventory =
             registry->GetComponent<InventoryComponent>(instigator);
 
-        if (inventory.items.size() <= inventory.column * inventory.row)
+        if (inventory.items.size() <= inventory.column * inventory.row) {
           resource.LeftResource--;
+          util::MarkReplicationDirty(registry, target,
+                                     EReplicatedComponent::ResourceNode);
+        }
 
         eventDispatcher->Publish(ItemAddEvent(
             instigator, OreToItemMapper::instance().get(resource.Ore), 1));
@@ -42,15 +46,7 @@ class ResourceMineCommand : public Command {
       if (registry->HasComponent<SpriteComponent>(target)) {
         auto &sprite = registry->GetComponent<SpriteComponent>(target);
         auto &resource = registry->GetComponent<ResourceNodeComponent>(target);
-        rsrc_amt_t minIron = world->GetMinironOreAmount();
-        rsrc_amt_t maxIron = world->GetMaxironOreAmount();
-
-        int richnessIndex =
-            (IRON_SPRITESHEET_HEIGHT - 1) -
-            std::min(
-                7.0f,
-                std::floor(static_cast<float>(resource.LeftResource - minIron) /
-                           static_cast<float>(maxIron - minIron) * 8.f));
+        int richnessIndex = world->GetOreRichnessIndex(resource.LeftResource);
         sprite.srcRect = {0, richnessIndex * 128, 128, 128};
       }
     }
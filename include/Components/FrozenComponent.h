@@ -0,0 +1,18 @@
+#ifndef COMPONENTS_FROZENCOMPONENT_
+#define COMPONENTS_FROZENCOMPONENT_
+
+/**
+ * @brief Marks a machine whose chunk left the view. Its timers stop and its
+ * production is settled in one step every kFrozenSettleInterval and when the
+ * chunk comes back, see ProjectProduction. settledAt is saved with the
+ * building when its chunk is evicted, a restored building starts out frozen
+ * and catches up on its first update.
+ */
+struct FrozenComponent {
+  double settledAt = 0.0;  // TimerManager::GetTime of the last settlement
+  // Seconds into the cycle underway of a restored building, which has no
+  // timer until it is settled
+  float progress = 0.f;
+};
+
+#endif /* COMPONENTS_FROZENCOMPONENT_ */
@@ -1,6 +1,16 @@
 #pragma once
+#include <array>
 #include <cstdint>
+
+#include "Core/Packet.h"
+
 struct InputStateComponent {
   uint8_t inputBit = 0;  // RIGHT/LEFT/UP/DOWN bits
   uint16_t sequence = 0; // Last processed input sequence from client
+  uint16_t lastReceivedSeq = 0; // Newest sequence seen in any move batch
+  // Received inputs still to apply, one per syncDelta, oldest first. The
+  // last one has lastReceivedSeq.
+  std::array<uint8_t, kMaxMoveBatch> queued{};
+  uint8_t queuedCount = 0;
+  float inputTime = 0.f;  // Server time not yet spent on queued inputs
 };
\ No newline at end of file
@@ -3,12 +3,13 @@
 
 struct InterpBufferComponent {
   struct Sample {
-    double t;     // seconds (steady clock)
+    uint32_t tick;  // server_tick of the snapshot
     float x, y;
     uint8_t facing;
   };
   static constexpr uint8_t N = 16;
-  uint8_t tail = 0;   // index of oldest
-  uint8_t count = 0;  // number of valid samples
+  uint8_t tail = 0;    // index of oldest
+  uint8_t count = 0;   // number of valid samples
+  uint8_t cursor = 0;  // last sample at or before the render tick, from tail
   Sample samples[N];
 };
\ No newline at end of file
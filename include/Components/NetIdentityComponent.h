@@ -0,0 +1,35 @@
+#ifndef COMPONENTS_NETIDENTITYCOMPONENT_
+#define COMPONENTS_NETIDENTITYCOMPONENT_
+
+#include <cstdint>
+
+// Network-wide identifier of a replicated entity. EntityIDs are local to each
+// process, so replication packets address entities with this instead.
+using netid_t = uint32_t;
+constexpr netid_t INVALID_NETID = 0;
+
+// Entities generated identically on every peer (e.g. ore nodes) are never
+// spawned over the network. Their id is derived from their tile instead and
+// carries this flag so the receiver can resolve it through the world.
+constexpr netid_t STATIC_NETID_FLAG = 0x80000000u;
+
+/**
+ * @brief Binds an entity to its network identifier.
+ * @details Only the authority (server) marks replicated components dirty;
+ * mirrored copies on clients carry bIsAuthority = false.
+ */
+struct NetIdentityComponent {
+  netid_t netID = INVALID_NETID;
+  bool bIsAuthority = false;
+};
+
+/**
+ * @brief A tag component added to an entity when one of its replicated
+ * components changed since the last replication pass.
+ * @details componentMask holds one bit per EReplicatedComponent.
+ */
+struct ReplicationDirtyTag {
+  uint8_t componentMask = 0;
+};
+
+#endif /* COMPONENTS_NETIDENTITYCOMPONENT_ */
@@ -8,10 +8,11 @@ struct TransformComponent {
   Vec2f position;
   Vec2f scale;
   float rotation;  // Rotation in degrees
+  // Position changed since World::SyncEntityIndex, set it after moving
   bool bIsDirty;
   constexpr TransformComponent(Vec2f position = {0.f, 0.f},
                                Vec2f scale = {1.f, 1.f}, float rotation = 0.f)
-      : position(position), scale(scale), rotation(rotation), bIsDirty(false) {
+      : position(position), scale(scale), rotation(rotation), bIsDirty(true) {
         };
 };
 
@@ -0,0 +1,129 @@
+#ifndef CORE_BOTCLIENT_
+#define CORE_BOTCLIENT_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Core/Packet.h"
+#include "Core/PacketAssembler.h"
+
+class PacketReader;
+
+/**
+ * @brief Measurements shared by every bot of a swarm.
+ * @details Samples are appended by the bots and cleared by the driver after
+ * each report, so percentiles describe the last reporting interval.
+ */
+struct BotStats {
+  std::vector<double> roundTripMs;
+  std::vector<double> snapshotIntervalMs;
+  std::vector<double> snapshotJitterMs;
+  std::size_t bytesReceived = 0;
+  std::size_t bytesSent = 0;
+  std::size_t connectedCount = 0;
+
+  void Clear();
+
+  /**
+   * @brief Nearest-rank percentile, reorders samples.
+   * @param percent In [0, 100].
+   * @return 0 for an empty sample set.
+   */
+  static double Percentile(std::vector<double>& samples, double percent);
+};
+
+/**
+ * @brief Protocol side of a headless client used to load test the server.
+ * @details Speaks the same TCP protocol as ClientNetworkSystem: CONNECT_SYN
+ * with a generated name, then batched CLIENT_MOVE_REQ random walks at
+ * syncRate and an occasional CHAT_CLIENT. Transport is left to the caller,
+ * which feeds received bytes in and sends whatever is appended to the output
+ * buffer, so one thread can drive thousands of bots.
+ *
+ * RTT is measured from the first send of an input sequence to the
+ * CLIENT_MOVE_RES acknowledging it. Snapshot jitter is the smoothed
+ * difference between consecutive TRANSFORM_SNAPSHOT inter-arrival times, as
+ * in RFC 3550.
+ */
+class BotClient {
+ public:
+  /**
+   * @param index Swarm wide index, used for the bot name.
+   * @param seed Seeds the random walk, so runs are repeatable.
+   * @param chatChance Probability of sending a chat message per move tick.
+   */
+  BotClient(uint32_t index, uint32_t seed, BotStats* stats,
+            float chatChance = 0.002f);
+
+  /**
+   * @brief Queues CONNECT_SYN. Call once the stream is connected.
+   */
+  void Start(std::vector<uint8_t>& out);
+
+  /**
+   * @brief Processes bytes received from the server.
+   * @return False if the stream is corrupted and should be dropped.
+   */
+  bool OnReceive(const uint8_t* data, std::size_t size, double now);
+
+  /**
+   * @brief Advances the bot by one move tick and queues what it sends.
+   * @details Does nothing until CONNECT_ACK arrived.
+   */
+  void Tick(double now, std::vector<uint8_t>& out);
+
+  inline bool IsConnected() const { return bIsConnected; }
+  inline clientid_t GetClientID() const { return clientID; }
+  inline const std::string& GetName() const { return name; }
+  inline uint16_t GetInputSequence() const { return inputSequenceNumber; }
+
+ private:
+  struct PendingInput {
+    uint16_t seq;
+    uint8_t inputBit;
+  };
+
+  void HandlePacket(const uint8_t* packet, double now);
+  void ConnectAckHandler(PacketReader& reader);
+  void ClientMoveResHandler(PacketReader& reader, double now);
+  void TransformSnapshotHandler(double now);
+  void SendMoveRequest(double now, std::vector<uint8_t>& out);
+  void SendChat(std::vector<uint8_t>& out);
+  void Append(const uint8_t* packet, std::vector<uint8_t>& out);
+  uint8_t NextWalkInput();
+
+  static constexpr std::size_t kSendTimeSlots = 256;
+
+  BotStats* stats;
+  std::string name;
+  std::mt19937 random;
+  float chatChance;
+  PacketAssembler assembler;
+
+  bool bIsConnected = false;
+  clientid_t clientID = 0;
+
+  // Random walk: keep a direction for a random number of ticks
+  uint8_t walkInput = 0;
+  int walkTicksLeft = 0;
+
+  uint16_t inputSequenceNumber = 0;
+  uint16_t lastAckedSeq = 0;
+  std::vector<PendingInput> pendingInputs;
+  uint8_t lastSentInputBit = 0;
+  uint8_t ticksSinceMoveSend = 0;
+  // First send time of each input, indexed by seq % kSendTimeSlots, -1 if
+  // not sent yet
+  std::array<double, kSendTimeSlots> sendTimes;
+
+  double lastSnapshotTime = -1.0;
+  double lastSnapshotInterval = -1.0;
+  double snapshotJitter = 0.0;
+  uint32_t chatCount = 0;
+};
+
+#endif /* CORE_BOTCLIENT_ */
@@ -0,0 +1,45 @@
+#ifndef CORE_BYTERING_
+#define CORE_BYTERING_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Fixed capacity FIFO of bytes backed by a single allocation.
+ * @details Holds outbound stream data between the game thread and the socket
+ * I/O thread. Not synchronized, the owner guards it. Writes are all or
+ * nothing so a packet is never split by a full ring.
+ */
+class ByteRing {
+ public:
+  explicit ByteRing(std::size_t capacity) : buffer(capacity) {}
+
+  /**
+   * @brief Appends size bytes.
+   * @return False, with nothing written, if they do not fit.
+   */
+  bool Write(const uint8_t* data, std::size_t size);
+
+  /**
+   * @brief Longest contiguous run of readable bytes starting at the front.
+   * @return Length of the run, 0 if the ring is empty.
+   */
+  std::size_t Peek(const uint8_t*& outData) const;
+
+  /**
+   * @brief Drops size bytes from the front, after they have been sent.
+   */
+  void Consume(std::size_t size);
+
+  inline std::size_t GetSize() const { return size; }
+  inline std::size_t GetCapacity() const { return buffer.size(); }
+  inline bool IsEmpty() const { return size == 0; }
+
+ private:
+  std::vector<uint8_t> buffer;
+  std::size_t head = 0;  // index of the oldest byte
+  std::size_t size = 0;
+};
+
+#endif /* CORE_BYTERING_ */
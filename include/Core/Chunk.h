@@ -1,14 +1,119 @@
 #ifndef CORE_CHUNK_
 #define CORE_CHUNK_
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "Core/Entity.h"
 #include "Core/TileData.h"
 #include "Core/Type.h"
 
-constexpr int CHUNK_WIDTH = 8;
-constexpr int CHUNK_HEIGHT = 8;
+constexpr int CHUNK_WIDTH = 16;
+constexpr int CHUNK_HEIGHT = 16;
+
+/**
+ * @brief ChunkCoordinate operator for RB-tree comparison
+ *
+ */
+struct ChunkCoord {
+  int x, y;
+  bool operator<(const ChunkCoord& other) const {
+    if (y < other.y) return true;
+    if (y > other.y) return false;
+    return x < other.x;
+  }
+  bool operator==(const ChunkCoord& other) const {
+    return x == other.x && y == other.y;
+  }
+};
+
+/**
+ * @brief Packs a chunk coordinate into a single 64-bit key for hashed lookups.
+ */
+inline uint64_t PackChunkKey(int x, int y) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+         static_cast<uint64_t>(static_cast<uint32_t>(y));
+}
+
+/**
+ * @brief Inverse of PackChunkKey.
+ */
+inline ChunkCoord UnpackChunkKey(uint64_t key) {
+  return {static_cast<int32_t>(static_cast<uint32_t>(key >> 32)),
+          static_cast<int32_t>(static_cast<uint32_t>(key))};
+}
+
+/**
+ * @brief Entities placed on a few tiles out of Count.
+ * @details A bitmask says which tiles have one, the entities themselves are
+ * kept sorted by tile index. Testing a tile or the whole chunk only reads the
+ * mask, a few words that the compiler vectorizes.
+ */
+template <int Count>
+class SparseTileLayer {
+ public:
+  static constexpr int kWordCount = (Count + 63) / 64;
+
+  inline bool Has(int index) const {
+    return (mask[index / 64] >> (index % 64)) & 1u;
+  }
+
+  EntityID Get(int index) const {
+    if (!Has(index)) return INVALID_ENTITY;
+    return Find(index)->second;
+  }
+
+  void Set(int index, EntityID entity) {
+    auto it = Find(index);
+    const bool bHad = Has(index);
+    if (entity == INVALID_ENTITY) {
+      if (bHad) entries.erase(it);
+      mask[index / 64] &= ~(uint64_t{1} << (index % 64));
+    } else if (bHad) {
+      it->second = entity;
+    } else {
+      entries.insert(it, {static_cast<uint16_t>(index), entity});
+      mask[index / 64] |= uint64_t{1} << (index % 64);
+    }
+  }
+
+  inline std::size_t Size() const { return entries.size(); }
+
+  bool Any() const {
+    uint64_t any = 0;
+    for (uint64_t word : mask) any |= word;
+    return any != 0;
+  }
+
+  /**
+   * @brief Calls fn(index, entity) for every entity, by tile index.
+   */
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (const auto& [index, entity] : entries) fn(index, entity);
+  }
+
+ private:
+  using Entry = std::pair<uint16_t, EntityID>;
+
+  typename std::vector<Entry>::const_iterator Find(int index) const {
+    return std::lower_bound(
+        entries.begin(), entries.end(), index,
+        [](const Entry& entry, int value) { return entry.first < value; });
+  }
+  typename std::vector<Entry>::iterator Find(int index) {
+    return std::lower_bound(
+        entries.begin(), entries.end(), index,
+        [](const Entry& entry, int value) { return entry.first < value; });
+  }
+
+  std::array<uint64_t, kWordCount> mask{};
+  std::vector<Entry> entries;
+};
 
 /**
  * @brief Represents a segment of the game world.
@@ -16,19 +121,147 @@ constexpr int CHUNK_HEIGHT = 8;
  * Each chunk contains a grid of tiles and is responsible for the entities
  * and resources within its boundaries. Chunks are loaded and unloaded
  * dynamically based on player proximity.
+ *
+ * Tiles are stored as a struct of arrays: one byte of TileType per tile, and
+ * sparse layers for the buildings and ore nodes that only a few tiles have.
+ * Tiles are addressed by local index, y * Width + x.
+ *
+ * Tiles whose type changed are flagged in a bitmask until their pixels in the
+ * chunk texture are redrawn, a newly filled chunk has all its tiles flagged.
  */
-class Chunk {
-public:
-  Chunk(int _chunkX, int _chunkY);
-  Vec2 GetLocalTileIndex(int worldTileX, int worldTileY) const;
-  TileData *GetTile(int localX, int localY);
-  const TileData *GetTile(int localX, int localY) const;
+template <int Width, int Height>
+class BasicChunk {
+ public:
+  static constexpr int kWidth = Width;
+  static constexpr int kHeight = Height;
+  static constexpr int kTileCount = Width * Height;
+  static_assert(kTileCount <= UINT16_MAX, "Tile index must fit in uint16_t");
+  static constexpr int kWordCount = (kTileCount + 63) / 64;
+
+  BasicChunk(int _chunkX, int _chunkY) : chunkX(_chunkX), chunkY(_chunkY) {
+    types.fill(static_cast<uint8_t>(TileType::Invalid));
+  }
+
+  static constexpr bool IsInside(int localX, int localY) {
+    return localX >= 0 && localX < Width && localY >= 0 && localY < Height;
+  }
+  static constexpr int GetLocalIndex(int localX, int localY) {
+    return localY * Width + localX;
+  }
+
+  Vec2 GetLocalTileIndex(int worldTileX, int worldTileY) const {
+    int localX = worldTileX - (chunkX * Width);
+    int localY = worldTileY - (chunkY * Height);
+
+    // negative value correction
+    if (localX < 0) localX += Width;
+    if (localY < 0) localY += Height;
+
+    return Vec2{localX, localY};
+  }
+
+  inline TileType GetType(int index) const {
+    return static_cast<TileType>(types[index]);
+  }
+  inline void SetType(int index, TileType type) {
+    const uint8_t value = static_cast<uint8_t>(type);
+    if (types[index] == value) return;
+    types[index] = value;
+    dirty[index / 64] |= uint64_t{1} << (index % 64);
+  }
+  inline const std::array<uint8_t, kTileCount>& GetTypes() const {
+    return types;
+  }
+
+  inline EntityID GetOccupyingEntity(int index) const {
+    return occupants.Get(index);
+  }
+  inline void SetOccupyingEntity(int index, EntityID entity) {
+    occupants.Set(index, entity);
+  }
+  inline EntityID GetOreEntity(int index) const { return ores.Get(index); }
+  inline void SetOreEntity(int index, EntityID entity) {
+    ores.Set(index, entity);
+  }
+
+  inline bool HasOccupant(int index) const { return occupants.Has(index); }
+  inline bool HasAnyOccupant() const { return occupants.Any(); }
+  inline const SparseTileLayer<kTileCount>& GetOccupants() const {
+    return occupants;
+  }
+  inline const SparseTileLayer<kTileCount>& GetOres() const { return ores; }
+
+  bool HasDirtyTiles() const {
+    uint64_t any = 0;
+    for (uint64_t word : dirty) any |= word;
+    return any != 0;
+  }
+
+  /**
+   * @brief Calls fn(index) for every tile whose type changed since the last
+   * ClearDirtyTiles, by tile index.
+   */
+  template <typename Fn>
+  void ForEachDirtyTile(Fn&& fn) const {
+    for (int word = 0; word < kWordCount; ++word) {
+      for (uint64_t bits = dirty[word]; bits != 0; bits &= bits - 1)
+        fn(word * 64 + std::countr_zero(bits));
+    }
+  }
+
+  inline void ClearDirtyTiles() { dirty.fill(0); }
+
   const int chunkX;
   const int chunkY;
   EntityID chunkEntity = 0;
 
-private:
-  std::vector<TileData> tiles;
+ private:
+  std::array<uint8_t, kTileCount> types;
+  std::array<uint64_t, kWordCount> dirty{};
+  SparseTileLayer<kTileCount> occupants;
+  SparseTileLayer<kTileCount> ores;
+};
+
+/**
+ * @brief The chunk size the game runs with.
+ * @details A class rather than an alias so it can be forward declared.
+ */
+class Chunk : public BasicChunk<CHUNK_WIDTH, CHUNK_HEIGHT> {
+ public:
+  using BasicChunk::BasicChunk;
+};
+
+/**
+ * @brief One tile of a loaded chunk, what World hands out for tile queries.
+ * @details Evaluates to false when the tile's chunk is not loaded. Valid as
+ * long as the chunk stays loaded.
+ */
+class TileRef {
+ public:
+  TileRef() = default;
+  TileRef(Chunk* chunk, int index) : chunk(chunk), index(index) {}
+
+  explicit operator bool() const { return chunk != nullptr; }
+  bool operator==(const TileRef& other) const {
+    return chunk == other.chunk && index == other.index;
+  }
+
+  inline TileType GetType() const { return chunk->GetType(index); }
+  inline void SetType(TileType type) const { chunk->SetType(index, type); }
+  inline EntityID GetOccupyingEntity() const {
+    return chunk->GetOccupyingEntity(index);
+  }
+  inline void SetOccupyingEntity(EntityID entity) const {
+    chunk->SetOccupyingEntity(index, entity);
+  }
+  inline EntityID GetOreEntity() const { return chunk->GetOreEntity(index); }
+  inline void SetOreEntity(EntityID entity) const {
+    chunk->SetOreEntity(index, entity);
+  }
+
+ private:
+  Chunk* chunk = nullptr;
+  int index = 0;
 };
 
-#endif /* CORE_CHUNK_ */
\ No newline at end of file
+#endif /* CORE_CHUNK_ */
@@ -0,0 +1,131 @@
+#ifndef CORE_CHUNKCACHE_
+#define CORE_CHUNKCACHE_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Chunk.h"
+#include "Core/ChunkMap.h"
+#include "Core/TileData.h"
+
+// Pre-rendered RGBA chunk texture, the bulk of what a cached chunk keeps alive
+constexpr std::size_t kChunkTextureBytes =
+    static_cast<std::size_t>(CHUNK_WIDTH * TILE_PIXEL_SIZE) *
+    (CHUNK_HEIGHT * TILE_PIXEL_SIZE) * 4;
+// Components and registry bookkeeping of one entity, estimated
+constexpr std::size_t kCachedEntityBytes = 512;
+// About a dozen chunks, enough for a player walking back and forth
+constexpr std::size_t kChunkCacheBudgetBytes = 12 * kChunkTextureBytes;
+// Serialized chunks, some ten thousand of them
+constexpr std::size_t kChunkBlobBudgetBytes = 4 * 1024 * 1024;
+
+/**
+ * @brief Counters of a ChunkCache since it was created.
+ */
+struct ChunkCacheStats {
+  std::size_t hits = 0;       // Reactivated while still live
+  std::size_t blobHits = 0;   // Rebuilt from a serialized chunk
+  std::size_t misses = 0;     // Not cached at all
+  std::size_t evictions = 0;  // Live chunks that went over the budget
+  std::size_t blobEvictions = 0;  // Blobs that went over theirs
+  std::size_t liveCount = 0;
+  std::size_t liveBytes = 0;
+  std::size_t blobCount = 0;
+  std::size_t blobBytes = 0;
+};
+
+/**
+ * @brief Chunks that left the view, least recently used first out.
+ * @details Unloaded chunks stay live, with their entities deactivated, so
+ * stepping back over a chunk border costs nothing. Once the live chunks are
+ * estimated to take more than the budget, the oldest are handed back through
+ * PopOverBudget for the owner to serialize and destroy. Serialized chunks may
+ * be kept here as blobs, a few hundred bytes each instead of a texture and a
+ * dozen entities. Blobs have a budget of their own, the oldest past it are
+ * handed back through PopBlobOverBudget.
+ */
+class ChunkCache {
+ public:
+  explicit ChunkCache(std::size_t budgetBytes = kChunkCacheBudgetBytes,
+                      std::size_t blobBudgetBytes = kChunkBlobBudgetBytes);
+
+  /**
+   * @brief Adds a chunk as the most recently used.
+   * @param bytes Estimated memory the chunk keeps alive.
+   */
+  void Insert(std::unique_ptr<Chunk> chunk, std::size_t bytes);
+
+  /**
+   * @brief Takes a chunk out of the cache.
+   * @param outBlob Filled when the chunk was serialized, empty otherwise.
+   * @return The live chunk, nullptr if it was serialized or is not cached.
+   */
+  std::unique_ptr<Chunk> Extract(ChunkCoord coord,
+                                 std::vector<uint8_t>& outBlob);
+
+  /**
+   * @brief Looks up a live chunk without touching its age.
+   */
+  Chunk* Find(ChunkCoord coord);
+
+  /**
+   * @brief Takes the least recently used chunk while over the budget.
+   * @return nullptr once the live chunks fit.
+   */
+  std::unique_ptr<Chunk> PopOverBudget();
+
+  /**
+   * @brief Keeps the serialized form of an evicted chunk, as the most
+   * recently stored.
+   */
+  void StoreBlob(ChunkCoord coord, std::vector<uint8_t> blob);
+
+  /**
+   * @brief Takes the oldest blob while the blobs are over their budget.
+   * @return False once they fit.
+   */
+  bool PopBlobOverBudget(ChunkCoord& outCoord, std::vector<uint8_t>& outBlob);
+
+  /**
+   * @brief Calls fn(chunk) for every live chunk.
+   */
+  template <typename Fn>
+  void ForEachLive(Fn&& fn) const {
+    live.ForEach(fn);
+  }
+
+  inline const ChunkCacheStats& GetStats() const { return stats; }
+
+ private:
+  struct LiveEntry {
+    std::list<uint64_t>::iterator age;
+    std::size_t bytes;
+  };
+
+  struct BlobEntry {
+    std::list<uint64_t>::iterator age;
+    std::vector<uint8_t> data;
+  };
+
+  // Drops the bookkeeping of a live chunk, false if it is not live
+  bool ForgetLive(uint64_t key);
+  // Takes a blob out, empty if there is none
+  std::vector<uint8_t> TakeBlob(uint64_t key);
+
+  std::size_t budgetBytes;
+  std::size_t blobBudgetBytes;
+  ChunkMap live;
+  // PackChunkKey of live chunks, most recently used first
+  std::list<uint64_t> ages;
+  std::unordered_map<uint64_t, LiveEntry> liveEntries;
+  // PackChunkKey of blobs, most recently stored first
+  std::list<uint64_t> blobAges;
+  std::unordered_map<uint64_t, BlobEntry> blobs;
+  ChunkCacheStats stats;
+};
+
+#endif /* CORE_CHUNKCACHE_ */
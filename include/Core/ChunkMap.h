@@ -0,0 +1,78 @@
+#ifndef CORE_CHUNKMAP_
+#define CORE_CHUNKMAP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Core/Chunk.h"
+
+/**
+ * @brief Chunks keyed by coordinate, for the tile lookups of every system.
+ * @details Open addressing with linear probing over PackChunkKey, so a lookup
+ * is a hash and a short scan of one contiguous slot array instead of a walk
+ * down a red-black tree. The slots own the chunks through unique_ptr, a Chunk*
+ * stays valid until its chunk is extracted even when the table grows, and
+ * chunks move between maps without copying their tiles.
+ *
+ * The last chunk found is remembered, consecutive queries on one chunk (a
+ * player walking, a building preview) skip the probe. Not thread safe, even
+ * for const lookups.
+ */
+class ChunkMap {
+ public:
+  ChunkMap();
+
+  Chunk* Find(int chunkX, int chunkY);
+  const Chunk* Find(int chunkX, int chunkY) const;
+  inline Chunk* Find(ChunkCoord coord) { return Find(coord.x, coord.y); }
+  inline bool Contains(ChunkCoord coord) const {
+    return Find(coord.x, coord.y) != nullptr;
+  }
+
+  /**
+   * @brief Adds a chunk, replacing the one at the same coordinate.
+   * @return The stored chunk.
+   */
+  Chunk& Insert(std::unique_ptr<Chunk> chunk);
+  Chunk& Emplace(int chunkX, int chunkY);
+
+  /**
+   * @brief Removes a chunk and hands it over.
+   * @return nullptr if there is no chunk at coord.
+   */
+  std::unique_ptr<Chunk> Extract(ChunkCoord coord);
+
+  inline std::size_t Size() const { return count; }
+  inline bool Empty() const { return count == 0; }
+
+  /**
+   * @brief Calls fn with every chunk, in no particular order. fn must not
+   * insert or extract.
+   */
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (const Slot& slot : slots) {
+      if (slot.chunk) fn(*slot.chunk);
+    }
+  }
+
+ private:
+  struct Slot {
+    uint64_t key = 0;
+    std::unique_ptr<Chunk> chunk;  // nullptr marks an empty slot
+  };
+
+  std::size_t Home(uint64_t key) const;
+  // Slot holding key, or the empty slot that ends its probe
+  std::size_t Probe(uint64_t key) const;
+  void Grow();
+
+  std::vector<Slot> slots;
+  std::size_t count = 0;
+  mutable uint64_t lastKey = 0;
+  mutable Chunk* lastChunk = nullptr;
+};
+
+#endif /* CORE_CHUNKMAP_ */
@@ -0,0 +1,85 @@
+#ifndef CORE_CHUNKPIPELINE_
+#define CORE_CHUNKPIPELINE_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Core/Chunk.h"
+#include "Core/WorldGenerator.h"
+
+/**
+ * @brief Generates chunk terrain on worker threads.
+ * @details The game thread requests chunks with a priority (lower is sooner)
+ * and collects the finished GeneratedChunks later. Workers always pick the
+ * queued chunk with the lowest priority, and requesting a queued chunk again
+ * only updates its priority, so the queue follows a moving player. A canceled
+ * chunk is dropped from the queue, or discarded when its worker finishes.
+ *
+ * Workers never touch the registry or the renderer, entities and textures
+ * are created by the game thread from the results.
+ */
+class ChunkPipeline {
+ public:
+  /**
+   * @param workerCount Number of threads, 0 picks one less than the
+   * hardware threads, at least one.
+   * @param seed World seed of the WorldGenerator.
+   */
+  explicit ChunkPipeline(std::size_t workerCount = 0,
+                         uint64_t seed = kDefaultWorldSeed);
+  ~ChunkPipeline();
+
+  ChunkPipeline(const ChunkPipeline&) = delete;
+  ChunkPipeline& operator=(const ChunkPipeline&) = delete;
+
+  /**
+   * @brief Queues a chunk, or updates the priority of a queued one.
+   * @details Chunks already being generated or done are left as they are.
+   */
+  void Request(ChunkCoord coord, int priority);
+
+  /**
+   * @brief Forgets a chunk that is no longer needed.
+   */
+  void Cancel(ChunkCoord coord);
+
+  /**
+   * @brief Whether a chunk is queued, being generated or waiting in
+   * TakeCompleted.
+   */
+  bool IsPending(ChunkCoord coord) const;
+
+  /**
+   * @brief Moves the finished chunks to the end of out, in completion order.
+   * @details A list since Chunk can be moved but not assigned.
+   */
+  void TakeCompleted(std::list<GeneratedChunk>& out);
+
+  inline std::size_t GetWorkerCount() const { return workers.size(); }
+
+ private:
+  void WorkerLoop();
+
+  const WorldGenerator generator;
+
+  mutable std::mutex mutex;
+  std::condition_variable workAvailable;
+  // PackChunkKey -> priority, chunks no worker has started on
+  std::unordered_map<uint64_t, int> queued;
+  std::unordered_set<uint64_t> running;
+  // Canceled while running, the result is thrown away
+  std::unordered_set<uint64_t> canceled;
+  std::list<GeneratedChunk> completed;
+  bool bIsStopping = false;
+
+  std::vector<std::thread> workers;
+};
+
+#endif /* CORE_CHUNKPIPELINE_ */
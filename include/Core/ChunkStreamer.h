@@ -0,0 +1,98 @@
+#ifndef CORE_CHUNKSTREAMER_
+#define CORE_CHUNKSTREAMER_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "Core/Packet.h"
+#include "Core/PacketPool.h"
+#include "Core/World.h"
+
+// Per-client chunk budget, on top of kReplicationBytesPerSecond. A full view
+// of 9 chunks, about 400 bytes each, takes a quarter second on join.
+constexpr float kChunkBytesPerSecond = 16.f * 1024.f;
+constexpr float kChunkBurstBytes = 2.f * 1024.f;
+// Chunks are unloaded this many chunks past the view distance, so walking
+// along a chunk border does not resend the same row
+constexpr int kChunkUnloadMargin = 1;
+
+/**
+ * @brief Decides which chunks each client holds and streams the missing ones.
+ * @details Every client owns a square view of (2 * viewDistance + 1)^2 chunks
+ * around its player. Chunks inside the view that were not sent yet go out
+ * nearest first, through a token bucket of kChunkBytesPerSecond, so a client
+ * that teleports or joins fills its screen from the center outwards without
+ * starving replication. Chunks further than viewDistance + kChunkUnloadMargin
+ * are unloaded with CHUNK_UNLOAD.
+ */
+class ChunkStreamer {
+ public:
+  /**
+   * @brief Builds the CHUNK_DATA of a chunk.
+   * @return nullptr while the chunk is not loaded on the server, it is tried
+   * again on the next flush.
+   */
+  using Encoder = std::function<PacketPtr(ChunkCoord)>;
+
+  explicit ChunkStreamer(int viewDistance);
+
+  void AddClient(clientid_t clientID);
+  void RemoveClient(clientid_t clientID);
+
+  /**
+   * @brief Re-centers the view of a client on the chunk its player is in.
+   */
+  void SetCenter(clientid_t clientID, ChunkCoord center);
+
+  /**
+   * @brief Whether the client was sent the chunk and not told to unload it.
+   */
+  bool HasChunk(clientid_t clientID, ChunkCoord chunk) const;
+  std::size_t GetChunkCount(clientid_t clientID) const;
+
+  /**
+   * @brief Sends the chunk again to every client holding it, ahead of the
+   * missing ones.
+   * @details For tiles changed on the server, the client redraws only the
+   * tiles that differ from its copy.
+   */
+  void ResendChunk(ChunkCoord chunk);
+
+  /**
+   * @brief Unloads chunks that left the view and sends missing ones as far
+   * as the budget allows.
+   * @param clientID Receiving client, needs a center first.
+   * @param deltaTime Time since the last flush, refills the budget.
+   * @param encode Builds CHUNK_DATA for a chunk.
+   * @param outPackets Complete packets ready for Unicast.
+   */
+  void Flush(clientid_t clientID, float deltaTime, const Encoder& encode,
+             std::vector<PacketPtr>& outPackets);
+
+ private:
+  struct ClientStream {
+    ChunkCoord center{0, 0};
+    bool bHasCenter = false;
+    std::unordered_set<uint64_t> chunks;  // PackChunkKey of sent chunks
+    std::unordered_set<uint64_t> stale;   // sent chunks that changed since
+    float budget = kChunkBurstBytes;
+  };
+
+  void WriteUnloads(ClientStream& stream, std::vector<PacketPtr>& outPackets);
+  // Appends the chunk's CHUNK_DATA and charges the budget, false if the
+  // server does not have it loaded
+  bool WriteChunk(ClientStream& stream, ChunkCoord chunk,
+                  const Encoder& encode, std::vector<PacketPtr>& outPackets);
+
+  int viewDistance;
+  std::unordered_map<clientid_t, ClientStream> clients;
+  std::vector<std::pair<int, ChunkCoord>> missing;
+  std::vector<ChunkCoord> unloads;
+};
+
+#endif /* CORE_CHUNKSTREAMER_ */
@@ -0,0 +1,233 @@
+#ifndef CORE_COMMANDPREDICTOR_
+#define CORE_COMMANDPREDICTOR_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#include "Core/Entity.h"
+#include "Core/Registry.h"
+
+class CommandPredictor;
+
+/**
+ * @brief Component access for one predicted command.
+ * @details The first Get of a component copies it before the command touches
+ * it, so a rollback restores exactly the components the command dirtied and
+ * nothing else.
+ */
+class PredictionScope {
+  friend class CommandPredictor;
+
+  struct Shadow {
+    EntityID entity;
+    std::type_index type;
+    // Copies the component as it is now, restore puts the copy back
+    std::function<void(Registry*)> capture;
+    std::function<void(Registry*)> restore;
+  };
+
+  struct Created {
+    EntityID entity;
+    std::optional<uint64_t> handOverKey;
+  };
+
+ public:
+  /**
+   * @brief Component about to be changed by the command.
+   * @return nullptr if the entity does not have the component.
+   */
+  template <typename T>
+  T* Get(EntityID entity) {
+    if (entity == INVALID_ENTITY) return nullptr;
+    SaveShadow<T>(entity);
+    if (!registry->HasComponent<T>(entity)) return nullptr;
+    return &registry->GetComponent<T>(entity);
+  }
+
+  /**
+   * @brief Marks an entity the command created locally, destroyed again on
+   * rollback. Once the command is confirmed it is destroyed as well, unless
+   * it has a hand-over key: it then stays until CommandPredictor::HandOver
+   * is called with that key, when the server's own entity arrives.
+   */
+  inline void TrackCreated(EntityID entity,
+                           std::optional<uint64_t> handOverKey = {}) {
+    if (entity != INVALID_ENTITY) created.push_back({entity, handOverKey});
+  }
+
+  /**
+   * @brief True when an older command was rolled back and this one is being
+   * applied again on top of the restored state.
+   */
+  inline bool IsReplay() const { return bIsReplay; }
+
+  inline Registry* GetRegistry() const { return registry; }
+
+ private:
+  PredictionScope(Registry* registry, bool bIsReplay)
+      : registry(registry), bIsReplay(bIsReplay) {}
+
+  template <typename T>
+  void SaveShadow(EntityID entity) {
+    const std::type_index type(typeid(T));
+    for (const Shadow& shadow : shadows) {
+      if (shadow.entity == entity && shadow.type == type) return;
+    }
+
+    auto saved = std::make_shared<std::optional<T>>();
+    Shadow shadow{entity, type,
+                  [entity, saved](Registry* registry) {
+                    if (registry->HasComponent<T>(entity))
+                      *saved = registry->GetComponent<T>(entity);
+                    else
+                      saved->reset();
+                  },
+                  [entity, saved](Registry* registry) {
+                    const bool bHas = registry->HasComponent<T>(entity);
+                    if (!*saved) {
+                      if (bHas) registry->RemoveComponent<T>(entity);
+                    } else if (bHas) {
+                      registry->GetComponent<T>(entity) = **saved;
+                    } else {
+                      registry->AddComponent<T>(entity, T(**saved));
+                    }
+                  }};
+    shadow.capture(registry);
+    shadows.push_back(std::move(shadow));
+  }
+
+  Registry* registry;
+  bool bIsReplay;
+  std::vector<Shadow> shadows;
+  std::vector<Created> created;
+};
+
+/**
+ * @brief Applies player commands locally before the server confirms them.
+ * @details Every command gets a sequence number that travels with its
+ * request. The command runs at once through a PredictionScope, the server
+ * answers with COMMAND_ACK and the shadows are either dropped or used to roll
+ * the command back. Commands newer than a rejected one are undone and applied
+ * again, since the server accepted them without it.
+ *
+ * Components are restored to their copies. The server only resends the
+ * components it changed, and what it sends does not include commands it has
+ * not acked yet. Rebase unwinds the pending commands around the written
+ * entity and applies them again on top of it, so they stay visible and a
+ * later rollback lands on the server's state instead of the older one the
+ * command was predicted on.
+ *
+ * The server acks a command as soon as it applies it, while the entity it
+ * made may reach the client much later. Entities created with a hand-over
+ * key outlive the confirmation as stand-ins until HandOver, so they never
+ * blink out in between.
+ */
+class CommandPredictor {
+ public:
+  using ApplyFn = std::function<void(PredictionScope&)>;
+  using DestroyFn = std::function<void(EntityID)>;
+
+  /**
+   * @param destroy Removes an entity made by a command, defaults to
+   * Registry::DestroyEntity.
+   */
+  explicit CommandPredictor(Registry* registry, DestroyFn destroy = nullptr);
+
+  /**
+   * @brief Applies a command and keeps it until the server answers.
+   * @return Sequence number to send with the request.
+   */
+  uint16_t Predict(ApplyFn apply);
+
+  /**
+   * @brief Server applied the command. Its entities with a hand-over key are
+   * kept as stand-ins for the replicated ones, the others destroyed.
+   */
+  void Confirm(uint16_t sequence);
+
+  /**
+   * @brief The server's entity for a key arrived, destroys the stand-in made
+   * for it. Works before the command is confirmed too, the server only
+   * sends the entity once it accepted the command.
+   * @return False if nothing was made for the key.
+   */
+  bool HandOver(uint64_t handOverKey);
+
+  /**
+   * @brief Destroys every confirmed stand-in, used when the server resends
+   * its whole state and stand-ins may no longer have an entity coming.
+   */
+  void DropStandIns();
+
+  /**
+   * @brief Server refused the command, undoes it keeping newer commands.
+   */
+  void Reject(uint16_t sequence);
+
+  /**
+   * @brief Rejects every unconfirmed command, used when their acks can no
+   * longer arrive.
+   */
+  void RejectAll();
+
+  /**
+   * @brief Replication wrote the server's state of the entity. If pending
+   * commands touched it they are replayed on top of that state, and roll
+   * back to it from now on.
+   */
+  void Rebase(EntityID entity);
+
+  /**
+   * @brief Forgets every pending command and stand-in without touching the
+   * registry.
+   */
+  void Clear();
+
+  inline std::size_t GetPendingCount() const { return pending.size(); }
+  inline std::size_t GetStandInCount() const { return standIns.size(); }
+  inline bool IsReplaying() const { return bIsReplaying; }
+
+ private:
+  struct PendingCommand {
+    uint16_t sequence;
+    bool bIsConfirmed;
+    ApplyFn apply;
+    PredictionScope scope;
+    // Hand-over keys whose entity arrived before the ack
+    std::vector<uint64_t> handedOver;
+    // Confirmed, and replication already wrote these entities with the
+    // command applied, replays leave them alone
+    std::vector<EntityID> serverOwned;
+  };
+
+  // Restores shadows newest first, except those of keep, and destroys
+  // created entities
+  void Undo(PredictionScope& scope, EntityID keep = INVALID_ENTITY);
+  // Restores and drops only the shadows of entity
+  void RestoreEntity(PredictionScope& scope, EntityID entity);
+  // Applies the command again in a fresh scope, without touching serverOwned
+  // entities or remaking entities that were already handed over
+  void Replay(PendingCommand& command);
+  void DestroyCreated(PredictionScope& scope);
+  // Keeps created entities with a hand-over key as stand-ins, destroys the
+  // others
+  void KeepStandIns(PredictionScope& scope);
+  void PopConfirmed();
+
+  Registry* registry;
+  DestroyFn destroy;
+  std::deque<PendingCommand> pending;
+  // Created by confirmed commands, waiting for HandOver
+  std::vector<PredictionScope::Created> standIns;
+  uint16_t nextSequence = 0;
+  bool bIsReplaying = false;
+};
+
+#endif /* CORE_COMMANDPREDICTOR_ */
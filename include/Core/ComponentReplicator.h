@@ -0,0 +1,139 @@
+#ifndef CORE_COMPONENTREPLICATOR_
+#define CORE_COMPONENTREPLICATOR_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Components/NetIdentityComponent.h"
+#include "Core/Entity.h"
+#include "Core/Registry.h"
+#include "Core/Type.h"
+
+/**
+ * @brief Components whose state is owned by the server and mirrored to
+ * clients.
+ * @details Each value is one bit of the per-entity component mask, so at most
+ * eight components can be replicated.
+ */
+enum class EReplicatedComponent : uint8_t {
+  ResourceNode,
+  AssemblingMachine,
+  MiningDrill,
+  Count
+};
+
+constexpr uint8_t ReplicationBit(EReplicatedComponent component) {
+  return static_cast<uint8_t>(1u << static_cast<uint8_t>(component));
+}
+
+/**
+ * @brief Describes what kind of entity a client constructs for ENTITY_SPAWN.
+ */
+enum class ENetArchetype : uint8_t {
+  None,
+  AssemblingMachine,
+  MiningDrill,
+};
+
+/**
+ * @brief Builds the static network id of a world-generated entity from its
+ * tile index.
+ * @details Both axes are stored as 15-bit two's complement values, which
+ * covers +-16384 tiles around the origin.
+ */
+inline netid_t MakeStaticNetID(Vec2 tileIndex) {
+  return STATIC_NETID_FLAG |
+         ((static_cast<uint32_t>(tileIndex.x) & 0x7FFFu) << 15) |
+         (static_cast<uint32_t>(tileIndex.y) & 0x7FFFu);
+}
+
+/**
+ * @brief Inverse of MakeStaticNetID.
+ */
+inline Vec2 GetStaticNetIDTile(netid_t netID) {
+  // sign-extend 15-bit fields
+  int x = static_cast<int>((netID >> 15) & 0x7FFFu);
+  int y = static_cast<int>(netID & 0x7FFFu);
+  if (x & 0x4000) x -= 0x8000;
+  if (y & 0x4000) y -= 0x8000;
+  return Vec2(x, y);
+}
+
+inline bool IsStaticNetID(netid_t netID) {
+  return (netID & STATIC_NETID_FLAG) != 0;
+}
+
+/**
+ * @brief Table of serializers for every replicated component.
+ * @details Replication packets carry, per entity, a one byte component mask
+ * followed by the payload of each component whose bit is set, in ascending
+ * bit order. Adding a replicated component only requires a new
+ * EReplicatedComponent value and a Register call; the server replication
+ * manager and the client handlers stay untouched.
+ */
+class ComponentReplicator {
+ public:
+  using HasFn = bool (*)(Registry*, EntityID);
+  using SizeFn = std::size_t (*)(Registry*, EntityID);
+  using WriteFn = void (*)(Registry*, EntityID, uint8_t*&);
+  // Reads one payload and applies it to the entity. With an INVALID_ENTITY
+  // (or an entity lacking the component) the payload is only skipped.
+  // Returns false if the payload runs past end.
+  using ReadFn = bool (*)(Registry*, EntityID, const uint8_t*&,
+                          const uint8_t* end);
+
+  struct Ops {
+    HasFn has = nullptr;
+    SizeFn size = nullptr;
+    WriteFn write = nullptr;
+    ReadFn read = nullptr;
+  };
+
+  static const ComponentReplicator& instance() {
+    static ComponentReplicator replicator;
+    return replicator;
+  }
+
+  /**
+   * @brief Mask of every replicated component the entity currently has.
+   */
+  uint8_t GetMask(Registry* registry, EntityID entity) const;
+
+  /**
+   * @brief Serialized size of the mask byte plus the selected payloads.
+   */
+  std::size_t GetSize(Registry* registry, EntityID entity, uint8_t mask) const;
+
+  /**
+   * @brief Writes the mask byte and the selected payloads.
+   * @details Bits of components the entity no longer has are cleared before
+   * writing, so GetSize must be called with the same mask beforehand.
+   */
+  void Write(Registry* registry, EntityID entity, uint8_t mask,
+             uint8_t*& wp) const;
+
+  /**
+   * @brief Reads a mask byte and every payload it announces.
+   * @return False on truncated data or an unknown component bit.
+   */
+  bool Read(Registry* registry, EntityID entity, const uint8_t*& rp,
+            const uint8_t* end) const;
+
+ private:
+  ComponentReplicator();
+
+  template <typename T>
+  void Register(EReplicatedComponent component, SizeFn size, WriteFn write,
+                ReadFn read) {
+    ops[static_cast<std::size_t>(component)] = Ops{
+        [](Registry* registry, EntityID entity) {
+          return registry->HasComponent<T>(entity);
+        },
+        size, write, read};
+  }
+
+  std::array<Ops, static_cast<std::size_t>(EReplicatedComponent::Count)> ops;
+};
+
+#endif /* CORE_COMPONENTREPLICATOR_ */
@@ -24,11 +24,22 @@ class EntityFactory {
   EntityFactory(Registry* registry, AssetManager* assetManager);
   virtual ~EntityFactory();
   
-  virtual EntityID CreateAssemblingMachine(World* world, Vec2f worldPos);
-  virtual EntityID CreateAssemblingMachine(World* world, Vec2 tileIndex);
+  virtual EntityID CreateAssemblingMachine(World* world, Vec2f worldPos,
+                                           EntityID builder = INVALID_ENTITY);
+  /**
+   * @param bIsReplicated True when mirroring a building the server already
+   * validated; skips the local placement check.
+   * @param builder Player placing the building, which may not stand on it.
+   */
+  virtual EntityID CreateAssemblingMachine(World* world, Vec2 tileIndex,
+                                           bool bIsReplicated = false,
+                                           EntityID builder = INVALID_ENTITY);
 
-  virtual EntityID CreateMiningDrill(World* world, Vec2f worldPos);
-  virtual EntityID CreateMiningDrill(World* world, Vec2 tileIndex);
+  virtual EntityID CreateMiningDrill(World* world, Vec2f worldPos,
+                                     EntityID builder = INVALID_ENTITY);
+  virtual EntityID CreateMiningDrill(World* world, Vec2 tileIndex,
+                                     bool bIsReplicated = false,
+                                     EntityID builder = INVALID_ENTITY);
 
   virtual EntityID CreatePlayer(World *world, Vec2f worldPos, clientid_t clientID, bool bIsLocalPlayer);
 };
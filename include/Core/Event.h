@@ -8,6 +8,7 @@
 #include "Core/Entity.h"
 #include "Core/Item.h"
 #include "Core/Packet.h"
+#include "Core/Recipe.h"
 #include "Core/Type.h"
 
 /**
@@ -91,6 +92,39 @@ struct AssemblyCraftOutputEvent : public Event {
   EntityID machine;
 };
 
+struct AssemblySetRecipeEvent : public Event {
+  AssemblySetRecipeEvent(EntityID machine, RecipeID recipe)
+      : machine(machine), recipe(recipe) {}
+  EntityID machine;
+  RecipeID recipe;
+};
+
+// Emitted on server when a building was placed and should be replicated
+struct BuildingPlacedEvent : public Event {
+  BuildingPlacedEvent(EntityID building, ItemID item, Vec2 tileIndex)
+      : building(building), item(item), tileIndex(tileIndex) {}
+  EntityID building;
+  ItemID item;
+  Vec2 tileIndex;
+};
+
+// Emitted on server when the type of a tile changed, clients holding its
+// chunk need it again
+struct TileChangedEvent : public Event {
+  explicit TileChangedEvent(Vec2 tileIndex) : tileIndex(tileIndex) {}
+  Vec2 tileIndex;
+};
+
+// Emitted on client instead of placing a building locally, the network
+// system predicts the placement until the server answers
+struct BuildRequestEvent : public Event {
+  BuildRequestEvent(EntityID player, ItemID item, Vec2 tileIndex)
+      : player(player), item(item), tileIndex(tileIndex) {}
+  EntityID player;
+  ItemID item;
+  Vec2 tileIndex;
+};
+
 struct ToggleInventoryEvent : public Event {
   ToggleInventoryEvent() = default;
 };
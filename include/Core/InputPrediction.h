@@ -0,0 +1,149 @@
+#ifndef CORE_INPUTPREDICTION_
+#define CORE_INPUTPREDICTION_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include "Core/Type.h"
+
+class Chunk;
+class Registry;
+struct InputStateComponent;
+
+/**
+ * @brief One tick of local player input and the position predicted from it.
+ */
+struct PredictedInput {
+  uint16_t sequence;
+  uint8_t inputBit;
+  float predX;
+  float predY;
+  float deltaTime;
+};
+
+/**
+ * @brief Tile passability for many queries around the same place.
+ * @details Remembers the last chunk it resolved and the last tile answer, so
+ * consecutive steps inside one tile or chunk skip the lookups entirely. Both
+ * are only valid while the world does not change, make one per prediction
+ * pass.
+ */
+class TileCollisionCache {
+ public:
+  using ChunkLookup = std::function<Chunk*(int chunkX, int chunkY)>;
+
+  TileCollisionCache(Registry* registry, ChunkLookup lookup)
+      : registry(registry), lookup(std::move(lookup)) {}
+
+  /**
+   * @brief Same rules as World::IsTilePassable, unloaded chunks block.
+   */
+  bool IsPassable(Vec2f worldPos);
+
+  inline std::size_t GetLookupCount() const { return lookupCount; }
+
+ private:
+  Registry* registry;
+  ChunkLookup lookup;
+  Chunk* cachedChunk = nullptr;
+  int cachedX = 0;
+  int cachedY = 0;
+  bool bHasCached = false;
+  int lastTileX = 0;
+  int lastTileY = 0;
+  bool bHasLastTile = false;
+  bool bLastPassable = false;
+  std::size_t lookupCount = 0;
+};
+
+/**
+ * @brief Moves a predicted position by one input tick with tile collision.
+ */
+void PredictMove(Vec2f& position, float speed, uint8_t inputBit,
+                 float deltaTime, TileCollisionCache& collision);
+
+/**
+ * @brief Inputs sent but not yet acknowledged by CLIENT_MOVE_RES.
+ * @details Fixed ring addressed by sequence % kCapacity. Acknowledging moves
+ * the oldest sequence forward instead of erasing entries, and nothing is
+ * allocated after construction. When more than kCapacity inputs are pending
+ * the oldest are overwritten, the server has long moved past them by then.
+ */
+class PendingInputRing {
+ public:
+  // Divides 65536 so sequence wrap keeps the slot mapping
+  static constexpr std::size_t kCapacity = 256;
+
+  /**
+   * @brief Adds the newest input.
+   * @details Sequences are expected to be consecutive, a gap restarts the
+   * ring from this input.
+   */
+  void Push(const PredictedInput& input);
+
+  /**
+   * @brief Drops every input up to and including sequence.
+   * @return The acknowledged input, valid until the next Push. nullptr if it
+   * was not pending.
+   */
+  const PredictedInput* Ack(uint16_t sequence);
+
+  /**
+   * @brief Simulates the pending inputs again from a corrected position and
+   * stores the new predictions.
+   * @return Predicted position after the newest input.
+   */
+  Vec2f Replay(Vec2f position, float speed, TileCollisionCache& collision);
+
+  /**
+   * @brief Pending input counted back from the newest one (0).
+   */
+  inline const PredictedInput& FromNewest(std::size_t index) const {
+    return inputs[static_cast<uint16_t>(oldest + count - 1 - index) %
+                  kCapacity];
+  }
+
+  inline std::size_t GetSize() const { return count; }
+  inline bool IsEmpty() const { return count == 0; }
+  inline void Clear() { count = 0; }
+
+ private:
+  std::array<PredictedInput, kCapacity> inputs{};
+  uint16_t oldest = 0;  // sequence of the oldest pending input
+  std::size_t count = 0;
+};
+
+/**
+ * @brief Queues the inputs of a CLIENT_MOVE_REQ batch the server has not seen
+ * yet, oldest first.
+ * @details Inputs older than the batch reaches back were lost for good. A
+ * client running ahead of the server loses its oldest queued inputs.
+ * @param packed input_bits of the batch, see util::ReadInputNibble.
+ * @return False if an earlier batch already delivered every input.
+ */
+bool QueueMoveBatch(InputStateComponent& state, uint16_t newestSeq,
+                    uint8_t inputCnt, const uint8_t* packed);
+
+/**
+ * @brief Adds server frame time for a remote player's queued inputs.
+ * @details Each input covers syncDelta, the step the client predicted it
+ * with, whatever the server frame rate. While nothing is queued time banks
+ * up only to one frame short of a step.
+ */
+void AdvanceInputTime(InputStateComponent& state, float deltaTime);
+
+/**
+ * @brief Takes the next queued input of a remote player into inputBit and
+ * sequence, to be applied for one syncDelta step.
+ * @details A remote player only moves on inputs that arrived. The client
+ * withholds unchanged inputs for up to kMoveBatchTicks and sends them with
+ * the next batch, repeating the last one meanwhile would apply them twice.
+ * @return False if none is queued or AdvanceInputTime has not added a full
+ * syncDelta for it yet.
+ */
+bool TakeQueuedInput(InputStateComponent& state);
+
+#endif /* CORE_INPUTPREDICTION_ */
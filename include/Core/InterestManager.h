@@ -0,0 +1,90 @@
+#ifndef CORE_INTERESTMANAGER_
+#define CORE_INTERESTMANAGER_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Packet.h"
+#include "Core/Type.h"
+#include "Core/World.h"
+
+// Players leave an area of interest this many chunks past the view distance,
+// so one pacing along its edge is not dropped and re-sent every step
+constexpr int kInterestLeaveMargin = 1;
+
+/**
+ * @brief Tracks which replicated players each client is able to see.
+ * @details Subjects (players) are bucketed by the chunk they stand in and
+ * every observer (connected client) owns a square area of interest of
+ * (2 * viewDistance + 1)^2 chunks centered on its own player. A subject
+ * enters when it comes inside that area and leaves once it is further than
+ * viewDistance + kInterestLeaveMargin. Refreshing an observer only visits
+ * the buckets out to that leave distance, so the cost and the resulting
+ * snapshot size depend on local density rather than on the total server
+ * population.
+ */
+class InterestManager {
+ public:
+  /**
+   * @brief Subjects that entered or left an observer's area since the last
+   * refresh.
+   */
+  struct ViewDelta {
+    std::vector<clientid_t> entered;
+    std::vector<clientid_t> left;
+  };
+
+  explicit InterestManager(int viewDistance);
+
+  /**
+   * @brief Inserts or moves a replicated player into the bucket of its chunk.
+   * @param subject ClientID of the player.
+   * @param worldPos Current world position (in pixels).
+   */
+  void UpdateSubject(clientid_t subject, Vec2f worldPos);
+  void RemoveSubject(clientid_t subject);
+
+  /**
+   * @brief Re-centers an observer's area of interest on its player.
+   * @param observer ClientID of the receiving client.
+   * @param worldPos World position of the observer's player.
+   */
+  void UpdateObserver(clientid_t observer, Vec2f worldPos);
+  void RemoveObserver(clientid_t observer);
+
+  /**
+   * @brief Recomputes the visible subject set of an observer.
+   * @param observer ClientID of the receiving client.
+   * @param outDelta Filled with subjects that entered or left the area.
+   * @return False if the observer is unknown.
+   */
+  bool Refresh(clientid_t observer, ViewDelta& outDelta);
+
+  /**
+   * @brief Subjects visible to an observer as of the last Refresh, sorted.
+   */
+  const std::vector<clientid_t>& GetVisibleSubjects(clientid_t observer) const;
+
+  /**
+   * @brief Checks whether a chunk lies inside an observer's area of interest,
+   * the enter distance.
+   */
+  bool IsChunkVisible(clientid_t observer, ChunkCoord chunk) const;
+
+  inline int GetViewDistance() const { return viewDistance; }
+
+ private:
+  struct Observer {
+    ChunkCoord center;
+    std::vector<clientid_t> visible;
+  };
+
+  int viewDistance;
+  std::unordered_map<uint64_t, std::vector<clientid_t>> subjectsByChunk;
+  std::unordered_map<clientid_t, ChunkCoord> subjectChunk;
+  std::unordered_map<clientid_t, Observer> observers;
+  std::vector<clientid_t> scratch;
+};
+
+#endif /* CORE_INTERESTMANAGER_ */
@@ -0,0 +1,155 @@
+#ifndef CORE_NETCONNECTION_
+#define CORE_NETCONNECTION_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Packet.h"
+
+// Keeps datagrams under the common 1280 byte IPv6 minimum MTU
+constexpr std::size_t kMaxDatagramSize = 1200;
+constexpr std::size_t sDatagramHeader =
+    sizeof(uint16_t) * 2 + sizeof(uint32_t);  // seq, ack, ack_bits
+constexpr std::size_t sMessageHeader =
+    sizeof(uint8_t) + sizeof(uint16_t);  // mode, message_seq
+// Largest packet (header included) that fits in a single datagram
+constexpr std::size_t kMaxDatagramPacketSize =
+    kMaxDatagramSize - sDatagramHeader - sMessageHeader;
+// Largest slice of a fragmented packet, after its uint16_t fragment_size
+constexpr std::size_t kMaxFragmentSize =
+    kMaxDatagramPacketSize - sizeof(uint16_t);
+
+/**
+ * @brief One end of a UDP conversation with per packet type delivery modes.
+ * @details Transport agnostic: datagrams are fed in through Receive and
+ * collected for sending through Flush, so the same logic runs on top of
+ * real sockets and of in-memory links in tests.
+ *
+ * Datagram layout
+ * ---------------------------------
+ * uint16_t : datagram_seq
+ * uint16_t : ack            newest datagram_seq received from the peer
+ * uint32_t : ack_bits       bit i set if (ack - 1 - i) was received too
+ *
+ * [Repeated until the end of the datagram]
+ * uint8_t :  mode (EDeliveryMode, or 2 for a fragment)
+ * uint16_t : message_seq    reliable: per connection, unreliable: per type
+ * ... :      packet, PacketHeader included
+ *
+ * [Fragment: mode 2]
+ * uint16_t : fragment_size
+ * ... :      next fragment_size bytes of the packet
+ * ---------------------------------
+ *
+ * Reliable messages remember which datagrams carried them and are resent
+ * after roughly one round trip until one of those datagrams is acked. Every
+ * datagram acks the last 33 datagrams received, so a single lost ack costs
+ * nothing. At most kReliableWindow reliable messages are in flight, the rest
+ * wait in the queue: the receiver drops anything further ahead than that,
+ * and a dropped message must never be acked.
+ *
+ * A reliable packet too large for one datagram is cut into fragments that
+ * take consecutive message_seqs, so the receiver gets them back in order
+ * and joins them before delivering the packet. Unreliable messages are sent
+ * once; the receiver drops any that is not newer than the last one delivered
+ * for the same packet type.
+ */
+class NetConnection {
+ public:
+  NetConnection();
+
+  /**
+   * @brief Queues a packet for sending with the mode of its packet type.
+   * @param packet Full packet, PacketHeader included.
+   * @return False if the packet is malformed, or unreliable and does not fit
+   * in a datagram. The packet is dropped then.
+   */
+  bool Send(const uint8_t* packet, std::size_t size);
+
+  /**
+   * @brief Processes one datagram from the peer.
+   * @param now Current time in seconds, used for round trip estimation.
+   * @return False if the datagram is malformed. Messages parsed before the
+   * malformed part are kept.
+   */
+  bool Receive(const uint8_t* datagram, std::size_t size, double now);
+
+  /**
+   * @brief Pops the next packet ready for the game, in delivery order.
+   */
+  bool Next(PacketPtr& outPacket);
+
+  /**
+   * @brief Builds the datagrams that should go on the wire now: queued
+   * packets, due resends and a bare ack if something was received.
+   * @param now Current time in seconds.
+   * @param outDatagrams Appended with complete datagrams.
+   */
+  void Flush(double now, std::vector<std::vector<uint8_t>>& outDatagrams);
+
+  // Smoothed round trip time in seconds
+  inline double GetRoundTripTime() const { return roundTripTime; }
+  // Reliable messages queued or sent but not acknowledged yet
+  inline std::size_t GetUnackedCount() const { return reliableOut.size(); }
+
+ private:
+  struct OutMessage {
+    EDeliveryMode mode;
+    uint16_t seq;
+    std::vector<uint8_t> bytes;
+    double lastSent = -1.0;
+    bool bIsAcked = false;
+    bool bIsFragment = false;
+  };
+
+  struct InMessage {
+    PacketPtr packet;
+    std::vector<uint8_t> fragment;
+    bool bIsFragment = false;
+  };
+
+  struct SentDatagram {
+    uint16_t seq = 0;
+    double time = 0.0;
+    std::vector<uint16_t> reliableSeqs;
+    bool bIsValid = false;
+  };
+
+  static constexpr std::size_t kSentHistory = 256;
+  // Reliable messages further ahead than this are dropped by the receiver,
+  // so the sender never has more than this many in flight
+  static constexpr uint16_t kReliableWindow = 1024;
+
+  void AckDatagram(uint16_t seq, double now);
+  void MarkReceived(uint16_t seq);
+  bool ReadMessage(const uint8_t*& rp, const uint8_t* end);
+  void DeliverReliable(InMessage& message);
+  double GetResendDelay() const;
+
+  // Outgoing
+  uint16_t nextDatagramSeq = 0;
+  uint16_t nextReliableSeq = 0;
+  std::unordered_map<uint16_t, uint16_t> nextUnreliableSeq;  // per packet id
+  std::deque<OutMessage> reliableOut;
+  std::deque<OutMessage> unreliableOut;
+  std::array<SentDatagram, kSentHistory> sentDatagrams;
+
+  // Incoming
+  bool bHasReceived = false;
+  bool bIsAckPending = false;
+  uint16_t remoteSeq = 0;
+  uint32_t remoteAckBits = 0;
+  uint16_t nextDeliverSeq = 0;
+  std::unordered_map<uint16_t, InMessage> reliableIn;
+  std::vector<uint8_t> partialPacket;  // Fragments joined so far
+  std::unordered_map<uint16_t, uint16_t> lastUnreliableSeq;  // per packet id
+  std::deque<PacketPtr> delivered;
+
+  double roundTripTime;
+};
+
+#endif /* CORE_NETCONNECTION_ */
@@ -0,0 +1,58 @@
+#ifndef CORE_NOISEGRID_
+#define CORE_NOISEGRID_
+
+#include <cstdint>
+
+/**
+ * @brief Noise algorithms NoiseGrid implements.
+ */
+enum class ENoiseType : uint8_t {
+  Perlin,
+  OpenSimplex2,
+};
+
+/**
+ * @brief 2D noise evaluated over a whole grid of integer coordinates.
+ * @details Reimplements FastNoiseLite's 2D Perlin and OpenSimplex2 (no
+ * fractal) with the same constants, hash and float operation order, so
+ * Generate matches FastNoiseLite::GetNoise(float(x), float(y)) bit for bit as
+ * long as the compiler does not fuse multiply-adds.
+ *
+ * Rows are evaluated 8 (AVX2) or 4 (SSE4.1) points at a time, with every
+ * branch of the scalar code turned into a mask, and the scalar code finishes
+ * the row. The instruction set is picked at build time by FACTORYGAME_SIMD.
+ */
+class NoiseGrid {
+ public:
+  explicit NoiseGrid(ENoiseType type, float frequency, int seed = 1337);
+
+  /**
+   * @brief Noise at (originX + x, originY + y) for every x < width and
+   * y < height, row major into out.
+   */
+  void Generate(int originX, int originY, int width, int height,
+                float* out) const;
+
+  /**
+   * @brief Same as Generate without SIMD, the reference it is checked
+   * against.
+   */
+  void GenerateScalar(int originX, int originY, int width, int height,
+                      float* out) const;
+
+  /**
+   * @brief Instruction set Generate was built with.
+   */
+  static const char* GetSimdName();
+
+  inline int GetSeed() const { return seed; }
+
+ private:
+  float Single(int x, int y) const;
+
+  ENoiseType type;
+  float frequency;
+  int seed;
+};
+
+#endif /* CORE_NOISEGRID_ */
@@ -4,13 +4,30 @@
 #include <cstdint>
 #include <memory>
 
-using PacketPtr = std::unique_ptr<uint8_t[]>;
+/**
+ * @brief Returns packet buffers to the PacketPool size class they came from.
+ * @details Buffers not taken from the pool (sizeClass left at kUnpooled) are
+ * freed with delete[].
+ */
+struct PacketDeleter {
+  static constexpr uint8_t kUnpooled = 0xFF;
+  uint8_t sizeClass = kUnpooled;
+  void operator()(uint8_t* buffer) const;
+};
+
+using PacketPtr = std::unique_ptr<uint8_t[], PacketDeleter>;
 using clientid_t = uint64_t;
 
-// run sync between server-client "syncRate" times per second
+// clients send inputs "syncRate" times per second, also the default snapshot
+// rate the server sends each client
 constexpr float syncRate = 30.f;
 constexpr float syncDelta = 1.f / syncRate;
 
+// server_tick of snapshots advances "tickRate" times per second of server time,
+// the server captures positions on every tick
+constexpr float tickRate = 60.f;
+constexpr float tickDelta = 1.f / tickRate;
+
 #pragma pack(push, 1)
 /**
  * @brief The header for all network packets.
@@ -39,6 +56,8 @@ struct Packet {
 enum class ESendType {
   UNICAST,
   BROADCAST,
+  REBIND,  // hands connection targetClientId the reboundClientId, then sends
+  SESSION,  // UNICAST that first gives the connection its sessionToken
 };
 
 /**
@@ -52,6 +71,8 @@ struct SendRequest {
   ESendType type;
   clientid_t targetClientId;  // positive int for UNICAST (0 for BROADCAST)
   PacketPtr packet;
+  clientid_t reboundClientId = 0;  // REBIND only
+  uint64_t sessionToken = 0;       // SESSION and REBIND, checked on UDP_BIND
 };
 
 /**
@@ -85,6 +106,8 @@ enum PACKET {
    * --- Payload ---
    * uint8_t :    name_len
    * char :       name[name_len] (UTF-8 without \0)
+   * uint32_t :   rate            bytes per second the client can take,
+   *                              0 leaves it to the server
    */
   CONNECT_SYN = 100,
   /**
@@ -92,9 +115,10 @@ enum PACKET {
    *
    * --- Payload ---
    * clientid_t : fresh allocated clientID for syn sender
-   * uint16_t : player_cnt
+   * uint64_t : session_token   proves the session in RECONNECT_SYN
+   * uint16_t : player_cnt      whole roster, PLAYER_ROSTER carries the rest
    *
-   * [Repeated for player_cnt]
+   * [Repeated up to player_cnt, until the end of the packet]
    * ---------------------------------
    * clientid_t : player_id
    * uint8_t :    name_len
@@ -131,16 +155,23 @@ enum PACKET {
   CHAT_BROADCAST,
 
   /**
-   * CLIENT_MOVE_REQ :
+   * CLIENT_MOVE_REQ : the newest unacknowledged inputs, so a late or lost
+   * batch is covered by the next one.
    *
    * --- Payload ---
-   * uint16_t :   input_sequence_num
-   * uint8_t :    input_bit                // used by server
+   * uint16_t :   newest_input_sequence_num
+   * uint8_t :    input_cnt (1..kMaxMoveBatch)
+   * uint8_t :    input_bits[(input_cnt + 1) / 2]
+   *
+   * Inputs are ordered oldest to newest, entry i has sequence
+   * newest - (input_cnt - 1 - i). Each is a 4 bit EPlayerInput mask, entry i
+   * in the low nibble of byte i / 2 when i is even, high nibble otherwise.
    */
   CLIENT_MOVE_REQ,
 
   /**
-   * CLIENT_MOVE_RES :
+   * CLIENT_MOVE_RES : sent at most once per server tick per client, only for
+   * the newest applied input.
    *
    * --- Payload ---
    * uint16_t : last_acked_input_sequence_num
@@ -153,6 +184,9 @@ enum PACKET {
    * TRANSFORM_SNAPSHOT :
    *
    * --- Payload ---
+   * uint32_t : server_tick    server time in tickDelta units, orders the
+   *                           snapshot and is echoed back by requests that
+   *                           get rewound
    * uint16_t : player_cnt
    *
    * [Repeated for player_cnt]
@@ -172,10 +206,285 @@ enum PACKET {
    * clientid_t : disconnected clientID
    */
   PLAYER_DISCONNECTED_BROADCAST,
+
+  /**
+   * INTEREST_ENTER : players that came into the receiver's area of interest.
+   * Snapshots for them resume from the next TRANSFORM_SNAPSHOT.
+   *
+   * --- Payload ---
+   * uint16_t : player_cnt
+   * clientid_t : player_id[player_cnt]
+   */
+  INTEREST_ENTER,
+
+  /**
+   * INTEREST_LEAVE : players that went out of the receiver's area of
+   * interest. No more snapshots are sent for them until INTEREST_ENTER.
+   *
+   * --- Payload ---
+   * uint16_t : player_cnt
+   * clientid_t : player_id[player_cnt]
+   */
+  INTEREST_LEAVE,
+
+  /**
+   * ENTITY_SPAWN : server-owned entities the receiver has to construct.
+   * Delivered in order and never dropped by the replication budget.
+   *
+   * --- Payload ---
+   * uint16_t : entity_cnt
+   *
+   * [Repeated for entity_cnt]
+   * ---------------------------------
+   * uint32_t : net_id
+   * uint8_t :  archetype (ENetArchetype)
+   * int32_t :  tileX
+   * int32_t :  tileY
+   * uint8_t :  component_mask
+   * ... :      payload of every component in component_mask
+   * ---------------------------------
+   */
+  ENTITY_SPAWN,
+
+  /**
+   * ENTITY_DESPAWN : server-owned entities the receiver has to destroy.
+   *
+   * --- Payload ---
+   * uint16_t : entity_cnt
+   * uint32_t : net_id[entity_cnt]
+   */
+  ENTITY_DESPAWN,
+
+  /**
+   * COMPONENT_UPDATE : latest value of changed replicated components.
+   * Changes made between two sends are coalesced into one entry.
+   *
+   * --- Payload ---
+   * uint16_t : entity_cnt
+   *
+   * [Repeated for entity_cnt]
+   * ---------------------------------
+   * uint32_t : net_id
+   * uint8_t :  component_mask
+   * ... :      payload of every component in component_mask
+   * ---------------------------------
+   */
+  COMPONENT_UPDATE,
+
+  /**
+   * BUILD_REQ : client asks the server to place a building.
+   *
+   * --- Payload ---
+   * uint16_t : command_seq  answered by COMMAND_ACK
+   * uint8_t : item_id
+   * int32_t : tileX
+   * int32_t : tileY
+   */
+  BUILD_REQ,
+
+  /**
+   * ENTITY_INTERACT_REQ : client interaction with a replicated entity.
+   *
+   * --- Payload ---
+   * uint16_t : command_seq  answered by COMMAND_ACK
+   * uint32_t : net_id
+   * uint8_t :  action (ENetInteraction)
+   * uint8_t :  item_id or recipe_id
+   * uint16_t : amount
+   * uint32_t : view_tick    server_tick the client was displaying, the
+   *                         server validates reach as of that tick
+   */
+  ENTITY_INTERACT_REQ,
+
+  /**
+   * UDP_BIND : first message a client sends over UDP, ties the datagram
+   * source address to the clientID received in CONNECT_ACK. Rejected unless
+   * the token matches the session of that clientID.
+   *
+   * --- Payload ---
+   * clientid_t : clientID
+   * uint64_t :   session_token from CONNECT_ACK
+   */
+  UDP_BIND,
+
+  /**
+   * UDP_BIND_ACK : server accepted UDP_BIND, from now on gameplay packets
+   * travel over UDP in both directions.
+   *
+   * --- Payload ---
+   * (none)
+   */
+  UDP_BIND_ACK,
+
+  /**
+   * COMMAND_ACK : server outcome of a predicted BUILD_REQ or
+   * ENTITY_INTERACT_REQ, the client drops or rolls back its prediction.
+   *
+   * --- Payload ---
+   * uint16_t : command_seq
+   * uint8_t :  accepted (0: rejected)
+   */
+  COMMAND_ACK,
+
+  /**
+   * REPLICATION_SYNC : every replication change up to version has been sent
+   * before this packet. The client reports it back in RECONNECT_SYN.
+   *
+   * --- Payload ---
+   * uint32_t : version
+   */
+  REPLICATION_SYNC,
+
+  /**
+   * RECONNECT_SYN : first packet on a new connection that resumes a session
+   * instead of joining as a new player.
+   *
+   * --- Payload ---
+   * clientid_t : clientID of the session
+   * uint64_t :   session_token from CONNECT_ACK
+   * uint32_t :   replication_version from the last REPLICATION_SYNC
+   */
+  RECONNECT_SYN,
+
+  /**
+   * RECONNECT_ACK : outcome of RECONNECT_SYN. When resumed the connection
+   * carries the old clientID again and the replication changes the client
+   * missed follow.
+   *
+   * --- Payload ---
+   * uint8_t :  result (EReconnectResult)
+   * uint16_t : player_cnt  whole roster, PLAYER_ROSTER carries the rest
+   *
+   * [Repeated up to player_cnt, until the end of the packet]
+   * ---------------------------------
+   * clientid_t : player_id
+   * uint8_t :    name_len
+   * char :     name[name_len] (UTF-8 without \0)
+   * ---------------------------------
+   */
+  RECONNECT_ACK,
+
+  /**
+   * CHUNK_DATA : a chunk entering the client's view. Clients never run
+   * worldgen, this is the only source of terrain and ore.
+   *
+   * Usually a few hundred bytes, one datagram. An ore-heavy chunk can reach
+   * about 1.8 KB; it stays on the UDP channel, fragmented by NetConnection
+   * like any large reliable packet, so it keeps its order with CHUNK_UNLOAD
+   * and the INTEREST packets of the same chunk.
+   *
+   * --- Payload ---
+   * int32_t :  chunkX
+   * int32_t :  chunkY
+   * uint16_t : run_cnt
+   *
+   * [Repeated for run_cnt, tiles in row-major order]
+   * ---------------------------------
+   * uint16_t : length
+   * uint8_t :  tile_type (TileType)
+   * ---------------------------------
+   *
+   * uint16_t : ore_cnt
+   *
+   * [Repeated for ore_cnt]
+   * ---------------------------------
+   * uint16_t : local tile index (y * CHUNK_WIDTH + x)
+   * uint8_t :  ore_type (OreType)
+   * uint32_t : amount
+   * ---------------------------------
+   */
+  CHUNK_DATA,
+
+  /**
+   * CHUNK_UNLOAD : chunks that left the client's view. They are sent again
+   * with their current state if they come back.
+   *
+   * --- Payload ---
+   * uint16_t : chunk_cnt
+   *
+   * [Repeated for chunk_cnt]
+   * ---------------------------------
+   * int32_t : chunkX
+   * int32_t : chunkY
+   * ---------------------------------
+   */
+  CHUNK_UNLOAD,
+
+  /**
+   * PLAYER_ROSTER : players of a CONNECT_ACK or RECONNECT_ACK roster that
+   * did not fit in the ack, sent right after it until player_cnt of the ack
+   * is reached.
+   *
+   * --- Payload ---
+   * uint16_t : player_cnt
+   *
+   * [Repeated for player_cnt]
+   * ---------------------------------
+   * clientid_t : player_id
+   * uint8_t :    name_len
+   * char :     name[name_len] (UTF-8 without \0)
+   * ---------------------------------
+   */
+  PLAYER_ROSTER,
+};
+
+/**
+ * @brief Result of RECONNECT_SYN.
+ */
+enum class EReconnectResult : uint8_t {
+  Rejected,  // unknown or expired session, join again with CONNECT_SYN
+  Resumed,   // only the replication changes since the version follow
+  Resynced,  // too far behind, drop every replica, all of them follow
+};
+
+/**
+ * @brief How a packet type is delivered over the UDP channel.
+ * @details UnreliableSequenced packets are sent once and an older packet of
+ * the same type arriving after a newer one is dropped. ReliableOrdered
+ * packets are resent until acknowledged and handed over in send order.
+ */
+enum class EDeliveryMode : uint8_t {
+  UnreliableSequenced,
+  ReliableOrdered,
+};
+
+constexpr EDeliveryMode GetDeliveryMode(PACKET packetId) {
+  switch (packetId) {
+    case TRANSFORM_SNAPSHOT:
+    case CLIENT_MOVE_REQ:
+    case CLIENT_MOVE_RES:
+      return EDeliveryMode::UnreliableSequenced;
+    default:
+      return EDeliveryMode::ReliableOrdered;
+  }
+}
+
+// Packets that must use the TCP stream because they set up the UDP channel
+constexpr bool IsHandshakePacket(PACKET packetId) {
+  return packetId == CONNECT_SYN || packetId == CONNECT_ACK ||
+         packetId == RECONNECT_SYN || packetId == RECONNECT_ACK ||
+         packetId == PLAYER_ROSTER;
+}
+
+/**
+ * @brief Interactions a client can request on a replicated entity.
+ */
+enum class ENetInteraction : uint8_t {
+  SetRecipe,
+  AddInput,
+  TakeOutput,
+  TakeInventory,
 };
 
 constexpr uint8_t NAME_MAX_LEN = 64;
+// Inputs resent in each CLIENT_MOVE_REQ
+constexpr uint8_t kMaxMoveBatch = 8;
+// A move batch is sent at least every kMoveBatchTicks inputs, or right away
+// when the input changes
+constexpr uint8_t kMoveBatchTicks = 4;
 constexpr std::size_t sPacketHeader = sizeof(PacketHeader);
+// packet_size is 16 bit, header included
+constexpr std::size_t kMaxPacketSize = UINT16_MAX;
 constexpr std::size_t sClientID = sizeof(clientid_t);
 constexpr std::size_t sHeaderAndId = sPacketHeader + sClientID;
 
@@ -0,0 +1,44 @@
+#ifndef CORE_PACKETASSEMBLER_
+#define CORE_PACKETASSEMBLER_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Core/Packet.h"
+
+/**
+ * @brief Splits a TCP byte stream back into packets.
+ * @details A single recv may return several packets glued together or only
+ * part of one. Bytes are accumulated here and cut on the packet_size field of
+ * each PacketHeader.
+ */
+class PacketAssembler {
+ public:
+  PacketAssembler() = default;
+
+  /**
+   * @brief Appends received bytes to the stream.
+   */
+  void Feed(const uint8_t* data, std::size_t size);
+
+  /**
+   * @brief Extracts the next complete packet.
+   * @param outPacket Receives the packet, header included.
+   * @return False if no complete packet is buffered yet.
+   */
+  bool Next(PacketPtr& outPacket);
+
+  /**
+   * @brief True if the stream declared an impossible packet size. The
+   * connection cannot be resynchronized and should be dropped.
+   */
+  inline bool IsCorrupted() const { return bIsCorrupted; }
+
+ private:
+  std::vector<uint8_t> stream;
+  std::size_t readOffset = 0;
+  bool bIsCorrupted = false;
+};
+
+#endif /* CORE_PACKETASSEMBLER_ */
@@ -0,0 +1,128 @@
+#ifndef CORE_PACKETCAPTURE_
+#define CORE_PACKETCAPTURE_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Core/Packet.h"
+#include "Core/ThreadSafeQueue.h"
+
+/**
+ * Capture file layout (big endian)
+ * ---------------------------------
+ * char[4] :  magic "FGPC"
+ * uint16_t : version
+ *
+ * [Repeated until the end of the file]
+ * uint32_t : tick            ServerNetworkSystem update the packet was read in
+ * uint32_t : time_ms         milliseconds since the recording started
+ * uint64_t : sender_client_id
+ * uint16_t : packet_size     0 for a disconnect notification
+ * uint8_t[packet_size] :     packet, PacketHeader included
+ * ---------------------------------
+ */
+constexpr char kCaptureMagic[4] = {'F', 'G', 'P', 'C'};
+constexpr uint16_t kCaptureVersion = 1;
+constexpr std::size_t sCaptureFileHeader = sizeof(kCaptureMagic) + 2;
+constexpr std::size_t sCaptureRecordHeader = 4 + 4 + 8 + 2;
+
+/**
+ * @brief Appends every packet the server receives to a capture file.
+ * @details Called from the game thread as packets are popped from the
+ * receive queue, so the log holds exactly what the handlers saw and in the
+ * same order. Writes go through the stream buffer; nothing is flushed per
+ * packet.
+ */
+class PacketRecorder {
+ public:
+  ~PacketRecorder();
+
+  /**
+   * @brief Creates (or truncates) the capture file and writes its header.
+   * @return False if the file could not be opened.
+   */
+  bool Open(const std::string& path);
+  void Close();
+
+  /**
+   * @brief Logs one received packet. A null packet is logged as a disconnect.
+   */
+  void Record(uint32_t tick, uint32_t timeMs, const RecvPacket& recv);
+
+  inline bool IsOpen() const { return file.is_open(); }
+  inline std::size_t GetRecordCount() const { return recordCount; }
+
+ private:
+  std::ofstream file;
+  std::size_t recordCount = 0;
+};
+
+/**
+ * @brief Feeds a capture file back into a receive queue without any sockets.
+ * @details The file is streamed one record ahead, so arbitrarily long
+ * captures replay in constant memory. Records can be released by recorded
+ * time (Advance, scaled by the playback rate) or one recorded tick at a time
+ * (StepTick) to run as fast as the server can consume them.
+ */
+class PacketReplayer {
+ public:
+  /**
+   * @param queue Receive queue the server network system reads from.
+   * @param playbackRate Recorded seconds replayed per elapsed second. 0 or
+   * less replays one recorded tick per Update, as fast as the caller runs.
+   */
+  explicit PacketReplayer(ThreadSafeQueue<RecvPacket>* queue,
+                          float playbackRate = 1.f);
+
+  /**
+   * @brief Opens a capture file and checks its header.
+   * @return False if the file is missing or not a supported capture.
+   */
+  bool Open(const std::string& path);
+
+  /**
+   * @brief Advance or StepTick depending on the playback rate.
+   * @return Number of records pushed.
+   */
+  std::size_t Update(float deltaTime);
+
+  /**
+   * @brief Moves the playback clock and pushes every record now due.
+   * @return Number of records pushed.
+   */
+  std::size_t Advance(float deltaTime);
+
+  /**
+   * @brief Pushes every record of the next recorded tick, ignoring time.
+   * @return Number of records pushed.
+   */
+  std::size_t StepTick();
+
+  inline bool IsFinished() const { return !bHasNext; }
+  inline std::size_t GetReplayedCount() const { return replayedCount; }
+
+ private:
+  struct Record {
+    uint32_t tick;
+    uint32_t timeMs;
+    clientid_t senderClientId;
+    std::vector<uint8_t> packet;
+  };
+
+  // Reads the record after next into next, clears bHasNext at the end
+  void ReadNext();
+  void PushNext();
+
+  ThreadSafeQueue<RecvPacket>* queue;
+  float playbackRate;
+  std::ifstream file;
+  Record next;
+  bool bHasNext = false;
+  double playbackMs = 0.0;
+  std::size_t replayedCount = 0;
+};
+
+#endif /* CORE_PACKETCAPTURE_ */
@@ -0,0 +1,64 @@
+#ifndef CORE_PACKETPOOL_
+#define CORE_PACKETPOOL_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Core/Packet.h"
+
+/**
+ * @brief Recycles packet buffers instead of allocating one per packet.
+ * @details Buffers are grouped in power-of-four size classes from 64 bytes up
+ * to the largest packet_size. Packets are built on the game thread and freed
+ * on the network threads (or the other way around), so every class has its
+ * own lock. Each class keeps at most kMaxPooledBytes of idle buffers; extra
+ * ones are freed.
+ */
+class PacketPool {
+ public:
+  static PacketPool& instance() {
+    static PacketPool pool;
+    return pool;
+  }
+
+  /**
+   * @brief Gets a buffer of at least size bytes. Contents are unspecified.
+   */
+  PacketPtr Acquire(std::size_t size);
+
+  /**
+   * @brief Idle buffers currently kept for the class serving size.
+   */
+  std::size_t GetIdleCount(std::size_t size);
+
+ private:
+  friend struct PacketDeleter;
+
+  static constexpr std::size_t kMinClassSize = 64;
+  static constexpr std::size_t kClassCount = 6;  // 64B .. 64KiB
+  static constexpr std::size_t kMaxPooledBytes = 1 << 20;
+
+  struct SizeClass {
+    std::mutex mutex;
+    std::vector<uint8_t*> idle;
+  };
+
+  PacketPool() = default;
+  ~PacketPool();
+  PacketPool(const PacketPool&) = delete;
+  PacketPool& operator=(const PacketPool&) = delete;
+
+  static uint8_t GetSizeClass(std::size_t size);
+  static std::size_t GetClassSize(uint8_t sizeClass) {
+    return kMinClassSize << (sizeClass * 2);
+  }
+
+  void Release(uint8_t* buffer, uint8_t sizeClass);
+
+  std::array<SizeClass, kClassCount> classes;
+};
+
+#endif /* CORE_PACKETPOOL_ */
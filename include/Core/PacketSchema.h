@@ -0,0 +1,386 @@
+#ifndef CORE_PACKETSCHEMA_
+#define CORE_PACKETSCHEMA_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "Core/Packet.h"
+#include "Core/PacketPool.h"
+#include "Util/PacketUtil.h"
+
+// uint8_t name_len followed by name_len bytes of UTF-8
+struct NameField {};
+// Every remaining byte of the packet, must be the last field
+struct TailField {};
+
+/**
+ * @brief Wire encoding of one schema field type.
+ * @details Scalars are big endian. Read checks the field against end, clears
+ * bIsOk and leaves rp untouched on overrun.
+ */
+template <typename T>
+struct FieldCodec {
+  using Value = T;
+  static constexpr std::size_t kMinSize = sizeof(T);
+
+  static std::size_t Size(Value) { return sizeof(T); }
+
+  static Value Read(const uint8_t*& rp, const uint8_t* end, bool& bIsOk) {
+    if (static_cast<std::size_t>(end - rp) < sizeof(T)) {
+      bIsOk = false;
+      return Value{};
+    }
+    if constexpr (sizeof(T) == 1) {
+      return static_cast<T>(*rp++);
+    } else if constexpr (std::is_same_v<T, float>) {
+      return util::ReadF32BigEnd(rp);
+    } else if constexpr (sizeof(T) == 2) {
+      return static_cast<T>(util::Read16BigEnd(rp));
+    } else if constexpr (sizeof(T) == 4) {
+      return static_cast<T>(util::Read32BigEnd(rp));
+    } else {
+      static_assert(sizeof(T) == 8, "Unsupported scalar field");
+      return static_cast<T>(util::Read64BigEnd(rp));
+    }
+  }
+
+  static void Write(uint8_t*& wp, Value v) {
+    if constexpr (sizeof(T) == 1) {
+      *wp++ = static_cast<uint8_t>(v);
+    } else if constexpr (std::is_same_v<T, float>) {
+      util::WriteF32BigEnd(wp, v);
+    } else if constexpr (sizeof(T) == 2) {
+      util::Write16BigEnd(wp, static_cast<uint16_t>(v));
+    } else if constexpr (sizeof(T) == 4) {
+      util::Write32BigEnd(wp, static_cast<uint32_t>(v));
+    } else {
+      util::Write64BigEnd(wp, static_cast<uint64_t>(v));
+    }
+  }
+};
+
+template <>
+struct FieldCodec<NameField> {
+  using Value = std::string_view;
+  static constexpr std::size_t kMinSize = sizeof(uint8_t);
+
+  static std::size_t Size(Value v) {
+    return sizeof(uint8_t) + std::min<std::size_t>(v.size(), NAME_MAX_LEN);
+  }
+
+  static Value Read(const uint8_t*& rp, const uint8_t* end, bool& bIsOk) {
+    if (rp == end || static_cast<std::size_t>(end - rp - 1) < *rp) {
+      bIsOk = false;
+      return {};
+    }
+    const uint8_t len = *rp++;
+    Value v(reinterpret_cast<const char*>(rp), len);
+    rp += len;
+    return v;
+  }
+
+  static void Write(uint8_t*& wp, Value v) {
+    const uint8_t len =
+        static_cast<uint8_t>(std::min<std::size_t>(v.size(), NAME_MAX_LEN));
+    *wp++ = len;
+    std::memcpy(wp, v.data(), len);
+    wp += len;
+  }
+};
+
+template <>
+struct FieldCodec<TailField> {
+  using Value = std::string_view;
+  static constexpr std::size_t kMinSize = 0;
+
+  static std::size_t Size(Value v) { return v.size(); }
+
+  static Value Read(const uint8_t*& rp, const uint8_t* end, bool&) {
+    Value v(reinterpret_cast<const char*>(rp),
+            static_cast<std::size_t>(end - rp));
+    rp = end;
+    return v;
+  }
+
+  static void Write(uint8_t*& wp, Value v) {
+    std::memcpy(wp, v.data(), v.size());
+    wp += v.size();
+  }
+};
+
+/**
+ * @brief An ordered list of fields, read and written as one unit.
+ * @details Values is the tuple handed out by PacketReader::Read. Name and
+ * tail fields come back as string_views into the packet, nothing is copied.
+ */
+template <typename... Fields>
+struct PacketFields {
+  using Values = std::tuple<typename FieldCodec<Fields>::Value...>;
+
+  // Size when every variable length field is empty
+  static constexpr std::size_t kMinSize =
+      (FieldCodec<Fields>::kMinSize + ... + 0);
+
+  template <typename... Args>
+  static std::size_t SizeOf(const Args&... args) {
+    static_assert(sizeof...(Fields) == sizeof...(Args),
+                  "Argument count does not match the schema");
+    return (FieldCodec<Fields>::Size(
+                static_cast<typename FieldCodec<Fields>::Value>(args)) +
+            ... + 0);
+  }
+};
+
+/**
+ * @brief Layout of each packet type, matching the comments on enum PACKET.
+ * @details Header is read once at the start of the payload. Packets with a
+ * repeated section describe one entry as Record and carry the entry count in
+ * Header. Replication records are variable and left to ComponentReplicator.
+ */
+template <PACKET Id>
+struct PacketSchema;
+
+template <typename HeaderFields, typename RecordFields = PacketFields<>>
+struct PacketLayout {
+  using Header = HeaderFields;
+  using Record = RecordFields;
+};
+
+// clang-format off
+template <> struct PacketSchema<CONNECT_SYN>
+    : PacketLayout<PacketFields<NameField, uint32_t>> {};
+template <> struct PacketSchema<CONNECT_ACK>
+    : PacketLayout<PacketFields<clientid_t, uint64_t, uint16_t>,
+                   PacketFields<clientid_t, NameField>> {};
+template <> struct PacketSchema<PLAYER_CONNECTED_BROADCAST>
+    : PacketLayout<PacketFields<clientid_t, NameField>> {};
+template <> struct PacketSchema<CHAT_CLIENT>
+    : PacketLayout<PacketFields<TailField>> {};
+template <> struct PacketSchema<CHAT_BROADCAST>
+    : PacketLayout<PacketFields<clientid_t, TailField>> {};
+// Packed inputs are written through the cursor after the header
+template <> struct PacketSchema<CLIENT_MOVE_REQ>
+    : PacketLayout<PacketFields<uint16_t, uint8_t>> {};
+template <> struct PacketSchema<CLIENT_MOVE_RES>
+    : PacketLayout<PacketFields<uint16_t, float, float>> {};
+template <> struct PacketSchema<TRANSFORM_SNAPSHOT>
+    : PacketLayout<PacketFields<uint32_t, uint16_t>,
+                   PacketFields<clientid_t, float, float, uint8_t>> {};
+template <> struct PacketSchema<PLAYER_DISCONNECTED_BROADCAST>
+    : PacketLayout<PacketFields<clientid_t>> {};
+template <> struct PacketSchema<INTEREST_ENTER>
+    : PacketLayout<PacketFields<uint16_t>, PacketFields<clientid_t>> {};
+template <> struct PacketSchema<INTEREST_LEAVE>
+    : PacketLayout<PacketFields<uint16_t>, PacketFields<clientid_t>> {};
+template <> struct PacketSchema<ENTITY_SPAWN>
+    : PacketLayout<PacketFields<uint16_t>> {};
+template <> struct PacketSchema<ENTITY_DESPAWN>
+    : PacketLayout<PacketFields<uint16_t>, PacketFields<uint32_t>> {};
+template <> struct PacketSchema<COMPONENT_UPDATE>
+    : PacketLayout<PacketFields<uint16_t>> {};
+template <> struct PacketSchema<BUILD_REQ>
+    : PacketLayout<PacketFields<uint16_t, uint8_t, int32_t, int32_t>> {};
+template <> struct PacketSchema<ENTITY_INTERACT_REQ>
+    : PacketLayout<PacketFields<uint16_t, uint32_t, uint8_t, uint8_t,
+                                uint16_t, uint32_t>> {};
+template <> struct PacketSchema<UDP_BIND>
+    : PacketLayout<PacketFields<clientid_t, uint64_t>> {};
+template <> struct PacketSchema<UDP_BIND_ACK>
+    : PacketLayout<PacketFields<>> {};
+template <> struct PacketSchema<COMMAND_ACK>
+    : PacketLayout<PacketFields<uint16_t, uint8_t>> {};
+template <> struct PacketSchema<REPLICATION_SYNC>
+    : PacketLayout<PacketFields<uint32_t>> {};
+template <> struct PacketSchema<RECONNECT_SYN>
+    : PacketLayout<PacketFields<clientid_t, uint64_t, uint32_t>> {};
+template <> struct PacketSchema<RECONNECT_ACK>
+    : PacketLayout<PacketFields<uint8_t, uint16_t>,
+                   PacketFields<clientid_t, NameField>> {};
+template <> struct PacketSchema<CHUNK_DATA>
+    : PacketLayout<PacketFields<int32_t, int32_t, uint16_t>,
+                   PacketFields<uint16_t, uint8_t>> {
+  // Second repeated section, after the tile runs
+  using OreHeader = PacketFields<uint16_t>;
+  using OreRecord = PacketFields<uint16_t, uint8_t, uint32_t>;
+};
+template <> struct PacketSchema<PLAYER_ROSTER>
+    : PacketLayout<PacketFields<uint16_t>,
+                   PacketFields<clientid_t, NameField>> {};
+template <> struct PacketSchema<CHUNK_UNLOAD>
+    : PacketLayout<PacketFields<uint16_t>, PacketFields<int32_t, int32_t>> {};
+// clang-format on
+
+/**
+ * @brief Bounds-checked view over a received packet.
+ * @details Fields are decoded in place from the packet buffer. Any read past
+ * packet_size fails and leaves the reader failed, so handlers only have to
+ * check the result of each Read instead of doing size arithmetic.
+ */
+class PacketReader {
+ public:
+  /**
+   * @param packet Full packet, PacketHeader included. The buffer must hold
+   * packet_size bytes, which PacketAssembler and NetConnection guarantee.
+   */
+  explicit PacketReader(const uint8_t* packet) : rp(packet), end(packet) {
+    std::size_t packetSize;
+    util::GetHeader(rp, packetId, packetSize);
+    if (packetSize < sPacketHeader) {
+      bIsOk = false;
+      return;
+    }
+    end = packet + packetSize;
+  }
+
+  template <typename Layout>
+  std::optional<typename Layout::Values> Read() {
+    return ReadImpl(static_cast<Layout*>(nullptr));
+  }
+
+  template <PACKET Id>
+  auto ReadHeader() {
+    return Read<typename PacketSchema<Id>::Header>();
+  }
+
+  template <PACKET Id>
+  auto ReadRecord() {
+    return Read<typename PacketSchema<Id>::Record>();
+  }
+
+  inline PACKET GetPacketId() const { return packetId; }
+  inline bool IsOk() const { return bIsOk; }
+  inline std::size_t GetRemaining() const {
+    return static_cast<std::size_t>(end - rp);
+  }
+  // Raw cursor for payloads decoded elsewhere (ComponentReplicator)
+  inline const uint8_t*& Cursor() { return rp; }
+  inline const uint8_t* End() const { return end; }
+
+ private:
+  template <typename... Fields>
+  std::optional<std::tuple<typename FieldCodec<Fields>::Value...>> ReadImpl(
+      PacketFields<Fields...>*) {
+    if (!bIsOk || GetRemaining() < PacketFields<Fields...>::kMinSize) {
+      bIsOk = false;
+      return std::nullopt;
+    }
+    // Braced initialization evaluates the fields left to right
+    std::tuple<typename FieldCodec<Fields>::Value...> values{
+        FieldCodec<Fields>::Read(rp, end, bIsOk)...};
+    if (!bIsOk) return std::nullopt;
+    return values;
+  }
+
+  const uint8_t* rp;
+  const uint8_t* end;
+  PACKET packetId;
+  bool bIsOk = true;
+};
+
+/**
+ * @brief Serializes a packet into a pooled buffer.
+ * @details The payload size is computed from the same schema the fields are
+ * written with, and writes past it are refused, so the header can never
+ * disagree with the bytes that follow. A payload that would not fit the 16
+ * bit packet_size refuses every write and Finish returns nullptr, callers
+ * with unbounded record lists split them over several packets.
+ */
+class PacketWriter {
+ public:
+  PacketWriter(PACKET packetId, std::size_t payloadSize)
+      : packet(PacketPool::instance().Acquire(
+            sPacketHeader + ClampPayload(payloadSize))),
+        wp(packet.get()),
+        end(packet.get() + sPacketHeader + ClampPayload(payloadSize)),
+        bIsOk(payloadSize <= kMaxPacketSize - sPacketHeader) {
+    util::WriteHeader(wp, packetId, sPacketHeader + ClampPayload(payloadSize));
+    if (!bIsOk)
+      std::cerr << "Packet " << packetId << " payload of " << payloadSize
+                << " bytes exceeds the packet size limit" << std::endl;
+  }
+
+  template <typename Layout, typename... Args>
+  bool Write(const Args&... args) {
+    return WriteImpl(static_cast<Layout*>(nullptr), args...);
+  }
+
+  template <PACKET Id, typename... Args>
+  bool WriteHeader(const Args&... args) {
+    return Write<typename PacketSchema<Id>::Header>(args...);
+  }
+
+  template <PACKET Id, typename... Args>
+  bool WriteRecord(const Args&... args) {
+    return Write<typename PacketSchema<Id>::Record>(args...);
+  }
+
+  // Raw cursor for payloads encoded elsewhere (nibble packed inputs)
+  inline uint8_t*& Cursor() { return wp; }
+  inline std::size_t GetRemaining() const {
+    return static_cast<std::size_t>(end - wp);
+  }
+
+  /**
+   * @brief Hands the packet over.
+   * @return nullptr if a write overflowed or the payload was left short.
+   */
+  PacketPtr Finish() {
+    if (!bIsOk || wp != end) {
+      std::cerr << "Packet written with a wrong size" << std::endl;
+      return nullptr;
+    }
+    return std::move(packet);
+  }
+
+ private:
+  template <typename... Fields, typename... Args>
+  bool WriteImpl(PacketFields<Fields...>*, const Args&... args) {
+    if (!bIsOk || GetRemaining() < PacketFields<Fields...>::SizeOf(args...)) {
+      bIsOk = false;
+      return false;
+    }
+    (FieldCodec<Fields>::Write(
+         wp, static_cast<typename FieldCodec<Fields>::Value>(args)),
+     ...);
+    return true;
+  }
+
+  // An oversized writer keeps an empty payload, it is never handed over
+  static std::size_t ClampPayload(std::size_t payloadSize) {
+    return payloadSize <= kMaxPacketSize - sPacketHeader ? payloadSize : 0;
+  }
+
+  PacketPtr packet;
+  uint8_t* wp;
+  uint8_t* end;
+  bool bIsOk = true;
+};
+
+/**
+ * @brief Payload size of a packet whose header and records are all fixed
+ * size.
+ */
+template <PACKET Id>
+constexpr std::size_t PayloadSize(std::size_t recordCount = 0) {
+  return PacketSchema<Id>::Header::kMinSize +
+         recordCount * PacketSchema<Id>::Record::kMinSize;
+}
+
+/**
+ * @brief Builds a packet that only has a header section.
+ */
+template <PACKET Id, typename... Args>
+PacketPtr MakePacket(const Args&... args) {
+  PacketWriter writer(Id, PacketSchema<Id>::Header::SizeOf(args...));
+  writer.template WriteHeader<Id>(args...);
+  return writer.Finish();
+}
+
+#endif /* CORE_PACKETSCHEMA_ */
@@ -0,0 +1,34 @@
+#ifndef CORE_PRODUCTIONMODEL_
+#define CORE_PRODUCTIONMODEL_
+
+// Game seconds between two settlements of a machine whose chunk left the view
+constexpr float kFrozenSettleInterval = 5.f;
+
+/**
+ * @brief What a machine did over an interval it was not ticked.
+ */
+struct ProductionProjection {
+  int completed = 0;      // Cycles finished, their output is due
+  int started = 0;        // Cycles begun, their inputs are due
+  bool bRunning = false;  // A cycle is underway at the end of the interval
+  float progress = 0.f;   // Seconds into that cycle
+};
+
+/**
+ * @brief Projects a machine repeating a fixed-length cycle, in closed form.
+ * @details Mirrors what the timers would have done: a cycle underway runs to
+ * completion, the next starts right after as long as the inputs and the
+ * output room allow. Nothing can be added or taken while the machine is off
+ * screen, so the number of cycles it can still start is known up front and
+ * the interval costs the same however long it was.
+ * @param bRunning Whether a cycle is underway, its inputs already paid.
+ * @param progress Seconds into that cycle.
+ * @param elapsed Seconds to project.
+ * @param cycleTime Seconds per cycle, positive.
+ * @param startable Further cycles the machine can start.
+ */
+ProductionProjection ProjectProduction(bool bRunning, float progress,
+                                       float elapsed, float cycleTime,
+                                       int startable);
+
+#endif /* CORE_PRODUCTIONMODEL_ */
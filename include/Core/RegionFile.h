@@ -0,0 +1,254 @@
+#ifndef CORE_REGIONFILE_
+#define CORE_REGIONFILE_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Components/ResourceNodeComponent.h"
+#include "Core/Chunk.h"
+#include "Core/ComponentReplicator.h"
+#include "Core/Item.h"
+#include "Core/Type.h"
+
+/**
+ * Region file layout (big endian)
+ * ---------------------------------
+ * char[4] :  magic "FGRG"
+ * uint16_t : version
+ * uint16_t : region_size     chunks per side, kRegionSize
+ *
+ * [kRegionSize * kRegionSize entries, row major by local chunk]
+ * uint32_t : first_sector    0 when the chunk was never saved
+ * uint32_t : byte_size
+ *
+ * [Padding up to the first sector after the table]
+ * [Payloads, each starting on a kRegionSectorSize boundary]
+ * ---------------------------------
+ * A rewritten payload stays in place when it still fits its sectors, and
+ * otherwise moves to the first free run, so the file only grows with the
+ * amount of live data.
+ */
+constexpr char kRegionMagic[4] = {'F', 'G', 'R', 'G'};
+constexpr uint16_t kRegionVersion = 3;
+constexpr int kRegionShift = 5;
+constexpr int kRegionSize = 1 << kRegionShift;
+constexpr int kRegionChunkCount = kRegionSize * kRegionSize;
+constexpr std::size_t kRegionSectorSize = 256;
+constexpr std::size_t sRegionFileHeader = sizeof(kRegionMagic) + 2 + 2;
+constexpr std::size_t sRegionTableEntry = 4 + 4;
+constexpr uint32_t kRegionHeaderSectors = static_cast<uint32_t>(
+    (sRegionFileHeader + kRegionChunkCount * sRegionTableEntry +
+     kRegionSectorSize - 1) /
+    kRegionSectorSize);
+
+/**
+ * World file layout (big endian), next to the region files
+ * ---------------------------------
+ * char[4] :  magic "FGWD"
+ * uint16_t : version
+ * uint64_t : world_seed
+ * uint64_t : game_time     TimerManager::GetTime at the last save, IEEE 754
+ * ---------------------------------
+ */
+constexpr char kWorldFileMagic[4] = {'F', 'G', 'W', 'D'};
+constexpr uint16_t kWorldFileVersion = 2;
+constexpr std::size_t sWorldFile = sizeof(kWorldFileMagic) + 2 + 8 + 8;
+
+/**
+ * @brief Everything a saved chunk restores.
+ * @details Payload layout (big endian):
+ * uint16_t : run_count, [uint16_t length, uint8_t tile_type] x run_count
+ * uint16_t : ore_count, [uint16_t index, uint8_t ore_type,
+ *                        uint32_t amount] x ore_count
+ * uint16_t : building_count, [uint8_t archetype, int32_t tile_x,
+ *                             int32_t tile_y, uint64_t settled_at,
+ *                             uint32_t progress, uint16_t state_size,
+ *                             uint8_t[state_size] state] x building_count
+ *
+ * Terrain is run length encoded like CHUNK_DATA, large patches make it the
+ * bulk of the savings. Building state is whatever ComponentReplicator writes
+ * for the entity, the same bytes clients receive. settled_at is the game
+ * time its production was settled up to (IEEE 754 bits), the rest is
+ * settled when the chunk is loaded again. progress is how many seconds into
+ * its cycle underway the building was (IEEE 754 bits), its timer is not
+ * saved.
+ */
+struct ChunkRecord {
+  struct Ore {
+    uint16_t index;
+    OreType type;
+    rsrc_amt_t amount;
+  };
+  struct Building {
+    ENetArchetype archetype;
+    // Top-left tile, the chunk holding it owns the building
+    Vec2 tileIndex;
+    std::vector<uint8_t> state;
+    double settledAt = 0.0;  // TimerManager::GetTime
+    float progress = 0.f;    // Seconds into the cycle underway
+  };
+
+  std::array<uint8_t, Chunk::kTileCount> types{};
+  std::vector<Ore> ores;
+  std::vector<Building> buildings;
+
+  void Encode(std::vector<uint8_t>& out) const;
+
+  /**
+   * @return False if the payload is truncated or holds invalid values.
+   */
+  bool Decode(const uint8_t* data, std::size_t size);
+};
+
+/**
+ * @brief Read-only memory map of a whole file.
+ */
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * @return False if the file is missing or empty.
+   */
+  bool Map(const std::string& path);
+  void Unmap();
+
+  inline bool IsMapped() const { return data != nullptr; }
+  inline const uint8_t* GetData() const { return data; }
+  inline std::size_t GetSize() const { return size; }
+
+ private:
+  const uint8_t* data = nullptr;
+  std::size_t size = 0;
+#ifdef _WIN32
+  void* fileHandle = nullptr;
+  void* mappingHandle = nullptr;
+#endif
+};
+
+/**
+ * @brief One region file, the chunks of a kRegionSize square.
+ * @details The offset table is kept in memory. Reads come straight out of a
+ * memory map of the file, writes go through a stream and drop the map, which
+ * is made again on the next read. Unloads come in bursts as a player walks,
+ * so a map survives all the reads between them.
+ */
+class RegionFile {
+ public:
+  ~RegionFile();
+
+  /**
+   * @brief Opens a region file, creating it if missing.
+   * @return False if the file cannot be created or is not a region file.
+   */
+  bool Open(const std::string& path);
+  void Close();
+
+  /**
+   * @param index Local chunk, (chunkY & (kRegionSize - 1)) * kRegionSize +
+   * (chunkX & (kRegionSize - 1)).
+   */
+  bool Contains(int index) const;
+
+  /**
+   * @brief Finds a saved payload.
+   * @param data Set to the payload inside the memory map, valid until the
+   * next Write or Close.
+   * @return False if the chunk was never saved or the file cannot be mapped.
+   */
+  bool Read(int index, const uint8_t*& data, std::size_t& size);
+
+  /**
+   * @brief Saves a payload, replacing the previous one of the chunk.
+   */
+  bool Write(int index, const std::vector<uint8_t>& payload);
+
+  /**
+   * @brief Sectors the file spans, header included.
+   */
+  inline uint32_t GetSectorCount() const {
+    return static_cast<uint32_t>(usedSectors.size());
+  }
+
+ private:
+  struct Entry {
+    uint32_t firstSector = 0;
+    uint32_t size = 0;
+  };
+
+  static uint32_t SectorsFor(std::size_t size);
+  uint32_t Allocate(uint32_t sectorCount);
+  void MarkSectors(const Entry& entry, bool bIsUsed);
+  void WriteEntry(int index);
+
+  std::string path;
+  std::fstream file;
+  MappedFile mapping;
+  std::array<Entry, kRegionChunkCount> entries{};
+  std::vector<bool> usedSectors;
+};
+
+/**
+ * @brief Directory of region files making up a saved world.
+ * @details Region files are opened on first use and stay open. Players only
+ * ever stand in a handful of regions, each costs a file handle and its
+ * 8 KB table.
+ */
+class RegionStore {
+ public:
+  /**
+   * @brief Reads the seed of a saved world.
+   * @return False if the directory holds no saved world.
+   */
+  static bool ReadSeed(const std::string& directory, uint64_t& seed);
+
+  /**
+   * @brief Uses a directory for the world with the given seed, creating it
+   * if needed.
+   * @return False if it cannot be created or belongs to another seed.
+   */
+  bool Open(const std::string& directory, uint64_t seed);
+
+  /**
+   * @brief Game time of the last SaveGameTime, 0 for a new save.
+   */
+  inline double GetGameTime() const { return gameTime; }
+
+  /**
+   * @brief Records the game time in the world file, buildings in the save
+   * were settled against that clock.
+   */
+  bool SaveGameTime(double time);
+
+  bool Contains(ChunkCoord coord);
+
+  /**
+   * @brief Finds a saved chunk, see RegionFile::Read.
+   */
+  bool Load(ChunkCoord coord, const uint8_t*& data, std::size_t& size);
+  bool Save(ChunkCoord coord, const std::vector<uint8_t>& payload);
+
+ private:
+  // nullptr if the region has no file and bCreate is false
+  RegionFile* GetRegion(ChunkCoord coord, bool bCreate);
+
+  bool WriteWorldFile(const std::string& path) const;
+
+  std::string directory;
+  uint64_t seed = 0;
+  double gameTime = 0.0;
+  // PackChunkKey of the region coordinate
+  std::unordered_map<uint64_t, std::unique_ptr<RegionFile>> regions;
+};
+
+#endif /* CORE_REGIONFILE_ */
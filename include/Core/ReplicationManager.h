@@ -0,0 +1,165 @@
+#ifndef CORE_REPLICATIONMANAGER_
+#define CORE_REPLICATIONMANAGER_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Components/NetIdentityComponent.h"
+#include "Core/ComponentReplicator.h"
+#include "Core/Entity.h"
+#include "Core/Packet.h"
+#include "Core/Type.h"
+
+class Registry;
+
+// Per-client replication budget. Leaves headroom under a 1 Mbit/s link for
+// transform snapshots, move acks and chat.
+constexpr float kReplicationBytesPerSecond = 80.f * 1024.f;  // ~0.66 Mbit/s
+constexpr float kReplicationBurstBytes = 8.f * 1024.f;
+// Must fit the 1024 byte receive buffers on both ends
+constexpr std::size_t kMaxReplicationPacketSize = 1000;
+// Despawns remembered for resuming clients. A client further behind gets
+// a full resync.
+constexpr std::size_t kMaxTombstones = 4096;
+// A drained stream announces its version at most this often
+constexpr float kReplicationSyncInterval = 0.25f;
+
+/**
+ * @brief Server side bookkeeping for component replication.
+ * @details Keeps the netID <-> EntityID mapping of every replicated entity and
+ * one outgoing stream per client made of two parts:
+ * - a FIFO of spawn/despawn operations that is always delivered, in order;
+ * - a coalesced set of dirty (netID, component mask) pairs. Repeated changes
+ *   of the same entity collapse into one entry, and the value is read from the
+ *   registry only when the entry is actually sent, so a client always gets the
+ *   latest state no matter how far behind its budget is.
+ * Each client drains its stream through a token bucket of
+ * kReplicationBytesPerSecond, spawns first.
+ *
+ * Every change bumps a version. Once a stream is drained the client is told
+ * the version it has caught up to, so after a reconnect only the changes
+ * made since then are queued again.
+ */
+class ReplicationManager {
+ public:
+  explicit ReplicationManager(Registry* registry);
+  ~ReplicationManager();
+
+  /**
+   * @brief Assigns a netID to a freshly created entity and queues its spawn
+   * for every client.
+   * @param entity The server-side entity.
+   * @param archetype What the client should construct.
+   * @param tileIndex Top-left tile the entity was placed at.
+   * @return The assigned netID.
+   */
+  netid_t RegisterEntity(EntityID entity, ENetArchetype archetype,
+                         Vec2 tileIndex);
+
+  /**
+   * @brief Forgets a destroyed entity and queues its despawn.
+   * @details Clients that have not received the spawn yet just drop it.
+   * World-generated entities are forgotten without a despawn.
+   */
+  void UnregisterEntity(EntityID entity);
+
+  EntityID GetEntity(netid_t netID) const;
+
+  /**
+   * @brief Starts a stream for a new client containing every live replicated
+   * entity plus any world-generated entity that has diverged from worldgen.
+   */
+  void AddClient(clientid_t clientID);
+  void RemoveClient(clientid_t clientID);
+
+  /**
+   * @brief Restarts the stream of a reconnecting client from the version it
+   * reported.
+   * @details Queues spawns of entities created since, despawns of entities
+   * destroyed since and the components that changed since.
+   * @return False if despawns that old were already forgotten. The stream
+   * then holds everything like AddClient, and the client has to drop its
+   * replicas first.
+   */
+  bool ResumeClient(clientid_t clientID, uint32_t knownVersion);
+
+  inline uint32_t GetVersion() const { return version; }
+
+  /**
+   * @brief Limits updates of world-generated entities to clients that hold
+   * the tile's chunk.
+   * @details Their state otherwise reaches the client with the chunk itself
+   * when it is streamed. Without a filter every client gets them.
+   */
+  void SetStaticFilter(std::function<bool(clientid_t, Vec2)> filter);
+
+  /**
+   * @brief Moves ReplicationDirtyTags from the registry into every client
+   * stream.
+   */
+  void CollectDirty();
+
+  /**
+   * @brief Emits as many packets as the client's budget allows.
+   * @param clientID Receiving client.
+   * @param deltaTime Time since the last flush, refills the budget.
+   * @param outPackets Complete packets ready for Unicast.
+   */
+  void Flush(clientid_t clientID, float deltaTime,
+             std::vector<PacketPtr>& outPackets);
+
+ private:
+  struct Replica {
+    EntityID entity;
+    ENetArchetype archetype;
+    Vec2 tileIndex;
+    uint32_t spawnVersion = 0;
+    std::array<uint32_t, 8> componentVersion{};  // per component mask bit
+  };
+
+  struct Tombstone {
+    netid_t netID;
+    uint32_t spawnVersion;
+    uint32_t version;
+  };
+
+  struct ReliableOp {
+    PACKET type;  // ENTITY_SPAWN or ENTITY_DESPAWN
+    netid_t netID;
+  };
+
+  struct ClientStream {
+    std::deque<ReliableOp> reliable;
+    std::unordered_set<netid_t> unspawned;
+    std::deque<netid_t> dirtyOrder;
+    std::unordered_map<netid_t, uint8_t> dirtyMask;
+    float budget = kReplicationBurstBytes;
+    uint32_t syncedVersion = 0;  // last REPLICATION_SYNC
+    float syncTimer = 0.f;
+  };
+
+  void QueueSpawn(ClientStream& stream, netid_t netID);
+  void QueueDirty(ClientStream& stream, netid_t netID, uint8_t mask);
+  void QueueEverything(ClientStream& stream);
+  std::size_t WriteReliable(ClientStream& stream, uint8_t* buffer);
+  std::size_t WriteUpdates(clientid_t clientID, ClientStream& stream,
+                           uint8_t* buffer);
+
+  Registry* registry;
+  netid_t nextNetID = 1;
+  std::unordered_map<netid_t, Replica> replicas;
+  std::unordered_map<EntityID, netid_t> entityToNet;
+  std::unordered_map<clientid_t, ClientStream> clients;
+  uint32_t version = 0;
+  std::deque<Tombstone> tombstones;
+  uint32_t forgottenVersion = 0;  // newest tombstone dropped
+  std::function<bool(clientid_t, Vec2)> staticFilter;
+};
+
+#endif /* CORE_REPLICATIONMANAGER_ */
@@ -0,0 +1,51 @@
+#ifndef CORE_SNAPSHOTCLOCK_
+#define CORE_SNAPSHOTCLOCK_
+
+#include <cstdint>
+
+#include "Core/Packet.h"
+
+/**
+ * @brief Maps server snapshot ticks onto the local clock and picks how far
+ * behind them remote entities are drawn.
+ * @details Each snapshot gives one sample of local arrival time minus server
+ * time, which is the clock difference plus that packet's delay. The earliest
+ * arrivals mark the baseline offset, how late the others come is the jitter.
+ * The interpolation delay covers one snapshot interval, measured from the
+ * tick gaps since the server may send slower than syncRate, plus a multiple
+ * of the jitter, so bunched TCP deliveries are absorbed instead of shown.
+ */
+class SnapshotClock {
+ public:
+  static constexpr double kMinDelay = 0.05;
+  static constexpr double kMaxDelay = 0.30;
+  static constexpr double kInitialDelay = 0.10;
+
+  /**
+   * @brief Adds the arrival of a snapshot. A tick far behind the newest one
+   * starts the estimate over, the server was restarted.
+   */
+  void OnSnapshot(uint32_t serverTick, double localTime);
+
+  /**
+   * @brief Server tick drawn at localTime, fractional between snapshots.
+   * @return 0 before the first snapshot.
+   */
+  double GetRenderTick(double localTime) const;
+
+  inline bool IsSynced() const { return bIsSynced; }
+  inline double GetOffset() const { return offset; }
+  inline double GetJitter() const { return jitter; }
+  inline double GetInterval() const { return interval; }
+  inline double GetDelay() const { return delay; }
+
+ private:
+  double offset = 0.0;  // local time minus server time, least delayed packets
+  double jitter = 0.0;  // mean lateness behind offset
+  double interval = syncDelta;  // mean server time between snapshots
+  double delay = kInitialDelay;
+  uint32_t newestTick = 0;
+  bool bIsSynced = false;
+};
+
+#endif /* CORE_SNAPSHOTCLOCK_ */
@@ -0,0 +1,93 @@
+#ifndef CORE_SNAPSHOTSCHEDULER_
+#define CORE_SNAPSHOTSCHEDULER_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Packet.h"
+#include "Core/Type.h"
+
+/**
+ * @brief Decides which players go into each client's next snapshot.
+ * @details The server captures positions every network tick, but each
+ * client is only sent a snapshot once per send window, and only as many
+ * records as its byte budget allows. Every visible player builds up priority
+ * each tick, faster when it is near the receiver or moved since it was last
+ * sent. A snapshot takes the players with the highest priority and resets
+ * them, so under a tight budget far and idle players are refreshed less
+ * often instead of every client dropping to a lower rate.
+ */
+class SnapshotScheduler {
+ public:
+  struct Subject {
+    clientid_t id;
+    Vec2f position;
+  };
+
+  struct ClientBudget {
+    float sendRate = syncRate;  // snapshots per second
+    std::size_t bytesPerSecond = 16 * 1024;
+  };
+
+  /**
+   * @param serverBytesPerSecond Shared by all clients, each one's budget is
+   * capped to an equal share of it.
+   */
+  explicit SnapshotScheduler(std::size_t serverBytesPerSecond = 1024 * 1024);
+
+  void AddClient(clientid_t client);
+  void AddClient(clientid_t client, ClientBudget budget);
+  void RemoveClient(clientid_t client);
+
+  /**
+   * @brief Adds one network tick of priority to the players a client sees.
+   * @details Players missing from visible are forgotten, a player entering
+   * again is sent as soon as possible. The client's own player should be left
+   * out, its position comes back through CLIENT_MOVE_RES.
+   */
+  void Accumulate(clientid_t client, Vec2f observerPos,
+                  const std::vector<Subject>& visible, float deltaTime);
+
+  /**
+   * @brief Advances the client's send window.
+   * @return True when a snapshot is due.
+   */
+  bool IsSendDue(clientid_t client, float deltaTime);
+
+  /**
+   * @brief Picks the players for a snapshot and resets their priority.
+   * @param headerBytes Packet size without records.
+   * @param recordBytes Size of one player record.
+   * @param out Filled with the chosen players, highest priority first.
+   */
+  void Select(clientid_t client, std::size_t headerBytes,
+              std::size_t recordBytes, std::vector<Subject>& out);
+
+  /**
+   * @brief Bytes one snapshot of the client may use.
+   */
+  std::size_t GetWindowBudget(clientid_t client) const;
+
+ private:
+  struct Entry {
+    Vec2f position;
+    Vec2f lastSent;
+    float priority = 0.f;
+    bool bWasSent = false;
+    bool bIsVisible = false;
+  };
+
+  struct ClientState {
+    ClientBudget budget;
+    float sendTimer = 0.f;
+    std::unordered_map<clientid_t, Entry> entries;
+  };
+
+  std::size_t serverBytesPerSecond;
+  std::unordered_map<clientid_t, ClientState> clients;
+  std::vector<std::pair<float, clientid_t>> scratch;
+};
+
+#endif /* CORE_SNAPSHOTSCHEDULER_ */
@@ -8,6 +8,21 @@
 
 class SocketImpl;
 
+/**
+ * @brief Tuning knobs for the client connection.
+ */
+struct SocketOptions {
+  // Disable Nagle so small gameplay packets leave right away
+  bool bNoDelay = true;
+  // Kernel send buffer in bytes, 0 keeps the OS default
+  int sendBufferSize = 0;
+  // Per address limit for the TCP handshake
+  int connectTimeoutMs = 3000;
+  // Outbound bytes queued while the server is slow to read. Overflowing it
+  // drops the connection instead of stalling the game.
+  std::size_t sendRingSize = 1 << 20;
+};
+
 /**
  * @brief Manages the client-side network communication.
  * @details This class provides a high-level interface for client socket
@@ -25,10 +40,37 @@ public:
     Socket(Socket&&) noexcept;
     Socket& operator=(Socket&&) noexcept;
 
-    bool Init();
+    bool Init(const SocketOptions& options = SocketOptions{});
     uint64_t Connect(std::string ip, int port);
+
+    /**
+     * @brief Queues bytes for the I/O thread, never waits for the network.
+     * @return size, or a negative value if the connection is closed or the
+     * send ring overflowed.
+     */
     int Send(uint8_t* buffer, std::size_t size);
+
+    /**
+     * @brief Waits for stream bytes from the server.
+     * @return Bytes received, 0 if the server closed the connection,
+     * negative on error.
+     */
     int Receive(uint8_t* buffer, std::size_t size);
+
+    // Bytes queued by Send that have not reached the kernel yet
+    std::size_t GetPendingSendBytes();
+
+    /**
+     * @brief Sends one datagram to the server over UDP.
+     * @return Bytes sent, or a negative value if UDP is unavailable.
+     */
+    int SendDatagram(const uint8_t* buffer, std::size_t size);
+
+    /**
+     * @brief Waits briefly for one datagram from the server.
+     * @return Bytes received, 0 on timeout, negative if UDP is unavailable.
+     */
+    int ReceiveDatagram(uint8_t* buffer, std::size_t size);
     void Close();
 
 
@@ -5,6 +5,8 @@
 #include <cstddef>
 #include <cstdint>
 
+struct SocketOptions;
+
 /**
  * @brief Interface for the socket implementation.
  * @details Defines the contract for platform-specific socket implementations.
@@ -14,10 +16,13 @@
 class SocketImpl {
 public:
     virtual ~SocketImpl() = default;
-    virtual bool Init() = 0;
+    virtual bool Init(const SocketOptions& options) = 0;
     virtual uint64_t Connect(std::string ip, int port) = 0;
     virtual int Send(uint8_t* buffer, std::size_t size) = 0;
     virtual int Receive(uint8_t* buffer, std::size_t size) = 0;
+    virtual int SendDatagram(const uint8_t* buffer, std::size_t size) = 0;
+    virtual int ReceiveDatagram(uint8_t* buffer, std::size_t size) = 0;
+    virtual std::size_t GetPendingSendBytes() = 0;
     virtual void Close() = 0;
 };
 
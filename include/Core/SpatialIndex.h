@@ -0,0 +1,139 @@
+#ifndef CORE_SPATIALINDEX_
+#define CORE_SPATIALINDEX_
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Chunk.h"
+#include "Core/Entity.h"
+#include "Core/TileData.h"
+#include "Core/Type.h"
+
+// One cell per chunk, in world pixels
+constexpr float kSpatialCellSize = CHUNK_WIDTH * TILE_PIXEL_SIZE;
+
+/**
+ * @brief Entities bucketed by the cell their position falls in.
+ * @details A loose grid: an entity is filed under the cell of its position
+ * only, whatever the size of its sprite, so moving it is a write in place
+ * until it crosses a cell border, then a swap-and-pop out of one cell list
+ * and a push into another. Queries only visit the cells overlapping the
+ * area. Callers looking for entities that merely overlap an area pad it by
+ * the largest extent they care about.
+ *
+ * Positions are copied into the cell lists, a query reads contiguous
+ * entries without touching the registry.
+ */
+class SpatialIndex {
+ public:
+  explicit SpatialIndex(float cellSize = kSpatialCellSize);
+
+  /**
+   * @brief Inserts an entity or moves it to a new position.
+   * @param position World position (in pixels).
+   */
+  void Update(EntityID entity, Vec2f position);
+  void Remove(EntityID entity);
+  void Clear();
+
+  /**
+   * @brief Appends the entities inside [min, max], borders included.
+   */
+  void QueryRect(Vec2f min, Vec2f max, std::vector<EntityID>& out) const;
+
+  /**
+   * @brief Appends the entities at most radius away from center.
+   */
+  void QueryRadius(Vec2f center, float radius,
+                   std::vector<EntityID>& out) const;
+
+  /**
+   * @brief Finds the closest entity accepted by a filter.
+   * @param accept Called as accept(entity), cells are searched in rings of
+   * growing distance until no closer entity can be found. The search costs
+   * a hash lookup per cell within maxRadius at worst, keep it local.
+   * @return INVALID_ENTITY if none lies within maxRadius.
+   */
+  template <typename Accept>
+  EntityID Nearest(Vec2f center, float maxRadius, Accept&& accept) const {
+    if (locations.empty()) return INVALID_ENTITY;
+    const ChunkCoord origin = CellOf(center);
+    const int maxRing = static_cast<int>(std::ceil(maxRadius / cellSize));
+    EntityID best = INVALID_ENTITY;
+    float bestDistSq = maxRadius * maxRadius;
+
+    for (int ring = 0; ring <= maxRing; ++ring) {
+      // Anything in this ring or beyond is at least ring - 1 cells away
+      const float ringDist = (ring - 1) * cellSize;
+      if (ring > 1 && ringDist * ringDist > bestDistSq) break;
+      ForEachRingCell(origin, ring, [&](const std::vector<Entry>& cell) {
+        for (const Entry& entry : cell) {
+          const float dx = entry.position.x - center.x;
+          const float dy = entry.position.y - center.y;
+          const float distSq = dx * dx + dy * dy;
+          // Ties keep the first found, the radius itself is included
+          const bool bCloser = best == INVALID_ENTITY ? distSq <= bestDistSq
+                                                      : distSq < bestDistSq;
+          if (bCloser && accept(entry.entity)) {
+            best = entry.entity;
+            bestDistSq = distSq;
+          }
+        }
+      });
+    }
+    return best;
+  }
+
+  EntityID Nearest(Vec2f center, float maxRadius) const {
+    return Nearest(center, maxRadius, [](EntityID) { return true; });
+  }
+
+  inline bool Contains(EntityID entity) const {
+    return locations.count(entity) > 0;
+  }
+  inline std::size_t GetSize() const { return locations.size(); }
+  inline std::size_t GetCellCount() const { return cells.size(); }
+
+ private:
+  struct Entry {
+    EntityID entity;
+    Vec2f position;
+  };
+  struct Location {
+    uint64_t cell;
+    std::size_t slot;
+  };
+
+  inline ChunkCoord CellOf(Vec2f position) const {
+    return {static_cast<int>(std::floor(position.x / cellSize)),
+            static_cast<int>(std::floor(position.y / cellSize))};
+  }
+
+  // Calls fn(cell) for the non-empty cells on the square ring of Chebyshev
+  // distance ring around origin
+  template <typename Fn>
+  void ForEachRingCell(ChunkCoord origin, int ring, Fn&& fn) const {
+    for (int y = origin.y - ring; y <= origin.y + ring; ++y) {
+      const bool bEdgeRow = y == origin.y - ring || y == origin.y + ring;
+      const int step = bEdgeRow || ring == 0 ? 1 : 2 * ring;
+      for (int x = origin.x - ring; x <= origin.x + ring; x += step) {
+        auto it = cells.find(PackChunkKey(x, y));
+        if (it != cells.end()) fn(it->second);
+      }
+    }
+  }
+
+  // Calls fn(cell) for the non-empty cells overlapping [min, max]
+  template <typename Fn>
+  void ForEachCell(Vec2f min, Vec2f max, Fn&& fn) const;
+
+  void RemoveFromCell(const Location& location);
+
+  float cellSize;
+  std::unordered_map<uint64_t, std::vector<Entry>> cells;
+  std::unordered_map<EntityID, Location> locations;
+};
+
+#endif /* CORE_SPATIALINDEX_ */
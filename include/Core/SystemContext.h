@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 // Forward declarations
 class AssetManager;
@@ -41,6 +42,7 @@ struct SystemContext {
   ThreadSafeQueue<SendRequest>* serverSendQueue = nullptr; // For server outgoing packets (needs SendRequest)
   ThreadSafeQueue<PacketPtr>* clientRecvQueue = nullptr;   // For client outgoing packets (only needs PacketPtr)
   ThreadSafeQueue<PacketPtr>* clientSendQueue = nullptr;   // For client outgoing packets (only needs PacketPtr)
+  ThreadSafeQueue<std::vector<uint8_t>>* clientDatagramQueue = nullptr; // Raw datagrams received over UDP
   ThreadSafeQueue<MoveApplied>* pendingMoves = nullptr;
   std::unordered_map<clientid_t, std::string>* clientNameMap = nullptr;
   Server* server = nullptr;
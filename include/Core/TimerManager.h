@@ -39,6 +39,22 @@ class TimerManager {
    */
   void DestroyTimer(TimerHandle handle);
 
+  /**
+   * @brief Moves the game clock forward, called once per frame by
+   * TimerSystem.
+   */
+  inline void Advance(float deltaTime) { time += deltaTime; }
+
+  /**
+   * @brief Game seconds since the world was created.
+   */
+  inline double GetTime() const { return time; }
+
+  /**
+   * @brief Resumes the clock of a saved world, before the first update.
+   */
+  inline void SetTime(double savedTime) { time = savedTime; }
+
  private:
   // The pool that owns all the TimerInstance objects.
   ObjectPool<TimerInstance> timerPool;
@@ -61,6 +77,8 @@ class TimerManager {
    * 
    */
   TimerHandle nextHandle;
+
+  double time = 0.0;
 };
 
 #endif /* CORE_TIMERMANAGER_ */
@@ -0,0 +1,101 @@
+#ifndef CORE_TRANSFORMHISTORY_
+#define CORE_TRANSFORMHISTORY_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Entity.h"
+#include "Core/Type.h"
+
+/**
+ * @brief Player positions over the last kCapacity network ticks, for
+ * rewinding to what a client was looking at.
+ * @details Remote players are drawn an interpolation delay behind the
+ * newest snapshot, so a client aims at where things were, not where they
+ * are. Every network tick is stored here and validation reads the world
+ * back at the server tick the client reports.
+ *
+ * Storage is structure of arrays: one column per field, each entity owning
+ * a fixed block of kCapacity cells indexed by tick slot. A rewind is a binary
+ * search over the shared tick ring plus two reads per column, with no
+ * allocation after an entity's first snapshot.
+ */
+class TransformHistory {
+ public:
+  // About one second of network ticks at tickRate
+  static constexpr std::size_t kCapacity = 64;
+  // Half a second at tickRate: the longest interpolation delay a client
+  // keeps (SnapshotClock::kMaxDelay) plus the trip of its request
+  static constexpr uint32_t kMaxRewindTicks = 30;
+
+  /**
+   * @brief Starts storing the snapshot of a new server tick.
+   * @param tick Must be greater than the previous snapshot tick.
+   */
+  void BeginSnapshot(uint32_t tick);
+
+  /**
+   * @brief Stores an entity position for the current snapshot tick.
+   */
+  void Store(EntityID entity, Vec2f position);
+
+  /**
+   * @brief Drops the history of an entity that no longer exists.
+   */
+  void Remove(EntityID entity);
+
+  /**
+   * @brief Position of an entity as seen at a server tick.
+   * @details Interpolated between the snapshots around the tick. Ticks older
+   * than the history are clamped to the oldest snapshot, newer ones to the
+   * newest.
+   * @return Empty if the entity is in neither snapshot around the tick.
+   */
+  std::optional<Vec2f> Sample(EntityID entity, uint32_t tick) const;
+
+  /**
+   * @brief Checks an interaction with the player and the target both
+   * rewound to the same view tick.
+   * @details viewTick is what the client claims to have been looking at, so
+   * it is clamped to at most kMaxRewindTicks behind the newest snapshot
+   * rather than trusted to pick any sample in the history. Entities without
+   * history, such as buildings, are taken at the given current position.
+   */
+  bool IsWithinReach(EntityID player, Vec2f playerPos, EntityID target,
+                     Vec2f targetPos, uint32_t viewTick,
+                     float maxDistance) const;
+
+  inline std::size_t GetSnapshotCount() const { return snapshotCount; }
+  inline uint32_t GetNewestTick() const { return newestTick; }
+
+ private:
+  // Slot not assigned yet, or cell never written
+  static constexpr uint32_t kUnset = UINT32_MAX;
+
+  // Ring position of the i-th oldest stored snapshot
+  inline std::size_t RingIndex(std::size_t i) const {
+    return (newestIndex + kCapacity + 1 - snapshotCount + i) % kCapacity;
+  }
+
+  std::optional<Vec2f> ReadCell(uint32_t slot, std::size_t ringIndex) const;
+
+  // Shared tick ring
+  std::array<uint32_t, kCapacity> ticks{};
+  std::size_t newestIndex = kCapacity - 1;
+  std::size_t snapshotCount = 0;
+  uint32_t newestTick = 0;
+
+  // Per entity columns, kCapacity cells per slot
+  std::vector<float> posX;
+  std::vector<float> posY;
+  std::vector<uint32_t> cellTick;  // tick the cell was written for
+
+  std::unordered_map<EntityID, uint32_t> slots;
+  std::vector<uint32_t> freeSlots;
+};
+
+#endif /* CORE_TRANSFORMHISTORY_ */
@@ -2,42 +2,62 @@
 #define CORE_WORLD_
 
 #include <cassert>
+#include <cstdint>
+#include <list>
 #include <map>
-#include <random>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "Components/ResourceNodeComponent.h"
 #include "Core/Chunk.h"
+#include "Core/ChunkCache.h"
+#include "Core/ChunkMap.h"
+#include "Core/ChunkPipeline.h"
 #include "Core/Entity.h"
 #include "Core/Packet.h"
+#include "Core/SpatialIndex.h"
 #include "Core/TileData.h"
 #include "Core/Type.h"
 #include "SDL_ttf.h"
 
+class PacketReader;
 class Registry;
 class WorldAssetManager;
 class EventDispatcher;
 class EntityFactory;
-
-// TODO : asyncronized chunk generation : threads, iocp whatever
-
-/**
- * @brief ChunkCoordinate operator for RB-tree comparison
- *
- */
-struct ChunkCoord {
-  int x, y;
-  bool operator<(const ChunkCoord& other) const {
-    if (y < other.y) return true;
-    if (y > other.y) return false;
-    return x < other.x;
-  }
-};
+class EventHandle;
+class RegionStore;
+class TimerManager;
+struct ChunkRecord;
 
 /**
  * @brief Manages the game world, including chunk loading and tile data.
  * @details Handles the procedural generation of the world, loading and
  * unloading of chunks based on player proximity, and provides an interface for
  *          querying tile data and managing building placement.
+ *
+ * Only the server generates chunks, around every player. Terrain is computed
+ * by a ChunkPipeline on worker threads, Update only creates the entities and
+ * textures of finished chunks, nearest first and within kChunkCommitBudget per
+ * frame. Clients build theirs from the CHUNK_DATA the server streams and
+ * unload them on CHUNK_UNLOAD.
+ *
+ * Unloaded chunks stay live in a ChunkCache, deactivated, until it goes over
+ * its memory budget. The oldest are then serialized with their ore and the
+ * buildings they own, and their entities destroyed. Machines on unloaded
+ * chunks keep producing: cached ones are settled at a coarse interval, and
+ * serialized ones carry the game time they were settled up to and the
+ * progress of their cycle, and catch up when loaded again, see
+ * FrozenComponent. The server writes serialized chunks to region files when
+ * a save is opened, otherwise they are kept in the cache as blobs. Blobs
+ * past their own budget are written out on the server and dropped on
+ * clients, which are streamed them again. Chunks found in the save are read
+ * back instead of generated.
+ *
+ * Every entity with a TransformComponent is kept in a SpatialIndex for
+ * position queries, brought up to date by SyncEntityIndex.
  */
 class World {
   TTF_Font* font;
@@ -45,29 +65,79 @@ class World {
   WorldAssetManager* worldAssetManager;
   EventDispatcher* eventDispatcher;
   EntityFactory* factory;
+  TimerManager* timerManager;
   EntityID localPlayer;
   bool bIsServer;
 
  public:
+  /**
+   * @param seed World seed, only used by the server to generate chunks.
+   */
   World(Registry* registry, WorldAssetManager* worldAssetManager,
         EntityFactory* factory, EventDispatcher* eventDispatcher,
-        TTF_Font* font, bool IsServer);
+        TimerManager* timerManager, TTF_Font* font, bool IsServer,
+        uint64_t seed = kDefaultWorldSeed);
   ~World();
 
   /**
-   * @brief Updates the world state, loading/unloading chunks around the player.
-   * @param player The player entity, used to determine which chunks should be
-   * active.
+   * @brief Requests the chunks around every player, commits the generated
+   * ones and unloads the ones no player is near. Does nothing on a client.
    */
   void Update();
 
+  /**
+   * @brief Files the entities whose TransformComponent is dirty under their
+   * new position. Call once per frame after the systems that move entities.
+   */
+  void SyncEntityIndex();
+
+  /**
+   * @brief Entities by position, as of the last SyncEntityIndex. Destroyed
+   * entities are dropped right away.
+   */
+  inline const SpatialIndex& GetEntityIndex() const { return entityIndex; }
+
+  /**
+   * @brief Serializes a loaded chunk with the current amount of its ore.
+   * @return CHUNK_DATA, or nullptr if the chunk is not loaded.
+   */
+  PacketPtr EncodeChunk(ChunkCoord coord);
+
+  /**
+   * @brief Loads a chunk from CHUNK_DATA, or refreshes it if the client
+   * already holds it.
+   * @return False if the packet is malformed.
+   */
+  bool ApplyChunkData(PacketReader& reader);
+
+  /**
+   * @brief Uses a save directory for the chunks the server unloads, see
+   * RegionStore::Open. The game clock resumes from the save, so call it
+   * before the first update. Does nothing on a client.
+   * @return False if the directory cannot be used, chunks then stay in
+   * memory once loaded.
+   */
+  bool OpenSave(const std::string& directory);
+
+  /**
+   * @brief Writes every loaded and cached chunk and the game clock to the
+   * save, keeping them.
+   */
+  void SaveAll();
+
+  /**
+   * @brief Deactivates a chunk the server stopped streaming. Buildings on it
+   * keep their tiles until the chunk comes back or is evicted from the cache.
+   */
+  void DropChunk(ChunkCoord coord);
+
   /**
    * @brief Gets the tile data at a specific world position.
    * @param position The world coordinates (in pixels).
-   * @return A pointer to the TileData, or nullptr if the chunk is not loaded.
+   * @return The tile, false if its chunk is not loaded.
    */
-  TileData* GetTileAtWorldPosition(Vec2f position);
-  TileData* GetTileAtWorldPosition(float worldX, float worldY);
+  TileRef GetTileAtWorldPosition(Vec2f position);
+  TileRef GetTileAtWorldPosition(float worldX, float worldY);
 
   /**
    * @brief Converts world coordinates to tile grid indices.
@@ -77,23 +147,41 @@ class World {
   Vec2 GetTileIndexFromWorldPosition(Vec2f position) const;
   Vec2 GetTileIndexFromWorldPosition(float worldX, float worldY) const;
 
+  /**
+   * @brief Converts world coordinates to the coordinate of the owning chunk.
+   * @param position The world coordinates (in pixels).
+   * @return The chunk coordinate containing the position.
+   */
+  static ChunkCoord GetChunkCoordFromWorldPosition(Vec2f position);
+
   /**
    * @brief Gets the tile data at a specific tile grid index.
    * @param tileIndex The tile coordinates.
-   * @return A pointer to the TileData, or nullptr if the chunk is not loaded.
+   * @return The tile, false if its chunk is not loaded.
+   */
+  TileRef GetTileAtTileIndex(Vec2 tileIndex);
+  TileRef GetTileAtTileIndex(int tileX, int tileY);
+
+  /**
+   * @brief Gets a loaded chunk.
+   * @return nullptr if the chunk is not active. Stays valid until the chunk
+   * is unloaded.
    */
-  TileData* GetTileAtTileIndex(Vec2 tileIndex);
-  TileData* GetTileAtTileIndex(int tileX, int tileY);
+  Chunk* GetActiveChunk(int chunkX, int chunkY);
 
   /**
    * @brief Checks if a building can be placed at a given location.
    * @param tileIndex The top-left tile index for the building.
    * @param width The width of the building in tiles.
    * @param height The height of the building in tiles.
+   * @param builder Player placing the building, the tile it stands on is
+   * refused. INVALID_ENTITY if no player is placing it.
    * @return True if the area is clear and buildable, false otherwise.
    */
-  bool HasNoOcuupyingEntity(Vec2 tileIndex, int width, int height);
-  bool HasNoOcuupyingEntity(int tileX, int tileY, int width, int height);
+  bool HasNoOcuupyingEntity(Vec2 tileIndex, int width, int height,
+                            EntityID builder);
+  bool HasNoOcuupyingEntity(int tileX, int tileY, int width, int height,
+                            EntityID builder);
 
   /**
    * @brief Marks tiles as occupied by a building.
@@ -131,28 +219,66 @@ class World {
     return INVALID_ENTITY;
   }
 
-  inline const std::map<ChunkCoord, Chunk>& GetActiveChunks() const {
-    return activeChunks;
-  }
+  inline const ChunkMap& GetActiveChunks() const { return activeChunks; }
   inline rsrc_amt_t GetMinironOreAmount() const { return minironOreAmount; }
   inline rsrc_amt_t GetMaxironOreAmount() const { return maxironOreAmount; }
+
+  /**
+   * @brief Picks the iron ore spritesheet row matching the remaining amount.
+   * @param amount Resource left in the node.
+   * @return Row index, 0 being the richest.
+   */
+  int GetOreRichnessIndex(rsrc_amt_t amount) const;
   inline int GetViewDistance() const { return viewDistance; }
+  inline uint64_t GetSeed() const { return seed; }
+  inline const ChunkCacheStats& GetChunkCacheStats() const {
+    return chunkCache.GetStats();
+  }
 
  private:
-  void LoadChunk(int chunkX, int chunkY);
-  void GenerateChunk(Chunk& chunk);
+  // Squared chunk distance to the nearest player
+  int GetPlayerDistanceSq(ChunkCoord coord) const;
+  void CommitGeneratedChunks();
+  void CommitChunk(GeneratedChunk& generated);
   void UnloadChunk(Chunk& chunk);
+  // Reactivates a cached chunk or loads a saved one, nullptr if it was never
+  // loaded
+  Chunk* RestoreChunk(ChunkCoord coord);
+  // Serializes a cached chunk and destroys its entities
+  void EvictChunk(Chunk& chunk);
+  // outBuildings receives the buildings the chunk owns, server only
+  void RecordChunk(const Chunk& chunk, ChunkRecord& record,
+                   std::vector<EntityID>& outBuildings);
+  Chunk* LoadSavedChunk(ChunkCoord coord);
+  Chunk* LoadChunkRecord(ChunkCoord coord, const uint8_t* data,
+                         std::size_t size);
+  void RestoreBuilding(const ChunkRecord& record, std::size_t index);
+  // Re-marks the tiles of neighbouring buildings that reach into a chunk
+  void OccupyOverlappingBuildings(const Chunk& chunk);
+  EntityID CreateOreNode(Chunk& chunk, int localX, int localY, OreType ore,
+                         rsrc_amt_t amount);
+  void CreateChunkEntity(Chunk& chunk);
 
-  std::mt19937 randomGenerator;
-  std::normal_distribution<float> distribution;
-  std::map<ChunkCoord, Chunk> activeChunks;
-  std::map<ChunkCoord, Chunk> chunkCache;
+  uint64_t seed;
+  ChunkMap activeChunks;
+  ChunkCache chunkCache;
+  SpatialIndex entityIndex;
+  std::unique_ptr<EventHandle> entityDestroyedHandle;
   std::map<clientid_t, EntityID> clientPlayerMap;
   rsrc_amt_t minironOreAmount;
+  std::vector<ChunkCoord> playerChunks;
+  std::vector<ChunkCoord> farChunks;
+  // Server only
+  std::unique_ptr<ChunkPipeline> pipeline;
+  // Requested from the pipeline and not committed yet
+  std::set<ChunkCoord> pendingChunks;
+  // Taken from the pipeline, waiting for commit budget
+  std::list<GeneratedChunk> generatedChunks;
+  std::unique_ptr<RegionStore> regionStore;
   // TODO should be configurable
-  rsrc_amt_t maxironOreAmount = 10000;
+  rsrc_amt_t maxironOreAmount = kMaxIronOreAmount;
   // HACK should be changed with screen size
-  int viewDistance = 2;  // Chunk load distance from player
+  int viewDistance = 1;  // Chunk load distance from player
 };
 
 #endif /* CORE_WORLD_ */
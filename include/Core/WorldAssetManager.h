@@ -1,21 +1,32 @@
 #ifndef CORE_WORLDASSETMANAGER_
 #define CORE_WORLDASSETMANAGER_
 
+#include <array>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "SDL.h"
 #include "Core/TextureDeleter.h"
+#include "Core/TileData.h"
 
 class Chunk;
 
+// Released chunk textures kept for reuse, enough for the row of chunks a
+// player brings in by crossing a chunk border
+constexpr std::size_t kChunkTexturePoolSize = 4;
+
 /**
  * @brief A singleton for managing and caching world tile assets.
  * @details Provides a centralized way to load tile textures.
  * It ensures that each tile texture is loaded only once by caching it
  * on the first request. Subsequent requests for the same tile texture return
  * the cached version, improving performance and reducing memory usage.
+ *
+ * Chunk textures are render targets of a whole chunk. Only the tiles a Chunk
+ * flags as dirty are redrawn once one exists, and textures of chunks that
+ * were unloaded are pooled for the next chunk instead of destroyed.
  */
 
 class WorldAssetManager {
@@ -25,10 +36,34 @@ class WorldAssetManager {
 
  public:
   // TODO : refactor cache not to use string key in hash map but to use int and vector cache
+  /**
+   * @brief Renders every tile of a chunk, into a pooled texture if any.
+   * @details Clears the dirty tiles of the chunk.
+   */
   SDL_Texture* CreateChunkTexture(Chunk& chunk);
+
+  /**
+   * @brief Redraws the dirty tiles of a chunk into its texture and clears
+   * them.
+   */
+  void UpdateChunkTexture(SDL_Texture* texture, Chunk& chunk);
+
+  /**
+   * @brief Hands a chunk texture back once its chunk is gone.
+   */
+  void ReleaseChunkTexture(SDL_Texture* texture);
+
   SDL_Texture* getTexture(const std::string& path);
   WorldAssetManager(SDL_Renderer* renderer);
   ~WorldAssetManager();
+
+ private:
+  // Draws one tile over whatever the target held there
+  void DrawTile(const Chunk& chunk, int index);
+
+  // Tileset per TileType, looked up once instead of per tile
+  std::array<SDL_Texture*, kTileTypeCount> tileTextures{};
+  std::vector<std::unique_ptr<SDL_Texture, TextureDeleter>> chunkTexturePool;
 };
 
 #endif /* CORE_WORLDASSETMANAGER_ */
@@ -0,0 +1,84 @@
+#ifndef CORE_WORLDGENERATOR_
+#define CORE_WORLDGENERATOR_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Components/ResourceNodeComponent.h"
+#include "Core/Chunk.h"
+#include "Core/NoiseGrid.h"
+
+// Ore noise above this becomes an ore node, scaled to its starting amount
+constexpr float kOreThreshold = 0.5f;
+constexpr rsrc_amt_t kMaxIronOreAmount = 10000;
+// Starting amounts vary this much either way, clamped to the ore range
+constexpr float kOreAmountJitter = 0.1f;
+constexpr uint64_t kDefaultWorldSeed = 1337;
+
+/**
+ * @brief Mixes a seed with a stream number and a chunk into an unrelated
+ * 64 bit value (SplitMix64 finalizer).
+ * @details Counter based, the result only depends on the inputs, never on
+ * what was hashed before.
+ */
+uint64_t HashChunkSeed(uint64_t seed, uint64_t stream, ChunkCoord coord);
+
+/**
+ * @brief Random numbers of one chunk, keyed by HashChunkSeed.
+ * @details The n-th number is a hash of the key and n, so a chunk draws the
+ * same sequence on any thread, in any order, on any platform. Standard
+ * distributions are avoided for that reason too, their output differs
+ * between standard libraries.
+ */
+class ChunkRandom {
+ public:
+  explicit ChunkRandom(uint64_t key) : key(key) {}
+
+  uint64_t Next();
+  // Uniform in [0, 1)
+  float NextFloat();
+
+ private:
+  uint64_t key;
+  uint64_t counter = 0;
+};
+
+/**
+ * @brief Terrain and ore of a chunk, before any entity exists for it.
+ */
+struct GeneratedChunk {
+  Chunk chunk;
+  // Local tile index (y * CHUNK_WIDTH + x) and starting amount of iron ore
+  std::vector<std::pair<int, rsrc_amt_t>> ores;
+};
+
+/**
+ * @brief Procedural terrain and ore, computed without touching the registry.
+ * @details Everything random derives from the world seed. Noise layers are
+ * seeded once per world, per chunk seeds would break the noise at chunk
+ * borders, and everything else a chunk draws comes from its own ChunkRandom.
+ * Generate is a pure function of the seed and the coordinate, so one
+ * generator can serve any number of worker threads in any order, and the
+ * same seed always builds the same world.
+ *
+ * Both noise grids of a chunk are evaluated in one batch and classified
+ * without branches.
+ */
+class WorldGenerator {
+ public:
+  explicit WorldGenerator(uint64_t seed = kDefaultWorldSeed);
+
+  GeneratedChunk Generate(ChunkCoord coord) const;
+
+  inline uint64_t GetSeed() const { return seed; }
+  inline const NoiseGrid& GetTerrainNoise() const { return terrainNoise; }
+  inline const NoiseGrid& GetOreNoise() const { return oreNoise; }
+
+ private:
+  uint64_t seed;
+  NoiseGrid terrainNoise;
+  NoiseGrid oreNoise;
+};
+
+#endif /* CORE_WORLDGENERATOR_ */
@@ -1,8 +1,11 @@
 ﻿#ifndef GAMESTATE_CLIENTSTATE_
 #define GAMESTATE_CLIENTSTATE_
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
+#include <future>
 #include <memory>
 #include <thread>
 #include <tuple>
@@ -11,6 +14,7 @@
 #include "Core/Entity.h"
 #include "Core/EventDispatcher.h"
 #include "Core/Packet.h"
+#include "Core/PacketAssembler.h"
 #include "Core/SystemContext.h"
 #include "Core/ThreadSafeQueue.h"
 #include "GameState/IGameState.h"
@@ -70,6 +74,7 @@ class ClientState : public IGameState {
 
   std::unique_ptr<ThreadSafeQueue<PacketPtr>> recvQueue;
   std::unique_ptr<ThreadSafeQueue<PacketPtr>> sendQueue;
+  std::unique_ptr<ThreadSafeQueue<std::vector<uint8_t>>> datagramQueue;
 
   std::unordered_map<clientid_t, std::string> clientNameMap;
 
@@ -78,11 +83,20 @@ class ClientState : public IGameState {
   EntityID player;
 
   std::vector<uint8_t> messageBuffer;
+  PacketAssembler packetAssembler;
   std::thread messageThread;
+  std::thread datagramThread;
   std::size_t clientID;
   bool bIsReceiving;
   bool bIsQuit;
 
+  // Set by the receive thread, the main thread decides whether to reconnect
+  std::atomic<bool> bIsConnectionLost{false};
+  bool bIsReconnecting = false;
+  std::future<std::unique_ptr<Socket>> pendingConnect;
+  std::chrono::steady_clock::time_point nextConnectAttempt;
+  std::chrono::steady_clock::time_point reconnectDeadline;
+
   std::unique_ptr<AnimationSystem> animationSystem;
   std::unique_ptr<AssemblingMachineSystem> assemblingMachineSystem;
   std::unique_ptr<CameraSystem> cameraSystem;
@@ -121,6 +135,12 @@ class ClientState : public IGameState {
 
  private:
   void SocketReceiveWorker();
+  void DatagramReceiveWorker();
+  void StartReceiving();
+  void StopReceiving();
+  // Connects again in the background while the world stays as it is
+  void BeginReconnect();
+  void PollReconnect();
   void RegisterComponent();
   void InitCoreSystem();
 };
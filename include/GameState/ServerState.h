@@ -21,6 +21,7 @@ class CommandQueue;
 class AssetManager;
 class EntityFactory;
 class IGameState;
+class PacketReplayer;
 class Registry;
 class SystemContext;
 class TimerManager;
@@ -64,6 +65,8 @@ class ServerState : public IGameState {
   std::unique_ptr<EntityFactory> entityFactory;
   std::unique_ptr<World> world;
   std::unique_ptr<Server> server;
+  // Set instead of server when a packet capture is replayed
+  std::unique_ptr<PacketReplayer> replayer;
 
   std::unique_ptr<ThreadSafeQueue<RecvPacket>> recvQueue;
   std::unique_ptr<ThreadSafeQueue<SendRequest>> sendQueue;
@@ -94,6 +97,8 @@ class ServerState : public IGameState {
 
   bool bIsQuit = false;
 
+  bool bIsReplayReported = false;
+
  public:
   ServerState();
   ~ServerState();
@@ -112,9 +117,15 @@ class ServerState : public IGameState {
     static constexpr std::size_t size = sizeof...(Types);
   };
 
+  /**
+   * @brief Registers every component type the server uses, also for servers
+   * run without this state.
+   */
+  static void RegisterComponent(Registry *registry);
+
  private:
-  void RegisterComponent();
   void InitCoreSystem();
+  void UpdateNetwork(float deltaTime);
 };
 
 #endif /* GAMESTATE_SERVERSTATE_ */
@@ -15,10 +15,12 @@ class AssemblingMachineSystem {
   Registry *registry;
   EventDispatcher *eventDispatcher;
   TimerManager *timerManager;
+  bool bIsServer;
 
   std::unique_ptr<EventHandle> AddInputEventHandle;
   std::unique_ptr<EventHandle> TakeOutputEventHandle;
   std::unique_ptr<EventHandle> CraftOutputEventHandle;
+  std::unique_ptr<EventHandle> SetRecipeEventHandle;
 
  public:
   AssemblingMachineSystem(const SystemContext &context);
@@ -32,6 +34,7 @@ class AssemblingMachineSystem {
  private:
   void AddInputHandler(const AssemblyAddInputEvent &event);
   void TakeOutputHandler(const AssemblyTakeOutputEvent &event);
+  void SetRecipeHandler(const AssemblySetRecipeEvent &event);
 
   bool HasEnoughIngredients(EntityID entity) const;
   bool CanStoreOutput(EntityID entity) const;
@@ -41,6 +44,11 @@ class AssemblingMachineSystem {
   void ConsumeIngredients(EntityID entity, AssemblingMachineComponent &machine);
   void ProduceOutput(EntityID entity);
   void StartCrafting(EntityID entity, AssemblingMachineComponent &machine);
+  // Freezes an inactive machine and settles it when due, true once it thawed
+  // and takes part in the update again
+  bool UpdateFrozen(EntityID entity, AssemblingMachineComponent &machine);
+  void SettleProduction(EntityID entity, AssemblingMachineComponent &machine,
+                        float elapsed);
   void UpdateAnimationState(EntityID entity,
                             AssemblingMachineComponent &machine);
 };
@@ -4,20 +4,38 @@
 #include <memory>
 #include <string>
 #include <cstdint>
-#include <deque>
+#include <functional>
 #include <unordered_map>
+#include <vector>
 
+#include "Components/NetIdentityComponent.h"
+#include "Core/Entity.h"
+#include "Core/InputPrediction.h"
+#include "Core/SnapshotClock.h"
 #include "Core/SystemContext.h"
+#include "Core/Type.h"
 
+class CommandPredictor;
 class EventHandle;
+class NetConnection;
+class PacketReader;
+class PredictionScope;
+enum class ItemID;
 
 class ClientNetworkSystem {
-  struct InputCommand {
-    uint16_t sequence;
-    uint8_t inputBit;
-    float predX;
-    float predY;
-    float deltaTime;
+  struct ReplicaRef {
+    EntityID entity;
+    Vec2 tileIndex;
+  };
+
+  struct DeferredRecord {
+    PACKET type;
+    std::vector<uint8_t> bytes;  // one entry of the packet, count excluded
+  };
+
+  struct DeferredChunk {
+    Vec2 tileIndex;  // any tile of the chunk, used to test if it is active
+    std::vector<DeferredRecord> records;
   };
 
   AssetManager* assetManager;
@@ -28,7 +46,9 @@ class ClientNetworkSystem {
   TimerManager* timerManager;
   ThreadSafeQueue<PacketPtr>* recvQueue;
   ThreadSafeQueue<PacketPtr>* sendQueue; // Now queues PacketPtr directly
+  ThreadSafeQueue<std::vector<uint8_t>>* datagramQueue;  // Raw UDP datagrams
   World* world;
+  EntityFactory* factory;
   Socket* connectionSocket;
   uint64_t myClientID;
   std::unordered_map<clientid_t, std::string>* clientNameMap;
@@ -38,27 +58,111 @@ class ClientNetworkSystem {
  public:
   ClientNetworkSystem(const SystemContext& context);
   ~ClientNetworkSystem();
-  void Init(std::u8string playerName);
+  /**
+   * @param rate Snapshot bytes per second to ask the server for, 0 leaves it
+   * to the server.
+   */
+  void Init(std::u8string playerName, uint32_t rate = 0);
   void Update(float deltatime);
+
+  // True once CONNECT_ACK handed out a session the server can resume
+  inline bool HasSession() const { return bHasSession; }
+
+  /**
+   * @brief Prepares for a new connection after the old one dropped.
+   * @details Pending commands are rolled back since their acks are lost, and
+   * nothing is sent until the session is resumed.
+   */
+  void OnConnectionLost();
+
+  /**
+   * @brief Asks the server on the new connection to hand the session back.
+   */
+  void Resume();
   
 
  private:
   std::unique_ptr<EventHandle> sendChatHandle;
-  void ConnectAckHandler(const uint8_t* rp, std::size_t packetSize);
-  void ChatBroadcastHandler(const uint8_t* rp, std::size_t packetSize);
-  void TransformSnapshotHandler(const uint8_t* rp, std::size_t packetSize);
-  void ClientMoveResHandler(const uint8_t* rp,
-                            std::size_t packetSize);  // Server reconciliation
+  std::unique_ptr<EventHandle> buildRequestHandle;
+  std::unique_ptr<EventHandle> setRecipeHandle;
+  std::unique_ptr<EventHandle> addInputHandle;
+  std::unique_ptr<EventHandle> takeOutputHandle;
+  std::unique_ptr<EventHandle> itemMoveHandle;
+  void HandlePacket(const uint8_t* packet);
+  void ConnectAckHandler(PacketReader& reader);
+  void ReconnectAckHandler(PacketReader& reader);
+  void PlayerRosterHandler(PacketReader& reader);
+  // Up to count roster records, fewer if the packet ends first
+  void ReadRoster(PacketReader& reader, uint16_t count);
+  // Reconciles the players once the whole resume roster arrived
+  void FinishResume();
+  void RequestUdpBind();
+  void DropReplicas();
+  void CommandAckHandler(PacketReader& reader);
+  void ChatBroadcastHandler(PacketReader& reader);
+  void TransformSnapshotHandler(PacketReader& reader);
+  void ClientMoveResHandler(PacketReader& reader);  // Server reconciliation
+  void InterestChangeHandler(PacketReader& reader, bool bEntered);
+  void ReplicationHandler(PacketReader& reader);
+  // Chunks that left the view, CHUNK_DATA goes straight to World
+  void ChunkUnloadHandler(PacketReader& reader);
+  bool ApplyReplicationRecord(PACKET packetId, const uint8_t*& rp,
+                              const uint8_t* end);
+  EntityID SpawnReplica(netid_t netID, uint8_t archetype, Vec2 tileIndex);
+  void DespawnReplica(netid_t netID);
+  void DestroyBuilding(EntityID entity);
+  void RetryDeferredRecords();
 
   void ApplyRemoteInterpolation();
   void ApplyLocalSmoothing(float deltaTime);
 
   void SendMessage(std::shared_ptr<std::string> message);
   void SendMoveRequest(float deltaTime);
+  TileCollisionCache MakeCollisionCache();
+  void ReceiveDatagrams();
+  void SendDatagrams();
+  void SendBuildRequest(EntityID player, ItemID item, Vec2 tileIndex);
+  // predict copies what the request changes and repeats it on replay
+  void SendInteractRequest(EntityID target, ENetInteraction action,
+                           uint8_t id, int amount,
+                           std::function<void(PredictionScope&)> predict);
+  // Server tick of the remote state currently drawn
+  uint32_t GetViewTick() const;
 
   // For client-side prediction and server reconciliation
-  std::deque<InputCommand> pendingInputQueue;
+  PendingInputRing pendingInputs;
   uint16_t inputSequenceNumber = 0;
+  uint8_t ticksSinceMoveSend = 0;
+  uint8_t lastSentInputBit = 0;
+
+  // Builds and interactions applied ahead of their COMMAND_ACK
+  std::unique_ptr<CommandPredictor> commandPredictor;
+
+  // Server tick to local time mapping and the adaptive interpolation delay
+  SnapshotClock snapshotClock;
+
+  // Proves the session in RECONNECT_SYN
+  uint64_t sessionToken = 0;
+  bool bHasSession = false;
+  // Waiting for RECONNECT_ACK, outgoing packets stay queued
+  bool bIsResuming = false;
+  // Roster players still to come in PLAYER_ROSTER after an ack
+  uint16_t rosterRemaining = 0;
+  bool bIsResumeRoster = false;
+  std::unordered_map<clientid_t, std::string> resumeRoster;
+  // Replication changes up to this version have been received
+  uint32_t replicationVersion = 0;
+
+  // Gameplay traffic moves here once the server acks UDP_BIND
+  std::unique_ptr<NetConnection> udpConnection;
+  bool bIsUdpBound = false;
+  bool bIsUdpAvailable = true;
+
+  // Server-owned entities. World-generated ones are found through their tile.
+  std::unordered_map<netid_t, ReplicaRef> replicas;
+  // Records for entities whose chunk is not active yet, in arrival order
+  std::unordered_map<uint64_t, DeferredChunk> deferredChunks;
+  std::unordered_map<netid_t, uint64_t> deferredNetIDs;
 };
 
 #endif/* SYSTEM_CLIENTNETWORKSYSTEM_ */
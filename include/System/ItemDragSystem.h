@@ -19,6 +19,7 @@ class ItemDragSystem {
   EventDispatcher* eventDispatcher;
   EntityFactory* factory;
 
+  bool bIsServer;
   bool bIsPreviewingBuilding;
   bool bIsBuildingPlaced;
   ItemID previewingItemID;
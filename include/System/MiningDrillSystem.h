@@ -15,11 +15,20 @@ class MiningDrillSystem {
  private:
   Registry* registry;
   World* world;
+  EventDispatcher* eventDispatcher;
   TimerManager* timerManager;
+  bool bIsServer;
   
   void UpdateAnimationState(MiningDrillComponent& drill, EntityID entity);
   bool TileEmpty(EntityID entity);
   void StartMining(MiningDrillComponent& drill, EntityID entity);
+  // Turns the mined out tile under the drill into dirt
+  void ExhaustTile(EntityID entity);
+  // Freezes an inactive drill and settles it when due, true once it thawed
+  // and takes part in the update again
+  bool UpdateFrozen(MiningDrillComponent& drill, EntityID entity);
+  void SettleProduction(MiningDrillComponent& drill, EntityID entity,
+                        float elapsed);
 };
 
 #endif/* SYSTEM_MININGDRILLSYSTEM_ */
@@ -1,6 +1,7 @@
 #ifndef SYSTEM_MOVEMENTSYSTEM_
 #define SYSTEM_MOVEMENTSYSTEM_
 
+#include "Core/Entity.h"
 #include "Core/SystemContext.h"
 
 class MovementSystem {
@@ -20,6 +21,8 @@ class MovementSystem {
 
  private:
   void ServerUpdate(float deltaTime);
+  // Moves one player by its current input for stepTime and acks the input
+  void StepPlayer(EntityID e, float stepTime);
   void ClientUpdate(float deltaTime);
 };
 
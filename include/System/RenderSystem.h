@@ -7,6 +7,7 @@
 
 struct SDL_Renderer;
 class EventHandle;
+class WorldAssetManager;
 struct EntityDestroyedEvent;
 
 /**
@@ -17,6 +18,7 @@ class RenderSystem {
   Registry *registry;
   SDL_Renderer *renderer;
   World *world;
+  WorldAssetManager *worldAssetManager;
   TTF_Font *font;
   std::unique_ptr<EventHandle> entityDestroyedEventHandle;
 
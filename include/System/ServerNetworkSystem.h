@@ -3,14 +3,40 @@
 
 #include <cstdint>
 #include <memory>
+#include <random>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "Components/NetIdentityComponent.h"
 #include "Core/SystemContext.h"
+#include "Core/Type.h"
 
+class ChunkStreamer;
 class EventHandle;
+class InterestManager;
+class PacketReader;
+class PacketRecorder;
+class ReplicationManager;
+class SnapshotScheduler;
+class TransformHistory;
+enum class ItemID;
 
 class ServerNetworkSystem {
+  // Lets a client whose connection dropped come back as the same player
+  struct Session {
+    uint64_t token;
+    uint32_t rate = 0;  // from CONNECT_SYN, kept for the resumed connection
+    bool bIsParked = false;  // connection lost, player kept until expireTime
+    double expireTime = 0.0;
+  };
+
+  // RECONNECT_SYN that arrived before the old connection was seen closing
+  struct PendingResume {
+    clientid_t connection;
+    uint32_t replicationVersion;
+  };
+
   AssetManager* assetManager;
   EventDispatcher* eventDispatcher;
   Registry* registry;
@@ -20,12 +46,18 @@ class ServerNetworkSystem {
   ThreadSafeQueue<SendRequest>*
       sendQueue;  // Outgoing packets (server-specific)
   World* world;
+  EntityFactory* factory;
   Server* server;
   std::unordered_map<clientid_t, std::string>* clientNameMap;
 
-  std::size_t playerSnapShotSize;
+  // Leftover time towards the next fixed network tick
+  float netTickTimer;
 
-  float syncTimer;
+  // Update count and total time, stamped on captured packets
+  uint32_t tick;
+  double elapsedTime;
+  // server_tick of the newest TRANSFORM_SNAPSHOT
+  uint32_t snapshotTick;
 
   ThreadSafeQueue<MoveApplied>* pendingMoves;
 
@@ -35,15 +67,68 @@ class ServerNetworkSystem {
   void Update(float deltatime);
   void AddPlayerToMap(clientid_t clientID, std::string name);
 
+  /**
+   * @brief Starts writing every received packet to a capture file.
+   * @details The capture can be fed back through the receive queue with
+   * PacketReplayer to reproduce the same traffic without any client.
+   * @return False if the file could not be opened.
+   */
+  bool StartRecording(const std::string& path);
+  void StopRecording();
+
  private:
   std::unique_ptr<EventHandle> sendChatHandle;
+  std::unique_ptr<PacketRecorder> recorder;
+  // Filters per-client snapshots down to players near the receiver
+  std::unique_ptr<InterestManager> interestManager;
+  // Streams building and machine state to every remote client
+  std::unique_ptr<ReplicationManager> replicationManager;
+  // Snapshot positions, rewound to validate requests at the client's view
+  std::unique_ptr<TransformHistory> transformHistory;
+  // Per-client send windows and which players fit in each snapshot
+  std::unique_ptr<SnapshotScheduler> snapshotScheduler;
+  // Terrain and ore around each remote client, which never runs worldgen
+  std::unique_ptr<ChunkStreamer> chunkStreamer;
+  std::unordered_map<clientid_t, Session> sessions;
+  std::unordered_map<clientid_t, PendingResume> pendingResumes;
+  std::mt19937_64 tokenGenerator;
+  std::unique_ptr<EventHandle> buildingPlacedHandle;
+  std::unique_ptr<EventHandle> entityDestroyedHandle;
+  std::unique_ptr<EventHandle> tileChangedHandle;
   void Unicast(uint64_t clientID, PacketPtr packet);
+  // Unicast that also hands the transport the token UDP_BIND must carry
+  void SendSession(clientid_t clientID, uint64_t token, PacketPtr packet);
   void Broadcast(PacketPtr packet);
-  void SendSyncPacket();
-  void ConnectSynHandler(const RecvPacket& recv, clientid_t clientID, const uint8_t* rp,
-                         std::size_t packetSize);
-  void ChatClientHandler(clientid_t clientID, const uint8_t* rp, std::size_t packetSize);
-  void ClientMoveReqHandler(clientid_t clientID, const uint8_t* rp, std::size_t packetSize);
+  // Captures positions every tickDelta and sends the snapshots that are due
+  void NetworkTick(float deltaTime);
+  void SendInterestChange(clientid_t clientID, PACKET packetId,
+                          const std::vector<clientid_t>& players);
+  void ConnectSynHandler(clientid_t clientID, PacketReader& reader);
+  void ReconnectSynHandler(clientid_t connection, PacketReader& reader);
+  void ConnectionClosed(clientid_t connection);
+  // Keeps the player of a lost connection for a while
+  void ParkSession(clientid_t clientID);
+  // Hands the session back to a new connection and resyncs what it missed
+  void ResumeSession(clientid_t connection, clientid_t clientID,
+                     uint32_t replicationVersion);
+  void DropClient(clientid_t clientID);
+  void ExpireSessions();
+  inline bool IsParked(clientid_t clientID) const {
+    auto it = sessions.find(clientID);
+    return it != sessions.end() && it->second.bIsParked;
+  }
+  void ChatClientHandler(clientid_t clientID, PacketReader& reader);
+  void ClientMoveReqHandler(clientid_t clientID, PacketReader& reader);
+  void BuildReqHandler(clientid_t clientID, PacketReader& reader);
+  void EntityInteractReqHandler(clientid_t clientID, PacketReader& reader);
+  bool TryBuild(clientid_t clientID, ItemID item, Vec2 tileIndex);
+  bool TryInteract(clientid_t clientID, netid_t netID,
+                   ENetInteraction action, uint8_t id, int amount,
+                   uint32_t viewTick);
+  // Answers a predicted request so the client keeps or rolls it back
+  void SendCommandAck(clientid_t clientID, uint16_t sequence, bool bAccepted);
+  void FlushReplication(float deltaTime);
+  void StreamChunks(float deltaTime);
 };
 
 #endif /* SYSTEM_NETWORKSYSTEM_ */
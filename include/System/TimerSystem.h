@@ -1,15 +1,23 @@
 #ifndef SYSTEM_TIMERSYSTEM_
 #define SYSTEM_TIMERSYSTEM_
 
+#include <memory>
+
 #include "Core/SystemContext.h"
 
+class EventHandle;
+
 /**
  * @brief System responsible for updating the elapsed time of all active timers
- *
+ * @details Timers of destroyed entities are returned to the TimerManager, the
+ * server destroys machines whenever their chunk is saved and unloaded. Timers
+ * of inactive entities are held where they are and the game clock of the
+ * TimerManager is advanced every update.
  */
 class TimerSystem {
   Registry* registry;
   TimerManager* timerManager;
+  std::unique_ptr<EventHandle> entityDestroyedHandle;
 
  public:
   TimerSystem(const SystemContext& context);
@@ -0,0 +1,33 @@
+#ifndef UTIL_INTERPUTIL_
+#define UTIL_INTERPUTIL_
+
+#include <cstdint>
+
+#include "Components/InterpBufferComponent.h"
+
+namespace util {
+
+/**
+ * @brief Appends a snapshot sample, dropping ones not newer than the last.
+ * @details A tick more than a second behind the newest sample restarts the
+ * buffer, the server was restarted.
+ * @return False if the sample was out of order.
+ */
+bool PushInterpSample(InterpBufferComponent &buf, uint32_t tick, float x,
+                      float y, uint8_t facing);
+
+/**
+ * @brief Interpolated sample at a fractional server tick.
+ * @details Walks forward from the cursor left by the previous call, render
+ * time only moves forward so this is O(1) per frame. Ticks before the oldest
+ * or after the newest sample clamp to it.
+ * @return False if the buffer is empty.
+ */
+bool SampleInterpBuffer(InterpBufferComponent &buf, double renderTick,
+                        float &outX, float &outY, uint8_t &outFacing);
+
+void ResetInterpBuffer(InterpBufferComponent &buf);
+
+}  // namespace util
+
+#endif /* UTIL_INTERPUTIL_ */
@@ -21,6 +21,15 @@ static inline bool seq_leq(uint16_t a, uint16_t b) {
   return static_cast<uint16_t>(b - a) < 0x8000;
 }
 
+// Entry i of the CLIENT_MOVE_REQ input_bits. Write expects zeroed bytes.
+inline void WriteInputNibble(uint8_t* packed, std::size_t i, uint8_t input) {
+  const uint8_t nibble = input & 0x0F;
+  packed[i / 2] |= (i % 2 == 0) ? nibble : static_cast<uint8_t>(nibble << 4);
+}
+inline uint8_t ReadInputNibble(const uint8_t* packed, std::size_t i) {
+  return (i % 2 == 0) ? (packed[i / 2] & 0x0F) : (packed[i / 2] >> 4);
+}
+
 inline void Write16BigEnd(uint8_t*& p, uint16_t v) {
   *p++ = static_cast<uint8_t>((v >> 8) & 0xFF);
   *p++ = static_cast<uint8_t>(v & 0xFF);
@@ -120,22 +129,6 @@ static void GetHeader(const uint8_t*& beginPtr, enum PACKET& packetID,
   size = Read16BigEnd(beginPtr);
 }
 
-static PacketPtr ChatBroadcastPacket(std::shared_ptr<std::string> message,
-                                     clientid_t senderId) {
-  const std::size_t payload = sizeof(clientid_t) + message->size();
-  const std::size_t total = sPacketHeader + payload;
-  PacketPtr packet = std::make_unique<uint8_t[]>(total);
-  uint8_t* p = packet.get();
-  WriteHeader(p, CHAT_BROADCAST, total);
-  Write64BigEnd(p, senderId);
-  std::memcpy(p, message->c_str(), message->size());
-  return packet;
-}
-
-static PacketPtr ChatBroadcastPacket(std::shared_ptr<std::string> message) {
-  return ChatBroadcastPacket(std::move(message), 0);
-}
-
 }  // namespace util
 
 #endif/* UTIL_PACKETUTIL_ */
@@ -0,0 +1,29 @@
+#ifndef UTIL_REPLICATIONUTIL_
+#define UTIL_REPLICATIONUTIL_
+
+#include "Core/ComponentReplicator.h"
+#include "Core/Entity.h"
+
+class Registry;
+
+namespace util {
+
+/**
+ * @brief Flags a replicated component of an entity as changed.
+ *
+ * Adds (or updates) a ReplicationDirtyTag on the entity so the server network
+ * system sends the new value on its next pass. Multiple calls before the pass
+ * coalesce into a single update carrying only the latest value. Entities
+ * without an authoritative NetIdentityComponent (i.e. anything on a client)
+ * are ignored.
+ *
+ * @param registry The game's entity-component registry.
+ * @param entity The entity whose component changed.
+ * @param component The component that changed.
+ */
+void MarkReplicationDirty(Registry* registry, EntityID entity,
+                          EReplicatedComponent component);
+
+}  // namespace util
+
+#endif /* UTIL_REPLICATIONUTIL_ */
@@ -42,6 +42,30 @@ void AttachTimer(Registry* registry, TimerManager* timerManager,
 void DetachTimer(Registry* registry, TimerManager* timerManager,
                  EntityID entity, TimerId id);
 
+/**
+ * @brief Checks whether an entity has a timer of the given ID attached.
+ *
+ * Machines restored from a save come back in their saved state without the
+ * timer that was driving it.
+ *
+ * @param registry The game's entity-component registry.
+ * @param entity The ID of the entity to check.
+ * @param id The semantic ID of the timer.
+ */
+bool HasTimer(Registry* registry, EntityID entity, TimerId id);
+
+/**
+ * @brief Gets the timer of the given ID attached to an entity.
+ *
+ * @param registry The game's entity-component registry.
+ * @param timerManager The game's timer manager.
+ * @param entity The ID of the entity owning the timer.
+ * @param id The semantic ID of the timer.
+ * @return TimerInstance* nullptr if no such timer is attached.
+ */
+TimerInstance* GetTimer(Registry* registry, TimerManager* timerManager,
+                        EntityID entity, TimerId id);
+
 }  // namespace util
 
 #endif /* UTIL_TIMERUTIL_ */
@@ -0,0 +1,306 @@
+// Headless load generator: drives many BotClients from one epoll loop.
+//
+// Usage: BotSwarm <host> <port> <bot count> [seconds] [connects per second]
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Core/BotClient.h"
+#include "Core/Packet.h"
+
+namespace {
+constexpr int kMaxEvents = 1024;
+constexpr std::size_t kRecvBufferSize = 64 * 1024;
+constexpr double kReportInterval = 1.0;
+
+struct BotConnection {
+  int fd = -1;
+  bool bIsConnecting = true;
+  bool bWantsWrite = false;
+  std::unique_ptr<BotClient> bot;
+  std::vector<uint8_t> outbound;
+  std::size_t outboundOffset = 0;
+};
+
+double NowSeconds() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return duration<double>(steady_clock::now() - start).count();
+}
+
+void RaiseFileLimit() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return;
+  limit.rlim_cur = limit.rlim_max;
+  if (setrlimit(RLIMIT_NOFILE, &limit) != 0)
+    std::cerr << "Could not raise the open file limit" << std::endl;
+}
+
+bool ResolveAddress(const char* host, const char* port, sockaddr_in& out) {
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(host, port, &hints, &result) != 0 || result == nullptr)
+    return false;
+  std::memcpy(&out, result->ai_addr, sizeof(out));
+  freeaddrinfo(result);
+  return true;
+}
+
+class BotSwarm {
+ public:
+  BotSwarm(const sockaddr_in& address, std::size_t botCount)
+      : address(address), connections(botCount) {}
+
+  ~BotSwarm() {
+    for (BotConnection& connection : connections) Drop(connection);
+    if (epollFd >= 0) close(epollFd);
+  }
+
+  bool Init() {
+    epollFd = epoll_create1(0);
+    if (epollFd < 0) {
+      std::cerr << "epoll_create1 failed errno: " << errno << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  void Run(double duration, double connectRate) {
+    std::vector<epoll_event> events(kMaxEvents);
+    std::vector<uint8_t> buffer(kRecvBufferSize);
+
+    const double start = NowSeconds();
+    double nextTick = start;
+    double nextReport = start + kReportInterval;
+    double lastReport = start;
+
+    while (NowSeconds() - start < duration) {
+      const double now = NowSeconds();
+
+      // Ramp up instead of flooding the accept backlog
+      const std::size_t due = std::min<std::size_t>(
+          connections.size(),
+          static_cast<std::size_t>((now - start) * connectRate) + 1);
+      while (started < due) Open(started++);
+
+      const int timeoutMs = static_cast<int>(
+          std::max(0.0, (std::min(nextTick, nextReport) - now) * 1000.0));
+      const int count = epoll_wait(epollFd, events.data(),
+                                   static_cast<int>(events.size()), timeoutMs);
+      if (count < 0 && errno != EINTR) {
+        std::cerr << "epoll_wait failed errno: " << errno << std::endl;
+        return;
+      }
+
+      for (int i = 0; i < count; ++i) {
+        BotConnection& connection = connections[events[i].data.u64];
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+          Drop(connection);
+          continue;
+        }
+        if (events[i].events & EPOLLOUT) OnWritable(connection);
+        if (events[i].events & EPOLLIN) OnReadable(connection, buffer);
+      }
+
+      const double tickNow = NowSeconds();
+      if (tickNow >= nextTick) {
+        for (BotConnection& connection : connections) {
+          if (connection.fd < 0 || !connection.bot) continue;
+          connection.bot->Tick(tickNow, connection.outbound);
+          Flush(connection);
+        }
+        // Skip ticks rather than bursting after a stall
+        nextTick = std::max(nextTick + syncDelta, tickNow);
+      }
+
+      if (tickNow >= nextReport) {
+        Report(tickNow - lastReport);
+        lastReport = tickNow;
+        nextReport = tickNow + kReportInterval;
+      }
+    }
+  }
+
+ private:
+  void Open(std::size_t index) {
+    BotConnection& connection = connections[index];
+    connection.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (connection.fd < 0) {
+      std::cerr << "socket failed errno: " << errno << std::endl;
+      return;
+    }
+    int noDelay = 1;
+    setsockopt(connection.fd, IPPROTO_TCP, TCP_NODELAY, &noDelay,
+               sizeof(noDelay));
+
+    if (connect(connection.fd, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) < 0 &&
+        errno != EINPROGRESS) {
+      std::cerr << "connect failed errno: " << errno << std::endl;
+      close(connection.fd);
+      connection.fd = -1;
+      return;
+    }
+
+    connection.bot = std::make_unique<BotClient>(
+        static_cast<uint32_t>(index), static_cast<uint32_t>(index) + 1,
+        &stats);
+    connection.bIsConnecting = true;
+    connection.bWantsWrite = true;
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u64 = index;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, connection.fd, &event);
+  }
+
+  void Drop(BotConnection& connection) {
+    if (connection.fd < 0) return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+    close(connection.fd);
+    connection.fd = -1;
+    if (connection.bot && connection.bot->IsConnected()) {
+      --stats.connectedCount;
+    }
+    ++dropped;
+    connection.bot.reset();
+  }
+
+  void OnWritable(BotConnection& connection) {
+    if (connection.bIsConnecting) {
+      int error = 0;
+      socklen_t len = sizeof(error);
+      getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+      if (error != 0) {
+        Drop(connection);
+        return;
+      }
+      connection.bIsConnecting = false;
+      connection.bot->Start(connection.outbound);
+    }
+    Flush(connection);
+  }
+
+  void OnReadable(BotConnection& connection, std::vector<uint8_t>& buffer) {
+    while (connection.fd >= 0) {
+      const ssize_t res = recv(connection.fd, buffer.data(), buffer.size(), 0);
+      if (res > 0) {
+        if (!connection.bot->OnReceive(buffer.data(),
+                                       static_cast<std::size_t>(res),
+                                       NowSeconds())) {
+          std::cerr << "Corrupted stream, dropping bot" << std::endl;
+          Drop(connection);
+        }
+        continue;
+      }
+      if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+      Drop(connection);
+    }
+  }
+
+  // Writes as much as the kernel takes, waits for EPOLLOUT for the rest
+  void Flush(BotConnection& connection) {
+    if (connection.fd < 0 || connection.bIsConnecting) return;
+
+    while (connection.outboundOffset < connection.outbound.size()) {
+      const ssize_t res =
+          send(connection.fd,
+               connection.outbound.data() + connection.outboundOffset,
+               connection.outbound.size() - connection.outboundOffset,
+               MSG_NOSIGNAL);
+      if (res < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        Drop(connection);
+        return;
+      }
+      connection.outboundOffset += static_cast<std::size_t>(res);
+    }
+
+    if (connection.outboundOffset == connection.outbound.size()) {
+      connection.outbound.clear();
+      connection.outboundOffset = 0;
+    }
+
+    const bool bWantsWrite = !connection.outbound.empty();
+    if (bWantsWrite == connection.bWantsWrite) return;
+    connection.bWantsWrite = bWantsWrite;
+
+    epoll_event event{};
+    event.events = EPOLLIN | (bWantsWrite ? uint32_t{EPOLLOUT} : 0u);
+    event.data.u64 = static_cast<uint64_t>(&connection - connections.data());
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+  }
+
+  void Report(double elapsed) {
+    std::printf(
+        "bots %zu/%zu dropped %zu | rtt ms p50 %.1f p95 %.1f p99 %.1f | "
+        "snapshot interval ms p50 %.1f p99 %.1f jitter p99 %.2f | "
+        "server %.1f KiB/s client %.1f KiB/s\n",
+        stats.connectedCount, connections.size(), dropped,
+        BotStats::Percentile(stats.roundTripMs, 50.0),
+        BotStats::Percentile(stats.roundTripMs, 95.0),
+        BotStats::Percentile(stats.roundTripMs, 99.0),
+        BotStats::Percentile(stats.snapshotIntervalMs, 50.0),
+        BotStats::Percentile(stats.snapshotIntervalMs, 99.0),
+        BotStats::Percentile(stats.snapshotJitterMs, 99.0),
+        stats.bytesReceived / elapsed / 1024.0,
+        stats.bytesSent / elapsed / 1024.0);
+    std::fflush(stdout);
+    stats.Clear();
+  }
+
+  sockaddr_in address;
+  int epollFd = -1;
+  std::vector<BotConnection> connections;
+  std::size_t started = 0;
+  std::size_t dropped = 0;
+  BotStats stats;
+};
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " <host> <port> <bot count> [seconds] [connects per second]"
+              << std::endl;
+    return 1;
+  }
+
+  const std::size_t botCount = std::strtoul(argv[3], nullptr, 10);
+  const double duration = argc > 4 ? std::strtod(argv[4], nullptr) : 60.0;
+  const double connectRate = argc > 5 ? std::strtod(argv[5], nullptr) : 200.0;
+
+  sockaddr_in address;
+  if (!ResolveAddress(argv[1], argv[2], address)) {
+    std::cerr << "Could not resolve " << argv[1] << ":" << argv[2]
+              << std::endl;
+    return 1;
+  }
+
+  RaiseFileLimit();
+
+  BotSwarm swarm(address, botCount);
+  if (!swarm.Init()) return 1;
+  swarm.Run(duration, connectRate);
+  return 0;
+}
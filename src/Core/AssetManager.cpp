@@ -12,6 +12,8 @@ SDL_Texture *AssetManager::getTexture(const std::string &path) {
   if (it != textureCache.end()) {
     return it->second.get();
   }
+  // Headless, nothing to draw to
+  if (renderer == nullptr) return nullptr;
 
   SDL_Surface *surface = IMG_Load(path.c_str());
   if (!surface) {
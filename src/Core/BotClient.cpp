@@ -0,0 +1,202 @@
+#include "Core/BotClient.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "Core/PacketSchema.h"
+#include "Util/PacketUtil.h"
+
+namespace {
+constexpr uint8_t kWalkInputs[] = {
+    0,
+    static_cast<uint8_t>(EPlayerInput::UP),
+    static_cast<uint8_t>(EPlayerInput::DOWN),
+    static_cast<uint8_t>(EPlayerInput::LEFT),
+    static_cast<uint8_t>(EPlayerInput::RIGHT),
+    static_cast<uint8_t>(EPlayerInput::UP) |
+        static_cast<uint8_t>(EPlayerInput::LEFT),
+    static_cast<uint8_t>(EPlayerInput::UP) |
+        static_cast<uint8_t>(EPlayerInput::RIGHT),
+    static_cast<uint8_t>(EPlayerInput::DOWN) |
+        static_cast<uint8_t>(EPlayerInput::LEFT),
+    static_cast<uint8_t>(EPlayerInput::DOWN) |
+        static_cast<uint8_t>(EPlayerInput::RIGHT),
+};
+constexpr int kMinWalkTicks = 15;
+constexpr int kMaxWalkTicks = 90;
+}  // namespace
+
+void BotStats::Clear() {
+  roundTripMs.clear();
+  snapshotIntervalMs.clear();
+  snapshotJitterMs.clear();
+  bytesReceived = 0;
+  bytesSent = 0;
+}
+
+double BotStats::Percentile(std::vector<double>& samples, double percent) {
+  if (samples.empty()) return 0.0;
+  const double rank = std::ceil(percent / 100.0 * samples.size());
+  const std::size_t index = std::min(
+      samples.size() - 1,
+      static_cast<std::size_t>(std::max(rank, 1.0)) - 1);
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+BotClient::BotClient(uint32_t index, uint32_t seed, BotStats* stats,
+                     float chatChance)
+    : stats(stats),
+      name("bot_" + std::to_string(index)),
+      random(seed),
+      chatChance(chatChance) {
+  pendingInputs.reserve(kMaxMoveBatch + 1);
+  sendTimes.fill(-1.0);
+}
+
+void BotClient::Start(std::vector<uint8_t>& out) {
+  PacketPtr packet = MakePacket<CONNECT_SYN>(name, uint32_t{0});
+  Append(packet.get(), out);
+}
+
+bool BotClient::OnReceive(const uint8_t* data, std::size_t size, double now) {
+  stats->bytesReceived += size;
+  assembler.Feed(data, size);
+
+  PacketPtr packet;
+  while (assembler.Next(packet)) HandlePacket(packet.get(), now);
+  return !assembler.IsCorrupted();
+}
+
+void BotClient::Tick(double now, std::vector<uint8_t>& out) {
+  if (!bIsConnected) return;
+
+  SendMoveRequest(now, out);
+
+  std::uniform_real_distribution<float> chance(0.f, 1.f);
+  if (chance(random) < chatChance) SendChat(out);
+}
+
+void BotClient::HandlePacket(const uint8_t* packet, double now) {
+  PacketReader reader(packet);
+  if (!reader.IsOk()) return;
+
+  switch (reader.GetPacketId()) {
+    case CONNECT_ACK:
+      ConnectAckHandler(reader);
+      break;
+    case CLIENT_MOVE_RES:
+      ClientMoveResHandler(reader, now);
+      break;
+    case TRANSFORM_SNAPSHOT:
+      TransformSnapshotHandler(now);
+      break;
+    default:
+      // Other broadcasts only count towards received bytes
+      break;
+  }
+}
+
+void BotClient::ConnectAckHandler(PacketReader& reader) {
+  auto header = reader.ReadHeader<CONNECT_ACK>();
+  if (!header || bIsConnected) return;
+  clientID = std::get<0>(*header);
+  bIsConnected = true;
+  ++stats->connectedCount;
+}
+
+void BotClient::ClientMoveResHandler(PacketReader& reader, double now) {
+  auto fields = reader.ReadHeader<CLIENT_MOVE_RES>();
+  if (!fields) return;
+  const uint16_t ackedSeq = std::get<0>(*fields);
+  if (!util::seq_gt(ackedSeq, lastAckedSeq)) return;
+  lastAckedSeq = ackedSeq;
+
+  const double sentAt = sendTimes[ackedSeq % kSendTimeSlots];
+  if (sentAt >= 0.0) stats->roundTripMs.push_back((now - sentAt) * 1000.0);
+
+  std::erase_if(pendingInputs, [ackedSeq](const PendingInput& input) {
+    return util::seq_leq(input.seq, ackedSeq);
+  });
+}
+
+void BotClient::TransformSnapshotHandler(double now) {
+  if (lastSnapshotTime >= 0.0) {
+    const double interval = now - lastSnapshotTime;
+    stats->snapshotIntervalMs.push_back(interval * 1000.0);
+
+    if (lastSnapshotInterval >= 0.0) {
+      const double delta = std::abs(interval - lastSnapshotInterval);
+      snapshotJitter += (delta - snapshotJitter) / 16.0;
+      stats->snapshotJitterMs.push_back(snapshotJitter * 1000.0);
+    }
+    lastSnapshotInterval = interval;
+  }
+  lastSnapshotTime = now;
+}
+
+void BotClient::SendMoveRequest(double now, std::vector<uint8_t>& out) {
+  const uint8_t inputBit = NextWalkInput();
+
+  ++inputSequenceNumber;
+  sendTimes[inputSequenceNumber % kSendTimeSlots] = -1.0;
+  pendingInputs.push_back({inputSequenceNumber, inputBit});
+  // Only the newest inputs are ever resent
+  if (pendingInputs.size() > kMaxMoveBatch)
+    pendingInputs.erase(pendingInputs.begin());
+
+  // Same batching rule as the real client
+  ++ticksSinceMoveSend;
+  if (inputBit == lastSentInputBit && ticksSinceMoveSend < kMoveBatchTicks)
+    return;
+  ticksSinceMoveSend = 0;
+  lastSentInputBit = inputBit;
+
+  const uint8_t inputCnt = static_cast<uint8_t>(pendingInputs.size());
+  const std::size_t packedSize = (inputCnt + 1) / 2;
+
+  PacketWriter writer(CLIENT_MOVE_REQ,
+                      PayloadSize<CLIENT_MOVE_REQ>() + packedSize);
+  writer.WriteHeader<CLIENT_MOVE_REQ>(inputSequenceNumber, inputCnt);
+  uint8_t*& p = writer.Cursor();
+  std::memset(p, 0, packedSize);
+  for (uint8_t i = 0; i < inputCnt; ++i) {
+    util::WriteInputNibble(p, i, pendingInputs[i].inputBit);
+
+    double& sentAt = sendTimes[pendingInputs[i].seq % kSendTimeSlots];
+    if (sentAt < 0.0) sentAt = now;
+  }
+  p += packedSize;
+
+  PacketPtr packet = writer.Finish();
+  if (packet) Append(packet.get(), out);
+}
+
+void BotClient::SendChat(std::vector<uint8_t>& out) {
+  PacketPtr packet = MakePacket<CHAT_CLIENT>(
+      name + " says hello #" + std::to_string(++chatCount));
+  if (packet) Append(packet.get(), out);
+}
+
+void BotClient::Append(const uint8_t* packet, std::vector<uint8_t>& out) {
+  const uint8_t* rp = packet;
+  PACKET packetId;
+  std::size_t packetSize;
+  util::GetHeader(rp, packetId, packetSize);
+  out.insert(out.end(), packet, packet + packetSize);
+  stats->bytesSent += packetSize;
+}
+
+uint8_t BotClient::NextWalkInput() {
+  if (walkTicksLeft <= 0) {
+    std::uniform_int_distribution<std::size_t> direction(
+        0, std::size(kWalkInputs) - 1);
+    std::uniform_int_distribution<int> duration(kMinWalkTicks, kMaxWalkTicks);
+    walkInput = kWalkInputs[direction(random)];
+    walkTicksLeft = duration(random);
+  }
+  --walkTicksLeft;
+  return walkInput;
+}
@@ -0,0 +1,28 @@
+#include "Core/ByteRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool ByteRing::Write(const uint8_t* data, std::size_t count) {
+  if (count > buffer.size() - size) return false;
+
+  const std::size_t tail = (head + size) % buffer.size();
+  const std::size_t first = std::min(count, buffer.size() - tail);
+  std::memcpy(buffer.data() + tail, data, first);
+  std::memcpy(buffer.data(), data + first, count - first);
+  size += count;
+  return true;
+}
+
+std::size_t ByteRing::Peek(const uint8_t*& outData) const {
+  outData = buffer.data() + head;
+  return std::min(size, buffer.size() - head);
+}
+
+void ByteRing::Consume(std::size_t count) {
+  count = std::min(count, size);
+  head = (head + count) % buffer.size();
+  size -= count;
+  // Restart at the front so later Peeks return one long run
+  if (size == 0) head = 0;
+}
@@ -0,0 +1,93 @@
+#include "Core/ChunkCache.h"
+
+#include <utility>
+
+ChunkCache::ChunkCache(std::size_t budgetBytes, std::size_t blobBudgetBytes)
+    : budgetBytes(budgetBytes), blobBudgetBytes(blobBudgetBytes) {}
+
+void ChunkCache::Insert(std::unique_ptr<Chunk> chunk, std::size_t bytes) {
+  const ChunkCoord coord{chunk->chunkX, chunk->chunkY};
+  const uint64_t key = PackChunkKey(coord.x, coord.y);
+
+  // Replaces whatever was cached for the coordinate
+  ForgetLive(key);
+  TakeBlob(key);
+
+  live.Insert(std::move(chunk));
+  ages.push_front(key);
+  liveEntries[key] = LiveEntry{ages.begin(), bytes};
+  ++stats.liveCount;
+  stats.liveBytes += bytes;
+}
+
+std::unique_ptr<Chunk> ChunkCache::Extract(ChunkCoord coord,
+                                           std::vector<uint8_t>& outBlob) {
+  const uint64_t key = PackChunkKey(coord.x, coord.y);
+  outBlob.clear();
+
+  if (ForgetLive(key)) {
+    ++stats.hits;
+    return live.Extract(coord);
+  }
+
+  if (blobs.count(key) != 0) {
+    outBlob = TakeBlob(key);
+    ++stats.blobHits;
+    return nullptr;
+  }
+
+  ++stats.misses;
+  return nullptr;
+}
+
+Chunk* ChunkCache::Find(ChunkCoord coord) { return live.Find(coord); }
+
+std::unique_ptr<Chunk> ChunkCache::PopOverBudget() {
+  if (stats.liveBytes <= budgetBytes || ages.empty()) return nullptr;
+
+  const uint64_t key = ages.back();
+  ForgetLive(key);
+  ++stats.evictions;
+  return live.Extract(UnpackChunkKey(key));
+}
+
+bool ChunkCache::ForgetLive(uint64_t key) {
+  auto it = liveEntries.find(key);
+  if (it == liveEntries.end()) return false;
+  ages.erase(it->second.age);
+  --stats.liveCount;
+  stats.liveBytes -= it->second.bytes;
+  liveEntries.erase(it);
+  return true;
+}
+
+std::vector<uint8_t> ChunkCache::TakeBlob(uint64_t key) {
+  auto it = blobs.find(key);
+  if (it == blobs.end()) return {};
+  std::vector<uint8_t> data = std::move(it->second.data);
+  blobAges.erase(it->second.age);
+  --stats.blobCount;
+  stats.blobBytes -= data.size();
+  blobs.erase(it);
+  return data;
+}
+
+void ChunkCache::StoreBlob(ChunkCoord coord, std::vector<uint8_t> blob) {
+  const uint64_t key = PackChunkKey(coord.x, coord.y);
+  TakeBlob(key);
+  blobAges.push_front(key);
+  ++stats.blobCount;
+  stats.blobBytes += blob.size();
+  blobs[key] = BlobEntry{blobAges.begin(), std::move(blob)};
+}
+
+bool ChunkCache::PopBlobOverBudget(ChunkCoord& outCoord,
+                                   std::vector<uint8_t>& outBlob) {
+  if (stats.blobBytes <= blobBudgetBytes || blobAges.empty()) return false;
+
+  const uint64_t key = blobAges.back();
+  outCoord = UnpackChunkKey(key);
+  outBlob = TakeBlob(key);
+  ++stats.blobEvictions;
+  return true;
+}
@@ -0,0 +1,92 @@
+#include "Core/ChunkMap.h"
+
+#include <utility>
+
+namespace {
+// Power of two, the table doubles at half load
+constexpr std::size_t kInitialSlots = 64;
+}  // namespace
+
+ChunkMap::ChunkMap() : slots(kInitialSlots) {}
+
+std::size_t ChunkMap::Home(uint64_t key) const {
+  // Fibonacci hashing, neighboring chunks differ only in the low bits of x
+  // and y and must not land in neighboring slots
+  return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) &
+         (slots.size() - 1);
+}
+
+std::size_t ChunkMap::Probe(uint64_t key) const {
+  const std::size_t mask = slots.size() - 1;
+  std::size_t index = Home(key);
+  while (slots[index].chunk && slots[index].key != key)
+    index = (index + 1) & mask;
+  return index;
+}
+
+Chunk* ChunkMap::Find(int chunkX, int chunkY) {
+  const uint64_t key = PackChunkKey(chunkX, chunkY);
+  if (lastChunk != nullptr && lastKey == key) return lastChunk;
+
+  Chunk* chunk = slots[Probe(key)].chunk.get();
+  if (chunk != nullptr) {
+    lastKey = key;
+    lastChunk = chunk;
+  }
+  return chunk;
+}
+
+const Chunk* ChunkMap::Find(int chunkX, int chunkY) const {
+  return const_cast<ChunkMap*>(this)->Find(chunkX, chunkY);
+}
+
+Chunk& ChunkMap::Insert(std::unique_ptr<Chunk> chunk) {
+  if ((count + 1) * 2 > slots.size()) Grow();
+
+  const uint64_t key = PackChunkKey(chunk->chunkX, chunk->chunkY);
+  Slot& slot = slots[Probe(key)];
+  if (slot.chunk) {
+    if (lastChunk == slot.chunk.get()) lastChunk = nullptr;
+  } else {
+    ++count;
+  }
+  slot.key = key;
+  slot.chunk = std::move(chunk);
+  return *slot.chunk;
+}
+
+Chunk& ChunkMap::Emplace(int chunkX, int chunkY) {
+  return Insert(std::make_unique<Chunk>(chunkX, chunkY));
+}
+
+std::unique_ptr<Chunk> ChunkMap::Extract(ChunkCoord coord) {
+  const uint64_t key = PackChunkKey(coord.x, coord.y);
+  std::size_t hole = Probe(key);
+  if (!slots[hole].chunk) return nullptr;
+
+  std::unique_ptr<Chunk> chunk = std::move(slots[hole].chunk);
+  if (lastChunk == chunk.get()) lastChunk = nullptr;
+  --count;
+
+  // Backward shift instead of tombstones, later entries of the cluster move
+  // into the hole unless that would put them before their home slot
+  const std::size_t mask = slots.size() - 1;
+  std::size_t next = (hole + 1) & mask;
+  while (slots[next].chunk) {
+    const std::size_t home = Home(slots[next].key);
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      slots[hole] = std::move(slots[next]);
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+  return chunk;
+}
+
+void ChunkMap::Grow() {
+  std::vector<Slot> old = std::move(slots);
+  slots = std::vector<Slot>(old.size() * 2);
+  for (Slot& slot : old) {
+    if (slot.chunk) slots[Probe(slot.key)] = std::move(slot);
+  }
+}
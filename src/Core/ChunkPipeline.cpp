@@ -0,0 +1,97 @@
+#include "Core/ChunkPipeline.h"
+
+#include <algorithm>
+#include <utility>
+
+ChunkPipeline::ChunkPipeline(std::size_t workerCount, uint64_t seed)
+    : generator(seed) {
+  if (workerCount == 0) {
+    // Leave a core for the game thread
+    const unsigned int hardware = std::thread::hardware_concurrency();
+    workerCount = hardware > 1 ? hardware - 1 : 1;
+  }
+  workers.reserve(workerCount);
+  for (std::size_t i = 0; i < workerCount; ++i)
+    workers.emplace_back(&ChunkPipeline::WorkerLoop, this);
+}
+
+ChunkPipeline::~ChunkPipeline() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    bIsStopping = true;
+  }
+  workAvailable.notify_all();
+  for (std::thread& worker : workers) worker.join();
+}
+
+void ChunkPipeline::Request(ChunkCoord coord, int priority) {
+  const uint64_t key = PackChunkKey(coord.x, coord.y);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    canceled.erase(key);
+    auto it = queued.find(key);
+    if (it != queued.end()) {
+      it->second = priority;
+      return;
+    }
+    if (running.count(key)) return;
+    for (const GeneratedChunk& done : completed) {
+      if (done.chunk.chunkX == coord.x && done.chunk.chunkY == coord.y)
+        return;
+    }
+    queued.emplace(key, priority);
+  }
+  workAvailable.notify_one();
+}
+
+void ChunkPipeline::Cancel(ChunkCoord coord) {
+  const uint64_t key = PackChunkKey(coord.x, coord.y);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (queued.erase(key)) return;
+  if (running.count(key)) canceled.insert(key);
+  completed.remove_if([coord](const GeneratedChunk& done) {
+    return done.chunk.chunkX == coord.x && done.chunk.chunkY == coord.y;
+  });
+}
+
+bool ChunkPipeline::IsPending(ChunkCoord coord) const {
+  const uint64_t key = PackChunkKey(coord.x, coord.y);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (queued.count(key) || (running.count(key) && !canceled.count(key)))
+    return true;
+  return std::any_of(completed.begin(), completed.end(),
+                     [coord](const GeneratedChunk& done) {
+                       return done.chunk.chunkX == coord.x &&
+                              done.chunk.chunkY == coord.y;
+                     });
+}
+
+void ChunkPipeline::TakeCompleted(std::list<GeneratedChunk>& out) {
+  std::lock_guard<std::mutex> lock(mutex);
+  out.splice(out.end(), completed);
+}
+
+void ChunkPipeline::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    workAvailable.wait(lock, [this] { return bIsStopping || !queued.empty(); });
+    if (bIsStopping) return;
+
+    // A handful of chunks are queued at a time, a scan beats keeping a heap
+    // in sync with priority updates and cancels
+    auto next = std::min_element(
+        queued.begin(), queued.end(),
+        [](const auto& a, const auto& b) { return a.second < b.second; });
+    const uint64_t key = next->first;
+    queued.erase(next);
+    running.insert(key);
+
+    lock.unlock();
+    GeneratedChunk generated = generator.Generate(UnpackChunkKey(key));
+    lock.lock();
+
+    running.erase(key);
+    if (canceled.erase(key)) continue;
+    completed.push_back(std::move(generated));
+  }
+}
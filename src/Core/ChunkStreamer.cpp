@@ -0,0 +1,139 @@
+#include "Core/ChunkStreamer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "Core/PacketSchema.h"
+
+namespace {
+// Keeps CHUNK_UNLOAD inside the 1024 byte receive buffers
+constexpr std::size_t kMaxUnloadsPerPacket = 100;
+}  // namespace
+
+ChunkStreamer::ChunkStreamer(int viewDistance) : viewDistance(viewDistance) {}
+
+void ChunkStreamer::AddClient(clientid_t clientID) {
+  clients[clientID] = ClientStream{};
+}
+
+void ChunkStreamer::RemoveClient(clientid_t clientID) {
+  clients.erase(clientID);
+}
+
+void ChunkStreamer::SetCenter(clientid_t clientID, ChunkCoord center) {
+  auto it = clients.find(clientID);
+  if (it == clients.end()) return;
+  it->second.center = center;
+  it->second.bHasCenter = true;
+}
+
+bool ChunkStreamer::HasChunk(clientid_t clientID, ChunkCoord chunk) const {
+  auto it = clients.find(clientID);
+  if (it == clients.end()) return false;
+  return it->second.chunks.count(PackChunkKey(chunk.x, chunk.y)) != 0;
+}
+
+std::size_t ChunkStreamer::GetChunkCount(clientid_t clientID) const {
+  auto it = clients.find(clientID);
+  return it != clients.end() ? it->second.chunks.size() : 0;
+}
+
+void ChunkStreamer::ResendChunk(ChunkCoord chunk) {
+  const uint64_t key = PackChunkKey(chunk.x, chunk.y);
+  for (auto& [clientID, stream] : clients)
+    if (stream.chunks.count(key)) stream.stale.insert(key);
+}
+
+void ChunkStreamer::Flush(clientid_t clientID, float deltaTime,
+                          const Encoder& encode,
+                          std::vector<PacketPtr>& outPackets) {
+  auto it = clients.find(clientID);
+  if (it == clients.end() || !it->second.bHasCenter) return;
+  ClientStream& stream = it->second;
+
+  stream.budget = std::min(stream.budget + kChunkBytesPerSecond * deltaTime,
+                           kChunkBurstBytes);
+
+  WriteUnloads(stream, outPackets);
+
+  // Changed chunks are already on screen, they go before the missing ones
+  for (auto staleIt = stream.stale.begin(); staleIt != stream.stale.end();) {
+    if (stream.budget <= 0.f) return;
+    if (WriteChunk(stream, UnpackChunkKey(*staleIt), encode, outPackets))
+      staleIt = stream.stale.erase(staleIt);
+    else
+      ++staleIt;
+  }
+
+  missing.clear();
+  const ChunkCoord center = stream.center;
+  for (int y = center.y - viewDistance; y <= center.y + viewDistance; ++y) {
+    for (int x = center.x - viewDistance; x <= center.x + viewDistance; ++x) {
+      if (stream.chunks.count(PackChunkKey(x, y))) continue;
+      const int dx = x - center.x;
+      const int dy = y - center.y;
+      missing.emplace_back(dx * dx + dy * dy, ChunkCoord{x, y});
+    }
+  }
+  if (missing.empty()) return;
+
+  // Nearest first, the screen fills from the player outwards
+  std::sort(missing.begin(), missing.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  for (const auto& [distance, chunk] : missing) {
+    if (stream.budget <= 0.f) break;
+    WriteChunk(stream, chunk, encode, outPackets);
+  }
+}
+
+bool ChunkStreamer::WriteChunk(ClientStream& stream, ChunkCoord chunk,
+                               const Encoder& encode,
+                               std::vector<PacketPtr>& outPackets) {
+  PacketPtr packet = encode(chunk);
+  if (packet == nullptr) return false;
+
+  PACKET packetId;
+  std::size_t size;
+  const uint8_t* hp = packet.get();
+  util::GetHeader(hp, packetId, size);
+
+  outPackets.push_back(std::move(packet));
+  stream.chunks.insert(PackChunkKey(chunk.x, chunk.y));
+  stream.budget -= static_cast<float>(size);
+  return true;
+}
+
+void ChunkStreamer::WriteUnloads(ClientStream& stream,
+                                 std::vector<PacketPtr>& outPackets) {
+  unloads.clear();
+  const int unloadDistance = viewDistance + kChunkUnloadMargin;
+  for (auto chunkIt = stream.chunks.begin(); chunkIt != stream.chunks.end();) {
+    const ChunkCoord chunk = UnpackChunkKey(*chunkIt);
+    if (std::abs(chunk.x - stream.center.x) > unloadDistance ||
+        std::abs(chunk.y - stream.center.y) > unloadDistance) {
+      unloads.push_back(chunk);
+      stream.stale.erase(*chunkIt);
+      chunkIt = stream.chunks.erase(chunkIt);
+    } else {
+      ++chunkIt;
+    }
+  }
+
+  // Unloads are tiny and always sent, a client must not hold stale chunks
+  for (std::size_t first = 0; first < unloads.size();
+       first += kMaxUnloadsPerPacket) {
+    const std::size_t count =
+        std::min(kMaxUnloadsPerPacket, unloads.size() - first);
+    PacketWriter writer(CHUNK_UNLOAD, PayloadSize<CHUNK_UNLOAD>(count));
+    writer.WriteHeader<CHUNK_UNLOAD>(static_cast<uint16_t>(count));
+    for (std::size_t i = first; i < first + count; ++i)
+      writer.WriteRecord<CHUNK_UNLOAD>(unloads[i].x, unloads[i].y);
+
+    PacketPtr packet = writer.Finish();
+    if (packet == nullptr) continue;
+    stream.budget -=
+        static_cast<float>(sPacketHeader + PayloadSize<CHUNK_UNLOAD>(count));
+    outPackets.push_back(std::move(packet));
+  }
+}
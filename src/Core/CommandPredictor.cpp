@@ -0,0 +1,193 @@
+#include "Core/CommandPredictor.h"
+
+#include <algorithm>
+#include <iostream>
+
+CommandPredictor::CommandPredictor(Registry* registry, DestroyFn destroy)
+    : registry(registry), destroy(std::move(destroy)) {
+  if (!this->destroy) {
+    this->destroy = [registry](EntityID entity) {
+      registry->DestroyEntity(entity);
+    };
+  }
+}
+
+uint16_t CommandPredictor::Predict(ApplyFn apply) {
+  const uint16_t sequence = nextSequence++;
+  pending.push_back(PendingCommand{sequence, false, std::move(apply),
+                                   PredictionScope(registry, false), {}, {}});
+  PendingCommand& command = pending.back();
+  command.apply(command.scope);
+  return sequence;
+}
+
+void CommandPredictor::Confirm(uint16_t sequence) {
+  for (PendingCommand& command : pending) {
+    if (command.sequence != sequence) continue;
+    command.bIsConfirmed = true;
+    // Replicated entities take over from the local stand-ins once they
+    // arrive
+    KeepStandIns(command.scope);
+    PopConfirmed();
+    return;
+  }
+}
+
+bool CommandPredictor::HandOver(uint64_t handOverKey) {
+  auto matches = [handOverKey](const PredictionScope::Created& created) {
+    return created.handOverKey == handOverKey;
+  };
+
+  auto it = std::find_if(standIns.begin(), standIns.end(), matches);
+  if (it != standIns.end()) {
+    destroy(it->entity);
+    standIns.erase(it);
+    return true;
+  }
+
+  // Entity arrived ahead of the ack, a rollback must not destroy it again
+  // and a replay must not make it again
+  for (PendingCommand& command : pending) {
+    std::vector<PredictionScope::Created>& created = command.scope.created;
+    auto createdIt = std::find_if(created.begin(), created.end(), matches);
+    if (createdIt == created.end()) continue;
+    destroy(createdIt->entity);
+    created.erase(createdIt);
+    command.handedOver.push_back(handOverKey);
+    return true;
+  }
+  return false;
+}
+
+void CommandPredictor::DropStandIns() {
+  for (const PredictionScope::Created& created : standIns)
+    destroy(created.entity);
+  standIns.clear();
+}
+
+void CommandPredictor::Reject(uint16_t sequence) {
+  std::size_t index = 0;
+  while (index < pending.size() && pending[index].sequence != sequence)
+    ++index;
+  if (index == pending.size()) {
+    std::cerr << "COMMAND_ACK for unknown command " << sequence << std::endl;
+    return;
+  }
+
+  // Unwind to the state before the rejected command
+  for (std::size_t i = pending.size(); i-- > index;) Undo(pending[i].scope);
+  pending.erase(pending.begin() + index);
+
+  bIsReplaying = true;
+  for (std::size_t i = index; i < pending.size(); ++i) {
+    PendingCommand& command = pending[i];
+    Replay(command);
+    // Its stand-ins were kept when it was confirmed, the replay made copies
+    if (command.bIsConfirmed) DestroyCreated(command.scope);
+  }
+  bIsReplaying = false;
+
+  PopConfirmed();
+}
+
+void CommandPredictor::RejectAll() {
+  // Oldest first, each rejection replays only what is still pending
+  while (true) {
+    auto it = std::find_if(
+        pending.begin(), pending.end(),
+        [](const PendingCommand& command) { return !command.bIsConfirmed; });
+    if (it == pending.end()) break;
+    Reject(it->sequence);
+  }
+}
+
+void CommandPredictor::Rebase(EntityID entity) {
+  auto touches = [entity](const PendingCommand& command) {
+    return std::any_of(
+        command.scope.shadows.begin(), command.scope.shadows.end(),
+        [entity](const PredictionScope::Shadow& shadow) {
+          return shadow.entity == entity;
+        });
+  };
+  if (std::none_of(pending.begin(), pending.end(), touches)) return;
+
+  // Everything else goes back to before the oldest pending command, the
+  // entity keeps what the server wrote
+  for (std::size_t i = pending.size(); i-- > 0;)
+    Undo(pending[i].scope, entity);
+
+  bIsReplaying = true;
+  for (PendingCommand& command : pending) {
+    // The server state already includes what a confirmed command did to the
+    // entity, and its stand-ins were kept when it was confirmed
+    if (command.bIsConfirmed) command.serverOwned.push_back(entity);
+    Replay(command);
+    if (command.bIsConfirmed) DestroyCreated(command.scope);
+  }
+  bIsReplaying = false;
+}
+
+void CommandPredictor::Clear() {
+  pending.clear();
+  standIns.clear();
+}
+
+void CommandPredictor::Undo(PredictionScope& scope, EntityID keep) {
+  for (auto it = scope.shadows.rbegin(); it != scope.shadows.rend(); ++it) {
+    if (it->entity != keep) it->restore(registry);
+  }
+  scope.shadows.clear();
+  DestroyCreated(scope);
+}
+
+void CommandPredictor::RestoreEntity(PredictionScope& scope, EntityID entity) {
+  std::vector<PredictionScope::Shadow>& shadows = scope.shadows;
+  for (auto it = shadows.rbegin(); it != shadows.rend(); ++it) {
+    if (it->entity == entity) it->restore(registry);
+  }
+  std::erase_if(shadows, [entity](const PredictionScope::Shadow& shadow) {
+    return shadow.entity == entity;
+  });
+}
+
+void CommandPredictor::Replay(PendingCommand& command) {
+  command.scope = PredictionScope(registry, true);
+  command.apply(command.scope);
+  for (EntityID entity : command.serverOwned)
+    RestoreEntity(command.scope, entity);
+
+  // The server's entity already took over from these
+  std::vector<PredictionScope::Created>& created = command.scope.created;
+  for (auto it = created.begin(); it != created.end();) {
+    if (it->handOverKey &&
+        std::find(command.handedOver.begin(), command.handedOver.end(),
+                  *it->handOverKey) != command.handedOver.end()) {
+      destroy(it->entity);
+      it = created.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void CommandPredictor::DestroyCreated(PredictionScope& scope) {
+  for (const PredictionScope::Created& created : scope.created)
+    destroy(created.entity);
+  scope.created.clear();
+}
+
+void CommandPredictor::KeepStandIns(PredictionScope& scope) {
+  for (const PredictionScope::Created& created : scope.created) {
+    if (created.handOverKey)
+      standIns.push_back(created);
+    else
+      destroy(created.entity);
+  }
+  scope.created.clear();
+}
+
+void CommandPredictor::PopConfirmed() {
+  // Shadows of a confirmed command stay while an older one may still be
+  // rejected and unwind through it
+  while (!pending.empty() && pending.front().bIsConfirmed) pending.pop_front();
+}
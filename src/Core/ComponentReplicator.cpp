@@ -0,0 +1,232 @@
+#include "Core/ComponentReplicator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Components/AssemblingMachineComponent.h"
+#include "Components/InventoryComponent.h"
+#include "Components/MiningDrillComponent.h"
+#include "Components/ResourceNodeComponent.h"
+#include "Util/PacketUtil.h"
+
+namespace {
+
+inline bool HasBytes(const uint8_t* rp, const uint8_t* end, std::size_t n) {
+  return rp <= end && static_cast<std::size_t>(end - rp) >= n;
+}
+
+inline uint16_t ClampAmount(int amount) {
+  return static_cast<uint16_t>(std::clamp(amount, 0, 0xFFFF));
+}
+
+/**
+ * ResourceNode :
+ * uint32_t : left_resource
+ */
+std::size_t ResourceNodeSize(Registry*, EntityID) { return sizeof(uint32_t); }
+
+void ResourceNodeWrite(Registry* registry, EntityID entity, uint8_t*& wp) {
+  const auto& node = registry->GetComponent<ResourceNodeComponent>(entity);
+  util::Write32BigEnd(wp, static_cast<uint32_t>(node.LeftResource));
+}
+
+bool ResourceNodeRead(Registry* registry, EntityID entity, const uint8_t*& rp,
+                      const uint8_t* end) {
+  if (!HasBytes(rp, end, sizeof(uint32_t))) return false;
+  const uint32_t left = util::Read32BigEnd(rp);
+
+  if (entity != INVALID_ENTITY &&
+      registry->HasComponent<ResourceNodeComponent>(entity)) {
+    registry->GetComponent<ResourceNodeComponent>(entity).LeftResource =
+        static_cast<rsrc_amt_t>(left);
+  }
+  return true;
+}
+
+/**
+ * AssemblingMachine :
+ * uint8_t : recipe_id
+ * uint8_t : state
+ * uint8_t : is_animating
+ * uint8_t : input_cnt,  [uint8_t item_id, uint16_t amount] x input_cnt
+ * uint8_t : output_cnt, [uint8_t item_id, uint16_t amount] x output_cnt
+ */
+constexpr std::size_t kItemStackSize = sizeof(uint8_t) + sizeof(uint16_t);
+
+std::size_t AssemblingMachineSize(Registry* registry, EntityID entity) {
+  const auto& machine =
+      registry->GetComponent<AssemblingMachineComponent>(entity);
+  return sizeof(uint8_t) * 5 +
+         (machine.inputInventory.size() + machine.outputInventory.size()) *
+             kItemStackSize;
+}
+
+void WriteItemMap(uint8_t*& wp, const std::unordered_map<ItemID, int>& items) {
+  *wp++ = static_cast<uint8_t>(items.size());
+  for (const auto& [item, amount] : items) {
+    *wp++ = static_cast<uint8_t>(item);
+    util::Write16BigEnd(wp, ClampAmount(amount));
+  }
+}
+
+bool ReadItemMap(const uint8_t*& rp, const uint8_t* end,
+                 std::unordered_map<ItemID, int>& items) {
+  if (!HasBytes(rp, end, sizeof(uint8_t))) return false;
+  const uint8_t count = *rp++;
+  if (!HasBytes(rp, end, count * kItemStackSize)) return false;
+
+  items.clear();
+  for (uint8_t i = 0; i < count; ++i) {
+    ItemID item = static_cast<ItemID>(*rp++);
+    items[item] = util::Read16BigEnd(rp);
+  }
+  return true;
+}
+
+void AssemblingMachineWrite(Registry* registry, EntityID entity,
+                            uint8_t*& wp) {
+  const auto& machine =
+      registry->GetComponent<AssemblingMachineComponent>(entity);
+  *wp++ = static_cast<uint8_t>(machine.currentRecipe);
+  *wp++ = static_cast<uint8_t>(machine.state);
+  *wp++ = machine.bIsAnimating ? 1 : 0;
+  WriteItemMap(wp, machine.inputInventory);
+  WriteItemMap(wp, machine.outputInventory);
+}
+
+bool AssemblingMachineRead(Registry* registry, EntityID entity,
+                           const uint8_t*& rp, const uint8_t* end) {
+  if (!HasBytes(rp, end, sizeof(uint8_t) * 3)) return false;
+  const RecipeID recipe = static_cast<RecipeID>(*rp++);
+  const auto state = static_cast<AssemblingMachineState>(*rp++);
+  const bool bIsAnimating = *rp++ != 0;
+
+  std::unordered_map<ItemID, int> input, output;
+  if (!ReadItemMap(rp, end, input)) return false;
+  if (!ReadItemMap(rp, end, output)) return false;
+
+  if (entity == INVALID_ENTITY ||
+      !registry->HasComponent<AssemblingMachineComponent>(entity))
+    return true;
+
+  // UI flags stay local to each peer
+  auto& machine = registry->GetComponent<AssemblingMachineComponent>(entity);
+  machine.currentRecipe = recipe;
+  machine.state = state;
+  machine.bIsAnimating = bIsAnimating;
+  machine.inputInventory = std::move(input);
+  machine.outputInventory = std::move(output);
+  if (recipe != RecipeID::None) machine.bIsShowingRecipeSelection = false;
+  return true;
+}
+
+/**
+ * MiningDrill :
+ * uint8_t :  state
+ * uint8_t :  is_animating
+ * uint8_t :  output_item_id (ItemID::None if empty)
+ * uint16_t : output_amount
+ */
+std::size_t MiningDrillSize(Registry*, EntityID) {
+  return sizeof(uint8_t) * 3 + sizeof(uint16_t);
+}
+
+void MiningDrillWrite(Registry* registry, EntityID entity, uint8_t*& wp) {
+  const auto& drill = registry->GetComponent<MiningDrillComponent>(entity);
+  *wp++ = static_cast<uint8_t>(drill.state);
+  *wp++ = drill.bIsAnimating ? 1 : 0;
+
+  std::pair<ItemID, int> output{ItemID::None, 0};
+  if (registry->HasComponent<InventoryComponent>(entity)) {
+    const auto& inv = registry->GetComponent<InventoryComponent>(entity);
+    if (!inv.items.empty()) output = inv.items[0];
+  }
+  *wp++ = static_cast<uint8_t>(output.first);
+  util::Write16BigEnd(wp, ClampAmount(output.second));
+}
+
+bool MiningDrillRead(Registry* registry, EntityID entity, const uint8_t*& rp,
+                     const uint8_t* end) {
+  if (!HasBytes(rp, end, MiningDrillSize(registry, entity))) return false;
+  const auto state = static_cast<MiningDrillState>(*rp++);
+  const bool bIsAnimating = *rp++ != 0;
+  const ItemID outputItem = static_cast<ItemID>(*rp++);
+  const int outputAmount = util::Read16BigEnd(rp);
+
+  if (entity == INVALID_ENTITY ||
+      !registry->HasComponent<MiningDrillComponent>(entity))
+    return true;
+
+  auto& drill = registry->GetComponent<MiningDrillComponent>(entity);
+  drill.state = state;
+  drill.bIsAnimating = bIsAnimating;
+
+  if (registry->HasComponent<InventoryComponent>(entity)) {
+    auto& inv = registry->GetComponent<InventoryComponent>(entity);
+    inv.items.clear();
+    if (outputItem != ItemID::None && outputAmount > 0)
+      inv.items.emplace_back(outputItem, outputAmount);
+  }
+  return true;
+}
+
+}  // namespace
+
+ComponentReplicator::ComponentReplicator() {
+  Register<ResourceNodeComponent>(EReplicatedComponent::ResourceNode,
+                                  &ResourceNodeSize, &ResourceNodeWrite,
+                                  &ResourceNodeRead);
+  Register<AssemblingMachineComponent>(
+      EReplicatedComponent::AssemblingMachine, &AssemblingMachineSize,
+      &AssemblingMachineWrite, &AssemblingMachineRead);
+  Register<MiningDrillComponent>(EReplicatedComponent::MiningDrill,
+                                 &MiningDrillSize, &MiningDrillWrite,
+                                 &MiningDrillRead);
+}
+
+uint8_t ComponentReplicator::GetMask(Registry* registry,
+                                     EntityID entity) const {
+  uint8_t mask = 0;
+  for (std::size_t i = 0; i < ops.size(); ++i) {
+    if (ops[i].has && ops[i].has(registry, entity))
+      mask |= static_cast<uint8_t>(1u << i);
+  }
+  return mask;
+}
+
+std::size_t ComponentReplicator::GetSize(Registry* registry, EntityID entity,
+                                         uint8_t mask) const {
+  std::size_t size = sizeof(uint8_t);
+  for (std::size_t i = 0; i < ops.size(); ++i) {
+    if (!(mask & (1u << i)) || !ops[i].has) continue;
+    if (ops[i].has(registry, entity)) size += ops[i].size(registry, entity);
+  }
+  return size;
+}
+
+void ComponentReplicator::Write(Registry* registry, EntityID entity,
+                                uint8_t mask, uint8_t*& wp) const {
+  uint8_t present = 0;
+  for (std::size_t i = 0; i < ops.size(); ++i) {
+    if ((mask & (1u << i)) && ops[i].has && ops[i].has(registry, entity))
+      present |= static_cast<uint8_t>(1u << i);
+  }
+
+  *wp++ = present;
+  for (std::size_t i = 0; i < ops.size(); ++i) {
+    if (present & (1u << i)) ops[i].write(registry, entity, wp);
+  }
+}
+
+bool ComponentReplicator::Read(Registry* registry, EntityID entity,
+                               const uint8_t*& rp, const uint8_t* end) const {
+  if (!HasBytes(rp, end, sizeof(uint8_t))) return false;
+  const uint8_t mask = *rp++;
+
+  for (std::size_t i = 0; i < 8; ++i) {
+    if (!(mask & (1u << i))) continue;
+    if (i >= ops.size() || !ops[i].read) return false;
+    if (!ops[i].read(registry, entity, rp, end)) return false;
+  }
+  return true;
+}
@@ -23,17 +23,21 @@
 EntityFactory::EntityFactory(Registry *registry, AssetManager *assetManager)
     : registry(registry), assetManager(assetManager) {}
 
-EntityID EntityFactory::CreateAssemblingMachine(World *world, Vec2f worldPos) {
+EntityID EntityFactory::CreateAssemblingMachine(World *world, Vec2f worldPos,
+                                                EntityID builder) {
   if (registry == nullptr || world == nullptr) return INVALID_ENTITY;
 
   Vec2 tileIndex = world->GetTileIndexFromWorldPosition(worldPos);
-  return CreateAssemblingMachine(world, tileIndex);
+  return CreateAssemblingMachine(world, tileIndex, false, builder);
 }
 
-EntityID EntityFactory::CreateAssemblingMachine(World *world, Vec2 tileIndex) {
+EntityID EntityFactory::CreateAssemblingMachine(World *world, Vec2 tileIndex,
+                                                bool bIsReplicated,
+                                                EntityID builder) {
   if (registry == nullptr || world == nullptr) return INVALID_ENTITY;
 
-  if (!world->HasNoOcuupyingEntity(tileIndex, 2, 2)) {
+  if (!bIsReplicated &&
+      !world->HasNoOcuupyingEntity(tileIndex, 2, 2, builder)) {
     return INVALID_ENTITY;
   }
 
@@ -81,17 +85,21 @@ EntityID EntityFactory::CreateAssemblingMachine(World *world, Vec2 tileIndex) {
   return entity;
 }
 
-EntityID EntityFactory::CreateMiningDrill(World *world, Vec2f worldPos) {
+EntityID EntityFactory::CreateMiningDrill(World *world, Vec2f worldPos,
+                                          EntityID builder) {
   if (registry == nullptr || world == nullptr) return INVALID_ENTITY;
 
   Vec2 tileIndex = world->GetTileIndexFromWorldPosition(worldPos);
-  return CreateMiningDrill(world, tileIndex);
+  return CreateMiningDrill(world, tileIndex, false, builder);
 }
 
-EntityID EntityFactory::CreateMiningDrill(World *world, Vec2 tileIndex) {
+EntityID EntityFactory::CreateMiningDrill(World *world, Vec2 tileIndex,
+                                          bool bIsReplicated,
+                                          EntityID builder) {
   if (registry == nullptr || world == nullptr) return INVALID_ENTITY;
 
-  if (!world->HasNoOcuupyingEntity(tileIndex, 1, 1)) {
+  if (!bIsReplicated &&
+      !world->HasNoOcuupyingEntity(tileIndex, 1, 1, builder)) {
     return INVALID_ENTITY;
   }
 
@@ -143,8 +151,8 @@ EntityID EntityFactory::CreateMiningDrill(World *world, Vec2 tileIndex) {
 
   MiningDrillComponent drill;
 
-  if (TileData *tile = world->GetTileAtTileIndex(tileIndex)) {
-    drill.oreEntity = tile->oreEntity;
+  if (TileRef tile = world->GetTileAtTileIndex(tileIndex)) {
+    drill.oreEntity = tile.GetOreEntity();
   }
   registry->AddComponent<MiningDrillComponent>(entity, std::move(drill));
   registry->EmplaceComponent<InventoryComponent>(entity, InventoryComponent{});
@@ -0,0 +1,150 @@
+#include "Core/InputPrediction.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Components/BuildingComponent.h"
+#include "Components/InputStateComponent.h"
+#include "Core/Chunk.h"
+#include "Core/Packet.h"
+#include "Core/Registry.h"
+#include "Core/TileData.h"
+#include "Util/PacketUtil.h"
+
+bool TileCollisionCache::IsPassable(Vec2f worldPos) {
+  const int tileX = static_cast<int>(std::floor(worldPos.x / TILE_PIXEL_SIZE));
+  const int tileY = static_cast<int>(std::floor(worldPos.y / TILE_PIXEL_SIZE));
+  if (bHasLastTile && tileX == lastTileX && tileY == lastTileY)
+    return bLastPassable;
+  lastTileX = tileX;
+  lastTileY = tileY;
+  bHasLastTile = true;
+  bLastPassable = false;
+
+  const int chunkX =
+      static_cast<int>(std::floor(static_cast<float>(tileX) / CHUNK_WIDTH));
+  const int chunkY =
+      static_cast<int>(std::floor(static_cast<float>(tileY) / CHUNK_HEIGHT));
+
+  if (!bHasCached || chunkX != cachedX || chunkY != cachedY) {
+    cachedChunk = lookup(chunkX, chunkY);
+    cachedX = chunkX;
+    cachedY = chunkY;
+    bHasCached = true;
+    ++lookupCount;
+  }
+  if (cachedChunk == nullptr) return false;
+
+  const Vec2 local = cachedChunk->GetLocalTileIndex(tileX, tileY);
+  const int index = Chunk::GetLocalIndex(local.x, local.y);
+  const TileType type = cachedChunk->GetType(index);
+  if (type == TileType::Water || type == TileType::Invalid) return false;
+  // Only the occupancy mask is read for the common empty tile
+  if (cachedChunk->HasOccupant(index) &&
+      registry->HasComponent<BuildingComponent>(
+          cachedChunk->GetOccupyingEntity(index)))
+    return false;
+
+  bLastPassable = true;
+  return true;
+}
+
+void PredictMove(Vec2f& position, float speed, uint8_t inputBit,
+                 float deltaTime, TileCollisionCache& collision) {
+  int ix = 0, iy = 0;
+  if (inputBit & static_cast<uint8_t>(EPlayerInput::RIGHT)) ix++;
+  if (inputBit & static_cast<uint8_t>(EPlayerInput::LEFT)) ix--;
+  if (inputBit & static_cast<uint8_t>(EPlayerInput::UP)) iy++;
+  if (inputBit & static_cast<uint8_t>(EPlayerInput::DOWN)) iy--;
+  if (ix == 0 && iy == 0) return;
+
+  float len = std::sqrt(static_cast<float>(ix * ix + iy * iy));
+  float stepX = ix / len * speed * deltaTime;
+  float stepY = iy / len * speed * deltaTime;
+
+  // lightweight client collision to reduce obvious tunneling
+  Vec2f tryPos{position.x + stepX, position.y + stepY};
+  if (collision.IsPassable(tryPos)) {
+    position = tryPos;
+    return;
+  }
+  // axis-separated fallback
+  Vec2f tryX{position.x + stepX, position.y};
+  if (collision.IsPassable(tryX)) position.x = tryX.x;
+  Vec2f tryY{position.x, position.y + stepY};
+  if (collision.IsPassable(tryY)) position.y = tryY.y;
+}
+
+void PendingInputRing::Push(const PredictedInput& input) {
+  if (count > 0 && input.sequence != static_cast<uint16_t>(oldest + count))
+    count = 0;
+  if (count == 0) oldest = input.sequence;
+
+  if (count == kCapacity) {
+    ++oldest;
+    --count;
+  }
+  inputs[input.sequence % kCapacity] = input;
+  ++count;
+}
+
+const PredictedInput* PendingInputRing::Ack(uint16_t sequence) {
+  // Older than the oldest pending input wraps past count as well
+  const std::size_t offset = static_cast<uint16_t>(sequence - oldest);
+  if (offset >= count) return nullptr;
+
+  oldest = static_cast<uint16_t>(sequence + 1);
+  count -= offset + 1;
+  return &inputs[sequence % kCapacity];
+}
+
+Vec2f PendingInputRing::Replay(Vec2f position, float speed,
+                               TileCollisionCache& collision) {
+  for (std::size_t i = 0; i < count; ++i) {
+    PredictedInput& input =
+        inputs[static_cast<uint16_t>(oldest + i) % kCapacity];
+    PredictMove(position, speed, input.inputBit, input.deltaTime, collision);
+    input.predX = position.x;
+    input.predY = position.y;
+  }
+  return position;
+}
+
+bool QueueMoveBatch(InputStateComponent& state, uint16_t newestSeq,
+                    uint8_t inputCnt, const uint8_t* packed) {
+  if (!util::seq_gt(newestSeq, state.lastReceivedSeq)) return false;
+
+  const uint16_t unseen = newestSeq - state.lastReceivedSeq;
+  const uint8_t fresh =
+      static_cast<uint8_t>(std::min<uint16_t>(unseen, inputCnt));
+  auto& queued = state.queued;
+  for (uint8_t i = inputCnt - fresh; i < inputCnt; ++i) {
+    if (state.queuedCount == queued.size()) {
+      std::copy(queued.begin() + 1, queued.end(), queued.begin());
+      --state.queuedCount;
+    }
+    queued[state.queuedCount++] = util::ReadInputNibble(packed, i);
+  }
+  state.lastReceivedSeq = newestSeq;
+  return true;
+}
+
+void AdvanceInputTime(InputStateComponent& state, float deltaTime) {
+  state.inputTime += deltaTime;
+  // Running dry keeps the next input due on the frame it arrives, but no
+  // earlier, so it does not pair up with the one after it
+  if (state.queuedCount == 0)
+    state.inputTime =
+        std::clamp(state.inputTime, 0.f, std::max(syncDelta - deltaTime, 0.f));
+}
+
+bool TakeQueuedInput(InputStateComponent& state) {
+  if (state.queuedCount == 0 || state.inputTime < syncDelta) return false;
+  state.inputTime -= syncDelta;
+  state.inputBit = state.queued[0];
+  --state.queuedCount;
+  state.sequence = state.lastReceivedSeq - state.queuedCount;
+  std::copy(state.queued.begin() + 1, state.queued.end(),
+            state.queued.begin());
+  return true;
+}
@@ -0,0 +1,98 @@
+#include "Core/InterestManager.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+InterestManager::InterestManager(int viewDistance)
+    : viewDistance(viewDistance) {}
+
+void InterestManager::UpdateSubject(clientid_t subject, Vec2f worldPos) {
+  const ChunkCoord chunk = World::GetChunkCoordFromWorldPosition(worldPos);
+
+  auto it = subjectChunk.find(subject);
+  if (it != subjectChunk.end()) {
+    if (it->second == chunk) return;
+    RemoveSubject(subject);
+  }
+
+  subjectChunk[subject] = chunk;
+  subjectsByChunk[PackChunkKey(chunk.x, chunk.y)].push_back(subject);
+}
+
+void InterestManager::RemoveSubject(clientid_t subject) {
+  auto it = subjectChunk.find(subject);
+  if (it == subjectChunk.end()) return;
+
+  auto bucketIt = subjectsByChunk.find(PackChunkKey(it->second.x, it->second.y));
+  if (bucketIt != subjectsByChunk.end()) {
+    auto& bucket = bucketIt->second;
+    auto pos = std::find(bucket.begin(), bucket.end(), subject);
+    if (pos != bucket.end()) {
+      // order inside a bucket doesn't matter
+      *pos = bucket.back();
+      bucket.pop_back();
+    }
+    if (bucket.empty()) subjectsByChunk.erase(bucketIt);
+  }
+  subjectChunk.erase(it);
+}
+
+void InterestManager::UpdateObserver(clientid_t observer, Vec2f worldPos) {
+  observers[observer].center = World::GetChunkCoordFromWorldPosition(worldPos);
+}
+
+void InterestManager::RemoveObserver(clientid_t observer) {
+  observers.erase(observer);
+}
+
+bool InterestManager::Refresh(clientid_t observer, ViewDelta& outDelta) {
+  outDelta.entered.clear();
+  outDelta.left.clear();
+
+  auto it = observers.find(observer);
+  if (it == observers.end()) return false;
+  Observer& obs = it->second;
+
+  // Past viewDistance only subjects that were already visible are kept
+  const int reach = viewDistance + kInterestLeaveMargin;
+  scratch.clear();
+  for (int y = obs.center.y - reach; y <= obs.center.y + reach; ++y) {
+    for (int x = obs.center.x - reach; x <= obs.center.x + reach; ++x) {
+      auto bucketIt = subjectsByChunk.find(PackChunkKey(x, y));
+      if (bucketIt == subjectsByChunk.end()) continue;
+      const bool bInView = std::abs(x - obs.center.x) <= viewDistance &&
+                           std::abs(y - obs.center.y) <= viewDistance;
+      for (clientid_t subject : bucketIt->second) {
+        if (bInView || std::binary_search(obs.visible.begin(),
+                                          obs.visible.end(), subject))
+          scratch.push_back(subject);
+      }
+    }
+  }
+  std::sort(scratch.begin(), scratch.end());
+
+  std::set_difference(scratch.begin(), scratch.end(), obs.visible.begin(),
+                      obs.visible.end(), std::back_inserter(outDelta.entered));
+  std::set_difference(obs.visible.begin(), obs.visible.end(), scratch.begin(),
+                      scratch.end(), std::back_inserter(outDelta.left));
+
+  obs.visible.swap(scratch);
+  return true;
+}
+
+const std::vector<clientid_t>& InterestManager::GetVisibleSubjects(
+    clientid_t observer) const {
+  static const std::vector<clientid_t> empty;
+  auto it = observers.find(observer);
+  if (it == observers.end()) return empty;
+  return it->second.visible;
+}
+
+bool InterestManager::IsChunkVisible(clientid_t observer,
+                                     ChunkCoord chunk) const {
+  auto it = observers.find(observer);
+  if (it == observers.end()) return false;
+  return std::abs(chunk.x - it->second.center.x) <= viewDistance &&
+         std::abs(chunk.y - it->second.center.y) <= viewDistance;
+}
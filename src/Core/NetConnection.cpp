@@ -0,0 +1,316 @@
+#include "Core/NetConnection.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "Core/PacketPool.h"
+#include "Util/PacketUtil.h"
+
+namespace {
+constexpr double kInitialRoundTripTime = 0.1;
+constexpr double kMinResendDelay = 0.05;
+constexpr double kRoundTripSmoothing = 0.1;
+// Wire mode of a slice of a reliable packet, next to the EDeliveryMode values
+constexpr uint8_t kFragmentMode = 2;
+}  // namespace
+
+NetConnection::NetConnection()
+    // Acks carry remoteSeq before anything arrived; 0xFFFF is the one seq we
+    // will not have sent by then, so it acks nothing
+    : remoteSeq(0xFFFF), roundTripTime(kInitialRoundTripTime) {}
+
+bool NetConnection::Send(const uint8_t* packet, std::size_t size) {
+  if (size < sPacketHeader) return false;
+
+  const uint8_t* rp = packet;
+  PACKET packetId;
+  std::size_t packetSize;
+  util::GetHeader(rp, packetId, packetSize);
+  if (packetSize != size) return false;
+
+  const EDeliveryMode mode = GetDeliveryMode(packetId);
+  if (mode == EDeliveryMode::UnreliableSequenced) {
+    if (size > kMaxDatagramPacketSize) {
+      std::cerr << "Unreliable packet of " << size
+                << " bytes does not fit in a datagram\n";
+      return false;
+    }
+    OutMessage message;
+    message.mode = mode;
+    message.seq = nextUnreliableSeq[static_cast<uint16_t>(packetId)]++;
+    message.bytes.assign(packet, packet + size);
+    unreliableOut.push_back(std::move(message));
+    return true;
+  }
+
+  if (size <= kMaxDatagramPacketSize) {
+    OutMessage message;
+    message.mode = mode;
+    message.seq = nextReliableSeq++;
+    message.bytes.assign(packet, packet + size);
+    reliableOut.push_back(std::move(message));
+    return true;
+  }
+
+  for (std::size_t offset = 0; offset < size; offset += kMaxFragmentSize) {
+    const std::size_t fragmentSize = std::min(kMaxFragmentSize, size - offset);
+    OutMessage message;
+    message.mode = mode;
+    message.seq = nextReliableSeq++;
+    message.bytes.assign(packet + offset, packet + offset + fragmentSize);
+    message.bIsFragment = true;
+    reliableOut.push_back(std::move(message));
+  }
+  return true;
+}
+
+bool NetConnection::Receive(const uint8_t* datagram, std::size_t size,
+                            double now) {
+  if (size < sDatagramHeader) return false;
+
+  const uint8_t* rp = datagram;
+  const uint8_t* end = datagram + size;
+
+  const uint16_t seq = util::Read16BigEnd(rp);
+  const uint16_t ack = util::Read16BigEnd(rp);
+  const uint32_t ackBits = util::Read32BigEnd(rp);
+
+  MarkReceived(seq);
+
+  AckDatagram(ack, now);
+  for (uint16_t i = 0; i < 32; ++i) {
+    if (ackBits & (1u << i))
+      AckDatagram(static_cast<uint16_t>(ack - 1 - i), now);
+  }
+
+  // Acked messages are always a prefix once everything before them is acked
+  while (!reliableOut.empty() && reliableOut.front().bIsAcked)
+    reliableOut.pop_front();
+
+  // Bare acks are not acked back, or both ends would ping-pong forever
+  if (rp < end) bIsAckPending = true;
+
+  while (rp < end) {
+    if (!ReadMessage(rp, end)) return false;
+  }
+  return true;
+}
+
+bool NetConnection::Next(PacketPtr& outPacket) {
+  if (delivered.empty()) return false;
+  outPacket = std::move(delivered.front());
+  delivered.pop_front();
+  return true;
+}
+
+void NetConnection::Flush(double now,
+                          std::vector<std::vector<uint8_t>>& outDatagrams) {
+  const double resendDelay = GetResendDelay();
+
+  // Reliable first so resends are not starved by a burst of snapshots. Only
+  // the oldest kReliableWindow go out, the receiver would drop the others.
+  std::vector<OutMessage*> pending;
+  const std::size_t inWindow =
+      std::min<std::size_t>(reliableOut.size(), kReliableWindow);
+  for (std::size_t i = 0; i < inWindow; ++i) {
+    OutMessage& message = reliableOut[i];
+    if (message.bIsAcked) continue;
+    if (message.lastSent < 0.0 || now - message.lastSent >= resendDelay)
+      pending.push_back(&message);
+  }
+  for (OutMessage& message : unreliableOut) pending.push_back(&message);
+
+  std::size_t next = 0;
+  while (next < pending.size() || bIsAckPending) {
+    std::vector<uint8_t> datagram(kMaxDatagramSize);
+    uint8_t* wp = datagram.data();
+    util::Write16BigEnd(wp, nextDatagramSeq);
+    util::Write16BigEnd(wp, remoteSeq);
+    util::Write32BigEnd(wp, remoteAckBits);
+
+    SentDatagram& sent = sentDatagrams[nextDatagramSeq % kSentHistory];
+    sent.seq = nextDatagramSeq;
+    sent.time = now;
+    sent.reliableSeqs.clear();
+
+    // Send rejects anything larger, so one message always fits
+    const std::size_t first = next;
+    const uint8_t* end = datagram.data() + kMaxDatagramSize;
+    while (next < pending.size()) {
+      OutMessage& message = *pending[next];
+      const std::size_t fragmentHeader =
+          message.bIsFragment ? sizeof(uint16_t) : 0;
+      if (static_cast<std::size_t>(end - wp) <
+          sMessageHeader + fragmentHeader + message.bytes.size())
+        break;
+
+      *wp++ = message.bIsFragment ? kFragmentMode
+                                  : static_cast<uint8_t>(message.mode);
+      util::Write16BigEnd(wp, message.seq);
+      if (message.bIsFragment)
+        util::Write16BigEnd(wp, static_cast<uint16_t>(message.bytes.size()));
+      std::memcpy(wp, message.bytes.data(), message.bytes.size());
+      wp += message.bytes.size();
+
+      if (message.mode == EDeliveryMode::ReliableOrdered) {
+        message.lastSent = now;
+        sent.reliableSeqs.push_back(message.seq);
+      }
+      ++next;
+    }
+    // Bare acks are acked late, they would skew the round trip estimate
+    sent.bIsValid = next > first;
+
+    datagram.resize(static_cast<std::size_t>(wp - datagram.data()));
+    outDatagrams.push_back(std::move(datagram));
+    ++nextDatagramSeq;
+    bIsAckPending = false;
+  }
+
+  unreliableOut.clear();
+}
+
+void NetConnection::AckDatagram(uint16_t seq, double now) {
+  SentDatagram& sent = sentDatagrams[seq % kSentHistory];
+  if (!sent.bIsValid || sent.seq != seq) return;
+  sent.bIsValid = false;
+
+  roundTripTime += (now - sent.time - roundTripTime) * kRoundTripSmoothing;
+
+  if (reliableOut.empty()) return;
+  const uint16_t firstSeq = reliableOut.front().seq;
+  for (uint16_t reliableSeq : sent.reliableSeqs) {
+    // reliableOut is contiguous in seq, index straight into it
+    const std::size_t index = static_cast<uint16_t>(reliableSeq - firstSeq);
+    if (index < reliableOut.size()) reliableOut[index].bIsAcked = true;
+  }
+}
+
+void NetConnection::MarkReceived(uint16_t seq) {
+  if (!bHasReceived) {
+    bHasReceived = true;
+    remoteSeq = seq;
+    remoteAckBits = 0;
+    return;
+  }
+
+  if (util::seq_gt(seq, remoteSeq)) {
+    const uint16_t shift = static_cast<uint16_t>(seq - remoteSeq);
+    if (shift > 32) {
+      remoteAckBits = 0;
+    } else {
+      // Previous newest moves into the history at bit (shift - 1)
+      remoteAckBits = (shift == 32 ? 0u : remoteAckBits << shift) |
+                      (1u << (shift - 1));
+    }
+    remoteSeq = seq;
+  } else {
+    const uint16_t age = static_cast<uint16_t>(remoteSeq - seq);
+    if (age >= 1 && age <= 32) remoteAckBits |= 1u << (age - 1);
+  }
+}
+
+bool NetConnection::ReadMessage(const uint8_t*& rp, const uint8_t* end) {
+  if (static_cast<std::size_t>(end - rp) < sMessageHeader + sizeof(uint16_t))
+    return false;
+
+  const uint8_t mode = *rp++;
+  if (mode > kFragmentMode) return false;
+  const uint16_t seq = util::Read16BigEnd(rp);
+
+  // A fragment is a bare slice, anything else a packet with its header
+  const uint8_t* payload;
+  std::size_t payloadSize;
+  PACKET packetId = PACKET::CONNECT_SYN;
+  if (mode == kFragmentMode) {
+    payloadSize = util::Read16BigEnd(rp);
+    payload = rp;
+    if (payloadSize == 0 || payloadSize > static_cast<std::size_t>(end - rp))
+      return false;
+  } else {
+    if (static_cast<std::size_t>(end - rp) < sPacketHeader) return false;
+    payload = rp;
+    util::GetHeader(rp, packetId, payloadSize);
+    if (payloadSize < sPacketHeader ||
+        payloadSize > static_cast<std::size_t>(end - payload))
+      return false;
+  }
+  rp = payload + payloadSize;
+
+  auto copyPacket = [payload, payloadSize]() {
+    PacketPtr packet = PacketPool::instance().Acquire(payloadSize);
+    std::memcpy(packet.get(), payload, payloadSize);
+    return packet;
+  };
+
+  if (static_cast<EDeliveryMode>(mode) == EDeliveryMode::UnreliableSequenced) {
+    auto [it, inserted] =
+        lastUnreliableSeq.try_emplace(static_cast<uint16_t>(packetId), seq);
+    if (!inserted) {
+      if (!util::seq_gt(seq, it->second)) return true;  // stale or duplicate
+      it->second = seq;
+    }
+    delivered.push_back(copyPacket());
+    return true;
+  }
+
+  // Already delivered (wraps to a large offset) or too far ahead
+  const uint16_t offset = static_cast<uint16_t>(seq - nextDeliverSeq);
+  if (offset >= kReliableWindow) return true;
+
+  if (reliableIn.find(seq) == reliableIn.end()) {
+    InMessage message;
+    if (mode == kFragmentMode) {
+      message.fragment.assign(payload, payload + payloadSize);
+      message.bIsFragment = true;
+    } else {
+      message.packet = copyPacket();
+    }
+    reliableIn.emplace(seq, std::move(message));
+  }
+
+  for (auto it = reliableIn.find(nextDeliverSeq); it != reliableIn.end();
+       it = reliableIn.find(nextDeliverSeq)) {
+    DeliverReliable(it->second);
+    reliableIn.erase(it);
+    ++nextDeliverSeq;
+  }
+  return true;
+}
+
+void NetConnection::DeliverReliable(InMessage& message) {
+  if (!message.bIsFragment) {
+    if (!partialPacket.empty()) {
+      std::cerr << "Fragmented packet cut short by the peer\n";
+      partialPacket.clear();
+    }
+    delivered.push_back(std::move(message.packet));
+    return;
+  }
+
+  // Fragments arrive here in seq order, the first starts with the header
+  partialPacket.insert(partialPacket.end(), message.fragment.begin(),
+                       message.fragment.end());
+  if (partialPacket.size() < sPacketHeader) return;
+
+  const uint8_t* rp = partialPacket.data();
+  PACKET packetId;
+  std::size_t packetSize;
+  util::GetHeader(rp, packetId, packetSize);
+  if (partialPacket.size() < packetSize) return;
+  if (partialPacket.size() > packetSize) {
+    std::cerr << "Fragments overrun packet of " << packetSize << " bytes\n";
+    partialPacket.clear();
+    return;
+  }
+
+  PacketPtr packet = PacketPool::instance().Acquire(packetSize);
+  std::memcpy(packet.get(), partialPacket.data(), packetSize);
+  delivered.push_back(std::move(packet));
+  partialPacket.clear();
+}
+
+double NetConnection::GetResendDelay() const {
+  return std::max(kMinResendDelay, roundTripTime * 1.5);
+}
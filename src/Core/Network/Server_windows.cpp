@@ -12,16 +12,23 @@
 #include <process.h>
 #include <windows.h>
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "Core/NetConnection.h"
 #include "Core/Packet.h"
+#include "Core/PacketAssembler.h"
+#include "Core/PacketSchema.h"
 #include "Core/ThreadSafeQueue.h"
 #include "Util/PacketUtil.h"
 
@@ -30,6 +37,11 @@ constexpr DWORD MAX_BUFFER = 1024;
 constexpr ULONG_PTR SHUT_DOWN_KEY = 0ul;
 constexpr ULONG_PTR WAKE_UP_KEY = 1ul;
 constexpr USHORT SERVER_PORT = 27015;
+// Short so resends and acks go out even when nothing is received
+constexpr DWORD DATAGRAM_RECV_TIMEOUT_MS = 10;
+// Addresses that sent datagrams but never a valid UDP_BIND
+constexpr std::size_t MAX_UNBOUND_PEERS = 64;
+constexpr double UNBOUND_PEER_TIMEOUT = 5.0;
 enum class IO_OPERATION { RECEIVE, SEND };
 
 struct SOCKET_OVERLAPPED {
@@ -50,9 +62,15 @@ struct ClientInfo {
   SOCKET socket;
   std::unique_ptr<SOCKET_OVERLAPPED> pSendOverlapped;
   std::unique_ptr<SOCKET_OVERLAPPED> pRecvOverlapped;
+  // Only one receive is outstanding per client, so no locking needed
+  PacketAssembler packetAssembler;
 
   DWORD refCount;
-  clientid_t clientID;
+  // Changed under clientMapSRW when a reconnect takes its old id back
+  std::atomic<clientid_t> clientID;
+  IN_ADDR peerAddr{};  // UDP_BIND must come from the same host
+  // Set under clientMapSRW by SESSION and REBIND, UDP_BIND must carry it
+  uint64_t sessionToken = 0;
 
   ClientInfo(SOCKET s, clientid_t id)
       : socket(s),
@@ -72,6 +90,27 @@ struct ClientInfo {
     }
   }
 };
+
+// UDP side of a client, keyed by source address
+struct UdpPeer {
+  SOCKADDR_IN addr;
+  clientid_t clientID = 0;  // 0 until a valid UDP_BIND arrives
+  double lastReceived = 0.0;
+  std::mutex mutex;  // guards connection
+  NetConnection connection;
+
+  explicit UdpPeer(const SOCKADDR_IN &addr) : addr(addr) {}
+};
+
+inline uint64_t AddrKey(const SOCKADDR_IN &addr) {
+  return (static_cast<uint64_t>(addr.sin_addr.S_un.S_addr) << 16) |
+         addr.sin_port;
+}
+
+inline double NowSeconds() {
+  using clock = std::chrono::steady_clock;
+  return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
 }  // anonymous namespace
 
 class WindowsServerImpl : public ServerImpl {
@@ -87,6 +126,222 @@ class WindowsServerImpl : public ServerImpl {
   ThreadSafeQueue<SendRequest> *sendQueue;
   bool bIsRunning;
 
+  // UDP channel, optional. Clients stay on TCP until their UDP_BIND is acked.
+  SOCKET datagramSocket = INVALID_SOCKET;
+  HANDLE datagramThreadHandle = INVALID_HANDLE_VALUE;
+  SRWLOCK peerMapSRW;
+  std::unordered_map<uint64_t, std::shared_ptr<UdpPeer>> addrToPeer;
+  std::unordered_map<clientid_t, std::shared_ptr<UdpPeer>> idToPeer;
+
+  std::shared_ptr<UdpPeer> FindBoundPeer(clientid_t clientID) {
+    AcquireSRWLockShared(&peerMapSRW);
+    auto it = idToPeer.find(clientID);
+    std::shared_ptr<UdpPeer> peer =
+        it != idToPeer.end() ? it->second : nullptr;
+    ReleaseSRWLockShared(&peerMapSRW);
+    return peer;
+  }
+
+  // Queues a packet on the client's UDP connection if it has one. Returns
+  // false if the packet has to go over TCP instead. Once bound, everything
+  // but the handshake stays on UDP whatever its size, reliable packets would
+  // lose their order if some of them took the TCP stream. Only an unreliable
+  // packet too large for a datagram is refused by the connection, it has no
+  // order to keep and takes TCP as well.
+  bool QueueDatagramPacket(clientid_t clientID, const uint8_t *packet,
+                           std::size_t packetSize, PACKET packetId,
+                           std::vector<std::shared_ptr<UdpPeer>> &touched) {
+    if (IsHandshakePacket(packetId)) return false;
+    std::shared_ptr<UdpPeer> peer = FindBoundPeer(clientID);
+    if (!peer) return false;
+
+    std::lock_guard<std::mutex> lock(peer->mutex);
+    if (!peer->connection.Send(packet, packetSize)) {
+      std::cerr << "Packet " << packetId << " to client " << clientID
+                << " did not fit UDP, sent over TCP" << std::endl;
+      return false;
+    }
+    touched.push_back(std::move(peer));
+    return true;
+  }
+
+  // Caller holds peer.mutex
+  void FlushPeer(UdpPeer &peer, double now) {
+    std::vector<std::vector<uint8_t>> datagrams;
+    peer.connection.Flush(now, datagrams);
+    for (const auto &datagram : datagrams) {
+      int res = sendto(datagramSocket,
+                       reinterpret_cast<const char *>(datagram.data()),
+                       static_cast<int>(datagram.size()), 0,
+                       (const sockaddr *)&peer.addr, sizeof(SOCKADDR_IN));
+      if (res == SOCKET_ERROR) {
+        std::cerr << "sendto failed:" << WSAGetLastError() << std::endl;
+        return;
+      }
+    }
+  }
+
+  // A matching source address alone is not enough, every host behind the
+  // same NAT shares it. Only the client holding the session token may bind.
+  // Caller holds peer.mutex
+  void BindPeer(UdpPeer &peer, const std::shared_ptr<UdpPeer> &shared,
+                clientid_t clientID, uint64_t token) {
+    AcquireSRWLockShared(&clientMapSRW);
+    auto it = idToInfoMap.find(clientID);
+    const bool bIsValid =
+        it != idToInfoMap.end() && it->second->sessionToken != 0 &&
+        it->second->sessionToken == token &&
+        it->second->peerAddr.S_un.S_addr == peer.addr.sin_addr.S_un.S_addr;
+    ReleaseSRWLockShared(&clientMapSRW);
+
+    if (!bIsValid) {
+      std::cerr << "Rejected UDP_BIND for client " << clientID << std::endl;
+      return;
+    }
+
+    peer.clientID = clientID;
+    AcquireSRWLockExclusive(&peerMapSRW);
+    idToPeer[clientID] = shared;
+    ReleaseSRWLockExclusive(&peerMapSRW);
+
+    uint8_t ack[sPacketHeader];
+    uint8_t *wp = ack;
+    util::WriteHeader(wp, PACKET::UDP_BIND_ACK, sPacketHeader);
+    peer.connection.Send(ack, sPacketHeader);
+    std::cout << "Client " << clientID << " bound to UDP." << std::endl;
+  }
+
+  void HandleDatagram(const SOCKADDR_IN &from, const uint8_t *data,
+                      std::size_t size, double now) {
+    std::shared_ptr<UdpPeer> peer;
+    AcquireSRWLockExclusive(&peerMapSRW);
+    auto it = addrToPeer.find(AddrKey(from));
+    if (it != addrToPeer.end()) {
+      peer = it->second;
+    } else if (addrToPeer.size() < idToPeer.size() + MAX_UNBOUND_PEERS) {
+      peer = std::make_shared<UdpPeer>(from);
+      addrToPeer.emplace(AddrKey(from), peer);
+    }
+    ReleaseSRWLockExclusive(&peerMapSRW);
+    if (!peer) return;
+
+    std::lock_guard<std::mutex> lock(peer->mutex);
+    peer->lastReceived = now;
+    if (!peer->connection.Receive(data, size, now)) {
+      std::cerr << "Malformed datagram from client " << peer->clientID
+                << std::endl;
+    }
+
+    PacketPtr packet;
+    while (peer->connection.Next(packet)) {
+      const uint8_t *rp = packet.get();
+      std::size_t packetSize;
+      PACKET packetId;
+      util::GetHeader(rp, packetId, packetSize);
+
+      if (packetId == UDP_BIND) {
+        if (peer->clientID == 0 &&
+            packetSize >= sPacketHeader + PayloadSize<UDP_BIND>()) {
+          const clientid_t clientID = util::Read64BigEnd(rp);
+          BindPeer(*peer, peer, clientID, util::Read64BigEnd(rp));
+        }
+        continue;
+      }
+      // Nothing but UDP_BIND is accepted from an unknown address
+      if (peer->clientID == 0) continue;
+
+      RecvPacket recvPacket;
+      recvPacket.senderClientId = peer->clientID;
+      recvPacket.packet = std::move(packet);
+      recvQueue->Push(std::move(recvPacket));
+    }
+  }
+
+  // Resends, acks and expiry of peers that never bound
+  void FlushAllPeers(double now) {
+    std::vector<std::shared_ptr<UdpPeer>> peers;
+    AcquireSRWLockExclusive(&peerMapSRW);
+    for (auto it = addrToPeer.begin(); it != addrToPeer.end();) {
+      if (it->second->clientID == 0 &&
+          now - it->second->lastReceived > UNBOUND_PEER_TIMEOUT) {
+        it = addrToPeer.erase(it);
+        continue;
+      }
+      peers.push_back(it->second);
+      ++it;
+    }
+    ReleaseSRWLockExclusive(&peerMapSRW);
+
+    for (auto &peer : peers) {
+      std::lock_guard<std::mutex> lock(peer->mutex);
+      FlushPeer(*peer, now);
+    }
+  }
+
+  void RemovePeer(clientid_t clientID) {
+    AcquireSRWLockExclusive(&peerMapSRW);
+    auto it = idToPeer.find(clientID);
+    if (it != idToPeer.end()) {
+      addrToPeer.erase(AddrKey(it->second->addr));
+      idToPeer.erase(it);
+    }
+    ReleaseSRWLockExclusive(&peerMapSRW);
+  }
+
+  void DatagramThread() {
+    std::vector<char> buffer(kMaxDatagramSize);
+    while (bIsRunning) {
+      SOCKADDR_IN from{};
+      int fromLen = sizeof(SOCKADDR_IN);
+      int res = recvfrom(datagramSocket, buffer.data(),
+                         static_cast<int>(buffer.size()), 0,
+                         (sockaddr *)&from, &fromLen);
+      const double now = NowSeconds();
+
+      if (res > 0) {
+        HandleDatagram(from, reinterpret_cast<const uint8_t *>(buffer.data()),
+                       static_cast<std::size_t>(res), now);
+      } else if (res == SOCKET_ERROR) {
+        const int error = WSAGetLastError();
+        // Timeout, ICMP unreachable from a gone client or oversized datagram
+        if (error != WSAETIMEDOUT && error != WSAECONNRESET &&
+            error != WSAEMSGSIZE) {
+          if (!bIsRunning) break;
+          std::cerr << "recvfrom failed:" << error << std::endl;
+        }
+      }
+
+      FlushAllPeers(now);
+    }
+  }
+
+  static unsigned WINAPI DatagramEntry(void *p) {
+    WindowsServerImpl *pServer = static_cast<WindowsServerImpl *>(p);
+    pServer->DatagramThread();
+    return 0;
+  }
+
+  bool OpenDatagramSocket() {
+    datagramSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (datagramSocket == INVALID_SOCKET) return false;
+
+    DWORD timeout = DATAGRAM_RECV_TIMEOUT_MS;
+    setsockopt(datagramSocket, SOL_SOCKET, SO_RCVTIMEO,
+               reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+
+    SOCKADDR_IN serverAddr{};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(SERVER_PORT);
+    serverAddr.sin_addr.S_un.S_addr = htonl(INADDR_ANY);
+    if (bind(datagramSocket, (sockaddr *)&serverAddr, sizeof(SOCKADDR_IN)) ==
+        SOCKET_ERROR) {
+      closesocket(datagramSocket);
+      datagramSocket = INVALID_SOCKET;
+      return false;
+    }
+    return true;
+  }
+
   static void PacketSendHelper(ClientInfo *client, char *sendbuffer,
                                std::size_t packet_size) {
     ZeroMemory(&(client->pSendOverlapped.get()->overlapped),
@@ -125,6 +380,7 @@ class WindowsServerImpl : public ServerImpl {
       else if ((ULONG_PTR)completionKey == WAKE_UP_KEY) {
         SendRequest request;
         std::vector<char> sendBuffer;
+        std::vector<std::shared_ptr<UdpPeer>> touchedPeers;
 
         // send every request inside queue
         while (sendQueue->TryPop(request)) {
@@ -137,8 +393,23 @@ class WindowsServerImpl : public ServerImpl {
           sendBuffer.resize(packetSize);
           std::memcpy(sendBuffer.data(), request.packet.get(), packetSize);
 
+          // A new session's token is in place before its CONNECT_ACK leaves
+          if (request.type == ESendType::SESSION) {
+            AcquireSRWLockExclusive(&clientMapSRW);
+            auto it = idToInfoMap.find(request.targetClientId);
+            if (it != idToInfoMap.end())
+              it->second->sessionToken = request.sessionToken;
+            ReleaseSRWLockExclusive(&clientMapSRW);
+          }
+
           // Process Unicast
-          if (request.type == ESendType::UNICAST) {
+          if (request.type == ESendType::UNICAST ||
+              request.type == ESendType::SESSION) {
+            if (QueueDatagramPacket(request.targetClientId,
+                                    request.packet.get(), packetSize, packetId,
+                                    touchedPeers))
+              continue;
+
             // minimize critical section
             AcquireSRWLockShared(&clientMapSRW);
             auto it = idToInfoMap.find(request.targetClientId);
@@ -152,6 +423,24 @@ class WindowsServerImpl : public ServerImpl {
             }
           }
 
+          // Process Rebind, the packet is sent once the id is handed over
+          else if (request.type == ESendType::REBIND) {
+            ClientInfo *client = nullptr;
+            AcquireSRWLockExclusive(&clientMapSRW);
+            auto it = idToInfoMap.find(request.targetClientId);
+            if (it != idToInfoMap.end() &&
+                idToInfoMap.count(request.reboundClientId) == 0) {
+              client = it->second;
+              idToInfoMap.erase(it);
+              client->clientID = request.reboundClientId;
+              client->sessionToken = request.sessionToken;
+              idToInfoMap[request.reboundClientId] = client;
+            }
+            ReleaseSRWLockExclusive(&clientMapSRW);
+            if (client != nullptr)
+              PacketSendHelper(client, sendBuffer.data(), packetSize);
+          }
+
           // Process Broadcast
           else if (request.type == ESendType::BROADCAST) {
             std::vector<ClientInfo *> clientsToSend;
@@ -167,10 +456,22 @@ class WindowsServerImpl : public ServerImpl {
             ReleaseSRWLockShared(&clientMapSRW);
 
             for (auto client : clientsToSend) {
+              if (QueueDatagramPacket(client->clientID, request.packet.get(),
+                                      packetSize, packetId, touchedPeers))
+                continue;
               PacketSendHelper(client, sendBuffer.data(), packetSize);
             }
           }
         }
+
+        // Everything queued for a client this round shares datagrams
+        const double now = NowSeconds();
+        std::unordered_set<UdpPeer *> flushed;
+        for (auto &peer : touchedPeers) {
+          if (!flushed.insert(peer.get()).second) continue;
+          std::lock_guard<std::mutex> lock(peer->mutex);
+          FlushPeer(*peer, now);
+        }
         // Sending Job Done - Back to waiting threadpool
         continue;
       }
@@ -199,6 +500,7 @@ class WindowsServerImpl : public ServerImpl {
         socketToInfoMap.erase(completionKey->socket);
         idToInfoMap.erase(completionKey->clientID);
         ReleaseSRWLockExclusive(&clientMapSRW);
+        RemovePeer(completionKey->clientID);
 
         completionKey->Release();  // disconnected so release
         continue;
@@ -208,13 +510,17 @@ class WindowsServerImpl : public ServerImpl {
       if (pSocketOverlapped->operationType == IO_OPERATION::RECEIVE) {
         // std::cout << "Bytes received: " << recvByteCnt << std::endl;
 
+        // TCP may merge or split packets, reassemble them from the stream
+        completionKey->packetAssembler.Feed(
+            reinterpret_cast<const uint8_t *>(pSocketOverlapped->messageBuffer),
+            recvByteCnt);
+
         RecvPacket recvPacket;
         recvPacket.senderClientId = completionKey->clientID;
-        recvPacket.packet = std::make_unique<uint8_t[]>(recvByteCnt);
-        std::memcpy(recvPacket.packet.get(), pSocketOverlapped->messageBuffer,
-                    recvByteCnt);
-
-        recvQueue->Push(std::move(recvPacket));
+        while (completionKey->packetAssembler.Next(recvPacket.packet)) {
+          recvQueue->Push(std::move(recvPacket));
+          recvPacket.senderClientId = completionKey->clientID;
+        }
 
         ZeroMemory(&pSocketOverlapped->overlapped, sizeof(WSAOVERLAPPED));
         pSocketOverlapped->dataBuf.len = MAX_BUFFER;
@@ -286,6 +592,7 @@ class WindowsServerImpl : public ServerImpl {
             ThreadSafeQueue<SendRequest> *sendQ) override {
     WSADATA wsaData;
     InitializeSRWLock(&clientMapSRW);
+    InitializeSRWLock(&peerMapSRW);
     int res = WSAStartup(MAKEWORD(2, 2), &wsaData);
 
     if (res != 0) {
@@ -341,6 +648,11 @@ class WindowsServerImpl : public ServerImpl {
       WSACleanup();
       return false;
     }
+
+    if (!OpenDatagramSocket()) {
+      std::cerr << "UDP socket unavailable, serving over TCP only:"
+                << WSAGetLastError() << std::endl;
+    }
     return true;
   }
 
@@ -349,6 +661,12 @@ class WindowsServerImpl : public ServerImpl {
     if (serverThreadHandle != INVALID_HANDLE_VALUE) return;
     serverThreadHandle = (HANDLE)_beginthreadex(
         nullptr, 0, &WindowsServerImpl::StartServer, this, 0, nullptr);
+
+    if (datagramSocket != INVALID_SOCKET &&
+        datagramThreadHandle == INVALID_HANDLE_VALUE) {
+      datagramThreadHandle = (HANDLE)_beginthreadex(
+          nullptr, 0, &WindowsServerImpl::DatagramEntry, this, 0, nullptr);
+    }
   }
 
   void StartThread() {
@@ -368,6 +686,7 @@ class WindowsServerImpl : public ServerImpl {
       std::cout << "Client connected." << std::endl;
 
       ClientInfo *pClientInfo = new ClientInfo(clientSocket, nextClientID++);
+      pClientInfo->peerAddr = clientAddr.sin_addr;
 
       AcquireSRWLockExclusive(&clientMapSRW);
       socketToInfoMap[clientSocket] = pClientInfo;
@@ -406,6 +725,16 @@ class WindowsServerImpl : public ServerImpl {
     closesocket(listenSocket);
     CloseHandle(serverThreadHandle);
 
+    if (datagramSocket != INVALID_SOCKET) {
+      closesocket(datagramSocket);
+      datagramSocket = INVALID_SOCKET;
+    }
+    if (datagramThreadHandle != INVALID_HANDLE_VALUE) {
+      WaitForSingleObject(datagramThreadHandle, INFINITE);
+      CloseHandle(datagramThreadHandle);
+      datagramThreadHandle = INVALID_HANDLE_VALUE;
+    }
+
     for (std::size_t i = 0; i < threadPool.size(); ++i)
       PostQueuedCompletionStatus(iocpHandle, 0, SHUT_DOWN_KEY, NULL);
 
@@ -2,21 +2,420 @@
 
 #ifdef __linux__
 
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "Core/ByteRing.h"
+#include "Core/Socket.h"
+
+namespace {
+// Lets the datagram receive thread notice shutdown
+constexpr int DATAGRAM_RECV_TIMEOUT_MS = 100;
+// Datagrams kept for the game thread before the oldest are dropped
+constexpr std::size_t MAX_QUEUED_DATAGRAMS = 256;
+constexpr std::size_t RECV_CHUNK_SIZE = 16 * 1024;
+constexpr std::size_t MAX_DATAGRAM_SIZE = 2048;
+}  // namespace
+
+/**
+ * @brief Non-blocking client socket driven by a single poll thread.
+ * @details The I/O thread owns every read and write on the TCP and UDP
+ * sockets. Send only copies into the send ring and wakes the thread through
+ * an eventfd, so the game thread never waits on the network. Received bytes
+ * and datagrams are handed to the receive workers under their own locks.
+ */
 class LinuxSocketImpl : public SocketImpl {
-  bool Init() override { return true; }
+  int connectFd = -1;
+  int datagramFd = -1;
+  int wakeFd = -1;
+  int connectTimeoutMs = 3000;
+  bool bNoDelay = true;
+  int sendBufferSize = 0;
+
+  std::thread ioThread;
+  std::atomic<bool> bIsRunning{false};
+
+  std::mutex sendMutex;
+  ByteRing sendRing{1};
+  std::deque<std::vector<uint8_t>> datagramsOut;
+
+  std::mutex recvMutex;
+  std::condition_variable recvCV;
+  std::vector<uint8_t> recvBytes;
+  std::deque<std::vector<uint8_t>> datagramsIn;
+  // Set once by the I/O thread, never cleared
+  bool bIsClosed = false;
+  bool bHasError = false;
+
+ public:
+  ~LinuxSocketImpl() override { Close(); }
+
+  bool Init(const SocketOptions& options) override {
+    connectTimeoutMs = options.connectTimeoutMs;
+    bNoDelay = options.bNoDelay;
+    sendBufferSize = options.sendBufferSize;
+    sendRing = ByteRing(std::max<std::size_t>(options.sendRingSize, 1));
+    return true;
+  }
+
+  uint64_t Connect(std::string ip, int port) override {
+    if (connectFd >= 0) return 0;
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    addrinfo* addrInfoList = nullptr;
+    int res = getaddrinfo(ip.c_str(), std::to_string(port).c_str(), &hints,
+                          &addrInfoList);
+    if (res != 0) {
+      std::cerr << "getaddrinfo failed: " << gai_strerror(res) << std::endl;
+      return 0;
+    }
+
+    for (addrinfo* addr = addrInfoList; addr != nullptr; addr = addr->ai_next) {
+      connectFd = ConnectWithTimeout(addr);
+      if (connectFd < 0) continue;
+      OpenDatagramSocket(addr);
+      break;
+    }
+    freeaddrinfo(addrInfoList);
+
+    if (connectFd < 0) {
+      std::cerr << "Unable to connect to server after trying all addresses"
+                << std::endl;
+      return 0;
+    }
+
+    ApplyOptions();
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+      std::cerr << "Error at eventfd() errno: " << errno << std::endl;
+      CloseDescriptors();
+      return 0;
+    }
+
+    bIsRunning = true;
+    ioThread = std::thread([this] { IoLoop(); });
+
+    std::cout << "Connected to server" << std::endl;
+    return static_cast<uint64_t>(connectFd);
+  }
+
+  int Send(uint8_t* buffer, std::size_t size) override {
+    {
+      std::lock_guard<std::mutex> lock(sendMutex);
+      if (!bIsRunning) return -1;
+      if (!sendRing.Write(buffer, size)) {
+        // Server has not read for a long time, give up on it
+        std::cerr << "Send ring overflow, dropping connection" << std::endl;
+        MarkClosed(true);
+        Wake();
+        return -1;
+      }
+    }
+    Wake();
+    return static_cast<int>(size);
+  }
+
+  int Receive(uint8_t* buffer, std::size_t size) override {
+    std::unique_lock<std::mutex> lock(recvMutex);
+    recvCV.wait(lock, [this] { return !recvBytes.empty() || bIsClosed; });
+    if (recvBytes.empty()) {
+      if (bHasError) return -1;
+      std::cout << "Connection closed" << std::endl;
+      return 0;
+    }
+
+    const std::size_t count = std::min(size, recvBytes.size());
+    std::memcpy(buffer, recvBytes.data(), count);
+    recvBytes.erase(recvBytes.begin(), recvBytes.begin() + count);
+    return static_cast<int>(count);
+  }
+
+  int SendDatagram(const uint8_t* buffer, std::size_t size) override {
+    if (datagramFd < 0) return -1;
+    {
+      std::lock_guard<std::mutex> lock(sendMutex);
+      if (!bIsRunning) return -1;
+      // Unreliable anyway, drop the oldest rather than grow without bound
+      if (datagramsOut.size() >= MAX_QUEUED_DATAGRAMS) datagramsOut.pop_front();
+      datagramsOut.emplace_back(buffer, buffer + size);
+    }
+    Wake();
+    return static_cast<int>(size);
+  }
+
+  int ReceiveDatagram(uint8_t* buffer, std::size_t size) override {
+    if (datagramFd < 0) return -1;
+    std::unique_lock<std::mutex> lock(recvMutex);
+    recvCV.wait_for(lock,
+                    std::chrono::milliseconds(DATAGRAM_RECV_TIMEOUT_MS),
+                    [this] { return !datagramsIn.empty() || bIsClosed; });
+    if (datagramsIn.empty()) return bIsClosed ? -1 : 0;
+
+    std::vector<uint8_t> datagram = std::move(datagramsIn.front());
+    datagramsIn.pop_front();
+    const std::size_t count = std::min(size, datagram.size());
+    std::memcpy(buffer, datagram.data(), count);
+    return static_cast<int>(count);
+  }
+
+  std::size_t GetPendingSendBytes() override {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    return sendRing.GetSize();
+  }
+
+  void Close() override {
+    if (ioThread.joinable()) {
+      bIsRunning = false;
+      Wake();
+      ioThread.join();
+    }
+    MarkClosed(false);
+    CloseDescriptors();
+  }
+
+ private:
+  int ConnectWithTimeout(const addrinfo* addr) {
+    int fd = socket(addr->ai_family,
+                    addr->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    addr->ai_protocol);
+    if (fd < 0) {
+      std::cerr << "Error at socket() errno: " << errno << std::endl;
+      return -1;
+    }
+
+    if (connect(fd, addr->ai_addr, addr->ai_addrlen) == 0) return fd;
+    if (errno != EINPROGRESS) {
+      std::cerr << "Error at connect() errno: " << errno << std::endl;
+      close(fd);
+      return -1;
+    }
+
+    pollfd pfd{fd, POLLOUT, 0};
+    int res;
+    do {
+      res = poll(&pfd, 1, connectTimeoutMs);
+    } while (res < 0 && errno == EINTR);
+    if (res == 0) {
+      std::cerr << "connect() timed out after " << connectTimeoutMs << " ms"
+                << std::endl;
+      close(fd);
+      return -1;
+    }
+
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (res < 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 ||
+        error != 0) {
+      std::cerr << "Error at connect() errno: " << (error ? error : errno)
+                << std::endl;
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  // UDP shares the server address and port of the TCP connection. Failure is
+  // not fatal, the client then keeps everything on TCP.
+  void OpenDatagramSocket(const addrinfo* addr) {
+    datagramFd = socket(addr->ai_family,
+                        SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (datagramFd < 0) {
+      std::cerr << "Error at UDP socket() errno: " << errno << std::endl;
+      return;
+    }
+    // Connected UDP socket, only accepts datagrams from the server
+    if (connect(datagramFd, addr->ai_addr, addr->ai_addrlen) < 0) {
+      std::cerr << "Error at UDP connect() errno: " << errno << std::endl;
+      close(datagramFd);
+      datagramFd = -1;
+    }
+  }
+
+  void ApplyOptions() {
+    const int noDelay = bNoDelay ? 1 : 0;
+    if (setsockopt(connectFd, IPPROTO_TCP, TCP_NODELAY, &noDelay,
+                   sizeof(noDelay)) < 0)
+      std::cerr << "Failed to set TCP_NODELAY errno: " << errno << std::endl;
+
+    if (sendBufferSize > 0 &&
+        setsockopt(connectFd, SOL_SOCKET, SO_SNDBUF, &sendBufferSize,
+                   sizeof(sendBufferSize)) < 0)
+      std::cerr << "Failed to set SO_SNDBUF errno: " << errno << std::endl;
+  }
+
+  void Wake() {
+    if (wakeFd < 0) return;
+    const uint64_t one = 1;
+    [[maybe_unused]] ssize_t res = write(wakeFd, &one, sizeof(one));
+  }
+
+  void MarkClosed(bool bIsError) {
+    bIsRunning = false;
+    {
+      std::lock_guard<std::mutex> lock(recvMutex);
+      if (!bIsClosed) bHasError = bIsError;
+      bIsClosed = true;
+    }
+    recvCV.notify_all();
+  }
+
+  void CloseDescriptors() {
+    if (connectFd >= 0) close(connectFd);
+    if (datagramFd >= 0) close(datagramFd);
+    if (wakeFd >= 0) close(wakeFd);
+    connectFd = datagramFd = wakeFd = -1;
+  }
+
+  void IoLoop() {
+    std::vector<uint8_t> chunk(RECV_CHUNK_SIZE);
+    bool bIsConnected = true;
+
+    while (bIsRunning && bIsConnected) {
+      bool bWantsStreamWrite;
+      bool bWantsDatagramWrite;
+      {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        bWantsStreamWrite = !sendRing.IsEmpty();
+        bWantsDatagramWrite = !datagramsOut.empty();
+      }
+      pollfd fds[3];
+      nfds_t count = 0;
+      fds[count++] = {wakeFd, POLLIN, 0};
+      fds[count++] = {connectFd,
+                      static_cast<short>(POLLIN |
+                                         (bWantsStreamWrite ? POLLOUT : 0)),
+                      0};
+      if (datagramFd >= 0) {
+        fds[count++] = {datagramFd,
+                        static_cast<short>(
+                            POLLIN | (bWantsDatagramWrite ? POLLOUT : 0)),
+                        0};
+      }
+
+      if (poll(fds, count, -1) < 0) {
+        if (errno == EINTR) continue;
+        std::cerr << "Error at poll() errno: " << errno << std::endl;
+        MarkClosed(true);
+        break;
+      }
+
+      if (fds[0].revents & POLLIN) {
+        uint64_t value;
+        [[maybe_unused]] ssize_t res = read(wakeFd, &value, sizeof(value));
+      }
+
+      const short streamEvents = fds[1].revents;
+      if (streamEvents & (POLLIN | POLLERR | POLLHUP))
+        bIsConnected = ReadStream(chunk);
+      if (bIsConnected && (streamEvents & POLLOUT))
+        bIsConnected = WriteStream();
+
+      if (count > 2) {
+        if (fds[2].revents & POLLIN) ReadDatagrams(chunk);
+        if (fds[2].revents & POLLOUT) WriteDatagrams();
+      }
+    }
+  }
 
-  uint64_t Connect(std::string ip, int port) override { return 0; }
+  // False once the connection is gone
+  bool ReadStream(std::vector<uint8_t>& chunk) {
+    while (true) {
+      ssize_t res = recv(connectFd, chunk.data(), chunk.size(), 0);
+      if (res > 0) {
+        {
+          std::lock_guard<std::mutex> lock(recvMutex);
+          recvBytes.insert(recvBytes.end(), chunk.begin(), chunk.begin() + res);
+        }
+        recvCV.notify_all();
+        continue;
+      }
+      if (res == 0) {
+        MarkClosed(false);
+        return false;
+      }
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+      std::cerr << "Error at recv() errno: " << errno << std::endl;
+      MarkClosed(true);
+      return false;
+    }
+  }
 
-  int Send(uint8_t* buffer, std::size_t size) override { return 0; }
+  bool WriteStream() {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    while (!sendRing.IsEmpty()) {
+      const uint8_t* data;
+      const std::size_t size = sendRing.Peek(data);
+      ssize_t res = send(connectFd, data, size, MSG_NOSIGNAL);
+      if (res > 0) {
+        sendRing.Consume(static_cast<std::size_t>(res));
+        continue;
+      }
+      if (res < 0 && errno == EINTR) continue;
+      if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+      std::cerr << "Error at send() errno: " << errno << std::endl;
+      MarkClosed(true);
+      return false;
+    }
+    return true;
+  }
 
-  int Receive(uint8_t* buffer, std::size_t size) override { return 0; }
+  void ReadDatagrams(std::vector<uint8_t>& chunk) {
+    bool bHasNew = false;
+    while (true) {
+      ssize_t res = recv(datagramFd, chunk.data(),
+                         std::min(chunk.size(), MAX_DATAGRAM_SIZE), 0);
+      if (res < 0) {
+        if (errno == EINTR) continue;
+        // EAGAIN, or ECONNREFUSED from an ICMP port unreachable
+        break;
+      }
+      std::lock_guard<std::mutex> lock(recvMutex);
+      if (datagramsIn.size() >= MAX_QUEUED_DATAGRAMS) datagramsIn.pop_front();
+      datagramsIn.emplace_back(chunk.begin(), chunk.begin() + res);
+      bHasNew = true;
+    }
+    if (bHasNew) recvCV.notify_all();
+  }
 
-  void Close() override {};
+  void WriteDatagrams() {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    while (!datagramsOut.empty()) {
+      const std::vector<uint8_t>& datagram = datagramsOut.front();
+      ssize_t res = send(datagramFd, datagram.data(), datagram.size(),
+                         MSG_NOSIGNAL);
+      if (res < 0 && errno == EINTR) continue;
+      if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+      // Sent, or refused by the network: either way it is gone
+      datagramsOut.pop_front();
+    }
+  }
 };
 #endif  // __linux__
@@ -11,26 +11,58 @@
 #include <process.h>
 #include <windows.h>
 
+#include <condition_variable>
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "Core/ByteRing.h"
+#include "Core/Socket.h"
+
+namespace {
+// Lets the datagram receive thread notice shutdown
+constexpr DWORD DATAGRAM_RECV_TIMEOUT_MS = 100;
+}  // namespace
+
 class WindowsSocketImpl : public SocketImpl {
   SOCKET connectSocket = INVALID_SOCKET;
+  SOCKET datagramSocket = INVALID_SOCKET;
   WSABUF dataBuf;
-  HANDLE plistenThreadHandle;
+  HANDLE plistenThreadHandle = nullptr;
   struct addrinfo *addrInfoList = nullptr, *addrIter = nullptr, hints;
   std::string address;
+  SocketOptions options;
+
+  // Blocking sends happen on sendThread, Send only fills the ring
+  std::thread sendThread;
+  std::mutex sendMutex;
+  std::condition_variable sendCV;
+  ByteRing sendRing{1};
+  bool bIsSending = false;
+  bool bIsWsaStarted = false;
+
+ public:
+  ~WindowsSocketImpl() override {
+    Close();
+    if (bIsWsaStarted) WSACleanup();
+  }
+
+  bool Init(const SocketOptions& socketOptions) override {
+    options = socketOptions;
+    // windows.h defines a max macro
+    sendRing = ByteRing(options.sendRingSize > 0 ? options.sendRingSize : 1);
 
-  bool Init() override {
     WSADATA wsaData;
     int res = WSAStartup(MAKEWORD(2, 2), &wsaData);
     if (res != 0) {
       std::cerr << "Can't Initialize winsock" << std::endl;
       return false;
     }
+    bIsWsaStarted = true;
 
     ZeroMemory(&hints, sizeof(hints));
     hints.ai_family = AF_UNSPEC;
@@ -69,6 +101,7 @@ class WindowsSocketImpl : public SocketImpl {
         connectSocket = INVALID_SOCKET;
         continue;
       }
+      OpenDatagramSocket(addrIter);
       break;
     }
 
@@ -81,16 +114,132 @@ class WindowsSocketImpl : public SocketImpl {
       return 0;
     }
 
+    ApplyOptions();
+    bIsSending = true;
+    sendThread = std::thread([this] { SendLoop(); });
+
     std::cout << "Connected to server" << std::endl;
 
     return static_cast<uint64_t>(connectSocket);
   }
 
   int Send(uint8_t* buffer, std::size_t size) override {
-    int res = send(connectSocket, reinterpret_cast<char*>(buffer), size, 0);
+    {
+      std::lock_guard<std::mutex> lock(sendMutex);
+      if (!bIsSending) return -1;
+      if (!sendRing.Write(buffer, size)) {
+        // Server has not read for a long time, give up on it
+        std::cerr << "Send ring overflow, dropping connection" << std::endl;
+        bIsSending = false;
+        shutdown(connectSocket, SD_BOTH);
+        sendCV.notify_one();
+        return -1;
+      }
+    }
+    sendCV.notify_one();
+    return static_cast<int>(size);
+  }
+
+  std::size_t GetPendingSendBytes() override {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    return sendRing.GetSize();
+  }
+
+  void ApplyOptions() {
+    const BOOL noDelay = options.bNoDelay ? TRUE : FALSE;
+    if (setsockopt(connectSocket, IPPROTO_TCP, TCP_NODELAY,
+                   reinterpret_cast<const char*>(&noDelay),
+                   sizeof(noDelay)) == SOCKET_ERROR)
+      std::cerr << "Failed to set TCP_NODELAY error code: " << WSAGetLastError()
+                << std::endl;
+
+    if (options.sendBufferSize > 0 &&
+        setsockopt(connectSocket, SOL_SOCKET, SO_SNDBUF,
+                   reinterpret_cast<const char*>(&options.sendBufferSize),
+                   sizeof(options.sendBufferSize)) == SOCKET_ERROR)
+      std::cerr << "Failed to set SO_SNDBUF error code: " << WSAGetLastError()
+                << std::endl;
+  }
+
+  // Bytes stay in the ring while send() reads them; Send only appends to the
+  // free part and only this thread consumes.
+  void SendLoop() {
+    while (true) {
+      const uint8_t* data;
+      std::size_t size;
+      {
+        std::unique_lock<std::mutex> lock(sendMutex);
+        sendCV.wait(lock,
+                    [this] { return !sendRing.IsEmpty() || !bIsSending; });
+        if (!bIsSending) return;
+        size = sendRing.Peek(data);
+      }
+
+      int res = send(connectSocket, reinterpret_cast<const char*>(data),
+                     static_cast<int>(size), 0);
+      std::lock_guard<std::mutex> lock(sendMutex);
+      if (res == SOCKET_ERROR) {
+        std::cerr << "Error at send() error code: " << WSAGetLastError()
+                  << std::endl;
+        // Wakes the receive thread, which reports the disconnect
+        bIsSending = false;
+        shutdown(connectSocket, SD_BOTH);
+        return;
+      }
+      sendRing.Consume(static_cast<std::size_t>(res));
+    }
+  }
+
+  void StopSendThread() {
+    {
+      std::lock_guard<std::mutex> lock(sendMutex);
+      bIsSending = false;
+    }
+    sendCV.notify_one();
+    if (sendThread.joinable()) sendThread.join();
+  }
+
+  // UDP shares the server address and port of the TCP connection. Failure is
+  // not fatal, the client then keeps everything on TCP.
+  void OpenDatagramSocket(const addrinfo* addr) {
+    datagramSocket = socket(addr->ai_family, SOCK_DGRAM, IPPROTO_UDP);
+    if (datagramSocket == INVALID_SOCKET) {
+      std::cerr << "Error at UDP socket() error code: " << WSAGetLastError()
+                << std::endl;
+      return;
+    }
+
+    DWORD timeout = DATAGRAM_RECV_TIMEOUT_MS;
+    setsockopt(datagramSocket, SOL_SOCKET, SO_RCVTIMEO,
+               reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+
+    // Connected UDP socket, only accepts datagrams from the server
+    if (connect(datagramSocket, addr->ai_addr, (int)addr->ai_addrlen) ==
+        SOCKET_ERROR) {
+      std::cerr << "Error at UDP connect() error code: " << WSAGetLastError()
+                << std::endl;
+      closesocket(datagramSocket);
+      datagramSocket = INVALID_SOCKET;
+    }
+  }
+
+  int SendDatagram(const uint8_t* buffer, std::size_t size) override {
+    if (datagramSocket == INVALID_SOCKET) return -1;
+    int res = send(datagramSocket, reinterpret_cast<const char*>(buffer),
+                   static_cast<int>(size), 0);
+    if (res == SOCKET_ERROR) return -1;
+    return res;
+  }
+
+  int ReceiveDatagram(uint8_t* buffer, std::size_t size) override {
+    if (datagramSocket == INVALID_SOCKET) return -1;
+    int res = recv(datagramSocket, reinterpret_cast<char*>(buffer),
+                   static_cast<int>(size), 0);
     if (res == SOCKET_ERROR) {
-      std::cerr << "Error at send() error code: " << WSAGetLastError() << std::endl;
-      Close();
+      // Timeouts and ICMP port unreachable resets are not fatal for UDP
+      const int error = WSAGetLastError();
+      if (error == WSAETIMEDOUT || error == WSAECONNRESET) return 0;
+      return -1;
     }
     return res;
   }
@@ -108,19 +257,21 @@ class WindowsSocketImpl : public SocketImpl {
   }
 
   void Close() override {
+    StopSendThread();
+    if (datagramSocket != INVALID_SOCKET) {
+      closesocket(datagramSocket);
+      datagramSocket = INVALID_SOCKET;
+    }
+    if (connectSocket != INVALID_SOCKET) {
+      closesocket(connectSocket);
+      connectSocket = INVALID_SOCKET;
+    }
     if (plistenThreadHandle != nullptr) {
-      if (connectSocket != INVALID_SOCKET) {
-        closesocket(connectSocket);
-        connectSocket = INVALID_SOCKET;
-      }
-
       WaitForSingleObject(plistenThreadHandle, 3000);
 
       CloseHandle(plistenThreadHandle);
       plistenThreadHandle = nullptr;
     }
-    connectSocket = INVALID_SOCKET;
-    WSACleanup();
   }
 };
 
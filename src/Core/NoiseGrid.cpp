@@ -0,0 +1,388 @@
+#include "Core/NoiseGrid.h"
+
+#include <array>
+
+#if defined(FACTORYGAME_SIMD_AVX2) || defined(FACTORYGAME_SIMD_SSE41)
+#include <immintrin.h>
+#endif
+
+namespace {
+// FastNoiseLite's hashing primes and multiplier
+constexpr int kPrimeX = 501125321;
+constexpr int kPrimeY = 1136930381;
+constexpr int kHashMultiplier = 0x27d4eb2d;
+
+// FastNoiseLite's Gradients2D: 24 directions repeated 5 times, then 8 more,
+// 128 (x, y) pairs addressed by an even hash
+struct GradientTable {
+  std::array<float, 256> values;
+
+  GradientTable() {
+    static constexpr float kBase[48] = {
+        0.130526192220052f,  0.99144486137381f,   0.38268343236509f,
+        0.923879532511287f,  0.608761429008721f,  0.793353340291235f,
+        0.793353340291235f,  0.608761429008721f,  0.923879532511287f,
+        0.38268343236509f,   0.99144486137381f,   0.130526192220051f,
+        0.99144486137381f,   -0.130526192220051f, 0.923879532511287f,
+        -0.38268343236509f,  0.793353340291235f,  -0.60876142900872f,
+        0.608761429008721f,  -0.793353340291235f, 0.38268343236509f,
+        -0.923879532511287f, 0.130526192220052f,  -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f,  -0.38268343236509f,
+        -0.923879532511287f, -0.608761429008721f, -0.793353340291235f,
+        -0.793353340291235f, -0.608761429008721f, -0.923879532511287f,
+        -0.38268343236509f,  -0.99144486137381f,  -0.130526192220052f,
+        -0.99144486137381f,  0.130526192220051f,  -0.923879532511287f,
+        0.38268343236509f,   -0.793353340291235f, 0.608761429008721f,
+        -0.608761429008721f, 0.793353340291235f,  -0.38268343236509f,
+        0.923879532511287f,  -0.130526192220052f, 0.99144486137381f};
+    static constexpr float kTail[16] = {
+        0.38268343236509f,  0.923879532511287f, 0.923879532511287f,
+        0.38268343236509f,  0.923879532511287f, -0.38268343236509f,
+        0.38268343236509f,  -0.923879532511287f, -0.38268343236509f,
+        -0.923879532511287f, -0.923879532511287f, -0.38268343236509f,
+        -0.923879532511287f, 0.38268343236509f,  -0.38268343236509f,
+        0.923879532511287f};
+    for (int i = 0; i < 240; ++i) values[i] = kBase[i % 48];
+    for (int i = 0; i < 16; ++i) values[240 + i] = kTail[i];
+  }
+};
+
+const GradientTable kGradients;
+
+// Derived the way FastNoiseLite does, in float
+constexpr float kSqrt3 = 1.7320508075688772935274463415059f;
+constexpr float kF2 = 0.5f * (kSqrt3 - 1);
+constexpr float kG2 = (3 - kSqrt3) / 6;
+constexpr float kSimplexC1 = 2 * (1 - 2 * kG2) * (1 / kG2 - 2);
+constexpr float kSimplexC2 = -2 * (1 - 2 * kG2) * (1 - 2 * kG2);
+constexpr float kSimplexEdge = 2 * kG2 - 1;
+constexpr float kSimplexScale = 99.83685446303647f;
+constexpr float kPerlinScale = 1.4247691104677813f;
+
+// Wrapping multiply, the scalar code relies on two's complement overflow
+inline int MulWrap(int a, int b) {
+  return static_cast<int>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
+}
+inline int AddWrap(int a, int b) {
+  return static_cast<int>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+}
+
+// FastNoiseLite's FastFloor, one too low on negative integers, kept as is
+inline int FastFloor(float f) {
+  return f >= 0 ? static_cast<int>(f) : static_cast<int>(f) - 1;
+}
+
+inline float GradCoord(int seed, int xPrimed, int yPrimed, float xd,
+                       float yd) {
+  int hash = MulWrap(seed ^ xPrimed ^ yPrimed, kHashMultiplier);
+  hash ^= hash >> 15;
+  hash &= 127 << 1;
+  return xd * kGradients.values[hash] + yd * kGradients.values[hash | 1];
+}
+
+inline float InterpQuintic(float t) {
+  return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+inline float Lerp(float a, float b, float t) { return a + t * (b - a); }
+
+float ScalarPerlin(int seed, float x, float y) {
+  int x0 = FastFloor(x);
+  int y0 = FastFloor(y);
+  const float xd0 = x - static_cast<float>(x0);
+  const float yd0 = y - static_cast<float>(y0);
+  const float xd1 = xd0 - 1;
+  const float yd1 = yd0 - 1;
+  const float xs = InterpQuintic(xd0);
+  const float ys = InterpQuintic(yd0);
+
+  x0 = MulWrap(x0, kPrimeX);
+  y0 = MulWrap(y0, kPrimeY);
+  const int x1 = AddWrap(x0, kPrimeX);
+  const int y1 = AddWrap(y0, kPrimeY);
+
+  const float xf0 = Lerp(GradCoord(seed, x0, y0, xd0, yd0),
+                         GradCoord(seed, x1, y0, xd1, yd0), xs);
+  const float xf1 = Lerp(GradCoord(seed, x0, y1, xd0, yd1),
+                         GradCoord(seed, x1, y1, xd1, yd1), xs);
+  return Lerp(xf0, xf1, ys) * kPerlinScale;
+}
+
+float ScalarSimplex(int seed, float x, float y) {
+  int i = FastFloor(x);
+  int j = FastFloor(y);
+  const float xi = x - static_cast<float>(i);
+  const float yi = y - static_cast<float>(j);
+  const float t = (xi + yi) * kG2;
+  const float x0 = xi - t;
+  const float y0 = yi - t;
+  i = MulWrap(i, kPrimeX);
+  j = MulWrap(j, kPrimeY);
+
+  float n0 = 0, n1 = 0, n2 = 0;
+  const float a = 0.5f - x0 * x0 - y0 * y0;
+  if (a > 0) n0 = (a * a) * (a * a) * GradCoord(seed, i, j, x0, y0);
+
+  const float c = kSimplexC1 * t + (kSimplexC2 + a);
+  if (c > 0) {
+    const float x2 = x0 + kSimplexEdge;
+    const float y2 = y0 + kSimplexEdge;
+    n2 = (c * c) * (c * c) *
+         GradCoord(seed, AddWrap(i, kPrimeX), AddWrap(j, kPrimeY), x2, y2);
+  }
+
+  const bool bUpper = y0 > x0;
+  const float x1 = x0 + (bUpper ? kG2 : kG2 - 1);
+  const float y1 = y0 + (bUpper ? kG2 - 1 : kG2);
+  const float b = 0.5f - x1 * x1 - y1 * y1;
+  if (b > 0) {
+    n1 = (b * b) * (b * b) *
+         GradCoord(seed, bUpper ? i : AddWrap(i, kPrimeX),
+                   bUpper ? AddWrap(j, kPrimeY) : j, x1, y1);
+  }
+  return (n0 + n1 + n2) * kSimplexScale;
+}
+
+#if defined(FACTORYGAME_SIMD_AVX2) || defined(FACTORYGAME_SIMD_SSE41)
+
+#if defined(FACTORYGAME_SIMD_AVX2)
+// 8 lanes
+struct Lanes {
+  using F = __m256;
+  using I = __m256i;
+  static constexpr int kWidth = 8;
+
+  static F Set(float v) { return _mm256_set1_ps(v); }
+  static I Set(int v) { return _mm256_set1_epi32(v); }
+  static I Ramp(int start) {
+    return _mm256_setr_epi32(start, start + 1, start + 2, start + 3,
+                             start + 4, start + 5, start + 6, start + 7);
+  }
+  static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+  static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+  static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+  static I Add(I a, I b) { return _mm256_add_epi32(a, b); }
+  static I Mul(I a, I b) { return _mm256_mullo_epi32(a, b); }
+  static I Xor(I a, I b) { return _mm256_xor_si256(a, b); }
+  static I And(I a, I b) { return _mm256_and_si256(a, b); }
+  static I ShiftRight(I a, int n) { return _mm256_srai_epi32(a, n); }
+  static F ToFloat(I a) { return _mm256_cvtepi32_ps(a); }
+  static I Truncate(F a) { return _mm256_cvttps_epi32(a); }
+  static F Less(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static F Greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+  static F Mask(F value, F mask) { return _mm256_and_ps(value, mask); }
+  static F Select(F mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+  static I Select(F mask, I a, I b) {
+    return _mm256_castps_si256(_mm256_blendv_ps(
+        _mm256_castsi256_ps(b), _mm256_castsi256_ps(a), mask));
+  }
+  static I AsInt(F a) { return _mm256_castps_si256(a); }
+  static F Gather(I index) {
+    return _mm256_i32gather_ps(kGradients.values.data(), index, 4);
+  }
+  static void Store(float* out, F v) { _mm256_storeu_ps(out, v); }
+};
+#else
+// 4 lanes, SSE4.1 has no gather, the lookups are done one by one
+struct Lanes {
+  using F = __m128;
+  using I = __m128i;
+  static constexpr int kWidth = 4;
+
+  static F Set(float v) { return _mm_set1_ps(v); }
+  static I Set(int v) { return _mm_set1_epi32(v); }
+  static I Ramp(int start) {
+    return _mm_setr_epi32(start, start + 1, start + 2, start + 3);
+  }
+  static F Add(F a, F b) { return _mm_add_ps(a, b); }
+  static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+  static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+  static I Add(I a, I b) { return _mm_add_epi32(a, b); }
+  static I Mul(I a, I b) { return _mm_mullo_epi32(a, b); }
+  static I Xor(I a, I b) { return _mm_xor_si128(a, b); }
+  static I And(I a, I b) { return _mm_and_si128(a, b); }
+  static I ShiftRight(I a, int n) { return _mm_srai_epi32(a, n); }
+  static F ToFloat(I a) { return _mm_cvtepi32_ps(a); }
+  static I Truncate(F a) { return _mm_cvttps_epi32(a); }
+  static F Less(F a, F b) { return _mm_cmplt_ps(a, b); }
+  static F Greater(F a, F b) { return _mm_cmpgt_ps(a, b); }
+  static F Mask(F value, F mask) { return _mm_and_ps(value, mask); }
+  static F Select(F mask, F a, F b) { return _mm_blendv_ps(b, a, mask); }
+  static I Select(F mask, I a, I b) {
+    return _mm_castps_si128(
+        _mm_blendv_ps(_mm_castsi128_ps(b), _mm_castsi128_ps(a), mask));
+  }
+  static I AsInt(F a) { return _mm_castps_si128(a); }
+  static F Gather(I index) {
+    alignas(16) int i[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(i), index);
+    const float* g = kGradients.values.data();
+    return _mm_setr_ps(g[i[0]], g[i[1]], g[i[2]], g[i[3]]);
+  }
+  static void Store(float* out, F v) { _mm_storeu_ps(out, v); }
+};
+#endif
+
+using F = Lanes::F;
+using I = Lanes::I;
+
+// Truncation plus the all-ones mask of negative lanes, as FastFloor
+inline I FastFloor(F f) {
+  return Lanes::Add(Lanes::Truncate(f),
+                    Lanes::AsInt(Lanes::Less(f, Lanes::Set(0.f))));
+}
+
+inline F GradCoord(I seed, I xPrimed, I yPrimed, F xd, F yd) {
+  I hash = Lanes::Mul(Lanes::Xor(Lanes::Xor(seed, xPrimed), yPrimed),
+                      Lanes::Set(kHashMultiplier));
+  hash = Lanes::Xor(hash, Lanes::ShiftRight(hash, 15));
+  hash = Lanes::And(hash, Lanes::Set(127 << 1));
+  const F xg = Lanes::Gather(hash);
+  const F yg = Lanes::Gather(Lanes::Add(hash, Lanes::Set(1)));
+  return Lanes::Add(Lanes::Mul(xd, xg), Lanes::Mul(yd, yg));
+}
+
+inline F InterpQuintic(F t) {
+  const F inner = Lanes::Add(
+      Lanes::Mul(t, Lanes::Sub(Lanes::Mul(t, Lanes::Set(6.f)),
+                               Lanes::Set(15.f))),
+      Lanes::Set(10.f));
+  return Lanes::Mul(Lanes::Mul(Lanes::Mul(t, t), t), inner);
+}
+
+inline F Lerp(F a, F b, F t) {
+  return Lanes::Add(a, Lanes::Mul(t, Lanes::Sub(b, a)));
+}
+
+F LanesPerlin(I seed, F x, F y) {
+  I x0 = FastFloor(x);
+  I y0 = FastFloor(y);
+  const F xd0 = Lanes::Sub(x, Lanes::ToFloat(x0));
+  const F yd0 = Lanes::Sub(y, Lanes::ToFloat(y0));
+  const F xd1 = Lanes::Sub(xd0, Lanes::Set(1.f));
+  const F yd1 = Lanes::Sub(yd0, Lanes::Set(1.f));
+  const F xs = InterpQuintic(xd0);
+  const F ys = InterpQuintic(yd0);
+
+  x0 = Lanes::Mul(x0, Lanes::Set(kPrimeX));
+  y0 = Lanes::Mul(y0, Lanes::Set(kPrimeY));
+  const I x1 = Lanes::Add(x0, Lanes::Set(kPrimeX));
+  const I y1 = Lanes::Add(y0, Lanes::Set(kPrimeY));
+
+  const F xf0 = Lerp(GradCoord(seed, x0, y0, xd0, yd0),
+                     GradCoord(seed, x1, y0, xd1, yd0), xs);
+  const F xf1 = Lerp(GradCoord(seed, x0, y1, xd0, yd1),
+                     GradCoord(seed, x1, y1, xd1, yd1), xs);
+  return Lanes::Mul(Lerp(xf0, xf1, ys), Lanes::Set(kPerlinScale));
+}
+
+// (v * v) * (v * v) * gradient where v > 0, 0 elsewhere
+inline F Falloff(F v, F gradient) {
+  const F v2 = Lanes::Mul(v, v);
+  return Lanes::Mask(Lanes::Mul(Lanes::Mul(v2, v2), gradient),
+                     Lanes::Greater(v, Lanes::Set(0.f)));
+}
+
+F LanesSimplex(I seed, F x, F y) {
+  I i = FastFloor(x);
+  I j = FastFloor(y);
+  const F xi = Lanes::Sub(x, Lanes::ToFloat(i));
+  const F yi = Lanes::Sub(y, Lanes::ToFloat(j));
+  const F t = Lanes::Mul(Lanes::Add(xi, yi), Lanes::Set(kG2));
+  const F x0 = Lanes::Sub(xi, t);
+  const F y0 = Lanes::Sub(yi, t);
+  i = Lanes::Mul(i, Lanes::Set(kPrimeX));
+  j = Lanes::Mul(j, Lanes::Set(kPrimeY));
+  const I i1 = Lanes::Add(i, Lanes::Set(kPrimeX));
+  const I j1 = Lanes::Add(j, Lanes::Set(kPrimeY));
+
+  const F a = Lanes::Sub(Lanes::Sub(Lanes::Set(0.5f), Lanes::Mul(x0, x0)),
+                         Lanes::Mul(y0, y0));
+  const F n0 = Falloff(a, GradCoord(seed, i, j, x0, y0));
+
+  const F c = Lanes::Add(Lanes::Mul(Lanes::Set(kSimplexC1), t),
+                         Lanes::Add(Lanes::Set(kSimplexC2), a));
+  const F x2 = Lanes::Add(x0, Lanes::Set(kSimplexEdge));
+  const F y2 = Lanes::Add(y0, Lanes::Set(kSimplexEdge));
+  const F n2 = Falloff(c, GradCoord(seed, i1, j1, x2, y2));
+
+  const F upper = Lanes::Greater(y0, x0);
+  const F x1 = Lanes::Add(
+      x0, Lanes::Select(upper, Lanes::Set(kG2), Lanes::Set(kG2 - 1)));
+  const F y1 = Lanes::Add(
+      y0, Lanes::Select(upper, Lanes::Set(kG2 - 1), Lanes::Set(kG2)));
+  const F b = Lanes::Sub(Lanes::Sub(Lanes::Set(0.5f), Lanes::Mul(x1, x1)),
+                         Lanes::Mul(y1, y1));
+  const F n1 = Falloff(b, GradCoord(seed, Lanes::Select(upper, i, i1),
+                                    Lanes::Select(upper, j1, j), x1, y1));
+
+  return Lanes::Mul(Lanes::Add(Lanes::Add(n0, n1), n2),
+                    Lanes::Set(kSimplexScale));
+}
+#endif
+}  // namespace
+
+NoiseGrid::NoiseGrid(ENoiseType type, float frequency, int seed)
+    : type(type), frequency(frequency), seed(seed) {}
+
+float NoiseGrid::Single(int x, int y) const {
+  float fx = static_cast<float>(x) * frequency;
+  float fy = static_cast<float>(y) * frequency;
+  if (type == ENoiseType::Perlin) return ScalarPerlin(seed, fx, fy);
+
+  // OpenSimplex2 skews the input, FastNoiseLite does it before sampling
+  const float t = (fx + fy) * kF2;
+  fx += t;
+  fy += t;
+  return ScalarSimplex(seed, fx, fy);
+}
+
+void NoiseGrid::GenerateScalar(int originX, int originY, int width,
+                               int height, float* out) const {
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x)
+      *out++ = Single(originX + x, originY + y);
+  }
+}
+
+void NoiseGrid::Generate(int originX, int originY, int width, int height,
+                         float* out) const {
+#if defined(FACTORYGAME_SIMD_AVX2) || defined(FACTORYGAME_SIMD_SSE41)
+  const I seedLanes = Lanes::Set(seed);
+  const F frequencyLanes = Lanes::Set(frequency);
+  for (int y = 0; y < height; ++y) {
+    const F fy = Lanes::Mul(Lanes::Set(static_cast<float>(originY + y)),
+                            frequencyLanes);
+    int x = 0;
+    for (; x + Lanes::kWidth <= width; x += Lanes::kWidth) {
+      F lx = Lanes::Mul(Lanes::ToFloat(Lanes::Ramp(originX + x)),
+                        frequencyLanes);
+      F ly = fy;
+      F value;
+      if (type == ENoiseType::Perlin) {
+        value = LanesPerlin(seedLanes, lx, ly);
+      } else {
+        const F t = Lanes::Mul(Lanes::Add(lx, ly), Lanes::Set(kF2));
+        lx = Lanes::Add(lx, t);
+        ly = Lanes::Add(ly, t);
+        value = LanesSimplex(seedLanes, lx, ly);
+      }
+      Lanes::Store(out + x, value);
+    }
+    for (; x < width; ++x) out[x] = Single(originX + x, originY + y);
+    out += width;
+  }
+#else
+  GenerateScalar(originX, originY, width, height, out);
+#endif
+}
+
+const char* NoiseGrid::GetSimdName() {
+#if defined(FACTORYGAME_SIMD_AVX2)
+  return "AVX2";
+#elif defined(FACTORYGAME_SIMD_SSE41)
+  return "SSE4.1";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,43 @@
+#include "Core/PacketAssembler.h"
+
+#include <cstring>
+
+#include "Core/PacketPool.h"
+#include "Util/PacketUtil.h"
+
+void PacketAssembler::Feed(const uint8_t* data, std::size_t size) {
+  // Compact once the consumed prefix dominates the buffer
+  if (readOffset > 0 && readOffset * 2 >= stream.size()) {
+    stream.erase(stream.begin(), stream.begin() + readOffset);
+    readOffset = 0;
+  }
+  stream.insert(stream.end(), data, data + size);
+}
+
+bool PacketAssembler::Next(PacketPtr& outPacket) {
+  if (bIsCorrupted) return false;
+
+  const std::size_t available = stream.size() - readOffset;
+  if (available < sPacketHeader) return false;
+
+  const uint8_t* rp = stream.data() + readOffset;
+  PACKET packetId;
+  std::size_t packetSize;
+  util::GetHeader(rp, packetId, packetSize);
+
+  if (packetSize < sPacketHeader) {
+    bIsCorrupted = true;
+    return false;
+  }
+  if (available < packetSize) return false;
+
+  outPacket = PacketPool::instance().Acquire(packetSize);
+  std::memcpy(outPacket.get(), stream.data() + readOffset, packetSize);
+  readOffset += packetSize;
+
+  if (readOffset == stream.size()) {
+    stream.clear();
+    readOffset = 0;
+  }
+  return true;
+}
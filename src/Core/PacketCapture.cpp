@@ -0,0 +1,152 @@
+#include "Core/PacketCapture.h"
+
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "Core/PacketPool.h"
+#include "Util/PacketUtil.h"
+
+PacketRecorder::~PacketRecorder() { Close(); }
+
+bool PacketRecorder::Open(const std::string& path) {
+  Close();
+  file.open(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    std::cerr << "Could not open capture file " << path << std::endl;
+    return false;
+  }
+
+  uint8_t header[sCaptureFileHeader];
+  uint8_t* wp = header;
+  std::memcpy(wp, kCaptureMagic, sizeof(kCaptureMagic));
+  wp += sizeof(kCaptureMagic);
+  util::Write16BigEnd(wp, kCaptureVersion);
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+  recordCount = 0;
+  return true;
+}
+
+void PacketRecorder::Close() {
+  if (file.is_open()) file.close();
+}
+
+void PacketRecorder::Record(uint32_t tick, uint32_t timeMs,
+                            const RecvPacket& recv) {
+  if (!file.is_open()) return;
+
+  std::size_t packetSize = 0;
+  if (recv.packet != nullptr) {
+    const uint8_t* rp = recv.packet.get();
+    PACKET packetId;
+    util::GetHeader(rp, packetId, packetSize);
+  }
+
+  uint8_t header[sCaptureRecordHeader];
+  uint8_t* wp = header;
+  util::Write32BigEnd(wp, tick);
+  util::Write32BigEnd(wp, timeMs);
+  util::Write64BigEnd(wp, recv.senderClientId);
+  util::Write16BigEnd(wp, static_cast<uint16_t>(packetSize));
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+  if (packetSize > 0)
+    file.write(reinterpret_cast<const char*>(recv.packet.get()), packetSize);
+  ++recordCount;
+}
+
+PacketReplayer::PacketReplayer(ThreadSafeQueue<RecvPacket>* queue,
+                               float playbackRate)
+    : queue(queue), playbackRate(playbackRate) {}
+
+bool PacketReplayer::Open(const std::string& path) {
+  file.open(path, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Could not open capture file " << path << std::endl;
+    return false;
+  }
+
+  uint8_t header[sCaptureFileHeader];
+  if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+      std::memcmp(header, kCaptureMagic, sizeof(kCaptureMagic)) != 0) {
+    std::cerr << path << " is not a packet capture" << std::endl;
+    return false;
+  }
+  const uint8_t* rp = header + sizeof(kCaptureMagic);
+  const uint16_t version = util::Read16BigEnd(rp);
+  if (version != kCaptureVersion) {
+    std::cerr << "Unsupported capture version " << version << std::endl;
+    return false;
+  }
+
+  playbackMs = 0.0;
+  replayedCount = 0;
+  ReadNext();
+  return true;
+}
+
+std::size_t PacketReplayer::Update(float deltaTime) {
+  return playbackRate > 0.f ? Advance(deltaTime) : StepTick();
+}
+
+std::size_t PacketReplayer::Advance(float deltaTime) {
+  playbackMs += static_cast<double>(deltaTime) * playbackRate * 1000.0;
+
+  std::size_t pushed = 0;
+  while (bHasNext && next.timeMs <= playbackMs) {
+    PushNext();
+    ++pushed;
+  }
+  return pushed;
+}
+
+std::size_t PacketReplayer::StepTick() {
+  if (!bHasNext) return 0;
+
+  const uint32_t tick = next.tick;
+  // Keep the clock in step so Advance can resume from here
+  playbackMs = next.timeMs;
+
+  std::size_t pushed = 0;
+  while (bHasNext && next.tick == tick) {
+    PushNext();
+    ++pushed;
+  }
+  return pushed;
+}
+
+void PacketReplayer::ReadNext() {
+  bHasNext = false;
+
+  uint8_t header[sCaptureRecordHeader];
+  if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) return;
+
+  const uint8_t* rp = header;
+  next.tick = util::Read32BigEnd(rp);
+  next.timeMs = util::Read32BigEnd(rp);
+  next.senderClientId = util::Read64BigEnd(rp);
+  const std::size_t packetSize = util::Read16BigEnd(rp);
+
+  next.packet.resize(packetSize);
+  if (packetSize == 0) {
+    bHasNext = true;
+    return;
+  }
+  if (packetSize < sPacketHeader ||
+      !file.read(reinterpret_cast<char*>(next.packet.data()), packetSize)) {
+    std::cerr << "Capture file is truncated, replay stopped" << std::endl;
+    return;
+  }
+  bHasNext = true;
+}
+
+void PacketReplayer::PushNext() {
+  RecvPacket recv;
+  recv.senderClientId = next.senderClientId;
+  if (!next.packet.empty()) {
+    recv.packet = PacketPool::instance().Acquire(next.packet.size());
+    std::memcpy(recv.packet.get(), next.packet.data(), next.packet.size());
+  }
+  queue->Push(std::move(recv));
+  ++replayedCount;
+  ReadNext();
+}
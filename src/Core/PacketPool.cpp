@@ -0,0 +1,62 @@
+#include "Core/PacketPool.h"
+
+void PacketDeleter::operator()(uint8_t* buffer) const {
+  if (buffer == nullptr) return;
+  if (sizeClass == kUnpooled) {
+    delete[] buffer;
+    return;
+  }
+  PacketPool::instance().Release(buffer, sizeClass);
+}
+
+PacketPool::~PacketPool() {
+  for (SizeClass& sizeClass : classes) {
+    for (uint8_t* buffer : sizeClass.idle) delete[] buffer;
+  }
+}
+
+PacketPtr PacketPool::Acquire(std::size_t size) {
+  const uint8_t sizeClass = GetSizeClass(size);
+  if (sizeClass == PacketDeleter::kUnpooled)
+    return PacketPtr(new uint8_t[size], PacketDeleter{});
+
+  SizeClass& entry = classes[sizeClass];
+  {
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    if (!entry.idle.empty()) {
+      uint8_t* buffer = entry.idle.back();
+      entry.idle.pop_back();
+      return PacketPtr(buffer, PacketDeleter{sizeClass});
+    }
+  }
+  return PacketPtr(new uint8_t[GetClassSize(sizeClass)],
+                   PacketDeleter{sizeClass});
+}
+
+std::size_t PacketPool::GetIdleCount(std::size_t size) {
+  const uint8_t sizeClass = GetSizeClass(size);
+  if (sizeClass == PacketDeleter::kUnpooled) return 0;
+
+  SizeClass& entry = classes[sizeClass];
+  std::lock_guard<std::mutex> lock(entry.mutex);
+  return entry.idle.size();
+}
+
+uint8_t PacketPool::GetSizeClass(std::size_t size) {
+  for (uint8_t i = 0; i < kClassCount; ++i) {
+    if (size <= GetClassSize(i)) return i;
+  }
+  return PacketDeleter::kUnpooled;
+}
+
+void PacketPool::Release(uint8_t* buffer, uint8_t sizeClass) {
+  SizeClass& entry = classes[sizeClass];
+  {
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    if (entry.idle.size() * GetClassSize(sizeClass) < kMaxPooledBytes) {
+      entry.idle.push_back(buffer);
+      return;
+    }
+  }
+  delete[] buffer;
+}
@@ -0,0 +1,30 @@
+#include "Core/ProductionModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+ProductionProjection ProjectProduction(bool bRunning, float progress,
+                                       float elapsed, float cycleTime,
+                                       int startable) {
+  ProductionProjection projection;
+  const int underway = bRunning ? 1 : 0;
+  const int total = underway + std::max(0, startable);
+  if (total == 0 || cycleTime <= 0.f) return projection;
+
+  const double time =
+      static_cast<double>(elapsed) + (bRunning ? progress : 0.f);
+  const double byTime = std::floor(time / cycleTime);
+  if (byTime >= total) {
+    // Ran out of inputs or room, idle for the rest of the interval
+    projection.completed = total;
+    projection.started = total - underway;
+    return projection;
+  }
+
+  projection.completed = static_cast<int>(byTime);
+  projection.started = projection.completed + 1 - underway;
+  projection.bRunning = true;
+  projection.progress = static_cast<float>(
+      std::clamp(time - byTime * cycleTime, 0.0, double{cycleTime}));
+  return projection;
+}
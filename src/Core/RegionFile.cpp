@@ -0,0 +1,521 @@
+#include "Core/RegionFile.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+#include "Core/TileData.h"
+#include "Util/PacketUtil.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr const char* kWorldFileName = "world.fgw";
+constexpr std::size_t kRunSize = 2 + 1;
+constexpr std::size_t kOreSize = 2 + 1 + 4;
+constexpr std::size_t kBuildingHeaderSize = 1 + 4 + 4 + 8 + 4 + 2;
+
+inline bool HasBytes(const uint8_t* rp, const uint8_t* end, std::size_t n) {
+  return rp <= end && static_cast<std::size_t>(end - rp) >= n;
+}
+
+bool ReadWorldFile(const std::string& directory, uint64_t& seed,
+                   double& gameTime) {
+  std::ifstream file(std::filesystem::path(directory) / kWorldFileName,
+                     std::ios::binary);
+  if (!file.is_open()) return false;
+
+  uint8_t bytes[sWorldFile];
+  file.read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+  const uint8_t* rp = bytes;
+  if (!file ||
+      std::memcmp(rp, kWorldFileMagic, sizeof(kWorldFileMagic)) != 0)
+    return false;
+  rp += sizeof(kWorldFileMagic);
+  if (util::Read16BigEnd(rp) != kWorldFileVersion) return false;
+  seed = util::Read64BigEnd(rp);
+  gameTime = std::bit_cast<double>(util::Read64BigEnd(rp));
+  if (!std::isfinite(gameTime) || gameTime < 0.0) gameTime = 0.0;
+  return true;
+}
+
+inline int GetRegionIndex(ChunkCoord coord) {
+  return ((coord.y & (kRegionSize - 1)) << kRegionShift) |
+         (coord.x & (kRegionSize - 1));
+}
+}  // namespace
+
+void ChunkRecord::Encode(std::vector<uint8_t>& out) const {
+  std::vector<std::pair<uint16_t, uint8_t>> runs;
+  for (const uint8_t type : types) {
+    if (!runs.empty() && runs.back().second == type)
+      ++runs.back().first;
+    else
+      runs.emplace_back(uint16_t{1}, type);
+  }
+
+  std::size_t size = 2 + runs.size() * kRunSize + 2 + ores.size() * kOreSize +
+                     2 + buildings.size() * kBuildingHeaderSize;
+  for (const Building& building : buildings) size += building.state.size();
+  out.resize(size);
+
+  uint8_t* wp = out.data();
+  util::Write16BigEnd(wp, static_cast<uint16_t>(runs.size()));
+  for (const auto& [length, type] : runs) {
+    util::Write16BigEnd(wp, length);
+    *wp++ = type;
+  }
+  util::Write16BigEnd(wp, static_cast<uint16_t>(ores.size()));
+  for (const Ore& ore : ores) {
+    util::Write16BigEnd(wp, ore.index);
+    *wp++ = static_cast<uint8_t>(ore.type);
+    util::Write32BigEnd(wp, static_cast<uint32_t>(ore.amount));
+  }
+  util::Write16BigEnd(wp, static_cast<uint16_t>(buildings.size()));
+  for (const Building& building : buildings) {
+    *wp++ = static_cast<uint8_t>(building.archetype);
+    util::Write32BigEnd(wp, static_cast<uint32_t>(building.tileIndex.x));
+    util::Write32BigEnd(wp, static_cast<uint32_t>(building.tileIndex.y));
+    util::Write64BigEnd(wp, std::bit_cast<uint64_t>(building.settledAt));
+    util::Write32BigEnd(wp, std::bit_cast<uint32_t>(building.progress));
+    util::Write16BigEnd(wp, static_cast<uint16_t>(building.state.size()));
+    std::memcpy(wp, building.state.data(), building.state.size());
+    wp += building.state.size();
+  }
+}
+
+bool ChunkRecord::Decode(const uint8_t* data, std::size_t size) {
+  const uint8_t* rp = data;
+  const uint8_t* end = data + size;
+
+  if (!HasBytes(rp, end, 2)) return false;
+  const uint16_t runCount = util::Read16BigEnd(rp);
+  if (!HasBytes(rp, end, runCount * kRunSize)) return false;
+  int filled = 0;
+  for (uint16_t i = 0; i < runCount; ++i) {
+    const uint16_t length = util::Read16BigEnd(rp);
+    const uint8_t type = *rp++;
+    if (filled + length > Chunk::kTileCount ||
+        type > static_cast<uint8_t>(TileType::Stone))
+      return false;
+    std::fill_n(types.begin() + filled, length, type);
+    filled += length;
+  }
+  if (filled != Chunk::kTileCount) return false;
+
+  if (!HasBytes(rp, end, 2)) return false;
+  const uint16_t oreCount = util::Read16BigEnd(rp);
+  if (!HasBytes(rp, end, oreCount * kOreSize)) return false;
+  ores.clear();
+  for (uint16_t i = 0; i < oreCount; ++i) {
+    Ore ore;
+    ore.index = util::Read16BigEnd(rp);
+    const uint8_t type = *rp++;
+    ore.amount = static_cast<rsrc_amt_t>(util::Read32BigEnd(rp));
+    if (ore.index >= Chunk::kTileCount ||
+        type >= static_cast<uint8_t>(OreType::MaxOreType))
+      return false;
+    ore.type = static_cast<OreType>(type);
+    ores.push_back(ore);
+  }
+
+  if (!HasBytes(rp, end, 2)) return false;
+  const uint16_t buildingCount = util::Read16BigEnd(rp);
+  buildings.clear();
+  for (uint16_t i = 0; i < buildingCount; ++i) {
+    if (!HasBytes(rp, end, kBuildingHeaderSize)) return false;
+    Building building;
+    const uint8_t archetype = *rp++;
+    building.tileIndex.x = static_cast<int32_t>(util::Read32BigEnd(rp));
+    building.tileIndex.y = static_cast<int32_t>(util::Read32BigEnd(rp));
+    building.settledAt = std::bit_cast<double>(util::Read64BigEnd(rp));
+    building.progress = std::bit_cast<float>(util::Read32BigEnd(rp));
+    const uint16_t stateSize = util::Read16BigEnd(rp);
+    if (archetype == static_cast<uint8_t>(ENetArchetype::None) ||
+        archetype > static_cast<uint8_t>(ENetArchetype::MiningDrill) ||
+        !std::isfinite(building.settledAt) || building.settledAt < 0.0 ||
+        !std::isfinite(building.progress) || building.progress < 0.f ||
+        !HasBytes(rp, end, stateSize))
+      return false;
+    building.archetype = static_cast<ENetArchetype>(archetype);
+    building.state.assign(rp, rp + stateSize);
+    rp += stateSize;
+    buildings.push_back(std::move(building));
+  }
+  return rp == end;
+}
+
+MappedFile::~MappedFile() { Unmap(); }
+
+#ifdef _WIN32
+bool MappedFile::Map(const std::string& path) {
+  Unmap();
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  fileHandle = file;
+  mappingHandle = mapping;
+  data = static_cast<const uint8_t*>(view);
+  size = static_cast<std::size_t>(fileSize.QuadPart);
+  return true;
+}
+
+void MappedFile::Unmap() {
+  if (data != nullptr) UnmapViewOfFile(data);
+  if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+  if (fileHandle != nullptr) CloseHandle(fileHandle);
+  data = nullptr;
+  size = 0;
+  mappingHandle = nullptr;
+  fileHandle = nullptr;
+}
+#else
+bool MappedFile::Map(const std::string& path) {
+  Unmap();
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat status;
+  if (fstat(fd, &status) != 0 || status.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  // The mapping keeps its own reference to the file
+  void* view = mmap(nullptr, static_cast<std::size_t>(status.st_size),
+                    PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) return false;
+
+  data = static_cast<const uint8_t*>(view);
+  size = static_cast<std::size_t>(status.st_size);
+  return true;
+}
+
+void MappedFile::Unmap() {
+  if (data != nullptr) munmap(const_cast<uint8_t*>(data), size);
+  data = nullptr;
+  size = 0;
+}
+#endif
+
+RegionFile::~RegionFile() { Close(); }
+
+bool RegionFile::Open(const std::string& filePath) {
+  Close();
+  path = filePath;
+  file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+  if (!file.is_open()) {
+    // in | out never creates a file
+    file.clear();
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary |
+                        std::ios::trunc);
+  }
+  if (!file.is_open()) {
+    std::cerr << "Could not open region file " << path << std::endl;
+    return false;
+  }
+
+  file.seekg(0, std::ios::end);
+  const std::size_t fileSize = static_cast<std::size_t>(file.tellg());
+  const std::size_t headerSize = kRegionHeaderSectors * kRegionSectorSize;
+  entries.fill(Entry{});
+
+  if (fileSize == 0) {
+    std::vector<uint8_t> header(headerSize, 0);
+    uint8_t* wp = header.data();
+    std::memcpy(wp, kRegionMagic, sizeof(kRegionMagic));
+    wp += sizeof(kRegionMagic);
+    util::Write16BigEnd(wp, kRegionVersion);
+    util::Write16BigEnd(wp, static_cast<uint16_t>(kRegionSize));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    file.flush();
+    if (!file) {
+      std::cerr << "Could not write region file " << path << std::endl;
+      Close();
+      return false;
+    }
+    usedSectors.assign(kRegionHeaderSectors, true);
+    return true;
+  }
+
+  std::vector<uint8_t> header(headerSize);
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(header.data()), header.size());
+  const uint8_t* rp = header.data();
+  if (!file || std::memcmp(rp, kRegionMagic, sizeof(kRegionMagic)) != 0) {
+    std::cerr << path << " is not a region file" << std::endl;
+    Close();
+    return false;
+  }
+  rp += sizeof(kRegionMagic);
+  const uint16_t version = util::Read16BigEnd(rp);
+  const uint16_t regionSize = util::Read16BigEnd(rp);
+  if (version != kRegionVersion || regionSize != kRegionSize) {
+    std::cerr << "Unsupported region file " << path << " (version "
+              << version << ", size " << regionSize << ")" << std::endl;
+    Close();
+    return false;
+  }
+
+  usedSectors.assign(
+      (fileSize + kRegionSectorSize - 1) / kRegionSectorSize, false);
+  std::fill_n(usedSectors.begin(), kRegionHeaderSectors, true);
+  for (int i = 0; i < kRegionChunkCount; ++i) {
+    Entry entry;
+    entry.firstSector = util::Read32BigEnd(rp);
+    entry.size = util::Read32BigEnd(rp);
+    if (entry.firstSector == 0) continue;
+
+    // A torn write can leave an entry pointing past the file or into
+    // another payload, the chunk is regenerated instead
+    bool bIsValid = entry.size > 0 &&
+                    entry.firstSector >= kRegionHeaderSectors &&
+                    entry.firstSector + SectorsFor(entry.size) <=
+                        usedSectors.size();
+    for (uint32_t s = 0; bIsValid && s < SectorsFor(entry.size); ++s)
+      bIsValid = !usedSectors[entry.firstSector + s];
+    if (!bIsValid) {
+      std::cerr << "Dropping corrupt chunk " << i << " of " << path
+                << std::endl;
+      continue;
+    }
+    entries[i] = entry;
+    MarkSectors(entry, true);
+  }
+  return true;
+}
+
+void RegionFile::Close() {
+  mapping.Unmap();
+  if (file.is_open()) file.close();
+  file.clear();
+  usedSectors.clear();
+}
+
+bool RegionFile::Contains(int index) const {
+  return index >= 0 && index < kRegionChunkCount &&
+         entries[index].firstSector != 0;
+}
+
+bool RegionFile::Read(int index, const uint8_t*& data, std::size_t& size) {
+  if (!Contains(index)) return false;
+  if (!mapping.IsMapped() && !mapping.Map(path)) {
+    std::cerr << "Could not map region file " << path << std::endl;
+    return false;
+  }
+
+  const Entry& entry = entries[index];
+  const std::size_t offset =
+      static_cast<std::size_t>(entry.firstSector) * kRegionSectorSize;
+  if (offset + entry.size > mapping.GetSize()) return false;
+  data = mapping.GetData() + offset;
+  size = entry.size;
+  return true;
+}
+
+bool RegionFile::Write(int index, const std::vector<uint8_t>& payload) {
+  if (!file.is_open() || index < 0 || index >= kRegionChunkCount)
+    return false;
+  // Windows cannot grow a mapped file, and the map would go stale anyway
+  mapping.Unmap();
+
+  Entry& entry = entries[index];
+  const uint32_t sectorCount = SectorsFor(payload.size());
+  const bool bFitsInPlace =
+      entry.firstSector != 0 && SectorsFor(entry.size) >= sectorCount;
+  MarkSectors(entry, false);
+  if (!bFitsInPlace) entry.firstSector = Allocate(sectorCount);
+  entry.size = static_cast<uint32_t>(payload.size());
+  MarkSectors(entry, true);
+
+  // Padded to whole sectors, the file always ends on a sector boundary
+  static const char kPadding[kRegionSectorSize] = {};
+  file.seekp(static_cast<std::streamoff>(entry.firstSector) *
+             kRegionSectorSize);
+  file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+  file.write(kPadding, sectorCount * kRegionSectorSize - payload.size());
+  WriteEntry(index);
+  file.flush();
+  if (!file) {
+    std::cerr << "Could not write chunk " << index << " to " << path
+              << std::endl;
+    file.clear();
+    return false;
+  }
+  return true;
+}
+
+uint32_t RegionFile::SectorsFor(std::size_t size) {
+  return static_cast<uint32_t>(
+      std::max<std::size_t>(1, (size + kRegionSectorSize - 1) /
+                                   kRegionSectorSize));
+}
+
+uint32_t RegionFile::Allocate(uint32_t sectorCount) {
+  // First fit, a run at the end of the file may be extended
+  uint32_t runStart = kRegionHeaderSectors;
+  uint32_t runLength = 0;
+  for (uint32_t s = kRegionHeaderSectors; s < usedSectors.size(); ++s) {
+    if (usedSectors[s]) {
+      runStart = s + 1;
+      runLength = 0;
+    } else if (++runLength == sectorCount) {
+      return runStart;
+    }
+  }
+  return runStart;
+}
+
+void RegionFile::MarkSectors(const Entry& entry, bool bIsUsed) {
+  if (entry.firstSector == 0) return;
+  const uint32_t end = entry.firstSector + SectorsFor(entry.size);
+  if (end > usedSectors.size()) usedSectors.resize(end, false);
+  for (uint32_t s = entry.firstSector; s < end; ++s) usedSectors[s] = bIsUsed;
+}
+
+void RegionFile::WriteEntry(int index) {
+  uint8_t bytes[sRegionTableEntry];
+  uint8_t* wp = bytes;
+  util::Write32BigEnd(wp, entries[index].firstSector);
+  util::Write32BigEnd(wp, entries[index].size);
+  file.seekp(sRegionFileHeader + index * sRegionTableEntry);
+  file.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+bool RegionStore::ReadSeed(const std::string& directory, uint64_t& seed) {
+  double gameTime;
+  return ReadWorldFile(directory, seed, gameTime);
+}
+
+bool RegionStore::Open(const std::string& path, uint64_t worldSeed) {
+  regions.clear();
+  directory.clear();
+  seed = worldSeed;
+  gameTime = 0.0;
+
+  std::error_code error;
+  std::filesystem::create_directories(path, error);
+  if (error) {
+    std::cerr << "Could not create save directory " << path << ": "
+              << error.message() << std::endl;
+    return false;
+  }
+
+  uint64_t savedSeed;
+  if (ReadWorldFile(path, savedSeed, gameTime)) {
+    if (savedSeed != seed) {
+      std::cerr << "Save " << path << " belongs to world seed " << savedSeed
+                << ", not " << seed << std::endl;
+      return false;
+    }
+  } else if (!WriteWorldFile(path)) {
+    return false;
+  }
+
+  directory = path;
+  return true;
+}
+
+bool RegionStore::SaveGameTime(double time) {
+  if (directory.empty()) return false;
+  gameTime = time;
+  return WriteWorldFile(directory);
+}
+
+bool RegionStore::WriteWorldFile(const std::string& path) const {
+  uint8_t bytes[sWorldFile];
+  uint8_t* wp = bytes;
+  std::memcpy(wp, kWorldFileMagic, sizeof(kWorldFileMagic));
+  wp += sizeof(kWorldFileMagic);
+  util::Write16BigEnd(wp, kWorldFileVersion);
+  util::Write64BigEnd(wp, seed);
+  util::Write64BigEnd(wp, std::bit_cast<uint64_t>(gameTime));
+  std::ofstream file(std::filesystem::path(path) / kWorldFileName,
+                     std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+  if (!file) {
+    std::cerr << "Could not write world file in " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool RegionStore::Contains(ChunkCoord coord) {
+  RegionFile* region = GetRegion(coord, false);
+  return region != nullptr && region->Contains(GetRegionIndex(coord));
+}
+
+bool RegionStore::Load(ChunkCoord coord, const uint8_t*& data,
+                       std::size_t& size) {
+  RegionFile* region = GetRegion(coord, false);
+  return region != nullptr && region->Read(GetRegionIndex(coord), data, size);
+}
+
+bool RegionStore::Save(ChunkCoord coord, const std::vector<uint8_t>& payload) {
+  RegionFile* region = GetRegion(coord, true);
+  return region != nullptr && region->Write(GetRegionIndex(coord), payload);
+}
+
+RegionFile* RegionStore::GetRegion(ChunkCoord coord, bool bCreate) {
+  if (directory.empty()) return nullptr;
+
+  // Arithmetic shift, chunk -1 is in region -1
+  const ChunkCoord region{coord.x >> kRegionShift, coord.y >> kRegionShift};
+  const uint64_t key = PackChunkKey(region.x, region.y);
+  // Missing and broken regions are kept as nullptr, chunks waiting to be
+  // generated look them up every frame
+  auto it = regions.find(key);
+  if (it != regions.end() && (it->second != nullptr || !bCreate))
+    return it->second.get();
+
+  const std::filesystem::path path =
+      std::filesystem::path(directory) /
+      ("r." + std::to_string(region.x) + "." + std::to_string(region.y) +
+       ".fgr");
+  std::unique_ptr<RegionFile> file;
+  if (bCreate || std::filesystem::exists(path)) {
+    file = std::make_unique<RegionFile>();
+    if (!file->Open(path.string())) file.reset();
+  }
+  RegionFile* opened = file.get();
+  regions[key] = std::move(file);
+  return opened;
+}
@@ -0,0 +1,322 @@
+#include "Core/ReplicationManager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "Core/PacketPool.h"
+#include "Core/PacketSchema.h"
+#include "Core/Registry.h"
+#include "Util/PacketUtil.h"
+
+namespace {
+constexpr std::size_t kCountSize = sizeof(uint16_t);
+constexpr std::size_t kSpawnHeaderSize =
+    sizeof(netid_t) + sizeof(uint8_t) + sizeof(int32_t) * 2;
+}  // namespace
+
+ReplicationManager::ReplicationManager(Registry* registry)
+    : registry(registry) {}
+
+netid_t ReplicationManager::RegisterEntity(EntityID entity,
+                                           ENetArchetype archetype,
+                                           Vec2 tileIndex) {
+  netid_t netID = nextNetID++;
+  // never hand out ids in the static range
+  if (IsStaticNetID(nextNetID)) nextNetID = 1;
+
+  registry->AddComponent<NetIdentityComponent>(
+      entity, NetIdentityComponent{netID, true});
+  replicas[netID] = Replica{entity, archetype, tileIndex, ++version};
+  entityToNet[entity] = netID;
+
+  for (auto& [clientID, stream] : clients) QueueSpawn(stream, netID);
+  return netID;
+}
+
+void ReplicationManager::UnregisterEntity(EntityID entity) {
+  auto it = entityToNet.find(entity);
+  if (it == entityToNet.end()) return;
+  const netid_t netID = it->second;
+  entityToNet.erase(it);
+  auto replicaIt = replicas.find(netID);
+  const uint32_t spawnVersion =
+      replicaIt != replicas.end() ? replicaIt->second.spawnVersion : 0;
+  if (replicaIt != replicas.end()) replicas.erase(replicaIt);
+
+  // World-generated entities are only unloaded, clients regenerate them
+  if (IsStaticNetID(netID)) return;
+
+  tombstones.push_back({netID, spawnVersion, ++version});
+  if (tombstones.size() > kMaxTombstones) {
+    forgottenVersion = tombstones.front().version;
+    tombstones.pop_front();
+  }
+
+  for (auto& [clientID, stream] : clients) {
+    if (stream.unspawned.erase(netID)) {
+      // Never reached this client, cancel instead of spawn + despawn
+      auto op = std::find_if(
+          stream.reliable.begin(), stream.reliable.end(),
+          [netID](const ReliableOp& r) {
+            return r.type == ENTITY_SPAWN && r.netID == netID;
+          });
+      if (op != stream.reliable.end()) stream.reliable.erase(op);
+      continue;
+    }
+    stream.reliable.push_back({ENTITY_DESPAWN, netID});
+  }
+}
+
+EntityID ReplicationManager::GetEntity(netid_t netID) const {
+  auto it = replicas.find(netID);
+  if (it == replicas.end()) return INVALID_ENTITY;
+  return it->second.entity;
+}
+
+void ReplicationManager::AddClient(clientid_t clientID) {
+  QueueEverything(clients[clientID]);
+}
+
+void ReplicationManager::RemoveClient(clientid_t clientID) {
+  clients.erase(clientID);
+}
+
+bool ReplicationManager::ResumeClient(clientid_t clientID,
+                                      uint32_t knownVersion) {
+  ClientStream& stream = clients[clientID];
+  stream = ClientStream{};
+  // A version from the future belongs to an earlier run of the server
+  if (knownVersion > version || knownVersion < forgottenVersion) {
+    QueueEverything(stream);
+    return false;
+  }
+
+  for (const Tombstone& tombstone : tombstones) {
+    // Created and destroyed while away, the client never had it
+    if (tombstone.version <= knownVersion ||
+        tombstone.spawnVersion > knownVersion)
+      continue;
+    stream.reliable.push_back({ENTITY_DESPAWN, tombstone.netID});
+  }
+
+  for (auto& [netID, replica] : replicas) {
+    if (replica.archetype != ENetArchetype::None &&
+        replica.spawnVersion > knownVersion) {
+      QueueSpawn(stream, netID);
+      continue;
+    }
+    uint8_t mask = 0;
+    for (std::size_t bit = 0; bit < replica.componentVersion.size(); ++bit) {
+      if (replica.componentVersion[bit] > knownVersion)
+        mask |= static_cast<uint8_t>(1u << bit);
+    }
+    QueueDirty(stream, netID, mask);
+  }
+  return true;
+}
+
+void ReplicationManager::CollectDirty() {
+  for (EntityID entity :
+       registry->view<ReplicationDirtyTag, NetIdentityComponent>()) {
+    const uint8_t mask =
+        registry->GetComponent<ReplicationDirtyTag>(entity).componentMask;
+    registry->RemoveComponent<ReplicationDirtyTag>(entity);
+
+    const netid_t netID =
+        registry->GetComponent<NetIdentityComponent>(entity).netID;
+
+    auto replicaIt = replicas.find(netID);
+    if (replicaIt == replicas.end()) {
+      if (!IsStaticNetID(netID)) continue;
+      // First divergence of a world-generated entity, remember it so late
+      // joiners get its state too.
+      replicaIt = replicas
+                      .emplace(netID, Replica{entity, ENetArchetype::None,
+                                              GetStaticNetIDTile(netID)})
+                      .first;
+      entityToNet[entity] = netID;
+    }
+
+    ++version;
+    auto& componentVersion = replicaIt->second.componentVersion;
+    for (std::size_t bit = 0; bit < componentVersion.size(); ++bit) {
+      if (mask & (1u << bit)) componentVersion[bit] = version;
+    }
+
+    for (auto& [clientID, stream] : clients) QueueDirty(stream, netID, mask);
+  }
+}
+
+void ReplicationManager::Flush(clientid_t clientID, float deltaTime,
+                               std::vector<PacketPtr>& outPackets) {
+  auto it = clients.find(clientID);
+  if (it == clients.end()) return;
+  ClientStream& stream = it->second;
+
+  stream.budget = std::min(
+      stream.budget + kReplicationBytesPerSecond * deltaTime,
+      kReplicationBurstBytes);
+
+  while (stream.budget > 0.f) {
+    // Written in place, packet_size tells readers where the data ends
+    PacketPtr packet = PacketPool::instance().Acquire(kMaxReplicationPacketSize);
+
+    // Spawns/despawns go first so updates never reference unknown ids
+    std::size_t size = WriteReliable(stream, packet.get());
+    if (size == 0) size = WriteUpdates(clientID, stream, packet.get());
+    if (size == 0) break;
+
+    outPackets.push_back(std::move(packet));
+    stream.budget -= static_cast<float>(size);
+  }
+
+  // Everything up to version is on its way, tell the client for resuming
+  stream.syncTimer += deltaTime;
+  if (stream.reliable.empty() && stream.dirtyOrder.empty() &&
+      stream.syncedVersion != version &&
+      stream.syncTimer >= kReplicationSyncInterval) {
+    outPackets.push_back(MakePacket<REPLICATION_SYNC>(version));
+    stream.syncedVersion = version;
+    stream.syncTimer = 0.f;
+  }
+}
+
+void ReplicationManager::QueueSpawn(ClientStream& stream, netid_t netID) {
+  stream.reliable.push_back({ENTITY_SPAWN, netID});
+  stream.unspawned.insert(netID);
+}
+
+void ReplicationManager::QueueEverything(ClientStream& stream) {
+  const auto& replicator = ComponentReplicator::instance();
+  for (auto& [netID, replica] : replicas) {
+    if (replica.archetype != ENetArchetype::None) {
+      QueueSpawn(stream, netID);
+    } else {
+      // World-generated entity that already diverged from worldgen
+      QueueDirty(stream, netID, replicator.GetMask(registry, replica.entity));
+    }
+  }
+}
+
+void ReplicationManager::QueueDirty(ClientStream& stream, netid_t netID,
+                                    uint8_t mask) {
+  if (mask == 0) return;
+  auto [it, inserted] = stream.dirtyMask.try_emplace(netID, 0);
+  if (it->second == 0) stream.dirtyOrder.push_back(netID);
+  it->second |= mask;
+}
+
+std::size_t ReplicationManager::WriteReliable(ClientStream& stream,
+                                              uint8_t* buffer) {
+  if (stream.reliable.empty()) return 0;
+
+  const auto& replicator = ComponentReplicator::instance();
+  const PACKET type = stream.reliable.front().type;
+
+  uint8_t* wp = buffer + sPacketHeader + kCountSize;
+  const uint8_t* end = buffer + kMaxReplicationPacketSize;
+  uint16_t count = 0;
+
+  while (!stream.reliable.empty() && stream.reliable.front().type == type) {
+    const netid_t netID = stream.reliable.front().netID;
+
+    if (type == ENTITY_DESPAWN) {
+      if (static_cast<std::size_t>(end - wp) < sizeof(netid_t)) break;
+      util::Write32BigEnd(wp, netID);
+    } else {
+      auto replicaIt = replicas.find(netID);
+      if (replicaIt != replicas.end()) {
+        const Replica& replica = replicaIt->second;
+        const uint8_t mask = replicator.GetMask(registry, replica.entity);
+        const std::size_t entrySize =
+            kSpawnHeaderSize + replicator.GetSize(registry, replica.entity, mask);
+
+        if (static_cast<std::size_t>(end - wp) < entrySize) {
+          if (count > 0) break;
+          std::cerr << "Replicated entity " << netID
+                    << " does not fit in a packet\n";
+        } else {
+          util::Write32BigEnd(wp, netID);
+          *wp++ = static_cast<uint8_t>(replica.archetype);
+          util::Write32BigEnd(wp, static_cast<uint32_t>(replica.tileIndex.x));
+          util::Write32BigEnd(wp, static_cast<uint32_t>(replica.tileIndex.y));
+          replicator.Write(registry, replica.entity, mask, wp);
+          ++count;
+        }
+      }
+      stream.unspawned.erase(netID);
+      stream.reliable.pop_front();
+      continue;
+    }
+    ++count;
+    stream.reliable.pop_front();
+  }
+
+  if (count == 0) return 0;
+
+  const std::size_t size = static_cast<std::size_t>(wp - buffer);
+  uint8_t* hp = buffer;
+  util::WriteHeader(hp, type, size);
+  util::Write16BigEnd(hp, count);
+  return size;
+}
+
+void ReplicationManager::SetStaticFilter(
+    std::function<bool(clientid_t, Vec2)> filter) {
+  staticFilter = std::move(filter);
+}
+
+std::size_t ReplicationManager::WriteUpdates(clientid_t clientID,
+                                             ClientStream& stream,
+                                             uint8_t* buffer) {
+  const auto& replicator = ComponentReplicator::instance();
+
+  uint8_t* wp = buffer + sPacketHeader + kCountSize;
+  const uint8_t* end = buffer + kMaxReplicationPacketSize;
+  uint16_t count = 0;
+
+  while (!stream.dirtyOrder.empty()) {
+    const netid_t netID = stream.dirtyOrder.front();
+    auto maskIt = stream.dirtyMask.find(netID);
+    auto replicaIt = replicas.find(netID);
+
+    // Destroyed, or the pending spawn or chunk will carry the full state
+    if (maskIt == stream.dirtyMask.end() || replicaIt == replicas.end() ||
+        stream.unspawned.count(netID) ||
+        (IsStaticNetID(netID) && staticFilter &&
+         !staticFilter(clientID, replicaIt->second.tileIndex))) {
+      if (maskIt != stream.dirtyMask.end()) stream.dirtyMask.erase(maskIt);
+      stream.dirtyOrder.pop_front();
+      continue;
+    }
+
+    const EntityID entity = replicaIt->second.entity;
+    const uint8_t mask = maskIt->second;
+    const std::size_t entrySize =
+        sizeof(netid_t) + replicator.GetSize(registry, entity, mask);
+
+    if (static_cast<std::size_t>(end - wp) < entrySize) {
+      if (count > 0) break;
+      std::cerr << "Replicated entity " << netID
+                << " does not fit in a packet\n";
+    } else {
+      util::Write32BigEnd(wp, netID);
+      replicator.Write(registry, entity, mask, wp);
+      ++count;
+    }
+    stream.dirtyMask.erase(maskIt);
+    stream.dirtyOrder.pop_front();
+  }
+
+  if (count == 0) return 0;
+
+  const std::size_t size = static_cast<std::size_t>(wp - buffer);
+  uint8_t* hp = buffer;
+  util::WriteHeader(hp, COMPONENT_UPDATE, size);
+  util::Write16BigEnd(hp, count);
+  return size;
+}
+
+ReplicationManager::~ReplicationManager() = default;
@@ -0,0 +1,56 @@
+#include "Core/SnapshotClock.h"
+
+#include <algorithm>
+
+#include "Core/Packet.h"
+
+namespace {
+// Baseline creep toward later arrivals, follows route and clock drift
+constexpr double kOffsetDrift = 1.0 / 256.0;
+constexpr double kJitterGain = 1.0 / 16.0;
+constexpr double kIntervalGain = 1.0 / 16.0;
+constexpr double kJitterScale = 2.5;
+// Grow the delay quickly on late packets, shrink it slowly once calm
+constexpr double kDelayGrowGain = 1.0 / 4.0;
+constexpr double kDelayShrinkGain = 1.0 / 64.0;
+}  // namespace
+
+void SnapshotClock::OnSnapshot(uint32_t serverTick, double localTime) {
+  if (bIsSynced && serverTick + static_cast<uint32_t>(tickRate) < newestTick)
+    bIsSynced = false;
+  // The server picks each client's send rate, learn it from the tick gaps
+  if (bIsSynced && serverTick > newestTick) {
+    const double gap =
+        (serverTick - newestTick) * static_cast<double>(tickDelta);
+    interval += (gap - interval) * kIntervalGain;
+  }
+  newestTick = bIsSynced ? std::max(newestTick, serverTick) : serverTick;
+
+  const double sample = localTime - serverTick * static_cast<double>(tickDelta);
+  if (!bIsSynced) {
+    offset = sample;
+    jitter = 0.0;
+    interval = syncDelta;
+    delay = kInitialDelay;
+    bIsSynced = true;
+    return;
+  }
+
+  if (sample < offset)
+    offset = sample;
+  else
+    offset += (sample - offset) * kOffsetDrift;
+
+  jitter += ((sample - offset) - jitter) * kJitterGain;
+
+  const double target = std::clamp(interval + kJitterScale * jitter,
+                                   kMinDelay, kMaxDelay);
+  delay += (target - delay) *
+           (target > delay ? kDelayGrowGain : kDelayShrinkGain);
+}
+
+double SnapshotClock::GetRenderTick(double localTime) const {
+  if (!bIsSynced) return 0.0;
+  const double serverTime = localTime - offset - delay;
+  return std::max(serverTime * tickRate, 0.0);
+}
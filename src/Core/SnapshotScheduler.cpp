@@ -0,0 +1,120 @@
+#include "Core/SnapshotScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Distance in pixels at which a player gains priority at half the rate
+constexpr float kDistanceFalloff = 256.f;
+// Players standing still since their last send fill up this much slower
+constexpr float kIdleScale = 0.1f;
+constexpr float kMoveEpsilon = 0.5f;
+// Newly visible players go out with the next snapshot
+constexpr float kEnterPriority = 1e6f;
+}  // namespace
+
+SnapshotScheduler::SnapshotScheduler(std::size_t serverBytesPerSecond)
+    : serverBytesPerSecond(serverBytesPerSecond) {}
+
+void SnapshotScheduler::AddClient(clientid_t client) {
+  AddClient(client, ClientBudget{});
+}
+
+void SnapshotScheduler::AddClient(clientid_t client, ClientBudget budget) {
+  ClientState& state = clients[client];
+  state.budget = budget;
+  state.sendTimer = 0.f;
+  state.entries.clear();
+}
+
+void SnapshotScheduler::RemoveClient(clientid_t client) {
+  clients.erase(client);
+  for (auto& [id, state] : clients) state.entries.erase(client);
+}
+
+void SnapshotScheduler::Accumulate(clientid_t client, Vec2f observerPos,
+                                   const std::vector<Subject>& visible,
+                                   float deltaTime) {
+  auto it = clients.find(client);
+  if (it == clients.end()) return;
+  auto& entries = it->second.entries;
+
+  for (auto& [id, entry] : entries) entry.bIsVisible = false;
+
+  for (const Subject& subject : visible) {
+    auto [entryIt, inserted] = entries.try_emplace(subject.id);
+    Entry& entry = entryIt->second;
+    entry.position = subject.position;
+    entry.bIsVisible = true;
+    if (!entry.bWasSent) {
+      entry.priority = kEnterPriority;
+      continue;
+    }
+
+    const float distance = std::hypot(subject.position.x - observerPos.x,
+                                      subject.position.y - observerPos.y);
+    float weight = 1.f / (1.f + distance / kDistanceFalloff);
+    const float moved = std::hypot(subject.position.x - entry.lastSent.x,
+                                   subject.position.y - entry.lastSent.y);
+    if (moved < kMoveEpsilon) weight *= kIdleScale;
+    entry.priority += weight * deltaTime;
+  }
+
+  std::erase_if(entries, [](const auto& kv) { return !kv.second.bIsVisible; });
+}
+
+bool SnapshotScheduler::IsSendDue(clientid_t client, float deltaTime) {
+  auto it = clients.find(client);
+  if (it == clients.end()) return false;
+  ClientState& state = it->second;
+
+  const float period = 1.f / state.budget.sendRate;
+  state.sendTimer += deltaTime;
+  if (state.sendTimer < period) return false;
+  // A stalled server sends once instead of a burst of catch-up snapshots
+  state.sendTimer = std::min(state.sendTimer - period, period);
+  return true;
+}
+
+void SnapshotScheduler::Select(clientid_t client, std::size_t headerBytes,
+                               std::size_t recordBytes,
+                               std::vector<Subject>& out) {
+  out.clear();
+  auto it = clients.find(client);
+  if (it == clients.end() || it->second.entries.empty()) return;
+  auto& entries = it->second.entries;
+
+  // Always carry one record so a starved budget still makes progress
+  const std::size_t budget = GetWindowBudget(client);
+  const std::size_t maxRecords =
+      budget > headerBytes + recordBytes ? (budget - headerBytes) / recordBytes
+                                         : 1;
+
+  scratch.clear();
+  for (const auto& [id, entry] : entries)
+    scratch.emplace_back(entry.priority, id);
+  const std::size_t count = std::min(maxRecords, scratch.size());
+  std::partial_sort(scratch.begin(), scratch.begin() + count, scratch.end(),
+                    [](const auto& a, const auto& b) {
+                      return a.first > b.first;
+                    });
+
+  for (std::size_t i = 0; i < count; ++i) {
+    Entry& entry = entries[scratch[i].second];
+    out.push_back(Subject{scratch[i].second, entry.position});
+    entry.lastSent = entry.position;
+    entry.priority = 0.f;
+    entry.bWasSent = true;
+  }
+}
+
+std::size_t SnapshotScheduler::GetWindowBudget(clientid_t client) const {
+  auto it = clients.find(client);
+  if (it == clients.end()) return 0;
+  const ClientBudget& budget = it->second.budget;
+
+  // Each client gets at most an equal share of the server's uplink
+  const std::size_t share = serverBytesPerSecond / clients.size();
+  const std::size_t perSecond = std::min(budget.bytesPerSecond, share);
+  return static_cast<std::size_t>(perSecond / budget.sendRate);
+}
@@ -31,8 +31,8 @@ Socket::~Socket() = default;
 Socket::Socket(Socket&&) noexcept = default;
 Socket& Socket::operator=(Socket&&) noexcept = default;
 
-bool Socket::Init() {
-  if (pimpl) return pimpl->Init();
+bool Socket::Init(const SocketOptions& options) {
+  if (pimpl) return pimpl->Init(options);
   return false;
 }
 
@@ -51,6 +51,21 @@ int Socket::Receive(uint8_t* buffer, std::size_t size) {
   return 0;
 }
 
+int Socket::SendDatagram(const uint8_t* buffer, std::size_t size) {
+  if (pimpl) return pimpl->SendDatagram(buffer, size);
+  return -1;
+}
+
+int Socket::ReceiveDatagram(uint8_t* buffer, std::size_t size) {
+  if (pimpl) return pimpl->ReceiveDatagram(buffer, size);
+  return -1;
+}
+
+std::size_t Socket::GetPendingSendBytes() {
+  if (pimpl) return pimpl->GetPendingSendBytes();
+  return 0;
+}
+
 void Socket::Close() {
   if (pimpl) pimpl->Close();
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "Core/SpatialIndex.h"
+
+#include <utility>
+
+SpatialIndex::SpatialIndex(float cellSize) : cellSize(cellSize) {}
+
+void SpatialIndex::Update(EntityID entity, Vec2f position) {
+  const ChunkCoord cell = CellOf(position);
+  const uint64_t key = PackChunkKey(cell.x, cell.y);
+
+  auto [it, bInserted] = locations.try_emplace(entity);
+  Location& location = it->second;
+  if (!bInserted) {
+    // Still in the same cell, only the stored position changes
+    if (location.cell == key) {
+      cells[key][location.slot].position = position;
+      return;
+    }
+    RemoveFromCell(location);
+  }
+
+  std::vector<Entry>& entries = cells[key];
+  location = Location{key, entries.size()};
+  entries.push_back(Entry{entity, position});
+}
+
+void SpatialIndex::Remove(EntityID entity) {
+  auto it = locations.find(entity);
+  if (it == locations.end()) return;
+  RemoveFromCell(it->second);
+  locations.erase(it);
+}
+
+void SpatialIndex::Clear() {
+  cells.clear();
+  locations.clear();
+}
+
+void SpatialIndex::RemoveFromCell(const Location& location) {
+  auto cellIt = cells.find(location.cell);
+  std::vector<Entry>& entries = cellIt->second;
+
+  // Swap-and-pop, the entry moved into the hole gets its new slot
+  if (location.slot != entries.size() - 1) {
+    entries[location.slot] = entries.back();
+    locations[entries[location.slot].entity].slot = location.slot;
+  }
+  entries.pop_back();
+  if (entries.empty()) cells.erase(cellIt);
+}
+
+template <typename Fn>
+void SpatialIndex::ForEachCell(Vec2f min, Vec2f max, Fn&& fn) const {
+  const ChunkCoord first = CellOf(min);
+  const ChunkCoord last = CellOf(max);
+  if (last.x < first.x || last.y < first.y) return;
+
+  // A rect spanning more cells than are filled walks the filled ones instead
+  const int64_t spanned = static_cast<int64_t>(last.x - first.x + 1) *
+                          static_cast<int64_t>(last.y - first.y + 1);
+  if (spanned > static_cast<int64_t>(cells.size())) {
+    for (const auto& [key, entries] : cells) {
+      const ChunkCoord cell = UnpackChunkKey(key);
+      if (cell.x >= first.x && cell.x <= last.x && cell.y >= first.y &&
+          cell.y <= last.y)
+        fn(entries);
+    }
+    return;
+  }
+
+  for (int y = first.y; y <= last.y; ++y) {
+    for (int x = first.x; x <= last.x; ++x) {
+      auto it = cells.find(PackChunkKey(x, y));
+      if (it != cells.end()) fn(it->second);
+    }
+  }
+}
+
+void SpatialIndex::QueryRect(Vec2f min, Vec2f max,
+                             std::vector<EntityID>& out) const {
+  ForEachCell(min, max, [&](const std::vector<Entry>& entries) {
+    for (const Entry& entry : entries) {
+      if (entry.position.x >= min.x && entry.position.x <= max.x &&
+          entry.position.y >= min.y && entry.position.y <= max.y)
+        out.push_back(entry.entity);
+    }
+  });
+}
+
+void SpatialIndex::QueryRadius(Vec2f center, float radius,
+                               std::vector<EntityID>& out) const {
+  const float radiusSq = radius * radius;
+  ForEachCell({center.x - radius, center.y - radius},
+              {center.x + radius, center.y + radius},
+              [&](const std::vector<Entry>& entries) {
+                for (const Entry& entry : entries) {
+                  const float dx = entry.position.x - center.x;
+                  const float dy = entry.position.y - center.y;
+                  if (dx * dx + dy * dy <= radiusSq)
+                    out.push_back(entry.entity);
+                }
+              });
+}
@@ -0,0 +1,96 @@
+#include "Core/TransformHistory.h"
+
+#include <algorithm>
+
+#include "Util/MathUtil.h"
+
+void TransformHistory::BeginSnapshot(uint32_t tick) {
+  newestIndex = (newestIndex + 1) % kCapacity;
+  ticks[newestIndex] = tick;
+  newestTick = tick;
+  if (snapshotCount < kCapacity) ++snapshotCount;
+}
+
+void TransformHistory::Store(EntityID entity, Vec2f position) {
+  if (snapshotCount == 0) return;
+
+  auto [it, inserted] = slots.try_emplace(entity, kUnset);
+  if (inserted) {
+    if (!freeSlots.empty()) {
+      it->second = freeSlots.back();
+      freeSlots.pop_back();
+    } else {
+      it->second = static_cast<uint32_t>(cellTick.size() / kCapacity);
+      posX.resize(posX.size() + kCapacity);
+      posY.resize(posY.size() + kCapacity);
+      cellTick.resize(cellTick.size() + kCapacity);
+    }
+    // A reused block may still hold ticks of its previous owner
+    const std::size_t base = it->second * kCapacity;
+    std::fill(cellTick.begin() + base, cellTick.begin() + base + kCapacity,
+              kUnset);
+  }
+
+  const std::size_t cell = it->second * kCapacity + newestIndex;
+  posX[cell] = position.x;
+  posY[cell] = position.y;
+  cellTick[cell] = newestTick;
+}
+
+void TransformHistory::Remove(EntityID entity) {
+  auto it = slots.find(entity);
+  if (it == slots.end()) return;
+  freeSlots.push_back(it->second);
+  slots.erase(it);
+}
+
+std::optional<Vec2f> TransformHistory::Sample(EntityID entity,
+                                              uint32_t tick) const {
+  auto it = slots.find(entity);
+  if (it == slots.end() || snapshotCount == 0) return std::nullopt;
+  const uint32_t slot = it->second;
+
+  // First stored snapshot at or after tick, ticks grow from oldest to newest
+  std::size_t low = 0;
+  std::size_t high = snapshotCount;
+  while (low < high) {
+    const std::size_t mid = (low + high) / 2;
+    if (ticks[RingIndex(mid)] < tick)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  if (low == snapshotCount) return ReadCell(slot, RingIndex(low - 1));
+  const std::size_t after = RingIndex(low);
+  if (low == 0 || ticks[after] == tick) return ReadCell(slot, after);
+
+  const std::size_t before = RingIndex(low - 1);
+  const std::optional<Vec2f> from = ReadCell(slot, before);
+  const std::optional<Vec2f> to = ReadCell(slot, after);
+  if (!from || !to) return from ? from : to;
+
+  const float t = static_cast<float>(tick - ticks[before]) /
+                  static_cast<float>(ticks[after] - ticks[before]);
+  return Vec2f(util::Lerp(from->x, to->x, t), util::Lerp(from->y, to->y, t));
+}
+
+bool TransformHistory::IsWithinReach(EntityID player, Vec2f playerPos,
+                                     EntityID target, Vec2f targetPos,
+                                     uint32_t viewTick,
+                                     float maxDistance) const {
+  const uint32_t oldest =
+      newestTick > kMaxRewindTicks ? newestTick - kMaxRewindTicks : 0;
+  const uint32_t tick = std::clamp(viewTick, oldest, newestTick);
+
+  const Vec2f from = Sample(player, tick).value_or(playerPos);
+  const Vec2f to = Sample(target, tick).value_or(targetPos);
+  return util::dist(from, to) <= maxDistance;
+}
+
+std::optional<Vec2f> TransformHistory::ReadCell(uint32_t slot,
+                                                std::size_t ringIndex) const {
+  const std::size_t cell = slot * kCapacity + ringIndex;
+  if (cellTick[cell] != ticks[ringIndex]) return std::nullopt;
+  return Vec2f(posX[cell], posY[cell]);
+}
@@ -1,82 +1,329 @@
 #include "Core/World.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include <map>
-#include <random>
+#include <utility>
+#include <vector>
 
 #include "Common.h"
+#include "Components/AssemblingMachineComponent.h"
 #include "Components/BuildingComponent.h"
 #include "Components/ChunkComponent.h"
 #include "Components/DebugRectComponent.h"
+#include "Components/FrozenComponent.h"
 #include "Components/InactiveComponent.h"
+#include "Components/MiningDrillComponent.h"
+#include "Components/NetIdentityComponent.h"
 #include "Components/ResourceNodeComponent.h"
 #include "Components/SpriteComponent.h"
 #include "Components/TextComponent.h"
 #include "Components/TransformComponent.h"
 #include "Core/Chunk.h"
+#include "Core/ComponentReplicator.h"
 #include "Core/EntityFactory.h"
 #include "Core/Event.h"
 #include "Core/EventDispatcher.h"
+#include "Core/PacketSchema.h"
+#include "Core/RegionFile.h"
 #include "Core/Registry.h"
 #include "Core/TileData.h"
+#include "Core/TimerManager.h"
 #include "Core/Type.h"
 #include "Core/World.h"
 #include "Core/WorldAssetManager.h"
-#include "FastNoiseLite.h"
 #include "SDL_ttf.h"
+#include "Util/TimerUtil.h"
+
+namespace {
+// Main thread time spent creating chunk entities and textures per frame, at
+// least one chunk is committed regardless
+constexpr std::chrono::microseconds kChunkCommitBudget{2000};
+constexpr int kChunkTileCount = CHUNK_WIDTH * CHUNK_HEIGHT;
+// Widest or tallest building in tiles, how far one can reach in from a
+// neighbouring chunk
+constexpr int kMaxBuildingSize = 2;
+
+// Rounds toward negative infinity, tile -1 belongs to chunk -1
+inline int FloorDiv(int value, int divisor) {
+  const int quotient = value / divisor;
+  return quotient * divisor > value ? quotient - 1 : quotient;
+}
+
+// What a cached chunk keeps alive, the texture dominates
+std::size_t GetCachedBytes(const Chunk &chunk) {
+  return kChunkTextureBytes + sizeof(Chunk) +
+         (1 + chunk.GetOres().Size() + chunk.GetOccupants().Size()) *
+             kCachedEntityBytes;
+}
+}  // namespace
 
 World::World(Registry *registry, WorldAssetManager *worldAssetManager,
              EntityFactory *factory, EventDispatcher *eventDispatcher,
-             TTF_Font *font, bool bIsServer)
-    : registry(registry),
-      factory(factory),
+             TimerManager *timerManager, TTF_Font *font, bool bIsServer,
+             uint64_t seed)
+    : font(font),
+      registry(registry),
       worldAssetManager(worldAssetManager),
       eventDispatcher(eventDispatcher),
-      font(font),
+      factory(factory),
+      timerManager(timerManager),
       localPlayer(INVALID_ENTITY),
-      bIsServer(bIsServer) {
-  std::random_device rd;
-  randomGenerator.seed(rd());
-  distribution = std::normal_distribution<float>(0.0, 1.0);
+      bIsServer(bIsServer),
+      seed(seed) {
+  minironOreAmount = static_cast<rsrc_amt_t>(
+      kOreThreshold * static_cast<float>(maxironOreAmount));
+  if (bIsServer) pipeline = std::make_unique<ChunkPipeline>(0, seed);
+  entityDestroyedHandle = eventDispatcher->Subscribe<EntityDestroyedEvent>(
+      [this](const EntityDestroyedEvent &event) {
+        entityIndex.Remove(event.entity);
+      });
+}
+
+void World::SyncEntityIndex() {
+  registry->forEach<TransformComponent>(
+      [this](EntityID entity, TransformComponent &transform) {
+        if (!transform.bIsDirty) return;
+        entityIndex.Update(entity, transform.position);
+        transform.bIsDirty = false;
+      });
 }
 
 void World::Update() {
-  if (!registry->HasComponent<TransformComponent>(localPlayer)) return;
-
-  const Vec2f playerPosition =
-      registry->GetComponent<TransformComponent>(localPlayer).position;
-
-  int playerChunkX =
-      std::floor(playerPosition.x / (CHUNK_WIDTH * TILE_PIXEL_SIZE));
-  int playerChunkY =
-      std::floor(playerPosition.y / (CHUNK_HEIGHT * TILE_PIXEL_SIZE));
-
-  auto it = activeChunks.begin();
-  while (it != activeChunks.end()) {
-    int dx = std::abs(it->first.x - playerChunkX);
-    int dy = std::abs(it->first.y - playerChunkY);
-
-    // Unload far chunk
-    if (dx > viewDistance || dy > viewDistance) {
-      UnloadChunk(it->second);
-      chunkCache.insert({it->first, it->second});
-      it = activeChunks.erase(it);
+  // Clients only hold what the server streams to them
+  if (!bIsServer) return;
+
+  // Remote players need their surroundings loaded to be validated and
+  // streamed, not only the host
+  playerChunks.clear();
+  for (auto& [clientID, player] : clientPlayerMap) {
+    if (!registry->HasComponent<TransformComponent>(player)) continue;
+    playerChunks.push_back(GetChunkCoordFromWorldPosition(
+        registry->GetComponent<TransformComponent>(player).position));
+  }
+  if (playerChunks.empty()) return;
+
+  auto isNearPlayer = [this](const ChunkCoord &chunk) {
+    for (const ChunkCoord &center : playerChunks) {
+      if (std::abs(chunk.x - center.x) <= viewDistance &&
+          std::abs(chunk.y - center.y) <= viewDistance)
+        return true;
+    }
+    return false;
+  };
+
+  // Unload far chunk
+  farChunks.clear();
+  activeChunks.ForEach([&](const Chunk &chunk) {
+    if (!isNearPlayer({chunk.chunkX, chunk.chunkY}))
+      farChunks.push_back({chunk.chunkX, chunk.chunkY});
+  });
+  for (const ChunkCoord &coord : farChunks) DropChunk(coord);
+
+  // Chunks that left the view before they were generated
+  for (auto pendingIt = pendingChunks.begin();
+       pendingIt != pendingChunks.end();) {
+    if (!isNearPlayer(*pendingIt)) {
+      pipeline->Cancel(*pendingIt);
+      pendingIt = pendingChunks.erase(pendingIt);
     } else {
-      ++it;
+      ++pendingIt;
     }
   }
 
-  // Load chunk in view dist
-  for (int y = playerChunkY - viewDistance; y <= playerChunkY + viewDistance;
-       ++y) {
-    for (int x = playerChunkX - viewDistance; x <= playerChunkX + viewDistance;
-         ++x) {
-      if (activeChunks.find({x, y}) == activeChunks.end()) {
-        LoadChunk(x, y);
+  // Load chunk in view dist, re-requesting pending ones keeps their priority
+  // up to date with the players
+  for (const ChunkCoord &center : playerChunks) {
+    for (int y = center.y - viewDistance; y <= center.y + viewDistance; ++y) {
+      for (int x = center.x - viewDistance; x <= center.x + viewDistance;
+           ++x) {
+        const ChunkCoord coord{x, y};
+        if (activeChunks.Contains(coord)) continue;
+        if (!pendingChunks.count(coord) && RestoreChunk(coord) != nullptr)
+          continue;
+        pipeline->Request(coord, GetPlayerDistanceSq(coord));
+        pendingChunks.insert(coord);
       }
     }
   }
+
+  CommitGeneratedChunks();
+}
+
+int World::GetPlayerDistanceSq(ChunkCoord coord) const {
+  int nearest = std::numeric_limits<int>::max();
+  for (const ChunkCoord &center : playerChunks) {
+    const int dx = coord.x - center.x;
+    const int dy = coord.y - center.y;
+    nearest = std::min(nearest, dx * dx + dy * dy);
+  }
+  return nearest;
+}
+
+void World::CommitGeneratedChunks() {
+  pipeline->TakeCompleted(generatedChunks);
+
+  // Canceled after the pipeline handed them over
+  generatedChunks.remove_if([this](const GeneratedChunk &generated) {
+    return pendingChunks.count({generated.chunk.chunkX,
+                                generated.chunk.chunkY}) == 0;
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  while (!generatedChunks.empty()) {
+    auto nearest = std::min_element(
+        generatedChunks.begin(), generatedChunks.end(),
+        [this](const GeneratedChunk &a, const GeneratedChunk &b) {
+          return GetPlayerDistanceSq({a.chunk.chunkX, a.chunk.chunkY}) <
+                 GetPlayerDistanceSq({b.chunk.chunkX, b.chunk.chunkY});
+        });
+    CommitChunk(*nearest);
+    generatedChunks.erase(nearest);
+
+    if (std::chrono::steady_clock::now() - start >= kChunkCommitBudget) break;
+  }
+}
+
+PacketPtr World::EncodeChunk(ChunkCoord coord) {
+  const Chunk *chunk = GetActiveChunk(coord.x, coord.y);
+  if (chunk == nullptr) return nullptr;
+
+  // Terrain is mostly large patches, run length encoding keeps a chunk
+  // to a few dozen bytes
+  std::vector<std::pair<uint16_t, uint8_t>> runs;
+  for (const uint8_t type : chunk->GetTypes()) {
+    if (!runs.empty() && runs.back().second == type)
+      ++runs.back().first;
+    else
+      runs.emplace_back(uint16_t{1}, type);
+  }
+  std::vector<std::pair<uint16_t, EntityID>> ores;
+  chunk->GetOres().ForEach([&](uint16_t index, EntityID ore) {
+    if (registry->HasComponent<ResourceNodeComponent>(ore))
+      ores.emplace_back(index, ore);
+  });
+
+  using Schema = PacketSchema<CHUNK_DATA>;
+  PacketWriter writer(CHUNK_DATA,
+                      PayloadSize<CHUNK_DATA>(runs.size()) +
+                          Schema::OreHeader::kMinSize +
+                          ores.size() * Schema::OreRecord::kMinSize);
+  writer.WriteHeader<CHUNK_DATA>(coord.x, coord.y,
+                                 static_cast<uint16_t>(runs.size()));
+  for (const auto& [length, type] : runs)
+    writer.WriteRecord<CHUNK_DATA>(length, type);
+
+  writer.Write<Schema::OreHeader>(static_cast<uint16_t>(ores.size()));
+  for (const auto& [index, ore] : ores) {
+    const auto &node = registry->GetComponent<ResourceNodeComponent>(ore);
+    writer.Write<Schema::OreRecord>(index, static_cast<uint8_t>(node.Ore),
+                                    node.LeftResource);
+  }
+  return writer.Finish();
+}
+
+bool World::ApplyChunkData(PacketReader &reader) {
+  using Schema = PacketSchema<CHUNK_DATA>;
+  auto header = reader.ReadHeader<CHUNK_DATA>();
+  if (!header) return false;
+  const auto [chunkX, chunkY, runCount] = *header;
+
+  std::array<TileType, kChunkTileCount> types;
+  int filled = 0;
+  for (uint16_t i = 0; i < runCount; ++i) {
+    auto run = reader.ReadRecord<CHUNK_DATA>();
+    if (!run) return false;
+    const auto [length, type] = *run;
+    if (filled + length > kChunkTileCount ||
+        type > static_cast<uint8_t>(TileType::Stone))
+      return false;
+    std::fill_n(types.begin() + filled, length, static_cast<TileType>(type));
+    filled += length;
+  }
+  if (filled != kChunkTileCount) return false;
+
+  auto oreHeader = reader.Read<Schema::OreHeader>();
+  if (!oreHeader) return false;
+  std::vector<Schema::OreRecord::Values> ores;
+  for (uint16_t i = 0; i < std::get<0>(*oreHeader); ++i) {
+    auto ore = reader.Read<Schema::OreRecord>();
+    if (!ore || std::get<0>(*ore) >= kChunkTileCount ||
+        std::get<1>(*ore) >= static_cast<uint8_t>(OreType::MaxOreType))
+      return false;
+    ores.push_back(*ore);
+  }
+
+  // Resent after leaving and re-entering the view, or after a reconnect
+  Chunk *chunk = GetActiveChunk(chunkX, chunkY);
+  if (chunk == nullptr) chunk = RestoreChunk({chunkX, chunkY});
+  const bool bIsNew = chunk == nullptr;
+  if (bIsNew) {
+    chunk = &activeChunks.Emplace(chunkX, chunkY);
+  }
+
+  for (int i = 0; i < kChunkTileCount; ++i) chunk->SetType(i, types[i]);
+
+  for (const auto& [index, ore, amount] : ores) {
+    const EntityID oreEntity = chunk->GetOreEntity(index);
+    if (oreEntity != INVALID_ENTITY &&
+        registry->HasComponent<ResourceNodeComponent>(oreEntity)) {
+      registry->GetComponent<ResourceNodeComponent>(oreEntity).LeftResource =
+          amount;
+    } else {
+      CreateOreNode(*chunk, index % CHUNK_WIDTH, index / CHUNK_WIDTH,
+                    static_cast<OreType>(ore), amount);
+    }
+  }
+
+  if (bIsNew) {
+    CreateChunkEntity(*chunk);
+  } else if (chunk->HasDirtyTiles() &&
+             registry->HasComponent<ChunkComponent>(chunk->chunkEntity)) {
+    // Only the tiles that changed, and new ore, are redrawn
+    registry->GetComponent<ChunkComponent>(chunk->chunkEntity).bNeedsRedraw =
+        true;
+  }
+  return true;
+}
+
+bool World::OpenSave(const std::string &directory) {
+  if (!bIsServer) return false;
+  auto store = std::make_unique<RegionStore>();
+  if (!store->Open(directory, seed)) return false;
+  // Saved buildings were settled against the clock of the save
+  timerManager->SetTime(store->GetGameTime());
+  regionStore = std::move(store);
+  return true;
+}
+
+void World::SaveAll() {
+  if (regionStore == nullptr) return;
+  // Cached chunks were not written out yet either
+  auto save = [this](const Chunk &chunk) {
+    ChunkRecord record;
+    std::vector<EntityID> buildings;
+    RecordChunk(chunk, record, buildings);
+    std::vector<uint8_t> payload;
+    record.Encode(payload);
+    regionStore->Save({chunk.chunkX, chunk.chunkY}, payload);
+  };
+  activeChunks.ForEach(save);
+  chunkCache.ForEachLive(save);
+  regionStore->SaveGameTime(timerManager->GetTime());
+}
+
+void World::DropChunk(ChunkCoord coord) {
+  std::unique_ptr<Chunk> chunk = activeChunks.Extract(coord);
+  if (chunk == nullptr) return;
+  UnloadChunk(*chunk);
+  const std::size_t bytes = GetCachedBytes(*chunk);
+  chunkCache.Insert(std::move(chunk), bytes);
+  while (std::unique_ptr<Chunk> cold = chunkCache.PopOverBudget())
+    EvictChunk(*cold);
 }
 
 void World::GeneratePlayer(clientid_t clientID, Vec2f pos, bool bIsLocal) {
@@ -86,11 +333,11 @@ void World::GeneratePlayer(clientid_t clientID, Vec2f pos, bool bIsLocal) {
   clientPlayerMap[clientID] = player;
 }
 
-TileData *World::GetTileAtWorldPosition(Vec2f position) {
+TileRef World::GetTileAtWorldPosition(Vec2f position) {
   return GetTileAtWorldPosition(position.x, position.y);
 }
 
-TileData *World::GetTileAtWorldPosition(float worldX, float worldY) {
+TileRef World::GetTileAtWorldPosition(float worldX, float worldY) {
   return GetTileAtTileIndex(GetTileIndexFromWorldPosition(worldX, worldY));
 }
 
@@ -105,66 +352,88 @@ Vec2 World::GetTileIndexFromWorldPosition(float worldX, float worldY) const {
   return Vec2(tileX, tileY);
 }
 
-TileData *World::GetTileAtTileIndex(Vec2 tileIndex) {
+ChunkCoord World::GetChunkCoordFromWorldPosition(Vec2f position) {
+  return {static_cast<int>(
+              std::floor(position.x / (CHUNK_WIDTH * TILE_PIXEL_SIZE))),
+          static_cast<int>(
+              std::floor(position.y / (CHUNK_HEIGHT * TILE_PIXEL_SIZE)))};
+}
+
+TileRef World::GetTileAtTileIndex(Vec2 tileIndex) {
   return GetTileAtTileIndex(tileIndex.x, tileIndex.y);
 }
 
-TileData *World::GetTileAtTileIndex(int tileX, int tileY) {
-  int chunkX = std::floor(static_cast<float>(tileX) / CHUNK_WIDTH);
-  int chunkY = std::floor(static_cast<float>(tileY) / CHUNK_HEIGHT);
+TileRef World::GetTileAtTileIndex(int tileX, int tileY) {
+  const int chunkX = FloorDiv(tileX, CHUNK_WIDTH);
+  const int chunkY = FloorDiv(tileY, CHUNK_HEIGHT);
 
-  auto it = activeChunks.find({chunkX, chunkY});
-  if (it != activeChunks.end()) {
-    Vec2 localCoords = it->second.GetLocalTileIndex(tileX, tileY);
-    return it->second.GetTile(localCoords.x, localCoords.y);
+  Chunk *chunk = activeChunks.Find(chunkX, chunkY);
+  if (chunk != nullptr) {
+    return TileRef(chunk,
+                   Chunk::GetLocalIndex(tileX - chunkX * CHUNK_WIDTH,
+                                        tileY - chunkY * CHUNK_HEIGHT));
   }
 
-  return nullptr;
+  return TileRef();
+}
+
+Chunk *World::GetActiveChunk(int chunkX, int chunkY) {
+  return activeChunks.Find(chunkX, chunkY);
 }
 
 bool World::IsTilePassable(Vec2f worldPos) {
   return IsTilePassable(GetTileIndexFromWorldPosition(worldPos));
 }
 bool World::IsTilePassable(Vec2 tileIdx) {
-  TileData *tile = GetTileAtTileIndex(tileIdx);
-  if (tile->type == TileType::Water || tile->type == TileType::Invalid)
-    return false;
-  if (tile->occupyingEntity != INVALID_ENTITY &&
-      registry->HasComponent<BuildingComponent>(tile->occupyingEntity))
+  TileRef tile = GetTileAtTileIndex(tileIdx);
+  // Unloaded chunks block like InputPrediction does
+  if (!tile) return false;
+  const TileType type = tile.GetType();
+  if (type == TileType::Water || type == TileType::Invalid) return false;
+  const EntityID occupant = tile.GetOccupyingEntity();
+  if (occupant != INVALID_ENTITY &&
+      registry->HasComponent<BuildingComponent>(occupant))
     return false;
 
   return true;
 }
 
-bool World::HasNoOcuupyingEntity(Vec2 tileIndex, int width, int height) {
-  return HasNoOcuupyingEntity(tileIndex.x, tileIndex.y, width, height);
+bool World::HasNoOcuupyingEntity(Vec2 tileIndex, int width, int height,
+                                 EntityID builder) {
+  return HasNoOcuupyingEntity(tileIndex.x, tileIndex.y, width, height,
+                              builder);
 }
 
-bool World::HasNoOcuupyingEntity(int tileX, int tileY, int width, int height) {
+bool World::HasNoOcuupyingEntity(int tileX, int tileY, int width, int height,
+                                 EntityID builder) {
+  // The player placing the building would be stuck inside it
+  TileRef builderTile;
+  if (builder != INVALID_ENTITY &&
+      registry->HasComponent<TransformComponent>(builder))
+    builderTile = GetTileAtWorldPosition(
+        registry->GetComponent<TransformComponent>(builder).position);
+
   // Check if all tiles for this building are available
   for (int dy = 0; dy < height; ++dy) {
     for (int dx = 0; dx < width; ++dx) {
       int checkX = tileX + dx;
       int checkY = tileY + dy;
 
-      // Get tile data (const cast is safe here since we're only checking)
-      TileData *tile =
-          const_cast<World *>(this)->GetTileAtTileIndex(checkX, checkY);
+      TileRef tile = GetTileAtTileIndex(checkX, checkY);
       if (!tile) {
         return false;  // Tile doesn't exist (chunk not loaded)
       }
 
-      if (tile->occupyingEntity != INVALID_ENTITY) {
+      if (tile.GetOccupyingEntity() != INVALID_ENTITY) {
         return false;  // Tile is already occupied
       }
 
-      if (tile->type == TileType::Water || tile->type == TileType::Invalid) {
+      if (tile.GetType() == TileType::Water ||
+          tile.GetType() == TileType::Invalid) {
         return false;  // Cannot build on water or invalid tiles
       }
 
-      auto &playertrans =
-          registry->GetComponent<TransformComponent>(localPlayer);
-      if (tile == GetTileAtWorldPosition(playertrans.position)) return false;
+      if (builderTile && tile == builderTile) return false;
     }
   }
   return true;
@@ -184,9 +453,9 @@ void World::OccupyTile(EntityID entity, int tileX, int tileY, int width,
       int checkX = tileX + dx;
       int checkY = tileY + dy;
 
-      TileData *tile = GetTileAtTileIndex(checkX, checkY);
+      TileRef tile = GetTileAtTileIndex(checkX, checkY);
       if (tile) {
-        tile->occupyingEntity = entity;
+        tile.SetOccupyingEntity(entity);
         occupiedTiles.push_back({checkX, checkY});
       }
     }
@@ -197,73 +466,273 @@ void World::OccupyTile(EntityID entity, int tileX, int tileY, int width,
     auto &building = registry->GetComponent<BuildingComponent>(entity);
     building.occupiedTiles = occupiedTiles;
   }
+
+  // Filed right away, a chunk restored before the next SyncEntityIndex looks
+  // its overlapping buildings up there
+  if (registry->HasComponent<TransformComponent>(entity))
+    entityIndex.Update(
+        entity, registry->GetComponent<TransformComponent>(entity).position);
 }
 
 void World::RemoveBuilding(EntityID entity,
                            const std::vector<Vec2> &occupiedTiles) {
   // Clear all tiles that this building occupied
   for (const Vec2 &tileIndex : occupiedTiles) {
-    TileData *tile = GetTileAtTileIndex(tileIndex);
-    if (tile && tile->occupyingEntity == entity) {
-      tile->occupyingEntity = INVALID_ENTITY;
+    TileRef tile = GetTileAtTileIndex(tileIndex);
+    if (tile && tile.GetOccupyingEntity() == entity) {
+      tile.SetOccupyingEntity(INVALID_ENTITY);
     }
   }
 }
 
-void World::LoadChunk(int chunkX, int chunkY) {
-  auto it = chunkCache.find({chunkX, chunkY});
-  if (it != chunkCache.end()) {
-    Chunk &chunk = it->second;
-    // Reactivate entities
-    registry->RemoveComponent<InactiveComponent>(chunk.chunkEntity);
-    for (int y = 0; y < CHUNK_HEIGHT; ++y) {
-      for (int x = 0; x < CHUNK_WIDTH; ++x) {
-        TileData *tile = chunk.GetTile(x, y);
-        if (tile) {
-          if (tile->occupyingEntity != INVALID_ENTITY)
-            registry->RemoveComponent<InactiveComponent>(tile->occupyingEntity);
-          if (tile->oreEntity != INVALID_ENTITY)
-            registry->RemoveComponent<InactiveComponent>(tile->oreEntity);
-        }
-      }
-    }
-    activeChunks.insert({it->first, chunk});
-    chunkCache.erase(it);
-    // std::cout << "Reloaded Chunk at (" << chunk.chunkX << ", " <<
-    // chunk.chunkY << ")\n";
+Chunk *World::RestoreChunk(ChunkCoord coord) {
+  std::vector<uint8_t> blob;
+  std::unique_ptr<Chunk> cached = chunkCache.Extract(coord, blob);
+  Chunk *chunk = nullptr;
+  if (cached != nullptr) {
+    chunk = &activeChunks.Insert(std::move(cached));
+  } else if (!blob.empty()) {
+    chunk = LoadChunkRecord(coord, blob.data(), blob.size());
   } else {
-    Chunk chunk(chunkX, chunkY);
-    GenerateChunk(chunk);
-    activeChunks.insert({{chunkX, chunkY}, chunk});
+    chunk = LoadSavedChunk(coord);
   }
+  if (chunk == nullptr) return nullptr;
+
+  // Neighbouring buildings may have been evicted and restored meanwhile
+  OccupyOverlappingBuildings(*chunk);
+
+  // Reactivate entities, a building is listed once per tile it covers
+  auto activate = [this](uint16_t, EntityID entity) {
+    if (registry->HasComponent<InactiveComponent>(entity))
+      registry->RemoveComponent<InactiveComponent>(entity);
+  };
+  activate(0, chunk->chunkEntity);
+  chunk->GetOccupants().ForEach(activate);
+  chunk->GetOres().ForEach(activate);
+  // std::cout << "Reloaded Chunk at (" << chunk->chunkX << ", " <<
+  // chunk->chunkY << ")\n";
+  return chunk;
 }
 
 void World::UnloadChunk(Chunk &chunk) {
   // Deactivate entities
-  registry->EmplaceComponent<InactiveComponent>(chunk.chunkEntity);
-  for (int y = 0; y < CHUNK_HEIGHT; ++y) {
-    for (int x = 0; x < CHUNK_WIDTH; ++x) {
-      TileData *tile = chunk.GetTile(x, y);
-      if (tile) {
-        if (tile->occupyingEntity != INVALID_ENTITY)
-          registry->EmplaceComponent<InactiveComponent>(tile->occupyingEntity);
-        if (tile->oreEntity != INVALID_ENTITY)
-          registry->EmplaceComponent<InactiveComponent>(tile->oreEntity);
-      }
-    }
-  }
+  auto deactivate = [this](uint16_t, EntityID entity) {
+    if (!registry->HasComponent<InactiveComponent>(entity))
+      registry->EmplaceComponent<InactiveComponent>(entity);
+  };
+  deactivate(0, chunk.chunkEntity);
+  chunk.GetOccupants().ForEach(deactivate);
+  chunk.GetOres().ForEach(deactivate);
   // std::cout << "Unloaded Chunk at (" << chunk.chunkX << ", " << chunk.chunkY
   // << ")\n";
 }
 
-void World::GenerateChunk(Chunk &chunk) {
-  FastNoiseLite noise;
-  noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-  noise.SetFrequency(0.05f);
-  int cx = chunk.chunkX;
-  int cy = chunk.chunkY;
-  EntityID chunkDebugRect = registry->CreateEntity();
+void World::EvictChunk(Chunk &chunk) {
+  const ChunkCoord coord{chunk.chunkX, chunk.chunkY};
+  ChunkRecord record;
+  std::vector<EntityID> buildings;
+  RecordChunk(chunk, record, buildings);
+  std::vector<uint8_t> payload;
+  record.Encode(payload);
+  // Kept in memory without a save, or when writing it failed
+  if (regionStore == nullptr || !regionStore->Save(coord, payload))
+    chunkCache.StoreBlob(coord, std::move(payload));
+  ChunkCoord coldCoord;
+  std::vector<uint8_t> coldBlob;
+  while (chunkCache.PopBlobOverBudget(coldCoord, coldBlob)) {
+    // Clients are streamed the chunk again, the server owns it
+    if (!bIsServer) continue;
+    if (regionStore == nullptr || !regionStore->Save(coldCoord, coldBlob))
+      std::cerr << "Dropped chunk " << coldCoord.x << ":" << coldCoord.y
+                << " that could not be saved\n";
+  }
+
+  for (EntityID building : buildings) {
+    // Tiles it covers in neighbouring chunks, loaded or cached
+    for (const Vec2 &tile :
+         registry->GetComponent<BuildingComponent>(building).occupiedTiles) {
+      const ChunkCoord owner{FloorDiv(tile.x, CHUNK_WIDTH),
+                             FloorDiv(tile.y, CHUNK_HEIGHT)};
+      Chunk *neighbour = activeChunks.Find(owner);
+      if (neighbour == nullptr) neighbour = chunkCache.Find(owner);
+      if (neighbour == nullptr || neighbour == &chunk) continue;
+      const int index = Chunk::GetLocalIndex(tile.x - owner.x * CHUNK_WIDTH,
+                                             tile.y - owner.y * CHUNK_HEIGHT);
+      if (neighbour->GetOccupyingEntity(index) == building)
+        neighbour->SetOccupyingEntity(index, INVALID_ENTITY);
+    }
+    registry->DestroyEntity(building);
+  }
+  chunk.GetOres().ForEach(
+      [this](uint16_t, EntityID ore) { registry->DestroyEntity(ore); });
+  if (registry->HasComponent<ChunkComponent>(chunk.chunkEntity)) {
+    worldAssetManager->ReleaseChunkTexture(
+        registry->GetComponent<ChunkComponent>(chunk.chunkEntity)
+            .chunkTexture);
+  }
+  registry->DestroyEntity(chunk.chunkEntity);
+}
+
+void World::RecordChunk(const Chunk &chunk, ChunkRecord &record,
+                        std::vector<EntityID> &outBuildings) {
+  record.types = chunk.GetTypes();
+  record.ores.clear();
+  chunk.GetOres().ForEach([&](uint16_t index, EntityID ore) {
+    if (!registry->HasComponent<ResourceNodeComponent>(ore)) return;
+    const auto &node = registry->GetComponent<ResourceNodeComponent>(ore);
+    record.ores.push_back({index, node.Ore, node.LeftResource});
+  });
+
+  // Clients only hold replicas of the server's buildings
+  record.buildings.clear();
+  outBuildings.clear();
+  if (!bIsServer) return;
+  const ComponentReplicator &replicator = ComponentReplicator::instance();
+  chunk.GetOccupants().ForEach([&](uint16_t, EntityID entity) {
+    if (std::find(outBuildings.begin(), outBuildings.end(), entity) !=
+            outBuildings.end() ||
+        !registry->HasComponent<TransformComponent>(entity))
+      return;
+
+    ENetArchetype archetype = ENetArchetype::None;
+    if (registry->HasComponent<AssemblingMachineComponent>(entity))
+      archetype = ENetArchetype::AssemblingMachine;
+    else if (registry->HasComponent<MiningDrillComponent>(entity))
+      archetype = ENetArchetype::MiningDrill;
+    if (archetype == ENetArchetype::None) return;
+
+    // Saved with the chunk of its top-left tile, a building reaching into
+    // neighbours is only saved once
+    const Vec2 tileIndex = GetTileIndexFromWorldPosition(
+        registry->GetComponent<TransformComponent>(entity).position);
+    if (FloorDiv(tileIndex.x, CHUNK_WIDTH) != chunk.chunkX ||
+        FloorDiv(tileIndex.y, CHUNK_HEIGHT) != chunk.chunkY)
+      return;
+
+    outBuildings.push_back(entity);
+    ChunkRecord::Building &saved = record.buildings.emplace_back();
+    saved.archetype = archetype;
+    saved.tileIndex = tileIndex;
+    // Frozen machines are settled up to their last settlement, running ones
+    // up to now
+    const FrozenComponent *frozen =
+        registry->HasComponent<FrozenComponent>(entity)
+            ? &registry->GetComponent<FrozenComponent>(entity)
+            : nullptr;
+    saved.settledAt = frozen ? frozen->settledAt : timerManager->GetTime();
+    // A building restored but not settled since has no timer yet
+    saved.progress = frozen ? frozen->progress : 0.f;
+    for (TimerId id : {TimerId::AssemblingMachineCraft, TimerId::Mine}) {
+      if (TimerInstance *timer =
+              util::GetTimer(registry, timerManager, entity, id))
+        saved.progress = timer->elapsed;
+    }
+    const uint8_t mask = replicator.GetMask(registry, entity);
+    saved.state.resize(replicator.GetSize(registry, entity, mask));
+    uint8_t *wp = saved.state.data();
+    replicator.Write(registry, entity, mask, wp);
+  });
+}
+
+Chunk *World::LoadSavedChunk(ChunkCoord coord) {
+  if (regionStore == nullptr) return nullptr;
+  const uint8_t *data = nullptr;
+  std::size_t size = 0;
+  if (!regionStore->Load(coord, data, size)) return nullptr;
+  return LoadChunkRecord(coord, data, size);
+}
+
+Chunk *World::LoadChunkRecord(ChunkCoord coord, const uint8_t *data,
+                              std::size_t size) {
+  ChunkRecord record;
+  if (!record.Decode(data, size)) {
+    std::cerr << "Stored chunk " << coord.x << ":" << coord.y
+              << " is corrupt, it is loaded again from scratch" << std::endl;
+    return nullptr;
+  }
+
+  Chunk &chunk = activeChunks.Emplace(coord.x, coord.y);
+  for (int i = 0; i < kChunkTileCount; ++i)
+    chunk.SetType(i, static_cast<TileType>(record.types[i]));
+  // Ore first, drills pick up the ore under them when created
+  for (const ChunkRecord::Ore &ore : record.ores) {
+    CreateOreNode(chunk, ore.index % CHUNK_WIDTH, ore.index / CHUNK_WIDTH,
+                  ore.type, ore.amount);
+  }
+  CreateChunkEntity(chunk);
+
+  for (std::size_t i = 0; i < record.buildings.size(); ++i)
+    RestoreBuilding(record, i);
+  return &chunk;
+}
+
+void World::RestoreBuilding(const ChunkRecord &record, std::size_t index) {
+  const ChunkRecord::Building &saved = record.buildings[index];
+
+  // Placement was validated when the building was first built
+  EntityID building = INVALID_ENTITY;
+  ItemID item = ItemID::None;
+  if (saved.archetype == ENetArchetype::AssemblingMachine) {
+    building = factory->CreateAssemblingMachine(this, saved.tileIndex, true);
+    item = ItemID::AssemblingMachine;
+  } else if (saved.archetype == ENetArchetype::MiningDrill) {
+    building = factory->CreateMiningDrill(this, saved.tileIndex, true);
+    item = ItemID::MiningDrill;
+  }
+  if (building == INVALID_ENTITY) return;
+
+  const uint8_t *rp = saved.state.data();
+  if (!ComponentReplicator::instance().Read(registry, building, rp,
+                                            rp + saved.state.size())) {
+    std::cerr << "Saved building at " << saved.tileIndex.x << ":"
+              << saved.tileIndex.y << " has corrupt state" << std::endl;
+  }
+  // Its system settles the time it spent serialized on its first update. A
+  // save written by a server that crashed may be ahead of the saved clock.
+  registry->EmplaceComponent<FrozenComponent>(
+      building,
+      FrozenComponent{std::min(saved.settledAt, timerManager->GetTime()),
+                      saved.progress});
+  // Replicates it to clients like a freshly placed one
+  eventDispatcher->Publish(BuildingPlacedEvent{building, item, saved.tileIndex});
+}
+
+void World::OccupyOverlappingBuildings(const Chunk &chunk) {
+  const int minX = chunk.chunkX * CHUNK_WIDTH;
+  const int minY = chunk.chunkY * CHUNK_HEIGHT;
+  // Buildings are filed at their top left tile, so only those up to
+  // kMaxBuildingSize - 1 tiles left of or above the chunk can reach into it
+  std::vector<EntityID> nearby;
+  entityIndex.QueryRect(
+      {static_cast<float>((minX - kMaxBuildingSize + 1) * TILE_PIXEL_SIZE),
+       static_cast<float>((minY - kMaxBuildingSize + 1) * TILE_PIXEL_SIZE)},
+      {static_cast<float>((minX + CHUNK_WIDTH) * TILE_PIXEL_SIZE),
+       static_cast<float>((minY + CHUNK_HEIGHT) * TILE_PIXEL_SIZE)},
+      nearby);
+
+  for (EntityID entity : nearby) {
+    if (!registry->HasComponent<BuildingComponent>(entity) ||
+        !registry->HasComponent<TransformComponent>(entity))
+      continue;
+    const auto &building = registry->GetComponent<BuildingComponent>(entity);
+    const Vec2 tileIndex = GetTileIndexFromWorldPosition(
+        registry->GetComponent<TransformComponent>(entity).position);
+    if (tileIndex.x + building.width <= minX ||
+        tileIndex.x >= minX + CHUNK_WIDTH ||
+        tileIndex.y + building.height <= minY ||
+        tileIndex.y >= minY + CHUNK_HEIGHT)
+      continue;
+    OccupyTile(entity, tileIndex, building.width, building.height);
+  }
+}
+
+void World::CommitChunk(GeneratedChunk &generated) {
+  const ChunkCoord coord{generated.chunk.chunkX, generated.chunk.chunkY};
+  pendingChunks.erase(coord);
+  Chunk &chunk = activeChunks.Insert(
+      std::make_unique<Chunk>(std::move(generated.chunk)));
 #ifdef DRAW_DEBUG_RECTS
+  EntityID chunkDebugRect = registry->CreateEntity();
   registry->EmplaceComponent<DebugRectComponent>(
       chunkDebugRect,
       DebugRectComponent{0, 0, TILE_PIXEL_SIZE * CHUNK_WIDTH,
@@ -279,13 +748,11 @@ void World::GenerateChunk(Chunk &chunk) {
            chunk.chunkY);
   textComp.color = SDL_Color{255, 255, 255, 255};
   registry->EmplaceComponent<TextComponent>(chunkDebugRect, textComp);
-#endif
-  // terrain generation
+
   for (int y = 0; y < CHUNK_HEIGHT; ++y) {
     for (int x = 0; x < CHUNK_WIDTH; ++x) {
       int worldTileX = chunk.chunkX * CHUNK_WIDTH + x;
       int worldTileY = chunk.chunkY * CHUNK_HEIGHT + y;
-#ifdef DRAW_DEBUG_RECTS
       EntityID tileDebugRect = registry->CreateEntity();
       registry->EmplaceComponent<DebugRectComponent>(
           tileDebugRect, DebugRectComponent{0, 0, TILE_PIXEL_SIZE,
@@ -295,86 +762,70 @@ void World::GenerateChunk(Chunk &chunk) {
           TransformComponent{{(float)(worldTileX * TILE_PIXEL_SIZE),
                               (float)(worldTileY * TILE_PIXEL_SIZE)}});
 
-      TextComponent textComp;
-      snprintf(textComp.text, sizeof(textComp.text), "tile %d:%d", worldTileX,
+      TextComponent tileText;
+      snprintf(tileText.text, sizeof(tileText.text), "tile %d:%d", worldTileX,
                worldTileY);
-      textComp.color = SDL_Color{255, 255, 255, 255};
-      registry->EmplaceComponent<TextComponent>(tileDebugRect, textComp);
-#endif
-      float terrainValue = noise.GetNoise((float)worldTileX, (float)worldTileY);
-      TileData *tile = chunk.GetTile(x, y);
-
-      if (terrainValue < -0.2f) {
-        tile->type = TileType::Water;
-      } else if (terrainValue < 0.3f) {
-        tile->type = TileType::Dirt;
-      } else {
-        tile->type = TileType::Grass;
-      }
+      tileText.color = SDL_Color{255, 255, 255, 255};
+      registry->EmplaceComponent<TextComponent>(tileDebugRect, tileText);
     }
   }
+#endif
+  for (const auto &[index, amount] : generated.ores) {
+    CreateOreNode(chunk, index % CHUNK_WIDTH, index / CHUNK_WIDTH,
+                  OreType::Iron, amount);
+  }
 
-  // ore group generation
-  FastNoiseLite oreNoise;
-  oreNoise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-  oreNoise.SetFrequency(0.02f);
-  float oreThreshold = 0.5f;
-  minironOreAmount = oreThreshold * static_cast<float>(maxironOreAmount);
-  for (int y = 0; y < CHUNK_HEIGHT; ++y) {
-    for (int x = 0; x < CHUNK_WIDTH; ++x) {
-      int worldTileX = chunk.chunkX * CHUNK_WIDTH + x;
-      int worldTileY = chunk.chunkY * CHUNK_HEIGHT + y;
+  CreateChunkEntity(chunk);
 
-      float oreValue = oreNoise.GetNoise((float)worldTileX, (float)worldTileY);
-
-      if (oreValue > oreThreshold &&
-          chunk.GetTile(x, y)->type != TileType::Water) {
-        TileData *tile = chunk.GetTile(x, y);
-
-        if (tile->occupyingEntity == INVALID_ENTITY) {
-          EntityID oreNode = registry->CreateEntity();
-
-          rsrc_amt_t oreAmount = static_cast<rsrc_amt_t>(
-              static_cast<float>(maxironOreAmount) * oreValue);
-
-          registry->EmplaceComponent<TransformComponent>(
-              oreNode, TransformComponent{
-                           {static_cast<float>(worldTileX * TILE_PIXEL_SIZE),
-                            static_cast<float>(worldTileY * TILE_PIXEL_SIZE)}});
-
-          registry->EmplaceComponent<ResourceNodeComponent>(
-              oreNode, ResourceNodeComponent{oreAmount, OreType::Iron});
-
-          TextComponent textComp;
-          snprintf(textComp.text, sizeof(textComp.text), "%d %d", worldTileX,
-                   worldTileY);
-          textComp.color = SDL_Color{255, 255, 255, 255};
-          registry->EmplaceComponent<TextComponent>(oreNode, textComp);
-
-          SDL_Texture *spritesheet =
-              worldAssetManager->getTexture("assets/img/entity/iron-ore.png");
-          SpriteComponent spriteComp;
-          spriteComp.texture = spritesheet;
-          // tile->debugValue = oreAmount;
-
-          int richnessIndex =
-              (IRON_SPRITESHEET_HEIGHT - 1) -
-              std::min(
-                  7.0f,
-                  std::floor(
-                      static_cast<float>(oreAmount - minironOreAmount) /
-                      static_cast<float>(maxironOreAmount - minironOreAmount) *
-                      8.f));
-          spriteComp.srcRect = {0, richnessIndex * 128, 128, 128};
-          spriteComp.renderRect = {0, 0, TILE_PIXEL_SIZE, TILE_PIXEL_SIZE};
-          registry->EmplaceComponent<SpriteComponent>(oreNode, spriteComp);
-          tile->oreEntity = oreNode;
-          tile->type = TileType::Stone;
-        }
-      }
-    }
+  // std::cout << "Generated Chunk at (" << chunk.chunkX << ", " << chunk.chunkY
+  // << " id=" << chunk.chunkEntity << ")\n";
+}
+
+EntityID World::CreateOreNode(Chunk &chunk, int localX, int localY,
+                              OreType ore, rsrc_amt_t amount) {
+  const int worldTileX = chunk.chunkX * CHUNK_WIDTH + localX;
+  const int worldTileY = chunk.chunkY * CHUNK_HEIGHT + localY;
+  const int index = Chunk::GetLocalIndex(localX, localY);
+
+  EntityID oreNode = registry->CreateEntity();
+
+  registry->EmplaceComponent<TransformComponent>(
+      oreNode, TransformComponent{
+                   {static_cast<float>(worldTileX * TILE_PIXEL_SIZE),
+                    static_cast<float>(worldTileY * TILE_PIXEL_SIZE)}});
+
+  registry->EmplaceComponent<ResourceNodeComponent>(
+      oreNode, ResourceNodeComponent{amount, ore});
+
+  TextComponent textComp;
+  snprintf(textComp.text, sizeof(textComp.text), "%d %d", worldTileX,
+           worldTileY);
+  textComp.color = SDL_Color{255, 255, 255, 255};
+  registry->EmplaceComponent<TextComponent>(oreNode, textComp);
+
+  SDL_Texture *spritesheet =
+      worldAssetManager->getTexture("assets/img/entity/iron-ore.png");
+  SpriteComponent spriteComp;
+  spriteComp.texture = spritesheet;
+
+  int richnessIndex = GetOreRichnessIndex(amount);
+  spriteComp.srcRect = {0, richnessIndex * 128, 128, 128};
+  spriteComp.renderRect = {0, 0, TILE_PIXEL_SIZE, TILE_PIXEL_SIZE};
+  registry->EmplaceComponent<SpriteComponent>(oreNode, spriteComp);
+
+  // Ore is addressed by tile instead of being spawned over the network, its
+  // state reaches clients with the chunk
+  if (bIsServer) {
+    registry->EmplaceComponent<NetIdentityComponent>(
+        oreNode, NetIdentityComponent{
+                     MakeStaticNetID({worldTileX, worldTileY}), true});
   }
+  chunk.SetOreEntity(index, oreNode);
+  chunk.SetType(index, TileType::Stone);
+  return oreNode;
+}
 
+void World::CreateChunkEntity(Chunk &chunk) {
   // Create a single entity for the entire chunk with a pre-rendered texture
   EntityID chunkEntity = registry->CreateEntity();
   chunk.chunkEntity = chunkEntity;
@@ -394,9 +845,15 @@ void World::GenerateChunk(Chunk &chunk) {
   chunkComp.chunkTexture = worldAssetManager->CreateChunkTexture(chunk);
   chunkComp.bNeedsRedraw = false;
   registry->EmplaceComponent<ChunkComponent>(chunkEntity, chunkComp);
+}
 
-  // std::cout << "Generated Chunk at (" << chunk.chunkX << ", " << chunk.chunkY
-  // << " id=" << chunkEntity << ")\n";
+int World::GetOreRichnessIndex(rsrc_amt_t amount) const {
+  return (IRON_SPRITESHEET_HEIGHT - 1) -
+         std::min(7.0f,
+                  std::floor(static_cast<float>(amount - minironOreAmount) /
+                             static_cast<float>(maxironOreAmount -
+                                                minironOreAmount) *
+                             8.f));
 }
 
 World::~World() = default;
\ No newline at end of file
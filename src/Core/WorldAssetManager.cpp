@@ -10,59 +10,35 @@
 WorldAssetManager::WorldAssetManager(SDL_Renderer *renderer)
     : renderer(renderer) {}
 
-SDL_Texture *WorldAssetManager::CreateChunkTexture(Chunk& chunk) {
-  SDL_Texture *chunkTexture = SDL_CreateTexture(
-      renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
-      CHUNK_WIDTH * TILE_PIXEL_SIZE, CHUNK_HEIGHT * TILE_PIXEL_SIZE);
+SDL_Texture *WorldAssetManager::CreateChunkTexture(Chunk &chunk) {
+  // Headless, the tiles count as drawn
+  if (renderer == nullptr) {
+    chunk.ClearDirtyTiles();
+    return nullptr;
+  }
+
+  SDL_Texture *chunkTexture = nullptr;
+  if (!chunkTexturePool.empty()) {
+    chunkTexture = chunkTexturePool.back().release();
+    chunkTexturePool.pop_back();
+  } else {
+    chunkTexture = SDL_CreateTexture(
+        renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+        CHUNK_WIDTH * TILE_PIXEL_SIZE, CHUNK_HEIGHT * TILE_PIXEL_SIZE);
+  }
 
   // Set the texture as the render target
   SDL_SetRenderTarget(renderer, chunkTexture);
 
-  // Clear the texture with transparent color
+  // Clear the texture with transparent color, a pooled one still shows its
+  // previous chunk
   SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
   SDL_RenderClear(renderer);
 
-  // Get the tileset texture for drawing individual tiles
-  SDL_Texture *tilesetTexture;
-
   // Draw all tiles in the chunk to the texture
-  for (int y = 0; y < CHUNK_HEIGHT; ++y) {
-    for (int x = 0; x < CHUNK_WIDTH; ++x) {
-      TileData *tile = chunk.GetTile(x, y);
-
-      // Determine source rectangle based on tile type
-      SDL_Rect srcRect;
-      switch (tile->type) {
-        case TileType::Dirt:
-          tilesetTexture = getTexture("assets/img/tile/dirt.png");
-          srcRect = {0, 0, 64, 64};
-          break;
-        case TileType::Grass:
-          tilesetTexture =
-              getTexture("assets/img/tile/grass.png");
-          srcRect = {0, 0, 64, 64};
-          break;
-        case TileType::Water:
-          tilesetTexture =
-              getTexture("assets/img/tile/water.png");
-          srcRect = {0, 0, 64, 64};
-          break;
-        case TileType::Stone:
-          tilesetTexture =
-              getTexture("assets/img/tile/stone.png");
-          srcRect = {0, 0, 64, 64};
-          break;
-        default:
-          break;
-      }
-
-      // Destination rectangle for this tile in the chunk texture
-      SDL_Rect destRect = {x * TILE_PIXEL_SIZE, y * TILE_PIXEL_SIZE,
-                           TILE_PIXEL_SIZE, TILE_PIXEL_SIZE};
-      // Render the tile to the chunk texture
-      SDL_RenderCopy(renderer, tilesetTexture, &srcRect, &destRect);
-    }
-  }
+  for (int index = 0; index < Chunk::kTileCount; ++index)
+    DrawTile(chunk, index);
+  chunk.ClearDirtyTiles();
 
   // Reset render target to default
   SDL_SetRenderTarget(renderer, nullptr);
@@ -70,11 +46,61 @@ SDL_Texture *WorldAssetManager::CreateChunkTexture(Chunk& chunk) {
   return chunkTexture;
 }
 
+void WorldAssetManager::UpdateChunkTexture(SDL_Texture *texture,
+                                           Chunk &chunk) {
+  if (texture == nullptr || !chunk.HasDirtyTiles()) return;
+
+  SDL_SetRenderTarget(renderer, texture);
+  // Overwrite the old tile, transparent pixels included
+  SDL_BlendMode blendMode;
+  SDL_GetRenderDrawBlendMode(renderer, &blendMode);
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+  chunk.ForEachDirtyTile([this, &chunk](int index) {
+    const SDL_Rect destRect = {(index % CHUNK_WIDTH) * TILE_PIXEL_SIZE,
+                               (index / CHUNK_WIDTH) * TILE_PIXEL_SIZE,
+                               TILE_PIXEL_SIZE, TILE_PIXEL_SIZE};
+    SDL_RenderFillRect(renderer, &destRect);
+    DrawTile(chunk, index);
+  });
+  chunk.ClearDirtyTiles();
+  SDL_SetRenderDrawBlendMode(renderer, blendMode);
+  SDL_SetRenderTarget(renderer, nullptr);
+}
+
+void WorldAssetManager::ReleaseChunkTexture(SDL_Texture *texture) {
+  if (texture == nullptr) return;
+  if (chunkTexturePool.size() >= kChunkTexturePoolSize) {
+    SDL_DestroyTexture(texture);
+    return;
+  }
+  chunkTexturePool.emplace_back(texture);
+}
+
+void WorldAssetManager::DrawTile(const Chunk &chunk, int index) {
+  static constexpr std::array<const char *, kTileTypeCount> kTilePaths = {
+      nullptr, "assets/img/tile/dirt.png", "assets/img/tile/grass.png",
+      "assets/img/tile/water.png", "assets/img/tile/stone.png"};
+
+  const int type = static_cast<int>(chunk.GetType(index));
+  if (type <= 0 || type >= kTileTypeCount) return;
+  SDL_Texture *&tilesetTexture = tileTextures[type];
+  if (tilesetTexture == nullptr) tilesetTexture = getTexture(kTilePaths[type]);
+
+  const SDL_Rect srcRect = {0, 0, 64, 64};
+  // Destination rectangle for this tile in the chunk texture
+  const SDL_Rect destRect = {(index % CHUNK_WIDTH) * TILE_PIXEL_SIZE,
+                             (index / CHUNK_WIDTH) * TILE_PIXEL_SIZE,
+                             TILE_PIXEL_SIZE, TILE_PIXEL_SIZE};
+  SDL_RenderCopy(renderer, tilesetTexture, &srcRect, &destRect);
+}
+
 SDL_Texture *WorldAssetManager::getTexture(const std::string &path) {
   auto it = textureCache.find(path);
   if (it != textureCache.end()) {
     return it->second.get();
   }
+  if (renderer == nullptr) return nullptr;
 
   SDL_Surface *surface = IMG_Load(path.c_str());
   if (!surface) {
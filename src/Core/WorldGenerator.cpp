@@ -0,0 +1,101 @@
+#include "Core/WorldGenerator.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+// HashChunkSeed streams, one per use of the seed
+enum : uint64_t {
+  kTerrainNoiseStream = 1,
+  kOreNoiseStream,
+  kChunkStream,
+};
+
+// No chunk, for the streams seeded once per world
+constexpr ChunkCoord kWorldCoord{0, 0};
+
+inline uint64_t Mix(uint64_t z) {
+  z += 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+int NoiseSeed(uint64_t seed, uint64_t stream) {
+  return static_cast<int>(
+      static_cast<uint32_t>(HashChunkSeed(seed, stream, kWorldCoord)));
+}
+}  // namespace
+
+uint64_t HashChunkSeed(uint64_t seed, uint64_t stream, ChunkCoord coord) {
+  return Mix(Mix(seed ^ Mix(stream)) ^ PackChunkKey(coord.x, coord.y));
+}
+
+uint64_t ChunkRandom::Next() { return Mix(key ^ Mix(counter++)); }
+
+float ChunkRandom::NextFloat() {
+  // Top 24 bits, exactly representable
+  return static_cast<float>(Next() >> 40) * (1.f / 16777216.f);
+}
+
+WorldGenerator::WorldGenerator(uint64_t seed)
+    : seed(seed),
+      terrainNoise(ENoiseType::Perlin, 0.05f,
+                   NoiseSeed(seed, kTerrainNoiseStream)),
+      oreNoise(ENoiseType::OpenSimplex2, 0.02f,
+               NoiseSeed(seed, kOreNoiseStream)) {}
+
+GeneratedChunk WorldGenerator::Generate(ChunkCoord coord) const {
+  GeneratedChunk generated{Chunk(coord.x, coord.y), {}};
+  Chunk& chunk = generated.chunk;
+
+  const int originX = coord.x * CHUNK_WIDTH;
+  const int originY = coord.y * CHUNK_HEIGHT;
+  std::array<float, Chunk::kTileCount> terrainValues;
+  std::array<float, Chunk::kTileCount> oreValues;
+  terrainNoise.Generate(originX, originY, CHUNK_WIDTH, CHUNK_HEIGHT,
+                        terrainValues.data());
+  oreNoise.Generate(originX, originY, CHUNK_WIDTH, CHUNK_HEIGHT,
+                    oreValues.data());
+
+  // Comparisons used as 0 or 1, noise is random enough to defeat the branch
+  // predictor on every threshold. Every tile writes an ore slot and only ore
+  // tiles advance the count.
+  std::array<std::pair<int, rsrc_amt_t>, Chunk::kTileCount> ores;
+  int oreCount = 0;
+  for (int i = 0; i < Chunk::kTileCount; ++i) {
+    const float terrainValue = terrainValues[i];
+    const float oreValue = oreValues[i];
+
+    // Grass, Dirt below 0.3, Water below -0.2
+    const int terrainType = static_cast<int>(TileType::Grass) -
+                            (terrainValue < 0.3f) +
+                            2 * (terrainValue < -0.2f);
+    const int bIsOre = (oreValue > kOreThreshold) &
+                       (terrainType != static_cast<int>(TileType::Water));
+    const int type =
+        terrainType +
+        bIsOre * (static_cast<int>(TileType::Stone) - terrainType);
+    chunk.SetType(i, static_cast<TileType>(type));
+
+    // Zeroed off ore, a negative amount must not reach the unsigned cast
+    const float amountValue = oreValue * static_cast<float>(bIsOre);
+    ores[oreCount] = {
+        i, static_cast<rsrc_amt_t>(static_cast<float>(kMaxIronOreAmount) *
+                                   amountValue)};
+    oreCount += bIsOre;
+  }
+
+  // Ore tiles draw in index order, the sequence only depends on the chunk
+  ChunkRandom random(HashChunkSeed(seed, kChunkStream, coord));
+  const float minAmount = kOreThreshold * static_cast<float>(kMaxIronOreAmount);
+  const float maxAmount = static_cast<float>(kMaxIronOreAmount);
+  generated.ores.assign(ores.begin(), ores.begin() + oreCount);
+  for (auto& [index, amount] : generated.ores) {
+    const float jitter =
+        1.f + kOreAmountJitter * (2.f * random.NextFloat() - 1.f);
+    amount = static_cast<rsrc_amt_t>(std::clamp(
+        static_cast<float>(amount) * jitter, minAmount, maxAmount));
+  }
+  return generated;
+}
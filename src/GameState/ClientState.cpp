@@ -3,6 +3,7 @@
 #include <cassert>
 #include <chrono>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <tuple>
 #include <utility>
@@ -14,6 +15,7 @@
 #include "Components/CameraComponent.h"
 #include "Components/ChunkComponent.h"
 #include "Components/DebugRectComponent.h"
+#include "Components/FrozenComponent.h"
 #include "Components/InactiveComponent.h"
 #include "Components/InputStateComponent.h"
 #include "Components/InventoryComponent.h"
@@ -21,6 +23,7 @@
 #include "Components/MiningDrillComponent.h"
 #include "Components/MovableComponent.h"
 #include "Components/MovementComponent.h"
+#include "Components/NetIdentityComponent.h"
 #include "Components/NetPredictionComponent.h"
 #include "Components/PlayerStateComponent.h"
 #include "Components/RefineryComponent.h"
@@ -36,6 +39,7 @@
 #include "Core/Event.h"
 #include "Core/EventDispatcher.h"
 #include "Core/GEngine.h"
+#include "Core/NetConnection.h"
 #include "Core/Packet.h"
 #include "Core/Registry.h"
 #include "Core/Socket.h"
@@ -63,6 +67,21 @@
 #include "System/UISystem.h"
 #include "imgui_impl_sdlrenderer2.h"
 
+namespace {
+// Stays below the server's session grace period
+constexpr std::chrono::seconds kReconnectWindow{20};
+constexpr std::chrono::seconds kReconnectRetryDelay{1};
+// Snapshot bytes per second to ask the server for, unset leaves it to the
+// server
+constexpr const char* kRateEnv = "FACTORYGAME_RATE";
+
+std::unique_ptr<Socket> ConnectToServer() {
+  auto socket = std::make_unique<Socket>();
+  socket->Init();
+  if (socket->Connect("127.0.0.1", 27015) == 0) return nullptr;
+  return socket;
+}
+}  // namespace
 
 ClientState::ClientState() : gEngine(nullptr), bIsQuit(false) {}
 ClientState::~ClientState() = default;
@@ -83,6 +102,7 @@ void ClientState::Init(GEngine* engine) {
   sendQueue =
       std::make_unique<ThreadSafeQueue<PacketPtr>>();  // Initialize as
                                                        // PacketPtr queue
+  datagramQueue = std::make_unique<ThreadSafeQueue<std::vector<uint8_t>>>();
 
   entityFactory = std::make_unique<EntityFactory>(registry.get(), assetManager);
   assert(timerManager && "Fail to initialize GEngine : Invalid timer manager");
@@ -94,7 +114,7 @@ void ClientState::Init(GEngine* engine) {
 
   world = std::make_unique<World>(registry.get(), worldAssetManager,
                                   entityFactory.get(), eventDispatcher.get(),
-                                  gFont, false);
+                                  timerManager.get(), gFont, false);
 
   systemContext.assetManager = assetManager;
   systemContext.worldAssetManager = worldAssetManager;
@@ -107,6 +127,7 @@ void ClientState::Init(GEngine* engine) {
   systemContext.timerManager = timerManager.get();
   systemContext.clientRecvQueue = recvQueue.get();
   systemContext.clientSendQueue = sendQueue.get();
+  systemContext.clientDatagramQueue = datagramQueue.get();
   systemContext.socket = connectionSocket.get();
   systemContext.clientNameMap = &clientNameMap;
   systemContext.bIsServer = false;
@@ -120,20 +141,71 @@ void ClientState::Init(GEngine* engine) {
   // TODO : move message buffer and receiving thread to network system
   messageBuffer = std::vector<uint8_t>(MAX_BUFFER);
 
+  StartReceiving();
+  uint32_t rate = 0;
+  if (const char* rateValue = std::getenv(kRateEnv))
+    rate = static_cast<uint32_t>(std::strtoul(rateValue, nullptr, 10));
+  networkSystem->Init(u8"Client", rate);
+}
+
+bool ClientState::TryConnect() {
+  connectionSocket = ConnectToServer();
+  // TODO : send duplicate name check packet and return if duplicate name exists
+
+  return connectionSocket != nullptr;
+}
+
+void ClientState::StartReceiving() {
+  packetAssembler = PacketAssembler();
   bIsReceiving = true;
   messageThread = std::thread([this] { SocketReceiveWorker(); });
-  networkSystem->Init(u8"Client");
+  datagramThread = std::thread([this] { DatagramReceiveWorker(); });
 }
 
-bool ClientState::TryConnect() {
-  connectionSocket = std::make_unique<Socket>();
-  connectionSocket->Init();
+void ClientState::StopReceiving() {
+  bIsReceiving = false;
+  if (messageThread.joinable()) messageThread.join();
+  if (datagramThread.joinable()) datagramThread.join();
+}
 
-  int res = connectionSocket->Connect("127.0.0.1", 27015);
-  // TODO : send duplicate name check packet and return if duplicate name exists
+void ClientState::BeginReconnect() {
+  std::cout << "Connection lost, reconnecting..." << std::endl;
+  StopReceiving();
+  connectionSocket->Close();
+  networkSystem->OnConnectionLost();
+
+  const auto now = std::chrono::steady_clock::now();
+  bIsReconnecting = true;
+  reconnectDeadline = now + kReconnectWindow;
+  nextConnectAttempt = now;
+}
+
+void ClientState::PollReconnect() {
+  const auto now = std::chrono::steady_clock::now();
+  if (!pendingConnect.valid()) {
+    if (now >= nextConnectAttempt)
+      pendingConnect = std::async(std::launch::async, ConnectToServer);
+    return;
+  }
+  if (pendingConnect.wait_for(std::chrono::seconds(0)) !=
+      std::future_status::ready)
+    return;
 
-  if (res == 0) return false;
-  return true;
+  std::unique_ptr<Socket> socket = pendingConnect.get();
+  if (socket == nullptr) {
+    if (now >= reconnectDeadline) {
+      std::cerr << "Could not reach the server again" << std::endl;
+      eventDispatcher->Publish(QuitEvent{});
+    }
+    nextConnectAttempt = now + kReconnectRetryDelay;
+    return;
+  }
+
+  // Receive threads are stopped, nothing else touches the socket now
+  *connectionSocket = std::move(*socket);
+  bIsReconnecting = false;
+  StartReceiving();
+  networkSystem->Resume();
 }
 
 void ClientState::SocketReceiveWorker() {
@@ -152,12 +224,32 @@ void ClientState::SocketReceiveWorker() {
       break;
     }
 
-    PacketPtr packet = std::make_unique<uint8_t[]>(res);
-    std::memcpy(packet.get(), messageBuffer.data(), res);
-    recvQueue->Push(std::move(packet));
+    // TCP may merge or split packets, reassemble them from the stream
+    packetAssembler.Feed(messageBuffer.data(), res);
+    PacketPtr packet;
+    while (packetAssembler.Next(packet)) {
+      recvQueue->Push(std::move(packet));
+    }
+    if (packetAssembler.IsCorrupted()) {
+      std::cerr << "Malformed packet stream from server.\n";
+      bIsReceiving = false;
+      break;
+    }
   }
   std::cout << "Receive thread ending.\n";
-  eventDispatcher->Publish(QuitEvent{});
+  bIsConnectionLost = true;
+}
+
+void ClientState::DatagramReceiveWorker() {
+  std::vector<uint8_t> buffer(kMaxDatagramSize);
+  while (bIsReceiving) {
+    // Times out periodically so shutdown is noticed
+    int res = connectionSocket->ReceiveDatagram(buffer.data(), buffer.size());
+    if (res < 0) break;  // UDP unavailable, TCP carries everything
+    if (res == 0) continue;
+    datagramQueue->Push(
+        std::vector<uint8_t>(buffer.begin(), buffer.begin() + res));
+  }
 }
 
 void ClientState::RegisterComponent() {
@@ -166,11 +258,11 @@ void ClientState::RegisterComponent() {
   using ComponentTypes =
       typeArray<AnimationComponent, AssemblingMachineComponent,
                 BuildingComponent, BuildingPreviewComponent, CameraComponent,
-                ChunkComponent, DebugRectComponent, InactiveComponent,
-                InventoryComponent,InterpBufferComponent, InputStateComponent, MiningDrillComponent, MovableComponent,
-                MovementComponent, NetPredictionComponent, LocalPlayerComponent,
+                ChunkComponent, DebugRectComponent, FrozenComponent,
+                InactiveComponent, InventoryComponent,InterpBufferComponent, InputStateComponent, MiningDrillComponent, MovableComponent,
+                MovementComponent, NetIdentityComponent, NetPredictionComponent, LocalPlayerComponent,
                 PlayerStateComponent, RefineryComponent, ResourceNodeComponent,
-                SpriteComponent, TimerComponent, TimerExpiredTag,
+                SpriteComponent, ReplicationDirtyTag, TimerComponent, TimerExpiredTag,
                 TransformComponent, TextComponent>;
 
   [reg = registry.get()]<std::size_t... Is>(std::index_sequence<Is...>) {
@@ -181,6 +273,9 @@ void ClientState::RegisterComponent() {
 }
 
 void ClientState::InitCoreSystem() {
+  // Subscribes first so predicted commands copy components before the local
+  // handlers of the same event change them
+  networkSystem = std::make_unique<ClientNetworkSystem>(systemContext);
   animationSystem = std::make_unique<AnimationSystem>(systemContext);
   assemblingMachineSystem =
       std::make_unique<AssemblingMachineSystem>(systemContext);
@@ -191,7 +286,6 @@ void ClientState::InitCoreSystem() {
   itemDragSystem = std::make_unique<ItemDragSystem>(systemContext);
   miningDrillSystem = std::make_unique<MiningDrillSystem>(systemContext);
   movementSystem = std::make_unique<MovementSystem>(systemContext);
-  networkSystem = std::make_unique<ClientNetworkSystem>(systemContext);
   refinerySystem = std::make_unique<RefinerySystem>(systemContext);
   resourceNodeSystem = std::make_unique<ResourceNodeSystem>(systemContext);
   timerExpireSystem = std::make_unique<TimerExpireSystem>(systemContext);
@@ -203,8 +297,8 @@ void ClientState::InitCoreSystem() {
 }
 
 void ClientState::Cleanup() {
-  bIsReceiving = false;
-  messageThread.join();
+  StopReceiving();
+  if (pendingConnect.valid()) pendingConnect.wait();
 }
 
 void ClientState::Update(float deltaTime) {
@@ -213,7 +307,19 @@ void ClientState::Update(float deltaTime) {
       gEngine->ChangeState(std::make_unique<MainMenuState>());
     return;  // The state is now being destroyed, so we should not continue.
   }
-  networkSystem->Update(deltaTime);
+
+  // A session can be resumed, anything else ends the game
+  if (bIsConnectionLost.exchange(false)) {
+    if (!networkSystem->HasSession()) {
+      eventDispatcher->Publish(QuitEvent{});
+      return;
+    }
+    BeginReconnect();
+  }
+  if (bIsReconnecting)
+    PollReconnect();
+  else
+    networkSystem->Update(deltaTime);
 
   // Process all pending commands.
   while (!commandQueue->IsEmpty()) {
@@ -238,6 +344,7 @@ void ClientState::Update(float deltaTime) {
   miningDrillSystem->Update();
   refinerySystem->Update();
   resourceNodeSystem->Update();
+  world->SyncEntityIndex();
 
   cameraSystem->Update(deltaTime);
 
@@ -4,6 +4,8 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <iostream>
 #include <tuple>
 #include <utility>
 
@@ -15,12 +17,14 @@
 #include "Components/CameraComponent.h"
 #include "Components/ChunkComponent.h"
 #include "Components/DebugRectComponent.h"
+#include "Components/FrozenComponent.h"
 #include "Components/InactiveComponent.h"
 #include "Components/InventoryComponent.h"
 #include "Components/LocalPlayerComponent.h"
 #include "Components/MiningDrillComponent.h"
 #include "Components/MovableComponent.h"
 #include "Components/MovementComponent.h"
+#include "Components/NetIdentityComponent.h"
 #include "Components/NetPredictionComponent.h"
 #include "Components/PlayerStateComponent.h"
 #include "Components/RefineryComponent.h"
@@ -36,6 +40,8 @@
 #include "Core/EventDispatcher.h"
 #include "Core/GEngine.h"
 #include "Core/Packet.h"
+#include "Core/PacketCapture.h"
+#include "Core/RegionFile.h"
 #include "Core/Registry.h"
 #include "Core/Server.h"
 #include "Core/ThreadSafeQueue.h"
@@ -63,6 +69,20 @@
 #include "System/UISystem.h"
 #include "imgui_impl_sdlrenderer2.h"
 
+namespace {
+// Path to write received packets to
+constexpr const char* kCaptureEnv = "FACTORYGAME_CAPTURE";
+// Path of a capture to replay instead of accepting clients
+constexpr const char* kReplayEnv = "FACTORYGAME_REPLAY";
+// Playback rate of the replay, 0 replays one recorded tick per frame
+constexpr const char* kReplayRateEnv = "FACTORYGAME_REPLAY_RATE";
+// World seed, the same seed always generates the same world
+constexpr const char* kWorldSeedEnv = "FACTORYGAME_WORLD_SEED";
+// Directory unloaded chunks are saved to
+constexpr const char* kSaveDirEnv = "FACTORYGAME_SAVE_DIR";
+constexpr const char* kDefaultSaveDir = "save";
+}  // namespace
+
 ServerState::ServerState() {}
 ServerState::~ServerState() = default;
 
@@ -82,9 +102,19 @@ void ServerState::Init(GEngine* engine) {
   sendQueue = std::make_unique<ThreadSafeQueue<SendRequest>>();
 
   pendingMoves = std::make_unique<ThreadSafeQueue<MoveApplied>>();
-  server = std::make_unique<Server>();  // ServerImpl needs SendRequest queue
-  server->Init(recvQueue.get(), sendQueue.get());
-  server->Start();
+  if (const char* replayPath = std::getenv(kReplayEnv)) {
+    const char* rate = std::getenv(kReplayRateEnv);
+    replayer = std::make_unique<PacketReplayer>(
+        recvQueue.get(), rate ? std::strtof(rate, nullptr) : 1.f);
+    if (!replayer->Open(replayPath)) replayer.reset();
+  }
+
+  // A replay stands in for the network, no sockets are opened
+  if (!replayer) {
+    server = std::make_unique<Server>();  // ServerImpl needs SendRequest queue
+    server->Init(recvQueue.get(), sendQueue.get());
+    server->Start();
+  }
   std::string serverName = "Server";
   clientNameMap[0] = serverName;
 
@@ -94,11 +124,22 @@ void ServerState::Init(GEngine* engine) {
          "Fail to initialize GEngine : Invalid eventDispatcher");
   assert(commandQueue && "Fail to initialize GEngine : Invalid command queue");
 
-  RegisterComponent();
+  RegisterComponent(registry.get());
 
+  // An existing save continues with its own seed unless one is forced
+  const char* saveDir = std::getenv(kSaveDirEnv);
+  if (saveDir == nullptr) saveDir = kDefaultSaveDir;
+  uint64_t worldSeed = kDefaultWorldSeed;
+  if (const char* seed = std::getenv(kWorldSeedEnv))
+    worldSeed = std::strtoull(seed, nullptr, 10);
+  else
+    RegionStore::ReadSeed(saveDir, worldSeed);
+  std::cout << "World seed " << worldSeed << std::endl;
   world = std::make_unique<World>(registry.get(), worldAssetManager,
                                   entityFactory.get(), eventDispatcher.get(),
-                                  gFont, true);
+                                  timerManager.get(), gFont, true, worldSeed);
+  if (world->OpenSave(saveDir))
+    std::cout << "Saving chunks to " << saveDir << std::endl;
 
   systemContext.assetManager = assetManager;
   systemContext.worldAssetManager = worldAssetManager;
@@ -119,6 +160,9 @@ void ServerState::Init(GEngine* engine) {
 
   InitCoreSystem();
 
+  if (const char* capturePath = std::getenv(kCaptureEnv))
+    networkSystem->StartRecording(capturePath);
+
   eventDispatcher->Subscribe<QuitEvent>(
       [this](QuitEvent e) { bIsQuit = true; });
 
@@ -126,20 +170,20 @@ void ServerState::Init(GEngine* engine) {
   world->GeneratePlayer(0, {0.f, 0.f}, true);
 }
 
-void ServerState::RegisterComponent() {
+void ServerState::RegisterComponent(Registry* registry) {
   // Register all component type inside typeArray to regsitry
   // powered by Lambda TMP Magic™
   using ComponentTypes =
       typeArray<AnimationComponent, AssemblingMachineComponent,
                 BuildingComponent, BuildingPreviewComponent, CameraComponent,
-                ChunkComponent, DebugRectComponent, InactiveComponent,
-                InventoryComponent, InputStateComponent, MiningDrillComponent, MovableComponent,
-                MovementComponent, NetPredictionComponent,
+                ChunkComponent, DebugRectComponent, FrozenComponent,
+                InactiveComponent, InventoryComponent, InputStateComponent, MiningDrillComponent, MovableComponent,
+                MovementComponent, NetIdentityComponent, NetPredictionComponent,
                 LocalPlayerComponent, PlayerStateComponent, RefineryComponent,
-                ResourceNodeComponent, SpriteComponent, TimerComponent,
+                ResourceNodeComponent, SpriteComponent, ReplicationDirtyTag, TimerComponent,
                 TimerExpiredTag, TransformComponent, TextComponent>;
 
-  [reg = registry.get()]<std::size_t... Is>(std::index_sequence<Is...>) {
+  [reg = registry]<std::size_t... Is>(std::index_sequence<Is...>) {
     ((reg->RegisterComponent<
          std::tuple_element_t<Is, typename ComponentTypes::typesTuple>>()),
      ...);
@@ -168,7 +212,26 @@ void ServerState::InitCoreSystem() {
       std::make_unique<RenderSystem>(systemContext, gRenderer, gFont);
 }
 
-void ServerState::Cleanup() {}
+void ServerState::Cleanup() {
+  // Chunks still loaded were never unloaded to the save
+  if (world) world->SaveAll();
+}
+
+void ServerState::UpdateNetwork(float deltaTime) {
+  if (!replayer) {
+    networkSystem->Update(deltaTime);
+    return;
+  }
+
+  replayer->Update(deltaTime);
+  networkSystem->Update(deltaTime);
+
+  // Paced by the window here, ReplayServer times the ticks without one
+  if (!bIsReplayReported && replayer->IsFinished()) {
+    bIsReplayReported = true;
+    std::cout << "Replayed " << replayer->GetReplayedCount() << " packets\n";
+  }
+}
 
 void ServerState::Update(float deltaTime) {
   if (bIsQuit) {
@@ -186,7 +249,7 @@ void ServerState::Update(float deltaTime) {
     }
   }
 
-  networkSystem->Update(deltaTime);
+  UpdateNetwork(deltaTime);
   itemDragSystem->Update();
   timerSystem->Update(deltaTime);
   timerExpireSystem->Update();
@@ -199,6 +262,7 @@ void ServerState::Update(float deltaTime) {
   miningDrillSystem->Update();
   refinerySystem->Update();
   resourceNodeSystem->Update();
+  world->SyncEntityIndex();
 
   cameraSystem->Update(deltaTime);
 
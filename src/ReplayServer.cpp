@@ -0,0 +1,182 @@
+// Windowless server that replays a packet capture as fast as it can and
+// reports what each server tick cost.
+//
+// Usage: ReplayServer <capture> [playback rate] [world seed]
+//
+// A playback rate of 0 replays one recorded tick per server tick. Otherwise
+// the recorded time is followed in simulated ticks of tickDelta, nothing
+// waits for the wall clock.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Core/AssetManager.h"
+#include "Core/CommandQueue.h"
+#include "Core/EntityFactory.h"
+#include "Core/EventDispatcher.h"
+#include "Core/Packet.h"
+#include "Core/PacketCapture.h"
+#include "Core/Registry.h"
+#include "Core/SystemContext.h"
+#include "Core/ThreadSafeQueue.h"
+#include "Core/TimerManager.h"
+#include "Core/World.h"
+#include "Core/WorldAssetManager.h"
+#include "GameState/ServerState.h"
+#include "System/AssemblingMachineSystem.h"
+#include "System/InteractionSystem.h"
+#include "System/InventorySystem.h"
+#include "System/MiningDrillSystem.h"
+#include "System/MovementSystem.h"
+#include "System/RefinerySystem.h"
+#include "System/ResourceNodeSystem.h"
+#include "System/ServerNetworkSystem.h"
+#include "System/TimerExpireSystem.h"
+#include "System/TimerSystem.h"
+#include "SDL.h"
+
+namespace {
+// Runs the systems ServerState runs, minus input, camera and rendering.
+// There is no host player, only the clients of the capture.
+class ReplayServer {
+ public:
+  ReplayServer(float playbackRate, uint64_t seed)
+      : registry(&eventDispatcher),
+        assetManager(nullptr),
+        worldAssetManager(nullptr),
+        factory(&registry, &assetManager),
+        replayer(&recvQueue, playbackRate) {
+    ServerState::RegisterComponent(&registry);
+    world = std::make_unique<World>(&registry, &worldAssetManager, &factory,
+                                    &eventDispatcher, &timerManager, nullptr,
+                                    true, seed);
+    clientNameMap[0] = "Server";
+
+    SystemContext context;
+    context.assetManager = &assetManager;
+    context.worldAssetManager = &worldAssetManager;
+    context.commandQueue = &commandQueue;
+    context.registry = &registry;
+    context.eventDispatcher = &eventDispatcher;
+    context.world = world.get();
+    context.entityFactory = &factory;
+    context.timerManager = &timerManager;
+    context.serverRecvQueue = &recvQueue;
+    context.serverSendQueue = &sendQueue;
+    context.pendingMoves = &pendingMoves;
+    context.clientNameMap = &clientNameMap;
+    context.bIsServer = true;
+
+    assemblingMachineSystem =
+        std::make_unique<AssemblingMachineSystem>(context);
+    interactionSystem = std::make_unique<InteractionSystem>(context);
+    inventorySystem = std::make_unique<InventorySystem>(context);
+    miningDrillSystem = std::make_unique<MiningDrillSystem>(context);
+    movementSystem = std::make_unique<MovementSystem>(context);
+    networkSystem = std::make_unique<ServerNetworkSystem>(context);
+    refinerySystem = std::make_unique<RefinerySystem>(context);
+    resourceNodeSystem = std::make_unique<ResourceNodeSystem>(context);
+    timerExpireSystem = std::make_unique<TimerExpireSystem>(context);
+    timerSystem = std::make_unique<TimerSystem>(context);
+  }
+
+  bool Open(const std::string& path) { return replayer.Open(path); }
+
+  void Run() {
+    std::size_t tickCount = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+
+    while (!replayer.IsFinished()) {
+      const auto start = std::chrono::steady_clock::now();
+      Tick();
+      const double elapsedMs = std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+      ++tickCount;
+      totalMs += elapsedMs;
+      maxMs = std::max(maxMs, elapsedMs);
+    }
+
+    std::cout << "Replayed " << replayer.GetReplayedCount() << " packets in "
+              << tickCount << " ticks, server tick avg "
+              << (tickCount ? totalMs / tickCount : 0.0) << " ms, max "
+              << maxMs << " ms, total " << totalMs << " ms" << std::endl;
+  }
+
+ private:
+  // Same order as ServerState::Update
+  void Tick() {
+    RunCommands();
+
+    replayer.Update(tickDelta);
+    networkSystem->Update(tickDelta);
+    timerSystem->Update(tickDelta);
+    timerExpireSystem->Update();
+    interactionSystem->Update();
+
+    world->Update();
+    movementSystem->Update(tickDelta);
+    assemblingMachineSystem->Update();
+    miningDrillSystem->Update();
+    refinerySystem->Update();
+    resourceNodeSystem->Update();
+    world->SyncEntityIndex();
+  }
+
+  void RunCommands() {
+    while (!commandQueue.IsEmpty()) {
+      std::unique_ptr<Command> command = commandQueue.Dequeue();
+      if (command) command->Execute(&registry, &eventDispatcher, world.get());
+    }
+  }
+
+  TimerManager timerManager;
+  EventDispatcher eventDispatcher;
+  Registry registry;
+  CommandQueue commandQueue;
+  ThreadSafeQueue<RecvPacket> recvQueue;
+  ThreadSafeQueue<SendRequest> sendQueue;
+  ThreadSafeQueue<MoveApplied> pendingMoves;
+  std::unordered_map<clientid_t, std::string> clientNameMap;
+  AssetManager assetManager;
+  WorldAssetManager worldAssetManager;
+  EntityFactory factory;
+  PacketReplayer replayer;
+  std::unique_ptr<World> world;
+
+  std::unique_ptr<AssemblingMachineSystem> assemblingMachineSystem;
+  std::unique_ptr<InteractionSystem> interactionSystem;
+  std::unique_ptr<InventorySystem> inventorySystem;
+  std::unique_ptr<MiningDrillSystem> miningDrillSystem;
+  std::unique_ptr<MovementSystem> movementSystem;
+  std::unique_ptr<ServerNetworkSystem> networkSystem;
+  std::unique_ptr<RefinerySystem> refinerySystem;
+  std::unique_ptr<ResourceNodeSystem> resourceNodeSystem;
+  std::unique_ptr<TimerExpireSystem> timerExpireSystem;
+  std::unique_ptr<TimerSystem> timerSystem;
+};
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0]
+              << " <capture> [playback rate] [world seed]" << std::endl;
+    return 1;
+  }
+
+  const float playbackRate = argc > 2 ? std::strtof(argv[2], nullptr) : 1.f;
+  const uint64_t seed =
+      argc > 3 ? std::strtoull(argv[3], nullptr, 10) : kDefaultWorldSeed;
+
+  ReplayServer server(playbackRate, seed);
+  if (!server.Open(argv[1])) return 1;
+  server.Run();
+  return 0;
+}
@@ -1,24 +1,30 @@
 #include "System/AssemblingMachineSystem.h"
 
 #include <algorithm>
+#include <limits>
 
 #include "Components/AnimationComponent.h"
 #include "Components/AssemblingMachineComponent.h"
+#include "Components/FrozenComponent.h"
+#include "Components/InactiveComponent.h"
 #include "Components/TimerComponent.h"
 #include "Core/Event.h"
 #include "Core/EventDispatcher.h"
 #include "Core/Item.h"
+#include "Core/ProductionModel.h"
 #include "Core/Recipe.h"
 #include "Core/Registry.h"
 #include "Core/TimerManager.h"
 #include "Util/AnimUtil.h"
+#include "Util/ReplicationUtil.h"
 #include "Util/TimerUtil.h"
 
 
 AssemblingMachineSystem::AssemblingMachineSystem(const SystemContext &context)
     : registry(context.registry),
       eventDispatcher(context.eventDispatcher),
-      timerManager(context.timerManager) {
+      timerManager(context.timerManager),
+      bIsServer(context.bIsServer) {
   // Subscribe event handler function
   AddInputEventHandle = eventDispatcher->Subscribe<AssemblyAddInputEvent>(
       [this](const AssemblyAddInputEvent &event) {
@@ -32,6 +38,10 @@ AssemblingMachineSystem::AssemblingMachineSystem(const SystemContext &context)
       [this](const AssemblyCraftOutputEvent &event) {
         this->ProduceOutput(event.machine);
       });
+  SetRecipeEventHandle = eventDispatcher->Subscribe<AssemblySetRecipeEvent>(
+      [this](const AssemblySetRecipeEvent &event) {
+        this->SetRecipeHandler(event);
+      });
 };
 
 void AssemblingMachineSystem::Update() {
@@ -40,6 +50,20 @@ void AssemblingMachineSystem::Update() {
   for (auto entity : view) {
     auto &machine = registry->GetComponent<AssemblingMachineComponent>(entity);
 
+    // Clients mirror the server's machine state, only animate it
+    if (!bIsServer) {
+      UpdateAnimationState(entity, machine);
+      continue;
+    }
+
+    // Off-screen machines are settled in bulk instead of ticked
+    if ((registry->HasComponent<InactiveComponent>(entity) ||
+         registry->HasComponent<FrozenComponent>(entity)) &&
+        !UpdateFrozen(entity, machine))
+      continue;
+
+    const AssemblingMachineState prevState = machine.state;
+
     switch (machine.state) {
       case AssemblingMachineState::Idle:
         if (machine.currentRecipe != RecipeID::None &&
@@ -55,6 +79,17 @@ void AssemblingMachineSystem::Update() {
         break;
 
       case AssemblingMachineState::Crafting:
+        // Restored from a save without its timer, the ingredients were
+        // consumed before saving
+        if (machine.currentRecipe != RecipeID::None &&
+            !util::HasTimer(registry, entity,
+                            TimerId::AssemblingMachineCraft)) {
+          util::AttachTimer(
+              registry, timerManager, entity, TimerId::AssemblingMachineCraft,
+              RecipeDatabase::instance().get(machine.currentRecipe)
+                  .craftingTime,
+              false);
+        }
         break;
 
       case AssemblingMachineState::OutputFull:
@@ -64,6 +99,10 @@ void AssemblingMachineSystem::Update() {
         break;
     }
 
+    if (machine.state != prevState)
+      util::MarkReplicationDirty(registry, entity,
+                                 EReplicatedComponent::AssemblingMachine);
+
     UpdateAnimationState(entity, machine);
   }
 }
@@ -71,7 +110,8 @@ void AssemblingMachineSystem::Update() {
 void AssemblingMachineSystem::AddInputHandler(
     const AssemblyAddInputEvent &event) {
   int amt = AddInputItem(event.machine, event.item, event.amount);
-  eventDispatcher->Publish(ItemConsumeEvent{event.target, event.item, amt});
+  if (amt > 0)
+    eventDispatcher->Publish(ItemConsumeEvent{event.target, event.item, amt});
 }
 
 void AssemblingMachineSystem::TakeOutputHandler(
@@ -80,9 +120,22 @@ void AssemblingMachineSystem::TakeOutputHandler(
   eventDispatcher->Publish(ItemAddEvent{event.target, event.item, amt});
 }
 
+void AssemblingMachineSystem::SetRecipeHandler(
+    const AssemblySetRecipeEvent &event) {
+  if (!registry->HasComponent<AssemblingMachineComponent>(event.machine))
+    return;
+
+  auto &machine =
+      registry->GetComponent<AssemblingMachineComponent>(event.machine);
+  machine.currentRecipe = event.recipe;
+  machine.state = AssemblingMachineState::Idle;
+  util::MarkReplicationDirty(registry, event.machine,
+                             EReplicatedComponent::AssemblingMachine);
+}
+
 int AssemblingMachineSystem::AddInputItem(EntityID entity, ItemID itemId,
                                           int amount) {
-  if (!registry->HasComponent<AssemblingMachineComponent>(entity)) return false;
+  if (!registry->HasComponent<AssemblingMachineComponent>(entity)) return 0;
 
   auto &machine = registry->GetComponent<AssemblingMachineComponent>(entity);
   const auto &itemData = ItemDatabase::instance().get(itemId);
@@ -95,9 +148,11 @@ int AssemblingMachineSystem::AddInputItem(EntityID entity, ItemID itemId,
 
   if (amountToAdd > 0) {
     machine.inputInventory[itemId] += amountToAdd;
+    util::MarkReplicationDirty(registry, entity,
+                               EReplicatedComponent::AssemblingMachine);
     return amountToAdd;
   }
-  return -1;
+  return 0;
 }
 
 int AssemblingMachineSystem::TakeOutputItem(EntityID entity, ItemID itemId,
@@ -115,6 +170,8 @@ int AssemblingMachineSystem::TakeOutputItem(EntityID entity, ItemID itemId,
   if (it->second <= 0) {
     machine.outputInventory.erase(it);
   }
+  util::MarkReplicationDirty(registry, entity,
+                             EReplicatedComponent::AssemblingMachine);
 
   return amountToTake;
 }
@@ -178,6 +235,8 @@ void AssemblingMachineSystem::ProduceOutput(EntityID entity) {
       RecipeDatabase::instance().get(machine.currentRecipe);
 
   machine.outputInventory[recipeData.outputItem] += recipeData.outputAmount;
+  util::MarkReplicationDirty(registry, entity,
+                             EReplicatedComponent::AssemblingMachine);
 
   if (HasEnoughIngredients(entity) && CanStoreOutput(entity)) {
     StartCrafting(entity, machine);
@@ -195,6 +254,8 @@ void AssemblingMachineSystem::StartCrafting(
   ConsumeIngredients(entity, machine);
   machine.state = AssemblingMachineState::Crafting;
   machine.bIsAnimating = true;
+  util::MarkReplicationDirty(registry, entity,
+                             EReplicatedComponent::AssemblingMachine);
 
   // Start crafting timer using TimerUtil
   if (machine.currentRecipe != RecipeID::None) {
@@ -206,6 +267,102 @@ void AssemblingMachineSystem::StartCrafting(
   }
 }
 
+bool AssemblingMachineSystem::UpdateFrozen(
+    EntityID entity, AssemblingMachineComponent &machine) {
+  const double now = timerManager->GetTime();
+  if (!registry->HasComponent<FrozenComponent>(entity)) {
+    registry->EmplaceComponent<FrozenComponent>(entity, FrozenComponent{now});
+    return false;
+  }
+
+  auto &frozen = registry->GetComponent<FrozenComponent>(entity);
+  const bool bThawed = !registry->HasComponent<InactiveComponent>(entity);
+  if (!bThawed && now - frozen.settledAt < kFrozenSettleInterval) return false;
+
+  SettleProduction(entity, machine,
+                   static_cast<float>(now - frozen.settledAt));
+  frozen.settledAt = now;
+  // Kept by the timer from now on
+  frozen.progress = 0.f;
+  if (bThawed) registry->RemoveComponent<FrozenComponent>(entity);
+  return bThawed;
+}
+
+void AssemblingMachineSystem::SettleProduction(
+    EntityID entity, AssemblingMachineComponent &machine, float elapsed) {
+  if (machine.currentRecipe == RecipeID::None) return;
+
+  // Idle and waiting machines would have started right away if they could
+  const bool bCrafting = machine.state == AssemblingMachineState::Crafting;
+  if (!bCrafting && !(HasEnoughIngredients(entity) && CanStoreOutput(entity)))
+    return;
+
+  const auto &recipeData =
+      RecipeDatabase::instance().get(machine.currentRecipe);
+  const int maxStackSize =
+      ItemDatabase::instance().get(recipeData.outputItem).maxStackSize;
+  auto outputIt = machine.outputInventory.find(recipeData.outputItem);
+  const int stored =
+      outputIt != machine.outputInventory.end() ? outputIt->second : 0;
+
+  // A craft starts only if its output fits next to what is stored, the one
+  // underway finishes regardless
+  const int room = (maxStackSize - stored) / recipeData.outputAmount -
+                   (bCrafting ? 1 : 0);
+  int affordable = std::numeric_limits<int>::max();
+  for (const auto &ingredient : recipeData.ingredients) {
+    auto it = machine.inputInventory.find(ingredient.itemId);
+    const int have = it != machine.inputInventory.end() ? it->second : 0;
+    affordable = std::min(affordable, have / ingredient.amount);
+  }
+
+  TimerInstance *timer = util::GetTimer(registry, timerManager, entity,
+                                        TimerId::AssemblingMachineCraft);
+  // A restored machine gets its timer back below
+  float progress = 0.f;
+  if (timer)
+    progress = timer->elapsed;
+  else if (registry->HasComponent<FrozenComponent>(entity))
+    progress = registry->GetComponent<FrozenComponent>(entity).progress;
+  const ProductionProjection projection = ProjectProduction(
+      bCrafting, bCrafting ? progress : 0.f, elapsed, recipeData.craftingTime,
+      std::min(affordable, std::max(0, room)));
+
+  if (projection.completed > 0) {
+    machine.outputInventory[recipeData.outputItem] +=
+        projection.completed * recipeData.outputAmount;
+  }
+  for (const auto &ingredient : recipeData.ingredients) {
+    if (projection.started == 0) break;
+    machine.inputInventory[ingredient.itemId] -=
+        projection.started * ingredient.amount;
+    if (machine.inputInventory[ingredient.itemId] <= 0)
+      machine.inputInventory.erase(ingredient.itemId);
+  }
+
+  if (projection.bRunning) {
+    if (timer == nullptr) {
+      util::AttachTimer(registry, timerManager, entity,
+                        TimerId::AssemblingMachineCraft,
+                        recipeData.craftingTime, false);
+      timer = util::GetTimer(registry, timerManager, entity,
+                             TimerId::AssemblingMachineCraft);
+    }
+    if (timer) timer->elapsed = projection.progress;
+    machine.state = AssemblingMachineState::Crafting;
+    machine.bIsAnimating = true;
+  } else {
+    util::DetachTimer(registry, timerManager, entity,
+                      TimerId::AssemblingMachineCraft);
+    machine.state = CanStoreOutput(entity)
+                        ? AssemblingMachineState::WaitingForIngredients
+                        : AssemblingMachineState::OutputFull;
+    machine.bIsAnimating = false;
+  }
+  util::MarkReplicationDirty(registry, entity,
+                             EReplicatedComponent::AssemblingMachine);
+}
+
 void AssemblingMachineSystem::UpdateAnimationState(
     EntityID entity, AssemblingMachineComponent &machine) {
   if (!registry->HasComponent<AnimationComponent>(entity)) return;
@@ -1,5 +1,7 @@
 #include "System/CameraSystem.h"
 
+#include <cmath>
+
 #include "Components/CameraComponent.h"
 #include "Components/TransformComponent.h"
 #include "Core/InputManager.h"
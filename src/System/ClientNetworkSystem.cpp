@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -11,21 +12,33 @@
 
 #include "Commands/PlayerDisconnectedCommnad.h"
 #include "Commands/PlayerSpawnCommand.h"
+#include "Commands/InventoryCommand.h"
 #include "Components/AnimationComponent.h"
+#include "Components/AssemblingMachineComponent.h"
+#include "Components/BuildingComponent.h"
+#include "Components/InactiveComponent.h"
 #include "Components/InterpBufferComponent.h"
+#include "Components/InventoryComponent.h"
 #include "Components/LocalPlayerComponent.h"
 #include "Components/MovementComponent.h"
 #include "Components/NetPredictionComponent.h"
 #include "Components/PlayerStateComponent.h"
 #include "Components/SpriteComponent.h"
 #include "Components/TransformComponent.h"
+#include "Core/CommandPredictor.h"
 #include "Core/CommandQueue.h"
+#include "Core/ComponentReplicator.h"
+#include "Core/EntityFactory.h"
 #include "Core/Event.h"
 #include "Core/EventDispatcher.h"
 #include "Core/InputManager.h"
+#include "Core/NetConnection.h"
 #include "Core/Packet.h"
+#include "Core/PacketSchema.h"
 #include "Core/Socket.h"
+#include "Core/World.h"
 #include "Util/AnimUtil.h"
+#include "Util/InterpUtil.h"
 #include "Util/MathUtil.h"
 #include "Util/PacketUtil.h"
 
@@ -34,77 +47,248 @@ ClientNetworkSystem::ClientNetworkSystem(const SystemContext& context)
       eventDispatcher(context.eventDispatcher),
       registry(context.registry),
       commandQueue(context.commandQueue),
-      world(context.world),
       inputManager(context.inputManager),
       timerManager(context.timerManager),
       recvQueue(context.clientRecvQueue),  // Incoming packets (client-specific)
       sendQueue(context.clientSendQueue),  // Outgoing packets (client-specific)
+      datagramQueue(context.clientDatagramQueue),
+      world(context.world),
+      factory(context.entityFactory),
       connectionSocket(context.socket),
       clientNameMap(context.clientNameMap),
       myClientID(-1),
-      moveReqTimer(0.f) {
+      moveReqTimer(0.f),
+      udpConnection(std::make_unique<NetConnection>()) {
+  commandPredictor = std::make_unique<CommandPredictor>(
+      registry, [this](EntityID entity) { DestroyBuilding(entity); });
+
   sendChatHandle = eventDispatcher->Subscribe<SendChatEvent>(
       [this](SendChatEvent e) { SendMessage(e.message); });
+
+  // Server owns buildings and machines, forward the request and predict the
+  // outcome until COMMAND_ACK. Interactions are applied by the local handlers
+  // of the same event, the prediction only copies what they are about to
+  // change and publishes the event again when it has to be replayed.
+  buildRequestHandle = eventDispatcher->Subscribe<BuildRequestEvent>(
+      [this](const BuildRequestEvent& e) {
+        SendBuildRequest(e.player, e.item, e.tileIndex);
+      });
+  setRecipeHandle = eventDispatcher->Subscribe<AssemblySetRecipeEvent>(
+      [this](const AssemblySetRecipeEvent& e) {
+        if (commandPredictor->IsReplaying()) return;
+        SendInteractRequest(
+            e.machine, ENetInteraction::SetRecipe,
+            static_cast<uint8_t>(e.recipe), 0,
+            [this, e](PredictionScope& scope) {
+              scope.Get<AssemblingMachineComponent>(e.machine);
+              if (scope.IsReplay()) eventDispatcher->Publish(e);
+            });
+      });
+  addInputHandle = eventDispatcher->Subscribe<AssemblyAddInputEvent>(
+      [this](const AssemblyAddInputEvent& e) {
+        if (commandPredictor->IsReplaying()) return;
+        SendInteractRequest(
+            e.machine, ENetInteraction::AddInput, static_cast<uint8_t>(e.item),
+            e.amount, [this, e](PredictionScope& scope) {
+              scope.Get<AssemblingMachineComponent>(e.machine);
+              scope.Get<InventoryComponent>(e.target);
+              if (scope.IsReplay()) eventDispatcher->Publish(e);
+            });
+      });
+  takeOutputHandle = eventDispatcher->Subscribe<AssemblyTakeOutputEvent>(
+      [this](const AssemblyTakeOutputEvent& e) {
+        if (commandPredictor->IsReplaying()) return;
+        SendInteractRequest(
+            e.machine, ENetInteraction::TakeOutput,
+            static_cast<uint8_t>(e.item), e.amount,
+            [this, e](PredictionScope& scope) {
+              scope.Get<AssemblingMachineComponent>(e.machine);
+              scope.Get<InventoryComponent>(e.target);
+              if (scope.IsReplay()) eventDispatcher->Publish(e);
+            });
+      });
+  itemMoveHandle = eventDispatcher->Subscribe<ItemMoveEvent>(
+      [this](const ItemMoveEvent& e) {
+        if (commandPredictor->IsReplaying()) return;
+        SendInteractRequest(
+            e.source, ENetInteraction::TakeInventory,
+            static_cast<uint8_t>(e.item), e.amount,
+            [this, e](PredictionScope& scope) {
+              scope.Get<InventoryComponent>(e.source);
+              scope.Get<InventoryComponent>(e.dest);
+              if (scope.IsReplay()) eventDispatcher->Publish(e);
+            });
+      });
 }
 
-void ClientNetworkSystem::Init(std::u8string playerName) {
+void ClientNetworkSystem::Init(std::u8string playerName, uint32_t rate) {
   myName = std::string(reinterpret_cast<const char*>(playerName.c_str()));
-  const uint8_t nameSize =
-      std::min(static_cast<uint8_t>(playerName.size()), NAME_MAX_LEN);
-
-  const size_t packetSize = sPacketHeader + sizeof(uint8_t) + nameSize;
 
-  PacketPtr packet = std::make_unique<uint8_t[]>(packetSize);
+  PacketPtr packet = MakePacket<CONNECT_SYN>(myName, rate);
+  const uint8_t* rp = packet.get();
+  PACKET packetId;
+  std::size_t packetSize;
+  util::GetHeader(rp, packetId, packetSize);
+  connectionSocket->Send(packet.get(), packetSize);
+}
 
-  uint8_t* p = packet.get();
+void ClientNetworkSystem::ConnectAckHandler(PacketReader& reader) {
+  auto header = reader.ReadHeader<CONNECT_ACK>();
+  if (!header) return;
+  const auto [clientID, token, playerCnt] = *header;
+  myClientID = clientID;
+  sessionToken = token;
+  bHasSession = true;
+
+  // Players that do not fit follow in PLAYER_ROSTER
+  bIsResumeRoster = false;
+  rosterRemaining = playerCnt;
+  ReadRoster(reader, playerCnt);
+  if (world->GetLocalPlayer() == INVALID_ENTITY) {
+    clientNameMap->emplace(myClientID, myName);
+    world->GeneratePlayer(myClientID, {0.f, 0.f}, true);
+  }
 
-  util::WriteHeader(p, PACKET::CONNECT_SYN, packetSize);
-  *p++ = nameSize;
-  std::memcpy(p, playerName.c_str(), nameSize);
-  connectionSocket->Send(packet.get(), packetSize);
+  RequestUdpBind();
 }
 
-void ClientNetworkSystem::ConnectAckHandler(const uint8_t* rp,
-                                            std::size_t packetSize) {
-  myClientID = util::Read64BigEnd(rp);
+void ClientNetworkSystem::ReconnectAckHandler(PacketReader& reader) {
+  auto header = reader.ReadHeader<RECONNECT_ACK>();
+  if (!header) return;
+  const auto [rawResult, playerCnt] = *header;
+  const auto result = static_cast<EReconnectResult>(rawResult);
 
-  uint16_t playerCnt = util::Read16BigEnd(rp);
+  if (result == EReconnectResult::Rejected) {
+    std::cerr << "Server no longer holds our session" << std::endl;
+    eventDispatcher->Publish(QuitEvent{});
+    return;
+  }
+  // Every replica follows again
+  if (result == EReconnectResult::Resynced) DropReplicas();
+
+  std::cout << "Session resumed"
+            << (result == EReconnectResult::Resynced ? " with a full resync"
+                                                      : "")
+            << std::endl;
+
+  // The roster is compared once every PLAYER_ROSTER of it arrived
+  bIsResumeRoster = true;
+  rosterRemaining = playerCnt;
+  resumeRoster.clear();
+  ReadRoster(reader, playerCnt);
+}
 
-  for (int i = 0; i < playerCnt; ++i) {
-    clientid_t id = util::Read64BigEnd(rp);
+void ClientNetworkSystem::PlayerRosterHandler(PacketReader& reader) {
+  auto header = reader.ReadHeader<PLAYER_ROSTER>();
+  if (!header || rosterRemaining == 0) return;
+  ReadRoster(reader, std::get<0>(*header));
+}
 
-    const uint8_t nameLen = *rp++;
-    constexpr size_t cap = NAME_MAX_LEN - 1;
+void ClientNetworkSystem::ReadRoster(PacketReader& reader, uint16_t count) {
+  for (uint16_t i = 0;
+       i < count && rosterRemaining > 0 && reader.GetRemaining() > 0; ++i) {
+    // Every roster packet shares the record layout
+    auto record = reader.ReadRecord<PLAYER_ROSTER>();
+    if (!record) {
+      std::cerr << "Malformed player roster" << std::endl;
+      break;
+    }
+    const auto [id, rawName] = *record;
+    --rosterRemaining;
 
-    size_t copyLen = util::utf8_clamp_to_codepoint(rp, nameLen, cap);
-    std::string name(reinterpret_cast<const char*>(rp), copyLen);
+    constexpr size_t cap = NAME_MAX_LEN - 1;
+    size_t copyLen = util::utf8_clamp_to_codepoint(
+        reinterpret_cast<const uint8_t*>(rawName.data()), rawName.size(), cap);
+    std::string name(rawName.data(), copyLen);
 
+    if (bIsResumeRoster) {
+      resumeRoster.emplace(id, std::move(name));
+      continue;
+    }
     std::cout << std::format("Player {}: {}", id, name) << std::endl;
 
-    rp += name.size();
-
     clientNameMap->emplace(id, name);
     commandQueue->Enqueue(std::make_unique<PlayerSpawnCommand>(id, false));
   }
-  if (world->GetLocalPlayer() == INVALID_ENTITY) {
-    clientNameMap->emplace(myClientID, myName);
-    world->GeneratePlayer(myClientID, {0.f, 0.f}, true);
+  if (bIsResumeRoster && rosterRemaining == 0) FinishResume();
+}
+
+void ClientNetworkSystem::FinishResume() {
+  bIsResumeRoster = false;
+
+  // Connects and disconnects broadcast while we were away
+  for (auto it = clientNameMap->begin(); it != clientNameMap->end();) {
+    if (it->first == myClientID || resumeRoster.count(it->first)) {
+      ++it;
+      continue;
+    }
+    commandQueue->Enqueue(
+        std::make_unique<PlayerDisconnectedCommand>(it->first));
+    it = clientNameMap->erase(it);
   }
+  for (auto& [id, name] : resumeRoster) {
+    if (!clientNameMap->emplace(id, name).second) continue;
+    commandQueue->Enqueue(std::make_unique<PlayerSpawnCommand>(id, false));
+  }
+  resumeRoster.clear();
+
+  bIsResuming = false;
+  RequestUdpBind();
+}
+
+void ClientNetworkSystem::RequestUdpBind() {
+  // Ask the server to move gameplay traffic to UDP. Resent by the
+  // connection until acked; nothing changes if UDP never gets through.
+  PacketPtr bind = MakePacket<UDP_BIND>(myClientID, sessionToken);
+  udpConnection->Send(bind.get(),
+                      sPacketHeader + PayloadSize<UDP_BIND>());
+}
+
+void ClientNetworkSystem::OnConnectionLost() {
+  bIsResuming = true;
+
+  // Their COMMAND_ACKs are gone, whatever the server applied comes back
+  // through replication
+  commandPredictor->RejectAll();
+  pendingInputs.Clear();
+
+  // The server starts a fresh UDP peer for the next UDP_BIND
+  udpConnection = std::make_unique<NetConnection>();
+  bIsUdpBound = false;
+  std::vector<uint8_t> stale;
+  while (datagramQueue->TryPop(stale)) {
+  }
+}
+
+void ClientNetworkSystem::Resume() {
+  PacketPtr packet = MakePacket<RECONNECT_SYN>(myClientID, sessionToken,
+                                               replicationVersion);
+  connectionSocket->Send(packet.get(),
+                         sPacketHeader + PayloadSize<RECONNECT_SYN>());
+}
+
+void ClientNetworkSystem::CommandAckHandler(PacketReader& reader) {
+  auto fields = reader.ReadHeader<COMMAND_ACK>();
+  if (!fields) return;
+  const auto [sequence, accepted] = *fields;
+  if (accepted)
+    commandPredictor->Confirm(sequence);
+  else
+    commandPredictor->Reject(sequence);
 }
 
-void ClientNetworkSystem::ChatBroadcastHandler(const uint8_t* rp,
-                                               std::size_t packetSize) {
+void ClientNetworkSystem::ChatBroadcastHandler(PacketReader& reader) {
   std::cout << "CHAT_BROADCAST from server" << std::endl;
-  clientid_t senderClientId = util::Read64BigEnd(rp);
+  auto fields = reader.ReadHeader<CHAT_BROADCAST>();
+  if (!fields) return;
+  const auto [senderClientId, text] = *fields;
 
   if (senderClientId == myClientID) return;
 
   auto iter = clientNameMap->find(senderClientId);
   if (iter != clientNameMap->end()) {
-    eventDispatcher->Publish(NewChatEvent(
-        senderClientId,
-        std::make_shared<std::string>(reinterpret_cast<const char*>(rp),
-                                      packetSize - sHeaderAndId)));
+    eventDispatcher->Publish(
+        NewChatEvent(senderClientId, std::make_shared<std::string>(text)));
   }
 }
 
@@ -113,20 +297,25 @@ inline double NowSeconds() {
   using clock = std::chrono::steady_clock;
   return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
 }
+
+// A predicted building hands over to the replica spawned on its tile
+inline uint64_t StandInKey(Vec2 tileIndex) {
+  return PackChunkKey(tileIndex.x, tileIndex.y);
+}
 }  // namespace
 
 // Push all snapshots (including local) into buffers. Do not write Transform
 // here
-void ClientNetworkSystem::TransformSnapshotHandler(const uint8_t* rp,
-                                                   std::size_t /*packetSize*/) {
-  const uint16_t count = util::Read16BigEnd(rp);
-  const double now = NowSeconds();
+void ClientNetworkSystem::TransformSnapshotHandler(PacketReader& reader) {
+  auto header = reader.ReadHeader<TRANSFORM_SNAPSHOT>();
+  if (!header) return;
+  const auto [serverTick, count] = *header;
+  snapshotClock.OnSnapshot(serverTick, NowSeconds());
 
   for (uint16_t i = 0; i < count; ++i) {
-    clientid_t id = util::Read64BigEnd(rp);
-    float posX = util::ReadF32BigEnd(rp);
-    float posY = util::ReadF32BigEnd(rp);
-    uint8_t facing = *rp++;
+    auto record = reader.ReadRecord<TRANSFORM_SNAPSHOT>();
+    if (!record) return;
+    const auto [id, posX, posY, facing] = *record;
 
     EntityID e = world->GetPlayerByClientID(id);
     if (e == INVALID_ENTITY) continue;
@@ -134,136 +323,315 @@ void ClientNetworkSystem::TransformSnapshotHandler(const uint8_t* rp,
     if (!registry->HasComponent<InterpBufferComponent>(e)) {
       registry->EmplaceComponent<InterpBufferComponent>(e);
     }
-    auto& buf = registry->GetComponent<InterpBufferComponent>(e);
+    // Stamped with the server tick, arrival bunching does not reach here
+    util::PushInterpSample(registry->GetComponent<InterpBufferComponent>(e),
+                           serverTick, posX, posY, facing);
+  }
+}
+
+TileCollisionCache ClientNetworkSystem::MakeCollisionCache() {
+  return TileCollisionCache(registry, [this](int chunkX, int chunkY) {
+    return world->GetActiveChunk(chunkX, chunkY);
+  });
+}
+
+void ClientNetworkSystem::ClientMoveResHandler(PacketReader& reader) {
+  auto fields = reader.ReadHeader<CLIENT_MOVE_RES>();
+  if (!fields) return;
+  const auto [lastAckedSeq, serverX, serverY] = *fields;
+
+  EntityID me = world->GetLocalPlayer();
+  if (me == INVALID_ENTITY) return;
+
+  auto& pred = registry->GetComponent<NetPredictionComponent>(me);
+  const auto& move = registry->GetComponent<MovementComponent>(me);
+
+  // Drop acknowledged inputs, then check the acked one for misprediction
+  const PredictedInput* acked = pendingInputs.Ack(lastAckedSeq);
+  if (acked == nullptr) return;
+  const float error =
+      std::hypot(acked->predX - serverX, acked->predY - serverY);
+  if (error <= 0.1f) return;
+
+  // Rewind to the server's state and replay the inputs it has not seen yet
+  TileCollisionCache collision = MakeCollisionCache();
+  const Vec2f replayed =
+      pendingInputs.Replay({serverX, serverY}, move.speed, collision);
+  pred.predictedX = replayed.x;
+  pred.predictedY = replayed.y;
+}
+
+// Players outside of our area of interest stop receiving snapshots, so hide
+// them instead of leaving them frozen at their last known position.
+void ClientNetworkSystem::InterestChangeHandler(PacketReader& reader,
+                                                bool bEntered) {
+  auto header = reader.ReadHeader<INTEREST_ENTER>();
+  if (!header) return;
+  const auto [count] = *header;
+
+  for (uint16_t i = 0; i < count; ++i) {
+    auto record = reader.ReadRecord<INTEREST_ENTER>();
+    if (!record) return;
+    const auto [id] = *record;
+    if (id == myClientID) continue;
 
-    const uint8_t writeIdx =
-        static_cast<uint8_t>((buf.tail + buf.count) % InterpBufferComponent::N);
-    buf.samples[writeIdx] = {now, posX, posY, facing};
-    if (buf.count < InterpBufferComponent::N) {
-      ++buf.count;
+    EntityID e = world->GetPlayerByClientID(id);
+    if (e == INVALID_ENTITY) continue;
+
+    // Stale samples would interpolate across the gap
+    if (registry->HasComponent<InterpBufferComponent>(e)) {
+      util::ResetInterpBuffer(
+          registry->GetComponent<InterpBufferComponent>(e));
+    }
+
+    if (bEntered) {
+      if (registry->HasComponent<InactiveComponent>(e))
+        registry->RemoveComponent<InactiveComponent>(e);
     } else {
-      buf.tail =
-          static_cast<uint8_t>((buf.tail + 1) % InterpBufferComponent::N);
+      if (!registry->HasComponent<InactiveComponent>(e))
+        registry->EmplaceComponent<InactiveComponent>(e);
     }
   }
 }
 
-static bool SampleBufferAt(const InterpBufferComponent& buf, double targetT,
-                           float& outX, float& outY, uint8_t& outFacing) {
-  if (buf.count == 0) return false;
+void ClientNetworkSystem::ChunkUnloadHandler(PacketReader& reader) {
+  auto header = reader.ReadHeader<CHUNK_UNLOAD>();
+  if (!header) return;
+  const auto [count] = *header;
 
-  // Find s0 (<= target) and s1 (>= target)
-  InterpBufferComponent::Sample s0 = buf.samples[buf.tail];
-  InterpBufferComponent::Sample s1 = s0;
-  bool found = false;
+  for (uint16_t i = 0; i < count; ++i) {
+    auto record = reader.ReadRecord<CHUNK_UNLOAD>();
+    if (!record) {
+      std::cerr << "Malformed CHUNK_UNLOAD" << std::endl;
+      return;
+    }
+    const auto [chunkX, chunkY] = *record;
+    world->DropChunk({chunkX, chunkY});
+  }
+}
 
-  for (uint8_t i = 0; i < buf.count; ++i) {
-    const auto& s = buf.samples[(buf.tail + i) % InterpBufferComponent::N];
-    if (s.t >= targetT) {
-      s1 = s;
-      if (i > 0)
-        s0 = buf.samples[(buf.tail + i - 1) % InterpBufferComponent::N];
-      found = true;
-      break;
+void ClientNetworkSystem::ReplicationHandler(PacketReader& reader) {
+  // Spawn, despawn and update share the count header
+  auto header = reader.ReadHeader<COMPONENT_UPDATE>();
+  if (!header) return;
+  const auto [count] = *header;
+
+  const PACKET packetId = reader.GetPacketId();
+  for (uint16_t i = 0; i < count; ++i) {
+    if (!ApplyReplicationRecord(packetId, reader.Cursor(), reader.End())) {
+      std::cerr << "Malformed replication packet " << packetId << std::endl;
+      return;
     }
-    s0 = s;
   }
+}
 
-  if (!found) {
-    const auto& newest =
-        buf.samples[(buf.tail + buf.count - 1) % InterpBufferComponent::N];
-    outX = newest.x;
-    outY = newest.y;
-    outFacing = newest.facing;
-    return true;
+// Applies one spawn/despawn/update entry, or stashes it until the chunk it
+// belongs to becomes active. Later records of a stashed entity are stashed
+// behind it so they replay in order.
+bool ClientNetworkSystem::ApplyReplicationRecord(PACKET packetId,
+                                                 const uint8_t*& rp,
+                                                 const uint8_t* end) {
+  const uint8_t* recordStart = rp;
+  if (end - rp < static_cast<std::ptrdiff_t>(sizeof(netid_t))) return false;
+  const netid_t netID = util::Read32BigEnd(rp);
+
+  uint8_t archetype = 0;
+  Vec2 tileIndex;
+  bool bIsKnown = true;
+
+  if (packetId == ENTITY_SPAWN) {
+    if (end - rp < static_cast<std::ptrdiff_t>(sizeof(uint8_t) +
+                                                sizeof(int32_t) * 2))
+      return false;
+    archetype = *rp++;
+    tileIndex.x = static_cast<int32_t>(util::Read32BigEnd(rp));
+    tileIndex.y = static_cast<int32_t>(util::Read32BigEnd(rp));
+  } else if (IsStaticNetID(netID)) {
+    tileIndex = GetStaticNetIDTile(netID);
+    // Without the chunk there is nothing to update, the chunk brings the
+    // current state when it is streamed
+    bIsKnown = static_cast<bool>(world->GetTileAtTileIndex(tileIndex));
+  } else {
+    auto it = replicas.find(netID);
+    if (it != replicas.end())
+      tileIndex = it->second.tileIndex;
+    else
+      bIsKnown = deferredNetIDs.count(netID) != 0;
+  }
+
+  auto deferIt = deferredNetIDs.find(netID);
+  const bool bDefer =
+      bIsKnown && (deferIt != deferredNetIDs.end() ||
+                   !world->GetTileAtTileIndex(tileIndex));
+
+  EntityID entity = INVALID_ENTITY;
+  if (bIsKnown && !bDefer) {
+    if (packetId == ENTITY_SPAWN) {
+      entity = SpawnReplica(netID, archetype, tileIndex);
+    } else if (IsStaticNetID(netID)) {
+      entity = world->GetTileAtTileIndex(tileIndex).GetOreEntity();
+    } else {
+      entity = replicas[netID].entity;
+    }
   }
 
-  if (s1.t <= s0.t + 1e-6) {
-    outX = s1.x;
-    outY = s1.y;
-    outFacing = s1.facing;
+  if (packetId != ENTITY_DESPAWN) {
+    if (!ComponentReplicator::instance().Read(registry, entity, rp, end))
+      return false;
+    // Pending commands go back on top of the server's state, and a rollback
+    // must not bring back what was there before
+    if (entity != INVALID_ENTITY) commandPredictor->Rebase(entity);
+  }
+
+  if (bDefer) {
+    uint64_t key;
+    if (deferIt != deferredNetIDs.end()) {
+      key = deferIt->second;
+    } else {
+      key = PackChunkKey(
+          static_cast<int>(std::floor(static_cast<float>(tileIndex.x) /
+                                      CHUNK_WIDTH)),
+          static_cast<int>(std::floor(static_cast<float>(tileIndex.y) /
+                                      CHUNK_HEIGHT)));
+      deferredNetIDs[netID] = key;
+    }
+    DeferredChunk& chunk = deferredChunks[key];
+    if (chunk.records.empty()) chunk.tileIndex = tileIndex;
+    chunk.records.push_back(
+        DeferredRecord{packetId, std::vector<uint8_t>(recordStart, rp)});
     return true;
   }
 
-  const double a = (targetT - s0.t) / (s1.t - s0.t);
-  outX = static_cast<float>(s0.x + (s1.x - s0.x) * a);
-  outY = static_cast<float>(s0.y + (s1.y - s0.y) * a);
-  outFacing = s1.facing;
+  if (packetId == ENTITY_DESPAWN && bIsKnown) DespawnReplica(netID);
   return true;
 }
 
-static void ApplyPrediction(NetPredictionComponent& pred,
-                            const MovementComponent& move, World* world,
-                            uint8_t inputBit, float deltaTime) {
-  int ix = 0, iy = 0;
-  if (inputBit & static_cast<uint8_t>(EPlayerInput::RIGHT)) ix++;
-  if (inputBit & static_cast<uint8_t>(EPlayerInput::LEFT)) ix--;
-  if (inputBit & static_cast<uint8_t>(EPlayerInput::UP)) iy++;
-  if (inputBit & static_cast<uint8_t>(EPlayerInput::DOWN)) iy--;
-
-  if (ix != 0 || iy != 0) {
-    float len = std::sqrt(static_cast<float>(ix * ix + iy * iy));
-    float nx = ix / len, ny = iy / len;
-    float stepX = nx * move.speed * deltaTime;
-    float stepY = ny * move.speed * deltaTime;
-
-    // lightweight client collision to reduce obvious tunneling
-    Vec2f tryPos{pred.predictedX + stepX, pred.predictedY + stepY};
-    if (world->IsTilePassable(tryPos)) {
-      pred.predictedX = tryPos.x;
-      pred.predictedY = tryPos.y;
-    } else {
-      // axis-separated fallback
-      Vec2f tryX{pred.predictedX + stepX, pred.predictedY};
-      if (world->IsTilePassable(tryX)) pred.predictedX = tryX.x;
-      Vec2f tryY{pred.predictedX, pred.predictedY + stepY};
-      if (world->IsTilePassable(tryY)) pred.predictedY = tryY.y;
-    }
+EntityID ClientNetworkSystem::SpawnReplica(netid_t netID, uint8_t archetype,
+                                           Vec2 tileIndex) {
+  // Spawn may be resent after a reconnect
+  auto it = replicas.find(netID);
+  if (it != replicas.end()) return it->second.entity;
+
+  EntityID entity = INVALID_ENTITY;
+  switch (static_cast<ENetArchetype>(archetype)) {
+    case ENetArchetype::AssemblingMachine:
+      entity = factory->CreateAssemblingMachine(world, tileIndex, true);
+      break;
+    case ENetArchetype::MiningDrill:
+      entity = factory->CreateMiningDrill(world, tileIndex, true);
+      break;
+    default:
+      break;
+  }
+  if (entity == INVALID_ENTITY) {
+    std::cerr << "Failed to spawn replicated entity " << netID << std::endl;
+    return INVALID_ENTITY;
   }
+
+  registry->AddComponent<NetIdentityComponent>(
+      entity, NetIdentityComponent{netID, false});
+  replicas[netID] = ReplicaRef{entity, tileIndex};
+  // Destroyed only now, the replica already took over its tiles
+  commandPredictor->HandOver(StandInKey(tileIndex));
+  return entity;
 }
 
-void ClientNetworkSystem::ClientMoveResHandler(const uint8_t* rp,
-                                               std::size_t packetSize) {
-  uint16_t lastAckedSeq = util::Read16BigEnd(rp);
-  float serverX = util::ReadF32BigEnd(rp);
-  float serverY = util::ReadF32BigEnd(rp);
+void ClientNetworkSystem::DespawnReplica(netid_t netID) {
+  auto it = replicas.find(netID);
+  if (it == replicas.end()) return;
+  const EntityID entity = it->second.entity;
+  replicas.erase(it);
+  DestroyBuilding(entity);
+}
 
-  EntityID me = world->GetLocalPlayer();
-  if (me == INVALID_ENTITY) return;
+void ClientNetworkSystem::DropReplicas() {
+  for (auto& [netID, replica] : replicas) DestroyBuilding(replica.entity);
+  commandPredictor->DropStandIns();
+  replicas.clear();
+  deferredChunks.clear();
+  deferredNetIDs.clear();
+}
 
-  auto& pred = registry->GetComponent<NetPredictionComponent>(me);
-  const auto& move = registry->GetComponent<MovementComponent>(me);
+void ClientNetworkSystem::DestroyBuilding(EntityID entity) {
+  if (registry->HasComponent<BuildingComponent>(entity)) {
+    const auto& building = registry->GetComponent<BuildingComponent>(entity);
+    world->RemoveBuilding(entity, building.occupiedTiles);
+  }
+  registry->DestroyEntity(entity);
+}
 
-  // Remove acknowledged inputs from the pending list.
-  auto it = pendingInputQueue.begin();
-  while (it != pendingInputQueue.end()) {
-    if (util::seq_leq(it->sequence, lastAckedSeq)) {
-      // This input is acknowledged. Check for misprediction.
-      if (it->sequence == lastAckedSeq) {
-        float error = std::hypot(it->predX - serverX, it->predY - serverY);
-        if (error > 0.1f) {  // Misprediction detected!
-          // Rewind: Set the base of our prediction to the server's state.
-          pred.predictedX = serverX;
-          pred.predictedY = serverY;
-
-          // Replay: Re-apply all inputs that came after the acknowledged one.
-          for (auto replay_it = std::next(it);
-               replay_it != pendingInputQueue.end(); ++replay_it) {
-            ApplyPrediction(pred, move, world, replay_it->inputBit,
-                            replay_it->deltaTime);
-            // Update the history with the new re-predicted position.
-            replay_it->predX = pred.predictedX;
-            replay_it->predY = pred.predictedY;
-          }
-        }
-      }
-      it = pendingInputQueue.erase(it);
-    } else {
-      ++it;
+void ClientNetworkSystem::RetryDeferredRecords() {
+  std::vector<uint64_t> readyChunks;
+  for (auto& [key, chunk] : deferredChunks) {
+    if (world->GetTileAtTileIndex(chunk.tileIndex))
+      readyChunks.push_back(key);
+  }
+
+  for (uint64_t key : readyChunks) {
+    std::vector<DeferredRecord> records =
+        std::move(deferredChunks[key].records);
+    deferredChunks.erase(key);
+    for (auto it = deferredNetIDs.begin(); it != deferredNetIDs.end();) {
+      if (it->second == key)
+        it = deferredNetIDs.erase(it);
+      else
+        ++it;
+    }
+
+    for (const DeferredRecord& record : records) {
+      const uint8_t* rp = record.bytes.data();
+      ApplyReplicationRecord(record.type, rp,
+                             record.bytes.data() + record.bytes.size());
     }
   }
 }
 
+void ClientNetworkSystem::SendBuildRequest(EntityID player, ItemID item,
+                                           Vec2 tileIndex) {
+  const uint16_t sequence = commandPredictor->Predict(
+      [this, player, item, tileIndex](PredictionScope& scope) {
+        // Stand-in until the server's building arrives as ENTITY_SPAWN,
+        // which may be well after COMMAND_ACK
+        EntityID building = INVALID_ENTITY;
+        if (item == ItemID::AssemblingMachine) {
+          building =
+              factory->CreateAssemblingMachine(world, tileIndex, false, player);
+        } else if (item == ItemID::MiningDrill) {
+          building =
+              factory->CreateMiningDrill(world, tileIndex, false, player);
+        }
+        if (building == INVALID_ENTITY) return;
+        scope.TrackCreated(building, StandInKey(tileIndex));
+
+        if (scope.Get<InventoryComponent>(player)) {
+          InventoryCommand(player, item, -1)
+              .Execute(registry, eventDispatcher, world);
+        }
+      });
+
+  sendQueue->Push(MakePacket<BUILD_REQ>(
+      sequence, static_cast<uint8_t>(item), tileIndex.x, tileIndex.y));
+}
+
+void ClientNetworkSystem::SendInteractRequest(
+    EntityID target, ENetInteraction action, uint8_t id, int amount,
+    std::function<void(PredictionScope&)> predict) {
+  // Only server-owned entities, local inventories stay local
+  if (!registry->HasComponent<NetIdentityComponent>(target)) return;
+  if (amount < 0) return;
+
+  const uint16_t sequence = commandPredictor->Predict(std::move(predict));
+  sendQueue->Push(MakePacket<ENTITY_INTERACT_REQ>(
+      sequence, registry->GetComponent<NetIdentityComponent>(target).netID,
+      static_cast<uint8_t>(action), id,
+      static_cast<uint16_t>(std::min(amount, static_cast<int>(UINT16_MAX))),
+      GetViewTick()));
+}
+
+uint32_t ClientNetworkSystem::GetViewTick() const {
+  return static_cast<uint32_t>(snapshotClock.GetRenderTick(NowSeconds()));
+}
+
 // Local prediction writes to NetPredictionComponent.predicted*, not Transform
 void ClientNetworkSystem::SendMoveRequest(float deltaTime) {
   EntityID localPlayer = world->GetLocalPlayer();
@@ -315,25 +683,44 @@ void ClientNetworkSystem::SendMoveRequest(float deltaTime) {
   }
 
   // Apply prediction for this tick
-  ApplyPrediction(pred, move, world, inputBit, deltaTime);
+  TileCollisionCache collision = MakeCollisionCache();
+  Vec2f predicted{pred.predictedX, pred.predictedY};
+  PredictMove(predicted, move.speed, inputBit, deltaTime, collision);
+  pred.predictedX = predicted.x;
+  pred.predictedY = predicted.y;
 
   // Every tick, generate a sequence number and an input command.
   inputSequenceNumber++;
 
   // Store input and the result for reconciliation
-  pendingInputQueue.push_back({inputSequenceNumber, inputBit, pred.predictedX,
-                               pred.predictedY, deltaTime});
-
-  // Send the input to the server
-  const std::size_t payloadSize = sizeof(uint16_t) + sizeof(uint8_t);
-  const std::size_t packetSize = sPacketHeader + payloadSize;
-
-  PacketPtr pkt = std::make_unique<uint8_t[]>(packetSize);
-  uint8_t* p = pkt.get();
-  util::WriteHeader(p, PACKET::CLIENT_MOVE_REQ, packetSize);
-  util::Write16BigEnd(p, inputSequenceNumber);
-  *p++ = inputBit;
-  sendQueue->Push(std::move(pkt));
+  pendingInputs.Push({inputSequenceNumber, inputBit, pred.predictedX,
+                      pred.predictedY, deltaTime});
+
+  // An unchanged input can wait for the batch, the server moves a remote
+  // player only on the inputs it received
+  ++ticksSinceMoveSend;
+  if (inputBit == lastSentInputBit && ticksSinceMoveSend < kMoveBatchTicks)
+    return;
+  ticksSinceMoveSend = 0;
+  lastSentInputBit = inputBit;
+
+  // Send the newest unacknowledged inputs to the server
+  const uint8_t inputCnt = static_cast<uint8_t>(
+      std::min<std::size_t>(pendingInputs.GetSize(), kMaxMoveBatch));
+  const std::size_t packedSize = (inputCnt + 1) / 2;
+
+  PacketWriter writer(CLIENT_MOVE_REQ,
+                      PayloadSize<CLIENT_MOVE_REQ>() + packedSize);
+  writer.WriteHeader<CLIENT_MOVE_REQ>(inputSequenceNumber, inputCnt);
+  uint8_t*& p = writer.Cursor();
+  std::memset(p, 0, packedSize);
+
+  for (uint8_t i = 0; i < inputCnt; ++i) {
+    const PredictedInput& input = pendingInputs.FromNewest(inputCnt - 1 - i);
+    util::WriteInputNibble(p, i, input.inputBit);
+  }
+  p += packedSize;
+  sendQueue->Push(writer.Finish());
 }
 
 // Smoothly interpolates the visual transform to the corrected predicted
@@ -353,12 +740,13 @@ void ClientNetworkSystem::ApplyLocalSmoothing(float deltaTime) {
       util::Lerp(trans.position.x, pred.predictedX, kCatchUpSpeed * deltaTime);
   trans.position.y =
       util::Lerp(trans.position.y, pred.predictedY, kCatchUpSpeed * deltaTime);
+  trans.bIsDirty = true;
 }
 
 // Remote interpolation for non-local players
 void ClientNetworkSystem::ApplyRemoteInterpolation() {
-  const double now = NowSeconds();
-  constexpr double kDelay = 0.10;  // 100 ms, also adjustable constant
+  if (!snapshotClock.IsSynced()) return;
+  const double renderTick = snapshotClock.GetRenderTick(NowSeconds());
 
   for (EntityID e :
        registry->view<InterpBufferComponent, TransformComponent>()) {
@@ -369,7 +757,7 @@ void ClientNetworkSystem::ApplyRemoteInterpolation() {
     auto& trans = registry->GetComponent<TransformComponent>(e);
     float x, y;
     uint8_t f;
-    if (!SampleBufferAt(buf, now - kDelay, x, y, f)) continue;
+    if (!util::SampleInterpBuffer(buf, renderTick, x, y, f)) continue;
     if (registry->HasComponent<AnimationComponent>(e)) {
       auto& anim = registry->GetComponent<AnimationComponent>(e);
       auto& psc = registry->GetComponent<PlayerStateComponent>(e);
@@ -382,6 +770,7 @@ void ClientNetworkSystem::ApplyRemoteInterpolation() {
     }
     trans.position.x = x;
     trans.position.y = y;
+    trans.bIsDirty = true;
 
     if (registry->HasComponent<SpriteComponent>(e)) {
       auto& spr = registry->GetComponent<SpriteComponent>(e);
@@ -390,49 +779,94 @@ void ClientNetworkSystem::ApplyRemoteInterpolation() {
   }
 }
 
-void ClientNetworkSystem::Update(float deltaTime) {
-  // 1) Drain incoming first
-  PacketPtr packet;
-  while (recvQueue->TryPop(packet)) {
-    const uint8_t* rp = packet.get();
-    std::size_t packetSize;
-    PACKET packetId;
-    util::GetHeader(rp, packetId, packetSize);
-    switch (packetId) {
-      case CONNECT_ACK:
-        ConnectAckHandler(rp, packetSize);
-        break;
-      case CHAT_BROADCAST:
-        ChatBroadcastHandler(rp, packetSize);
-        break;
-      case TRANSFORM_SNAPSHOT:
-        TransformSnapshotHandler(rp, packetSize);
-        break;
-      case CLIENT_MOVE_RES:
-        ClientMoveResHandler(rp, packetSize);
-        break;
-      case PLAYER_DISCONNECTED_BROADCAST: {
-        clientid_t disconnectedId = util::Read64BigEnd(rp);
-        std::cout << "PLAYER_DISCONNECTED_BROADCAST from server, id: "
-                  << disconnectedId << std::endl;
-
-        auto iter = clientNameMap->find(disconnectedId);
-        if (iter != clientNameMap->end()) {
-          clientNameMap->erase(iter);
-          commandQueue->Enqueue(
-              std::make_unique<PlayerDisconnectedCommand>(disconnectedId));
-        }
-        break;
+void ClientNetworkSystem::HandlePacket(const uint8_t* packet) {
+  PacketReader reader(packet);
+  if (!reader.IsOk()) return;
+  switch (reader.GetPacketId()) {
+    case CONNECT_ACK:
+      ConnectAckHandler(reader);
+      break;
+    case RECONNECT_ACK:
+      ReconnectAckHandler(reader);
+      break;
+    case PLAYER_ROSTER:
+      PlayerRosterHandler(reader);
+      break;
+    case REPLICATION_SYNC: {
+      auto fields = reader.ReadHeader<REPLICATION_SYNC>();
+      if (fields) replicationVersion = std::get<0>(*fields);
+      break;
+    }
+    case COMMAND_ACK:
+      CommandAckHandler(reader);
+      break;
+    case CHAT_BROADCAST:
+      ChatBroadcastHandler(reader);
+      break;
+    case TRANSFORM_SNAPSHOT:
+      TransformSnapshotHandler(reader);
+      break;
+    case CLIENT_MOVE_RES:
+      ClientMoveResHandler(reader);
+      break;
+    case INTEREST_ENTER:
+      InterestChangeHandler(reader, true);
+      break;
+    case INTEREST_LEAVE:
+      InterestChangeHandler(reader, false);
+      break;
+    case ENTITY_SPAWN:
+    case ENTITY_DESPAWN:
+    case COMPONENT_UPDATE:
+      ReplicationHandler(reader);
+      break;
+    case CHUNK_DATA:
+      if (!world->ApplyChunkData(reader))
+        std::cerr << "Malformed CHUNK_DATA" << std::endl;
+      break;
+    case CHUNK_UNLOAD:
+      ChunkUnloadHandler(reader);
+      break;
+    case UDP_BIND_ACK:
+      std::cout << "Gameplay traffic switched to UDP" << std::endl;
+      bIsUdpBound = true;
+      break;
+    case PLAYER_DISCONNECTED_BROADCAST: {
+      auto fields = reader.ReadHeader<PLAYER_DISCONNECTED_BROADCAST>();
+      if (!fields) break;
+      const auto [disconnectedId] = *fields;
+      std::cout << "PLAYER_DISCONNECTED_BROADCAST from server, id: "
+                << disconnectedId << std::endl;
+
+      auto iter = clientNameMap->find(disconnectedId);
+      if (iter != clientNameMap->end()) {
+        clientNameMap->erase(iter);
+        commandQueue->Enqueue(
+            std::make_unique<PlayerDisconnectedCommand>(disconnectedId));
       }
-      default:
-        break;
+      break;
     }
+    default:
+      break;
   }
+}
+
+void ClientNetworkSystem::Update(float deltaTime) {
+  // 1) Drain incoming first
+  PacketPtr packet;
+  while (recvQueue->TryPop(packet)) HandlePacket(packet.get());
+
+  ReceiveDatagrams();
+
+  RetryDeferredRecords();
 
   // 2) Apply smoothing
   ApplyRemoteInterpolation();
   ApplyLocalSmoothing(deltaTime);
 
+  // Nothing leaves until the server hands the session back
+  if (bIsResuming) return;
+
   // 3) Fixed-rate send + local prediction
   moveReqTimer += deltaTime;
   while (moveReqTimer >= syncDelta) {
@@ -442,23 +876,52 @@ void ClientNetworkSystem::Update(float deltaTime) {
 
   // 4) Flush outgoing
   while (sendQueue->TryPop(packet)) {
+    if (packet == nullptr) continue;
     const uint8_t* rp = packet.get();
     std::size_t packetSize;
     PACKET packetId;
     util::GetHeader(rp, packetId, packetSize);
+    // Never split the reliable stream across both sockets, NetConnection
+    // fragments what does not fit in a datagram
+    if (bIsUdpBound && !IsHandshakePacket(packetId)) {
+      udpConnection->Send(packet.get(), packetSize);
+      continue;
+    }
     connectionSocket->Send(packet.get(), packetSize);
   }
+  SendDatagrams();
 }
 
-void ClientNetworkSystem::SendMessage(std::shared_ptr<std::string> message) {
-  PacketPtr packet =
-      std::make_unique<uint8_t[]>(sPacketHeader + message->size());
+void ClientNetworkSystem::ReceiveDatagrams() {
+  const double now = NowSeconds();
+  std::vector<uint8_t> datagram;
+  while (datagramQueue->TryPop(datagram)) {
+    if (!udpConnection->Receive(datagram.data(), datagram.size(), now))
+      std::cerr << "Malformed datagram from server" << std::endl;
+  }
+
+  PacketPtr packet;
+  while (udpConnection->Next(packet)) HandlePacket(packet.get());
+}
 
-  uint8_t* p = packet.get();
-  util::WriteHeader(p, PACKET::CHAT_CLIENT, sPacketHeader + message->size());
+void ClientNetworkSystem::SendDatagrams() {
+  if (!bIsUdpAvailable) return;
+
+  std::vector<std::vector<uint8_t>> datagrams;
+  udpConnection->Flush(NowSeconds(), datagrams);
+  for (const auto& datagram : datagrams) {
+    if (connectionSocket->SendDatagram(datagram.data(), datagram.size()) < 0) {
+      // No UDP on this platform or network, stay on TCP
+      std::cerr << "UDP unavailable, using TCP only" << std::endl;
+      bIsUdpAvailable = false;
+      bIsUdpBound = false;
+      return;
+    }
+  }
+}
 
-  std::memcpy(p, message->c_str(), message->size());
-  sendQueue->Push(std::move(packet));
+void ClientNetworkSystem::SendMessage(std::shared_ptr<std::string> message) {
+  sendQueue->Push(MakePacket<CHAT_CLIENT>(*message));
 }
 
 ClientNetworkSystem::~ClientNetworkSystem() = default;
\ No newline at end of file
@@ -67,15 +67,15 @@ void InteractionSystem::OnPlayerInteractEvent(
     return;
   }
 
-  TileData *tile = world->GetTileAtWorldPosition(event.target);
+  TileRef tile = world->GetTileAtWorldPosition(event.target);
   if (!tile) return;
 
   // Target occupying entity first
-  EntityID targetEntity = tile->occupyingEntity;
+  EntityID targetEntity = tile.GetOccupyingEntity();
 
   // Target Ore if there's no entity
-  if (targetEntity == INVALID_ENTITY && tile->oreEntity != INVALID_ENTITY) {
-    targetEntity = tile->oreEntity;
+  if (targetEntity == INVALID_ENTITY) {
+    targetEntity = tile.GetOreEntity();
   }
 
   if (!registry->HasComponent<PlayerStateComponent>(localPlayer)) return;
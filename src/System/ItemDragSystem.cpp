@@ -27,6 +27,7 @@ ItemDragSystem::ItemDragSystem(const SystemContext &context)
       inputManager(context.inputManager),
       eventDispatcher(context.eventDispatcher),
       factory(context.entityFactory),
+      bIsServer(context.bIsServer),
       bIsPreviewingBuilding(false),
       bIsBuildingPlaced(false),
       previewEntity(INVALID_ENTITY),
@@ -85,6 +86,7 @@ void ItemDragSystem::UpdatePreviewEntity() {
 
   auto &transform = registry->GetComponent<TransformComponent>(previewEntity);
   transform.position = snapWorldPos;
+  transform.bIsDirty = true;
 }
 
 void ItemDragSystem::CreatePreviewEntity(ItemID itemID) {
@@ -143,19 +145,34 @@ void ItemDragSystem::ItemDropEventHandler(const ItemDropInWorldEvent &event) {
 
     Vec2f snapWorldPos = (tileIndex * TILE_PIXEL_SIZE);
 
-    EntityID newBuilding = INVALID_ENTITY;
-    if (event.payload.id == ItemID::AssemblingMachine) {
-      if (world->HasNoOcuupyingEntity(tileIndex, 2, 2)) {
-        newBuilding = factory->CreateAssemblingMachine(world, snapWorldPos);
+    // TODO : move this into itemDB
+    const int size = event.payload.id == ItemID::AssemblingMachine ? 2 : 1;
+
+    if (!bIsServer) {
+      // Buildings are server owned, the placed entity arrives as ENTITY_SPAWN
+      if (world->HasNoOcuupyingEntity(tileIndex, size, size, player)) {
+        eventDispatcher->Publish(
+            BuildRequestEvent{player, event.payload.id, tileIndex});
       }
-    } else if (event.payload.id == ItemID::MiningDrill) {
-      if (world->HasNoOcuupyingEntity(tileIndex, 1, 1)) {
-        newBuilding = factory->CreateMiningDrill(world, snapWorldPos);
+    } else {
+      EntityID newBuilding = INVALID_ENTITY;
+      if (event.payload.id == ItemID::AssemblingMachine) {
+        if (world->HasNoOcuupyingEntity(tileIndex, 2, 2, player)) {
+          newBuilding =
+              factory->CreateAssemblingMachine(world, snapWorldPos, player);
+        }
+      } else if (event.payload.id == ItemID::MiningDrill) {
+        if (world->HasNoOcuupyingEntity(tileIndex, 1, 1, player)) {
+          newBuilding = factory->CreateMiningDrill(world, snapWorldPos, player);
+        }
       }
-    }
 
-    if (newBuilding != INVALID_ENTITY) {
-      eventDispatcher->Publish(ItemConsumeEvent{player, event.payload.id, 1});
+      if (newBuilding != INVALID_ENTITY) {
+        eventDispatcher->Publish(
+            BuildingPlacedEvent{newBuilding, event.payload.id, tileIndex});
+        eventDispatcher->Publish(
+            ItemConsumeEvent{player, event.payload.id, 1});
+      }
     }
 
     DestroyPreviewEntity();
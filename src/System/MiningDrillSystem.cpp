@@ -1,22 +1,37 @@
 #include "System/MiningDrillSystem.h"
 
+#include <algorithm>
+
 #include "Components/AnimationComponent.h"
+#include "Components/FrozenComponent.h"
+#include "Components/InactiveComponent.h"
 #include "Components/InventoryComponent.h"
 #include "Components/MiningDrillComponent.h"
 #include "Components/ResourceNodeComponent.h"
 #include "Components/TransformComponent.h"
 #include "Core/Entity.h"
+#include "Core/Event.h"
+#include "Core/EventDispatcher.h"
 #include "Core/Item.h"
+#include "Core/ProductionModel.h"
 #include "Core/Registry.h"
 #include "Core/TimerManager.h"
 #include "Core/World.h"
 #include "Util/AnimUtil.h"
+#include "Util/ReplicationUtil.h"
 #include "Util/TimerUtil.h"
 
+namespace {
+// Seconds per ore mined
+constexpr float kMinePeriod = 1.f;
+}  // namespace
+
 MiningDrillSystem::MiningDrillSystem(const SystemContext& context)
     : registry(context.registry),
       world(context.world),
-      timerManager(context.timerManager) {}
+      eventDispatcher(context.eventDispatcher),
+      timerManager(context.timerManager),
+      bIsServer(context.bIsServer) {}
 
 void MiningDrillSystem::Update() {
   for (auto& entity : registry->view<MiningDrillComponent, InventoryComponent,
@@ -24,6 +39,21 @@ void MiningDrillSystem::Update() {
     auto& drill = registry->GetComponent<MiningDrillComponent>(entity);
     auto& inv = registry->GetComponent<InventoryComponent>(entity);
 
+    // Clients mirror the server's drill state, only animate it
+    if (!bIsServer) {
+      UpdateAnimationState(drill, entity);
+      continue;
+    }
+
+    // Off-screen drills are settled in bulk instead of ticked
+    if ((registry->HasComponent<InactiveComponent>(entity) ||
+         registry->HasComponent<FrozenComponent>(entity)) &&
+        !UpdateFrozen(drill, entity))
+      continue;
+
+    const MiningDrillState prevState = drill.state;
+    const bool bWasAnimating = drill.bIsAnimating;
+
     switch (drill.state) {
       // Initial State
       case MiningDrillState::Idle: {
@@ -43,8 +73,13 @@ void MiningDrillSystem::Update() {
                            .get(inv.items[0].first)
                            .maxStackSize <= inv.items[0].second) {
           drill.state = MiningDrillState::OutputFull;
-        } else
+        } else {
+          // Restored from a save without its timer
+          if (!util::HasTimer(registry, entity, TimerId::Mine))
+            util::AttachTimer(registry, timerManager, entity, TimerId::Mine,
+                              kMinePeriod, true);
           continue;  // continue mining
+        }
 
         util::DetachTimer(registry, timerManager, entity, TimerId::Mine);
         drill.bIsAnimating = false;
@@ -73,6 +108,12 @@ void MiningDrillSystem::Update() {
       }
     }
 
+    if (drill.state != prevState || drill.bIsAnimating != bWasAnimating)
+      util::MarkReplicationDirty(registry, entity,
+                                 EReplicatedComponent::MiningDrill);
+    if (drill.state == MiningDrillState::TileEmpty && prevState != drill.state)
+      ExhaustTile(entity);
+
     UpdateAnimationState(drill, entity);
   }
 }
@@ -81,13 +122,13 @@ void MiningDrillSystem::StartMining(MiningDrillComponent& drill,
                                     EntityID entity) {
   auto& transform = registry->GetComponent<TransformComponent>(entity);
 
-  TileData* tile = world->GetTileAtWorldPosition(transform.position);
+  TileRef tile = world->GetTileAtWorldPosition(transform.position);
 
-  if (!tile || tile->oreEntity == INVALID_ENTITY) return;
+  if (!tile || tile.GetOreEntity() == INVALID_ENTITY) return;
 
-  if (registry->HasComponent<ResourceNodeComponent>(tile->oreEntity)) {
+  if (registry->HasComponent<ResourceNodeComponent>(tile.GetOreEntity())) {
     auto& resnode =
-        registry->GetComponent<ResourceNodeComponent>(tile->oreEntity);
+        registry->GetComponent<ResourceNodeComponent>(tile.GetOreEntity());
 
     if (resnode.LeftResource == 0) {
       drill.state = MiningDrillState::TileEmpty;
@@ -95,26 +136,112 @@ void MiningDrillSystem::StartMining(MiningDrillComponent& drill,
     } else {
       drill.state = MiningDrillState::Mining;
       drill.bIsAnimating = true;
-      util::AttachTimer(registry, timerManager, entity, TimerId::Mine, 1.f,
-                        true);
+      util::AttachTimer(registry, timerManager, entity, TimerId::Mine,
+                        kMinePeriod, true);
     }
   }
 }
 
+bool MiningDrillSystem::UpdateFrozen(MiningDrillComponent& drill,
+                                     EntityID entity) {
+  const double now = timerManager->GetTime();
+  if (!registry->HasComponent<FrozenComponent>(entity)) {
+    registry->EmplaceComponent<FrozenComponent>(entity, FrozenComponent{now});
+    return false;
+  }
+
+  auto& frozen = registry->GetComponent<FrozenComponent>(entity);
+  const bool bThawed = !registry->HasComponent<InactiveComponent>(entity);
+  if (!bThawed && now - frozen.settledAt < kFrozenSettleInterval) return false;
+
+  SettleProduction(drill, entity, static_cast<float>(now - frozen.settledAt));
+  frozen.settledAt = now;
+  // Kept by the timer from now on
+  frozen.progress = 0.f;
+  if (bThawed) registry->RemoveComponent<FrozenComponent>(entity);
+  return bThawed;
+}
+
+void MiningDrillSystem::SettleProduction(MiningDrillComponent& drill,
+                                         EntityID entity, float elapsed) {
+  if (drill.state != MiningDrillState::Mining ||
+      !registry->HasComponent<ResourceNodeComponent>(drill.oreEntity) ||
+      !registry->HasComponent<InventoryComponent>(entity))
+    return;
+
+  auto& resNode =
+      registry->GetComponent<ResourceNodeComponent>(drill.oreEntity);
+  auto& inv = registry->GetComponent<InventoryComponent>(entity);
+  const ItemID item = OreToItemMapper::instance().get(resNode.Ore);
+  int stored = 0;
+  if (!inv.items.empty()) {
+    if (inv.items[0].first != item) return;
+    stored = inv.items[0].second;
+  }
+
+  // Mines until the ore runs out or the output slot is full, the next update
+  // after thawing stops the drill then
+  const int room =
+      std::max(0, ItemDatabase::instance().get(item).maxStackSize - stored);
+  const int minable =
+      static_cast<int>(std::min<rsrc_amt_t>(resNode.LeftResource, room));
+  if (minable == 0) return;
+
+  TimerInstance* timer =
+      util::GetTimer(registry, timerManager, entity, TimerId::Mine);
+  // A restored drill gets its timer back here
+  float progress = 0.f;
+  if (timer)
+    progress = timer->elapsed;
+  else if (registry->HasComponent<FrozenComponent>(entity))
+    progress = registry->GetComponent<FrozenComponent>(entity).progress;
+  const ProductionProjection projection =
+      ProjectProduction(true, progress, elapsed,
+                        timer ? timer->duration : kMinePeriod, minable - 1);
+  if (timer == nullptr) {
+    util::AttachTimer(registry, timerManager, entity, TimerId::Mine,
+                      kMinePeriod, true);
+    timer = util::GetTimer(registry, timerManager, entity, TimerId::Mine);
+  }
+  if (timer) timer->elapsed = projection.progress;
+  if (projection.completed == 0) return;
+
+  resNode.LeftResource -= projection.completed;
+  if (inv.items.empty())
+    inv.items.push_back({item, projection.completed});
+  else
+    inv.items[0].second += projection.completed;
+  util::MarkReplicationDirty(registry, entity,
+                             EReplicatedComponent::MiningDrill);
+  util::MarkReplicationDirty(registry, drill.oreEntity,
+                             EReplicatedComponent::ResourceNode);
+  if (resNode.LeftResource == 0) ExhaustTile(entity);
+}
+
 bool MiningDrillSystem::TileEmpty(EntityID entity) {
   auto& transform = registry->GetComponent<TransformComponent>(entity);
 
-  if (TileData* tile = world->GetTileAtWorldPosition(transform.position)) {
-    if (tile->oreEntity != INVALID_ENTITY &&
-        registry->HasComponent<ResourceNodeComponent>(tile->oreEntity)) {
-      auto& resNode =
-          registry->GetComponent<ResourceNodeComponent>(tile->oreEntity);
+  if (TileRef tile = world->GetTileAtWorldPosition(transform.position)) {
+    const EntityID ore = tile.GetOreEntity();
+    if (ore != INVALID_ENTITY &&
+        registry->HasComponent<ResourceNodeComponent>(ore)) {
+      auto& resNode = registry->GetComponent<ResourceNodeComponent>(ore);
       if (resNode.LeftResource > 0) return false;
     }
   }
   return true;
 }
 
+void MiningDrillSystem::ExhaustTile(EntityID entity) {
+  auto& transform = registry->GetComponent<TransformComponent>(entity);
+  TileRef tile = world->GetTileAtWorldPosition(transform.position);
+  if (!tile || tile.GetType() == TileType::Dirt) return;
+
+  tile.SetType(TileType::Dirt);
+  eventDispatcher->Publish(TileChangedEvent(
+      world->GetTileIndexFromWorldPosition(transform.position)));
+}
+
 void MiningDrillSystem::UpdateAnimationState(MiningDrillComponent& drill,
                                              EntityID entity) {
   if (!registry->HasComponent<AnimationComponent>(entity)) return;
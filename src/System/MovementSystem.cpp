@@ -14,6 +14,7 @@
 #include "Core/Entity.h"
 #include "Core/Event.h"
 #include "Core/InputManager.h"
+#include "Core/InputPrediction.h"
 #include "Core/Packet.h"
 #include "Core/Registry.h"
 #include "Core/TimerManager.h"
@@ -46,8 +47,8 @@ void MovementSystem::ServerUpdate(float deltaTime) {
   if (deltaTime > kMaxStep) deltaTime = kMaxStep;
 
   // Pre-pass: write host (server-local) input into InputStateComponent
+  const EntityID localPlayer = world->GetLocalPlayer();
   {
-    EntityID localPlayer = world->GetLocalPlayer();
     if (localPlayer != INVALID_ENTITY &&
         registry->HasComponent<PlayerStateComponent>(localPlayer)) {
       int ix = inputManager->GetXAxis();
@@ -77,51 +78,67 @@ void MovementSystem::ServerUpdate(float deltaTime) {
     if (!registry->HasComponent<PlayerStateComponent>(e)) continue;
     if (!registry->HasComponent<InputStateComponent>(e)) continue;
 
-    auto& psc = registry->GetComponent<PlayerStateComponent>(e);
-    auto& trans = registry->GetComponent<TransformComponent>(e);
-    const auto& move = registry->GetComponent<MovementComponent>(e);
+    if (e == localPlayer) {
+      StepPlayer(e, deltaTime);
+      continue;
+    }
+
+    // Remote players step through the inputs they sent. Each one moves them
+    // by the syncDelta the client predicted it with, however long this frame
+    // was.
     auto& in = registry->GetComponent<InputStateComponent>(e);
+    AdvanceInputTime(in, deltaTime);
+    while (TakeQueuedInput(in)) StepPlayer(e, syncDelta);
+  }
+}
 
-    int ix = 0, iy = 0;
-    if (in.inputBit & static_cast<uint8_t>(EPlayerInput::RIGHT)) ix++;
-    if (in.inputBit & static_cast<uint8_t>(EPlayerInput::LEFT)) ix--;
-    if (in.inputBit & static_cast<uint8_t>(EPlayerInput::UP)) iy++;
-    if (in.inputBit & static_cast<uint8_t>(EPlayerInput::DOWN)) iy--;
-
-    // Animation and facing if present
-    if (registry->HasComponent<AnimationComponent>(e)) {
-      auto& anim = registry->GetComponent<AnimationComponent>(e);
-      if (ix == 0 && iy == 0) {
-        if (!psc.bIsMining)
-          util::SetAnimation(AnimationName::PLAYER_IDLE, anim, true);
-      } else {
-        util::SetAnimation(AnimationName::PLAYER_WALK, anim, true);
-      }
-    }
-    if (registry->HasComponent<SpriteComponent>(e)) {
-      auto& spr = registry->GetComponent<SpriteComponent>(e);
-      if (ix > 0)
-        spr.flip = SDL_FLIP_NONE;
-      else if (ix < 0)
-        spr.flip = SDL_FLIP_HORIZONTAL;
+void MovementSystem::StepPlayer(EntityID e, float stepTime) {
+  auto& psc = registry->GetComponent<PlayerStateComponent>(e);
+  auto& trans = registry->GetComponent<TransformComponent>(e);
+  const auto& move = registry->GetComponent<MovementComponent>(e);
+  auto& in = registry->GetComponent<InputStateComponent>(e);
+
+  int ix = 0, iy = 0;
+  if (in.inputBit & static_cast<uint8_t>(EPlayerInput::RIGHT)) ix++;
+  if (in.inputBit & static_cast<uint8_t>(EPlayerInput::LEFT)) ix--;
+  if (in.inputBit & static_cast<uint8_t>(EPlayerInput::UP)) iy++;
+  if (in.inputBit & static_cast<uint8_t>(EPlayerInput::DOWN)) iy--;
+
+  // Animation and facing if present
+  if (registry->HasComponent<AnimationComponent>(e)) {
+    auto& anim = registry->GetComponent<AnimationComponent>(e);
+    if (ix == 0 && iy == 0) {
+      if (!psc.bIsMining)
+        util::SetAnimation(AnimationName::PLAYER_IDLE, anim, true);
+    } else {
+      util::SetAnimation(AnimationName::PLAYER_WALK, anim, true);
     }
+  }
+  if (registry->HasComponent<SpriteComponent>(e)) {
+    auto& spr = registry->GetComponent<SpriteComponent>(e);
+    if (ix > 0)
+      spr.flip = SDL_FLIP_NONE;
+    else if (ix < 0)
+      spr.flip = SDL_FLIP_HORIZONTAL;
+  }
 
-    if (ix == 0 && iy == 0) continue;
-
+  if (ix != 0 || iy != 0) {
     float len = std::sqrt(static_cast<float>(ix * ix + iy * iy));
     Vec2f dir{ix / len, iy / len};
 
-    Vec2f next = trans.position + dir * move.speed * deltaTime;
+    Vec2f next = trans.position + dir * move.speed * stepTime;
     if (world->IsTilePassable(next)) {
       trans.position = next;
+      trans.bIsDirty = true;
     }
+  }
 
-    // After movement, if it was based on a client request, queue a response.
-    if (in.sequence != 0) {
-      pendingMoves->Push(
-          {psc.clientID, in.sequence, trans.position.x, trans.position.y});
-      in.sequence = 0;  // Consume the input sequence
-    }
+  // After movement, if it was based on a client request, queue a response.
+  // Standing still is acked too, the client predicted it as well.
+  if (in.sequence != 0) {
+    pendingMoves->Push(
+        {psc.clientID, in.sequence, trans.position.x, trans.position.y});
+    in.sequence = 0;  // Consume the input sequence
   }
 }
 
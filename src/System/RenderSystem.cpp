@@ -17,13 +17,19 @@
 #include "Core/Registry.h"
 #include "Core/TileData.h"
 #include "Core/World.h"
+#include "Core/WorldAssetManager.h"
 #include "SDL.h"
 #include "SDL_ttf.h"
 #include "Util/CameraUtil.h"
 
+namespace {
+// Largest sprite drawn away from its position, a building is a few tiles
+constexpr float kMaxSpriteExtent = 4 * TILE_PIXEL_SIZE;
+}  // namespace
 
 RenderSystem::RenderSystem(const SystemContext &context, SDL_Renderer* renderer, TTF_Font *font)
-    : registry(context.registry), renderer(renderer), world(context.world), font(font) {
+    : registry(context.registry), renderer(renderer), world(context.world),
+      worldAssetManager(context.worldAssetManager), font(font) {
       entityDestroyedEventHandle = context.eventDispatcher->Subscribe<EntityDestroyedEvent>([this](const auto& event) { this->OnEntityDestroyed(event); });
     }
 
@@ -70,9 +76,18 @@ void RenderSystem::RenderChunks(Vec2f cameraPos, Vec2 screenSize, float zoom) {
     if (registry->HasComponent<InactiveComponent>(entity)) {
       continue;
     }
-    const auto &chunk = registry->GetComponent<ChunkComponent>(entity);
+    auto &chunk = registry->GetComponent<ChunkComponent>(entity);
     const auto &transform = registry->GetComponent<TransformComponent>(entity);
 
+    // Tiles changed since the texture was drawn, redraw only those
+    if (chunk.bNeedsRedraw) {
+      const ChunkCoord coord =
+          World::GetChunkCoordFromWorldPosition(transform.position);
+      if (Chunk *data = world->GetActiveChunk(coord.x, coord.y))
+        worldAssetManager->UpdateChunkTexture(chunk.chunkTexture, *data);
+      chunk.bNeedsRedraw = false;
+    }
+
     // Convert world position to screen position
     Vec2f screenPos =
         util::WorldToScreen(transform.position, cameraPos, screenSize, zoom);
@@ -95,14 +110,24 @@ void RenderSystem::RenderChunks(Vec2f cameraPos, Vec2 screenSize, float zoom) {
 
 void RenderSystem::RenderEntities(Vec2f cameraPos, Vec2 screenSize,
                                   float zoom) {
-  // Render all regular entities with SpriteComponent
-  auto view = registry->view<SpriteComponent, TransformComponent>();
+  // Only entities filed near the screen, padded so sprites reaching in from
+  // outside still show
+  const Vec2f viewMin =
+      util::ScreenToWorld({0.f, 0.f}, cameraPos, screenSize, zoom);
+  const Vec2f viewMax = util::ScreenToWorld(
+      Vec2f(screenSize.x, screenSize.y), cameraPos, screenSize, zoom);
+  std::vector<EntityID> nearby;
+  world->GetEntityIndex().QueryRect(
+      {viewMin.x - kMaxSpriteExtent, viewMin.y - kMaxSpriteExtent},
+      {viewMax.x + kMaxSpriteExtent, viewMax.y + kMaxSpriteExtent}, nearby);
 
   // Create a vector of entities with their render order for sorting
   std::vector<std::pair<EntityID, int>> entitiesWithOrder;
 
-  for (EntityID entity : view) {
-    if (registry->HasComponent<InactiveComponent>(entity) ||
+  for (EntityID entity : nearby) {
+    if (!registry->HasComponent<SpriteComponent>(entity) ||
+        !registry->HasComponent<TransformComponent>(entity) ||
+        registry->HasComponent<InactiveComponent>(entity) ||
         registry->HasComponent<ChunkComponent>(entity) ||
         registry->HasComponent<BuildingPreviewComponent>(entity)) {
       continue;
@@ -249,7 +274,8 @@ void RenderSystem::RenderBuildingPreviews(Vec2f cameraPos, Vec2 screenSize,
                              static_cast<int>(TILE_PIXEL_SIZE * zoom)};
 
         // Set color based on validity - use more visible alpha values
-        if (world->HasNoOcuupyingEntity(tileindex + Vec2{dx, dy}, 1, 1)) {
+        if (world->HasNoOcuupyingEntity(tileindex + Vec2{dx, dy}, 1, 1,
+                                        world->GetLocalPlayer())) {
           SDL_SetRenderDrawColor(renderer, 0, 255, 0,
                                  80);  // Green with transparency
         } else {
@@ -1,6 +1,7 @@
 #include "System/ResourceNodeSystem.h"
 
 #include "Components/ResourceNodeComponent.h"
+#include "Components/SpriteComponent.h"
 #include "Components/TextComponent.h"
 #include "Core/Registry.h"
 #include "Core/World.h"
@@ -19,6 +20,14 @@ void ResourceNodeSystem::Update() {
         snprintf(textComp.text, sizeof(textComp.text), "%lld",
                  static_cast<unsigned long long>(resource.LeftResource));
         textComp.isDirty = true;
+
+        // Amount may also change through replication, keep richness in sync
+        if (registry->HasComponent<SpriteComponent>(entity)) {
+          auto &sprite = registry->GetComponent<SpriteComponent>(entity);
+          sprite.srcRect.y =
+              world->GetOreRichnessIndex(resource.LeftResource) *
+              sprite.srcRect.h;
+        }
       }
     }
   }
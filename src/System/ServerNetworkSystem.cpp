@@ -1,5 +1,7 @@
 #include "System/ServerNetworkSystem.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
@@ -8,131 +10,365 @@
 #include "Commands/PlayerDisconnectedCommnad.h"
 #include "Commands/PlayerSpawnCommand.h"
 #include "Components/InputStateComponent.h"
+#include "Components/InventoryComponent.h"
 #include "Components/PlayerStateComponent.h"
 #include "Components/SpriteComponent.h"
 #include "Components/TransformComponent.h"
+#include "Core/ChunkStreamer.h"
 #include "Core/CommandQueue.h"
+#include "Core/EntityFactory.h"
 #include "Core/Event.h"
 #include "Core/EventDispatcher.h"
+#include "Core/InputPrediction.h"
+#include "Core/InterestManager.h"
 #include "Core/Packet.h"
+#include "Core/PacketCapture.h"
+#include "Core/PacketSchema.h"
+#include "Core/ReplicationManager.h"
 #include "Core/Server.h"
+#include "Core/SnapshotScheduler.h"
 #include "Core/ThreadSafeQueue.h"
+#include "Core/TransformHistory.h"
+#include "Core/World.h"
+#include "Util/MathUtil.h"
 #include "Util/PacketUtil.h"
 
 
+namespace {
+// Same reach InteractionSystem allows the host
+constexpr float kMaxInteractionDistance = 200.f;
+// How long the player of a lost connection waits for it to come back
+constexpr double kSessionGraceSeconds = 30.0;
+// Roster packets stay far below kMaxPacketSize whatever the player count
+constexpr std::size_t kMaxRosterPayload = 4096;
+// Range a client's requested snapshot rate is clamped to, in bytes per second
+constexpr std::size_t kMinClientRate = 4 * 1024;
+constexpr std::size_t kMaxClientRate = 128 * 1024;
+
+// Snapshot budget for the rate a client sent in CONNECT_SYN
+SnapshotScheduler::ClientBudget BudgetFor(uint32_t rate) {
+  SnapshotScheduler::ClientBudget budget;
+  if (rate != 0)
+    budget.bytesPerSecond = std::clamp<std::size_t>(rate, kMinClientRate,
+                                                    kMaxClientRate);
+  return budget;
+}
+
+// The roster as an Id packet with the given header followed by as many
+// PLAYER_ROSTER packets as the remaining players need
+template <PACKET Id, typename... HeaderArgs>
+std::vector<PacketPtr> WriteRoster(
+    const std::unordered_map<clientid_t, std::string>& roster,
+    const HeaderArgs&... header) {
+  using Record = typename PacketSchema<Id>::Record;
+  std::vector<PacketPtr> packets;
+  auto it = roster.begin();
+  do {
+    const bool bIsAck = packets.empty();
+    const std::size_t headerSize =
+        bIsAck ? PacketSchema<Id>::Header::SizeOf(header...)
+               : PayloadSize<PLAYER_ROSTER>();
+    std::size_t payloadSize = headerSize;
+    uint16_t count = 0;
+    for (auto last = it; last != roster.end(); ++last, ++count) {
+      const std::size_t recordSize = Record::SizeOf(last->first, last->second);
+      if (payloadSize + recordSize > kMaxRosterPayload) break;
+      payloadSize += recordSize;
+    }
+
+    PacketWriter writer(bIsAck ? Id : PLAYER_ROSTER, payloadSize);
+    if (bIsAck)
+      writer.WriteHeader<Id>(header...);
+    else
+      writer.WriteHeader<PLAYER_ROSTER>(count);
+    for (uint16_t i = 0; i < count; ++i, ++it)
+      writer.Write<Record>(it->first, it->second);
+    packets.push_back(writer.Finish());
+  } while (it != roster.end());
+  return packets;
+}
+
+// How many of an item an entity holds, 0 without an inventory
+int GetHeldAmount(Registry* registry, EntityID entity, ItemID item) {
+  if (!registry->HasComponent<InventoryComponent>(entity)) return 0;
+  int held = 0;
+  for (const auto& [heldItem, count] :
+       registry->GetComponent<InventoryComponent>(entity).items) {
+    if (heldItem == item) held += count;
+  }
+  return held;
+}
+}  // namespace
+
 ServerNetworkSystem::ServerNetworkSystem(const SystemContext& context)
     : assetManager(context.assetManager),
       eventDispatcher(context.eventDispatcher),
       registry(context.registry),
       commandQueue(context.commandQueue),
-      world(context.world),
       timerManager(context.timerManager),
       recvQueue(context.serverRecvQueue),  // Incoming packets (server-specific)
       sendQueue(context.serverSendQueue),  // Outgoing packets (server-specific)
+      world(context.world),
+      factory(context.entityFactory),
       server(context.server),
       clientNameMap(context.clientNameMap),
+      netTickTimer(0.f),
+      tick(0),
+      elapsedTime(0.0),
+      snapshotTick(0),
       pendingMoves(context.pendingMoves),
-      syncTimer(0.f),
-      playerSnapShotSize(0) {
+      interestManager(
+          std::make_unique<InterestManager>(context.world->GetViewDistance())),
+      replicationManager(
+          std::make_unique<ReplicationManager>(context.registry)),
+      transformHistory(std::make_unique<TransformHistory>()),
+      snapshotScheduler(std::make_unique<SnapshotScheduler>()),
+      chunkStreamer(
+          std::make_unique<ChunkStreamer>(context.world->GetViewDistance())),
+      tokenGenerator(std::random_device{}()) {
   // Subscribe chat event
   sendChatHandle =
       eventDispatcher->Subscribe<SendChatEvent>([this](SendChatEvent e) {
-        Broadcast(util::ChatBroadcastPacket(e.message));
+        Broadcast(MakePacket<CHAT_BROADCAST>(clientid_t{0}, *e.message));
+      });
+
+  buildingPlacedHandle = eventDispatcher->Subscribe<BuildingPlacedEvent>(
+      [this](const BuildingPlacedEvent& e) {
+        ENetArchetype archetype = ENetArchetype::None;
+        if (e.item == ItemID::AssemblingMachine)
+          archetype = ENetArchetype::AssemblingMachine;
+        else if (e.item == ItemID::MiningDrill)
+          archetype = ENetArchetype::MiningDrill;
+        if (archetype == ENetArchetype::None) return;
+
+        replicationManager->RegisterEntity(e.building, archetype, e.tileIndex);
+      });
+
+  entityDestroyedHandle = eventDispatcher->Subscribe<EntityDestroyedEvent>(
+      [this](const EntityDestroyedEvent& e) {
+        replicationManager->UnregisterEntity(e.entity);
+      });
+
+  tileChangedHandle = eventDispatcher->Subscribe<TileChangedEvent>(
+      [this](const TileChangedEvent& e) {
+        const Vec2f worldPos{
+            static_cast<float>(e.tileIndex.x * TILE_PIXEL_SIZE),
+            static_cast<float>(e.tileIndex.y * TILE_PIXEL_SIZE)};
+        chunkStreamer->ResendChunk(
+            World::GetChunkCoordFromWorldPosition(worldPos));
       });
 
-  for (auto& [id, name] : *clientNameMap)
-    playerSnapShotSize += sClientID + sizeof(uint8_t) + name.size();
+  // Ore state travels with the chunks, clients without one get nothing
+  replicationManager->SetStaticFilter([this](clientid_t clientID, Vec2 tile) {
+    const Vec2f worldPos{static_cast<float>(tile.x * TILE_PIXEL_SIZE),
+                         static_cast<float>(tile.y * TILE_PIXEL_SIZE)};
+    return chunkStreamer->HasChunk(
+        clientID, World::GetChunkCoordFromWorldPosition(worldPos));
+  });
+
 }
 
-void ServerNetworkSystem::ConnectSynHandler(const RecvPacket& recv,
-                                            clientid_t clientID,
-                                            const uint8_t* rp,
-                                            std::size_t packetSize) {
+void ServerNetworkSystem::ConnectSynHandler(clientid_t clientID,
+                                            PacketReader& reader) {
   std::cout << "CONNECT_SYN from clientID: " << clientID << "\n";
-  const uint8_t nameLen = *rp++;
-  if (packetSize < (static_cast<size_t>(rp - recv.packet.get()) + nameLen)) {
-    // invalid
-    return;
-  }
+  auto fields = reader.ReadHeader<CONNECT_SYN>();
+  if (!fields) return;
+  auto [rawName, rate] = *fields;
+
   constexpr size_t cap = NAME_MAX_LEN - 1;
-  size_t copyLen = util::utf8_clamp_to_codepoint(rp, nameLen, cap);
-  std::string name(reinterpret_cast<const char*>(rp), copyLen);
+  size_t copyLen = util::utf8_clamp_to_codepoint(
+      reinterpret_cast<const uint8_t*>(rawName.data()), rawName.size(), cap);
+  std::string name(rawName.data(), copyLen);
 
   // Generate character of connected client
   commandQueue->Enqueue(std::make_unique<PlayerSpawnCommand>(clientID, false));
 
-  {  // Send CONNECT_ACK for connected client
-    std::size_t totalPacketSize = sPacketHeader + sizeof(clientid_t) +
-                                  sizeof(uint16_t) +
-                                  playerSnapShotSize;  // header + playercnt
-
-    std::unique_ptr<uint8_t[]> snapshotPacket =
-        std::make_unique<uint8_t[]>(totalPacketSize);
+  // Token is only known to this connection, it proves a later reconnect
+  const uint64_t token = tokenGenerator();
+  sessions[clientID] = Session{token, rate};
 
-    uint8_t* wp = snapshotPacket.get();
-
-    util::WriteHeader(wp, PACKET::CONNECT_ACK, totalPacketSize);
-    util::Write64BigEnd(wp, clientID);
+  {  // Send CONNECT_ACK for connected client
     if (clientNameMap->size() != 0) {
-      util::Write16BigEnd(wp, static_cast<uint16_t>(clientNameMap->size()));
-      for (auto& [id, name] : *clientNameMap) {
-        util::Write64BigEnd(wp, id);
-        *wp++ = static_cast<uint8_t>(name.size());
-        std::memcpy(wp, name.c_str(), name.size());
-
-        wp += name.size();
-      }
-      Unicast(clientID, std::move(snapshotPacket));
+      std::vector<PacketPtr> packets = WriteRoster<CONNECT_ACK>(
+          *clientNameMap, clientID, token,
+          static_cast<uint16_t>(clientNameMap->size()));
+      SendSession(clientID, token, std::move(packets[0]));
+      for (std::size_t i = 1; i < packets.size(); ++i)
+        Unicast(clientID, std::move(packets[i]));
     }
   }
 
   AddPlayerToMap(clientID, name);
+  replicationManager->AddClient(clientID);
+  snapshotScheduler->AddClient(clientID, BudgetFor(rate));
+  chunkStreamer->AddClient(clientID);
+
+  // BROADCAST PLAYER_CONNECTED TO ALL PLAYERS
+  Broadcast(MakePacket<PLAYER_CONNECTED_BROADCAST>(clientID, name));
+}
+
+void ServerNetworkSystem::ReconnectSynHandler(clientid_t connection,
+                                              PacketReader& reader) {
+  auto fields = reader.ReadHeader<RECONNECT_SYN>();
+  if (!fields) return;
+  const auto [clientID, token, replicationVersion] = *fields;
+
+  auto it = sessions.find(clientID);
+  if (it == sessions.end() || it->second.token != token ||
+      clientNameMap->count(connection) != 0) {
+    std::cout << "Rejected reconnect of client " << clientID << "\n";
+    Unicast(connection,
+            MakePacket<RECONNECT_ACK>(
+                static_cast<uint8_t>(EReconnectResult::Rejected),
+                uint16_t{0}));
+    return;
+  }
+
+  // The old connection is usually noticed closing first, if not the resume
+  // waits for it
+  if (!it->second.bIsParked) {
+    pendingResumes[clientID] = PendingResume{connection, replicationVersion};
+    return;
+  }
+  ResumeSession(connection, clientID, replicationVersion);
+}
+
+void ServerNetworkSystem::ConnectionClosed(clientid_t connection) {
+  // A reconnect that gave up before its old connection closed
+  std::erase_if(pendingResumes, [connection](const auto& kv) {
+    return kv.second.connection == connection;
+  });
+
+  if (clientNameMap->count(connection) == 0) return;
+  if (sessions.count(connection) == 0) {
+    DropClient(connection);
+    return;
+  }
+
+  ParkSession(connection);
+  auto pendingIt = pendingResumes.find(connection);
+  if (pendingIt != pendingResumes.end()) {
+    const PendingResume pending = pendingIt->second;
+    pendingResumes.erase(pendingIt);
+    ResumeSession(pending.connection, connection, pending.replicationVersion);
+  }
+}
+
+void ServerNetworkSystem::ParkSession(clientid_t clientID) {
+  Session& session = sessions[clientID];
+  session.bIsParked = true;
+  session.expireTime = elapsedTime + kSessionGraceSeconds;
+
+  // Others keep seeing the player where it stopped
+  interestManager->RemoveObserver(clientID);
+  replicationManager->RemoveClient(clientID);
+  snapshotScheduler->RemoveClient(clientID);
+  chunkStreamer->RemoveClient(clientID);
+
+  EntityID player = world->GetPlayerByClientID(clientID);
+  if (player != INVALID_ENTITY &&
+      registry->HasComponent<InputStateComponent>(player))
+    registry->GetComponent<InputStateComponent>(player).inputBit = 0;
+
+  std::cout << "Client " << clientID << " lost connection, keeping it for "
+            << kSessionGraceSeconds << "s\n";
+}
+
+void ServerNetworkSystem::ResumeSession(clientid_t connection,
+                                        clientid_t clientID,
+                                        uint32_t replicationVersion) {
+  Session& session = sessions[clientID];
+  session.bIsParked = false;
+  snapshotScheduler->AddClient(clientID, BudgetFor(session.rate));
+  // The client keeps its chunks, resent ones are refreshed in place
+  chunkStreamer->AddClient(clientID);
+  const bool bIsDelta =
+      replicationManager->ResumeClient(clientID, replicationVersion);
+  const EReconnectResult result =
+      bIsDelta ? EReconnectResult::Resumed : EReconnectResult::Resynced;
+
+  // Players that joined or left meanwhile are found from the full list
+  std::vector<PacketPtr> packets = WriteRoster<RECONNECT_ACK>(
+      *clientNameMap, static_cast<uint8_t>(result),
+      static_cast<uint16_t>(clientNameMap->size()));
+
+  std::cout << "Client " << clientID << " resumed on connection "
+            << connection << (bIsDelta ? "" : " with a full resync") << "\n";
+
+  if (server == nullptr) return;
+  // The transport moves the connection to the old id and then sends the ack,
+  // so nothing addressed to clientID can overtake it
+  SendRequest request;
+  request.type = ESendType::REBIND;
+  request.targetClientId = connection;
+  request.reboundClientId = clientID;
+  request.sessionToken = sessions[clientID].token;
+  request.packet = std::move(packets[0]);
+  sendQueue->Push(std::move(request));
+  server->StartSend();
+  for (std::size_t i = 1; i < packets.size(); ++i)
+    Unicast(clientID, std::move(packets[i]));
+}
 
-  {  // BROADCAST PLAYER_CONNECTED TO ALL PLAYERS
-    PacketPtr packet = std::make_unique<uint8_t[]>(
-        sHeaderAndId + sizeof(uint8_t) + name.size());
-    uint8_t* wp = packet.get();
-    util::WriteHeader(wp, PACKET::PLAYER_CONNECTED_BROADCAST,
-                      sHeaderAndId + sizeof(uint8_t) + name.size());
-    util::Write64BigEnd(wp, clientID);
-    *wp++ = static_cast<uint8_t>(name.size());
-    std::memcpy(wp, name.c_str(), name.size());
-
-    Broadcast(std::move(packet));
+void ServerNetworkSystem::DropClient(clientid_t clientID) {
+  auto iter = clientNameMap->find(clientID);
+  if (iter == clientNameMap->end()) return;
+
+  EntityID player = world->GetPlayerByClientID(clientID);
+  if (player != INVALID_ENTITY) transformHistory->Remove(player);
+  clientNameMap->erase(iter);
+  interestManager->RemoveObserver(clientID);
+  interestManager->RemoveSubject(clientID);
+  replicationManager->RemoveClient(clientID);
+  snapshotScheduler->RemoveClient(clientID);
+  chunkStreamer->RemoveClient(clientID);
+  sessions.erase(clientID);
+  pendingResumes.erase(clientID);
+
+  commandQueue->Enqueue(std::make_unique<PlayerDisconnectedCommand>(clientID));
+
+  // Broadcast PLAYER_DISCONNECTED to all players
+  Broadcast(MakePacket<PLAYER_DISCONNECTED_BROADCAST>(clientID));
+}
+
+void ServerNetworkSystem::ExpireSessions() {
+  std::vector<clientid_t> expired;
+  for (auto& [clientID, session] : sessions) {
+    if (session.bIsParked && elapsedTime >= session.expireTime)
+      expired.push_back(clientID);
+  }
+  for (clientid_t clientID : expired) {
+    std::cout << "Session of client " << clientID << " expired\n";
+    DropClient(clientID);
   }
 }
 
 void ServerNetworkSystem::ChatClientHandler(clientid_t clientID,
-                                            const uint8_t* rp,
-                                            std::size_t packetSize) {
+                                            PacketReader& reader) {
   std::cout << "CHAT_CLIENT from clientID: " << clientID << "\n";
-  // Broadcast chat to everyone
-  const char* msgStart = reinterpret_cast<const char*>(rp);
-  std::size_t msgSize = packetSize - sPacketHeader;
-  std::shared_ptr<std::string> message =
-      std::make_shared<std::string>(msgStart, msgSize);
+  auto fields = reader.ReadHeader<CHAT_CLIENT>();
+  if (!fields) return;
+  auto [text] = *fields;
 
   auto iter = clientNameMap->find(clientID);
 
   if (iter != clientNameMap->end()) {
-    eventDispatcher->Publish(NewChatEvent(clientID, message));
-
-    PacketPtr packet = util::ChatBroadcastPacket(message, clientID);
-    Broadcast(std::move(packet));
+    // Broadcast chat to everyone
+    eventDispatcher->Publish(
+        NewChatEvent(clientID, std::make_shared<std::string>(text)));
+    Broadcast(MakePacket<CHAT_BROADCAST>(clientID, text));
   }
 }
 
 void ServerNetworkSystem::ClientMoveReqHandler(clientid_t clientID,
-                                               const uint8_t* rp,
-                                               std::size_t /*packetSize*/) {
-  uint16_t seq = util::Read16BigEnd(rp);
-  uint8_t inputBit = *rp++;
-
-#ifdef PACKET_DEBUG
-  std::cout << "CLIENT_MOVE_REQ from clientID: " << clientID
-            << " seq=" << seq << " inputBit=" << static_cast<int>(inputBit)
-            << "\n";
-#endif
+                                               PacketReader& reader) {
+  auto fields = reader.ReadHeader<CLIENT_MOVE_REQ>();
+  if (!fields) return;
+  const auto [newestSeq, inputCnt] = *fields;
+  if (inputCnt == 0 || inputCnt > kMaxMoveBatch) return;
+  if (reader.GetRemaining() < static_cast<std::size_t>(inputCnt + 1) / 2)
+    return;
+  const uint8_t* rp = reader.Cursor();
 
   EntityID e = world->GetPlayerByClientID(clientID);
   if (e == INVALID_ENTITY) return;
@@ -141,96 +377,239 @@ void ServerNetworkSystem::ClientMoveReqHandler(clientid_t clientID,
     registry->EmplaceComponent<InputStateComponent>(e);
   }
   auto& inputState = registry->GetComponent<InputStateComponent>(e);
-  inputState.inputBit = inputBit;
-  // Only process newer inputs to avoid out-of-order execution
-  if (util::seq_gt(seq, inputState.sequence)) {
-    inputState.sequence = seq;
+
+  // MovementSystem applies the queued inputs one per tick, in order. The
+  // whole batch is redundant if an earlier one already delivered it.
+  if (!QueueMoveBatch(inputState, newestSeq, inputCnt, rp)) return;
+
+#ifdef PACKET_DEBUG
+  std::cout << "CLIENT_MOVE_REQ from clientID: " << clientID
+            << " seq=" << newestSeq << " cnt=" << static_cast<int>(inputCnt)
+            << "\n";
+#endif
+}
+
+void ServerNetworkSystem::BuildReqHandler(clientid_t clientID,
+                                          PacketReader& reader) {
+  auto fields = reader.ReadHeader<BUILD_REQ>();
+  if (!fields) return;
+  const auto [sequence, rawItem, tileX, tileY] = *fields;
+
+  SendCommandAck(clientID, sequence,
+                 TryBuild(clientID, static_cast<ItemID>(rawItem),
+                          Vec2(tileX, tileY)));
+}
+
+bool ServerNetworkSystem::TryBuild(clientid_t clientID, ItemID item,
+                                   Vec2 tileIndex) {
+  EntityID player = world->GetPlayerByClientID(clientID);
+  if (player == INVALID_ENTITY) return false;
+  if (!registry->HasComponent<TransformComponent>(player)) return false;
+
+  // The building comes out of the player's inventory, placed within reach
+  if (GetHeldAmount(registry, player, item) < 1) {
+    std::cerr << "BUILD_REQ without the item from clientID: " << clientID
+              << "\n";
+    return false;
+  }
+  const Vec2f playerPos =
+      registry->GetComponent<TransformComponent>(player).position;
+  const Vec2f tilePos = tileIndex * TILE_PIXEL_SIZE;
+  if (util::dist(playerPos, tilePos) > kMaxInteractionDistance) {
+    std::cerr << "BUILD_REQ out of reach from clientID: " << clientID << "\n";
+    return false;
+  }
+
+  // Factory rejects occupied or unloaded tiles, and the requester's own
+  EntityID building = INVALID_ENTITY;
+  if (item == ItemID::AssemblingMachine) {
+    building =
+        factory->CreateAssemblingMachine(world, tileIndex, false, player);
+  } else if (item == ItemID::MiningDrill) {
+    building = factory->CreateMiningDrill(world, tileIndex, false, player);
+  }
+  if (building == INVALID_ENTITY) return false;
+
+  eventDispatcher->Publish(BuildingPlacedEvent{building, item, tileIndex});
+  eventDispatcher->Publish(ItemConsumeEvent{player, item, 1});
+  return true;
+}
+
+void ServerNetworkSystem::EntityInteractReqHandler(clientid_t clientID,
+                                                   PacketReader& reader) {
+  auto fields = reader.ReadHeader<ENTITY_INTERACT_REQ>();
+  if (!fields) return;
+  const auto [sequence, netID, rawAction, id, amount, viewTick] = *fields;
+
+  SendCommandAck(clientID, sequence,
+                 TryInteract(clientID, netID,
+                             static_cast<ENetInteraction>(rawAction), id,
+                             amount, viewTick));
+}
+
+bool ServerNetworkSystem::TryInteract(clientid_t clientID, netid_t netID,
+                                      ENetInteraction action, uint8_t id,
+                                      int amount, uint32_t viewTick) {
+  EntityID player = world->GetPlayerByClientID(clientID);
+  EntityID target = replicationManager->GetEntity(netID);
+  if (player == INVALID_ENTITY || target == INVALID_ENTITY) return false;
+  if (amount <= 0) return false;
+  if (!registry->HasComponent<TransformComponent>(player) ||
+      !registry->HasComponent<TransformComponent>(target))
+    return false;
+
+  // Player and target are both rewound to viewTick, anything without
+  // history there (buildings) is taken where it is now
+  const Vec2f playerPos =
+      registry->GetComponent<TransformComponent>(player).position;
+  const Vec2f targetPos =
+      registry->GetComponent<TransformComponent>(target).position;
+  if (!transformHistory->IsWithinReach(player, playerPos, target, targetPos,
+                                       viewTick, kMaxInteractionDistance)) {
+    std::cerr << "ENTITY_INTERACT_REQ out of reach from clientID: "
+              << clientID << "\n";
+    return false;
+  }
+
+  // Systems handling these events validate the target components themselves.
+  // Items only move out of an inventory that holds them.
+  switch (action) {
+    case ENetInteraction::SetRecipe:
+      if (id >= static_cast<uint8_t>(RecipeID::MaxRecipeID)) return false;
+      eventDispatcher->Publish(
+          AssemblySetRecipeEvent{target, static_cast<RecipeID>(id)});
+      return true;
+    case ENetInteraction::AddInput: {
+      if (id >= static_cast<uint8_t>(ItemID::MaxItemID)) return false;
+      const ItemID item = static_cast<ItemID>(id);
+      amount = std::min(amount, GetHeldAmount(registry, player, item));
+      if (amount <= 0) return false;
+      eventDispatcher->Publish(
+          AssemblyAddInputEvent{target, player, item, amount});
+      return true;
+    }
+    case ENetInteraction::TakeOutput:
+      if (id >= static_cast<uint8_t>(ItemID::MaxItemID)) return false;
+      eventDispatcher->Publish(AssemblyTakeOutputEvent{
+          target, player, static_cast<ItemID>(id), amount});
+      return true;
+    case ENetInteraction::TakeInventory: {
+      if (id >= static_cast<uint8_t>(ItemID::MaxItemID)) return false;
+      const ItemID item = static_cast<ItemID>(id);
+      amount = std::min(amount, GetHeldAmount(registry, target, item));
+      if (amount <= 0) return false;
+      eventDispatcher->Publish(ItemMoveEvent{target, player, item, amount});
+      return true;
+    }
   }
+  return false;
+}
+
+void ServerNetworkSystem::SendCommandAck(clientid_t clientID,
+                                         uint16_t sequence, bool bAccepted) {
+  Unicast(clientID,
+          MakePacket<COMMAND_ACK>(sequence, static_cast<uint8_t>(bAccepted)));
 }
 
 void ServerNetworkSystem::Update(float deltatime) {
+  ++tick;
+  elapsedTime += deltatime;
+
   // Process incoming packets
   RecvPacket recv;
   while (recvQueue->TryPop(recv)) {
+    if (recorder)
+      recorder->Record(tick, static_cast<uint32_t>(elapsedTime * 1000.0),
+                       recv);
+
     if (recv.packet == nullptr) {
-      // Player Disconnected
-      auto iter = clientNameMap->find(recv.senderClientId);
-      if (iter != clientNameMap->end()) {
-        std::string name = iter->second;
-        clientNameMap->erase(iter);
-        playerSnapShotSize -= sClientID + sizeof(uint8_t) + name.size();
-
-        commandQueue->Enqueue(
-            std::make_unique<PlayerDisconnectedCommand>(recv.senderClientId));
-
-        // Broadcast PLAYER_DISCONNECTED to all players
-        PacketPtr packet = std::make_unique<uint8_t[]>(sHeaderAndId);
-        uint8_t* wp = packet.get();
-        util::WriteHeader(wp, PACKET::PLAYER_DISCONNECTED_BROADCAST,
-                          sHeaderAndId);
-        util::Write64BigEnd(wp, recv.senderClientId);
-
-        Broadcast(std::move(packet));
-      }
+      ConnectionClosed(recv.senderClientId);
       continue;
     }
 
-    const uint8_t* rp = recv.packet.get();
-    std::size_t packetSize;
-    PACKET packetId;
-
-    util::GetHeader(rp, packetId, packetSize);
+    PacketReader reader(recv.packet.get());
+    if (!reader.IsOk()) continue;
     clientid_t clientID = recv.senderClientId;
 
-    switch (packetId) {
+    switch (reader.GetPacketId()) {
       // TODO : add duplicate name check packet
       case CONNECT_SYN:
-        ConnectSynHandler(recv, clientID, rp, packetSize);
+        ConnectSynHandler(clientID, reader);
+        break;
+
+      case RECONNECT_SYN:
+        ReconnectSynHandler(clientID, reader);
         break;
 
       case CHAT_CLIENT:
-        ChatClientHandler(clientID, rp, packetSize);
+        ChatClientHandler(clientID, reader);
         break;
 
       case CLIENT_MOVE_REQ:
-        ClientMoveReqHandler(clientID, rp, packetSize);
+        ClientMoveReqHandler(clientID, reader);
+        break;
+
+      case BUILD_REQ:
+        BuildReqHandler(clientID, reader);
+        break;
+
+      case ENTITY_INTERACT_REQ:
+        EntityInteractReqHandler(clientID, reader);
+        break;
+
+      default:
         break;
     }
   }
 
-  // Periodic snapshot
-  syncTimer += deltatime;
-  if (syncTimer >= (1.f / syncRate)) {
-    syncTimer -= (1.f / syncRate);
-    SendSyncPacket();
+  ExpireSessions();
+  FlushReplication(deltatime);
+
+  // Fixed rate network tick, a long frame runs it once with the whole step
+  netTickTimer += deltatime;
+  if (netTickTimer >= tickDelta) {
+    const float steps = std::floor(netTickTimer / tickDelta);
+    netTickTimer -= steps * tickDelta;
+    NetworkTick(steps * tickDelta);
+  }
+
+  // Only the newest applied input per client needs to be acked
+  std::unordered_map<clientid_t, MoveApplied> newestMoves;
+  MoveApplied applied;
+  while (pendingMoves->TryPop(applied)) {
+    auto [it, inserted] = newestMoves.try_emplace(applied.clientID, applied);
+    if (!inserted && util::seq_gt(applied.seq, it->second.seq))
+      it->second = applied;
   }
 
   // Send applied move result to requested client
-  MoveApplied mv;
-  while (pendingMoves->TryPop(mv)) {
+  for (auto& [clientID, mv] : newestMoves) {
     // Unicast immediate move result
-    const std::size_t payloadSize = sizeof(uint16_t) + sizeof(float) * 2;
-    const std::size_t totalSize = sPacketHeader + payloadSize;
-
-    PacketPtr pkt = std::make_unique<uint8_t[]>(totalSize);
-    uint8_t* p = pkt.get();
-
-    util::WriteHeader(p, PACKET::CLIENT_MOVE_RES, totalSize);
-    util::Write16BigEnd(p, mv.seq);
-    util::WriteF32BigEnd(p, mv.x);
-    util::WriteF32BigEnd(p, mv.y);
-
-    Unicast(mv.clientID, std::move(pkt));
+    Unicast(mv.clientID, MakePacket<CLIENT_MOVE_RES>(mv.seq, mv.x, mv.y));
   }
 }
 
 void ServerNetworkSystem::AddPlayerToMap(clientid_t clientID,
                                          std::string name) {
   clientNameMap->emplace(clientID, name);
-  playerSnapShotSize += sClientID + sizeof(uint8_t) + name.size();
 }
 
-void ServerNetworkSystem::SendSyncPacket() {
+bool ServerNetworkSystem::StartRecording(const std::string& path) {
+  auto newRecorder = std::make_unique<PacketRecorder>();
+  if (!newRecorder->Open(path)) return false;
+
+  recorder = std::move(newRecorder);
+  std::cout << "Recording received packets to " << path << "\n";
+  return true;
+}
+
+void ServerNetworkSystem::StopRecording() {
+  if (!recorder) return;
+  std::cout << "Recorded " << recorder->GetRecordCount() << " packets\n";
+  recorder.reset();
+}
+
+void ServerNetworkSystem::NetworkTick(float deltaTime) {
   struct Entry {
     clientid_t id;
     float x;
@@ -238,7 +617,12 @@ void ServerNetworkSystem::SendSyncPacket() {
     uint8_t facing;
   };
 
-  std::vector<Entry> entries;
+  // Ticks follow server time so clients can lay snapshots on their own clock
+  snapshotTick = std::max(static_cast<uint32_t>(elapsedTime * tickRate),
+                          snapshotTick + 1);
+
+  std::unordered_map<clientid_t, Entry> entries;
+  transformHistory->BeginSnapshot(snapshotTick);
 
   for (EntityID player :
        registry->view<PlayerStateComponent, TransformComponent>()) {
@@ -247,29 +631,116 @@ void ServerNetworkSystem::SendSyncPacket() {
     const auto& spr = registry->GetComponent<SpriteComponent>(player);
     uint8_t facing = spr.flip == SDL_FLIP_HORIZONTAL ? 1 : 0;
 
-    entries.push_back(Entry{pc.clientID, t.position.x, t.position.y, facing});
+    entries.emplace(pc.clientID,
+                    Entry{pc.clientID, t.position.x, t.position.y, facing});
+    interestManager->UpdateSubject(pc.clientID, t.position);
+    transformHistory->Store(player, t.position);
+  }
+
+  // Each client only receives players inside its own area of interest, and
+  // of those only what its budget allows this window
+  constexpr std::size_t kHeaderBytes =
+      sizeof(PacketHeader) + PayloadSize<TRANSFORM_SNAPSHOT>();
+  constexpr std::size_t kRecordBytes =
+      PayloadSize<TRANSFORM_SNAPSHOT>(1) - PayloadSize<TRANSFORM_SNAPSHOT>();
+  InterestManager::ViewDelta delta;
+  std::vector<SnapshotScheduler::Subject> visible;
+  std::vector<SnapshotScheduler::Subject> selected;
+  for (auto& [clientID, name] : *clientNameMap) {
+    // Host plays on the authoritative world directly
+    if (clientID == 0 || IsParked(clientID)) continue;
+
+    auto observerIt = entries.find(clientID);
+    if (observerIt == entries.end()) continue;
+    const Vec2f observerPos{observerIt->second.x, observerIt->second.y};
+
+    interestManager->UpdateObserver(clientID, observerPos);
+    const bool bIsSendDue = snapshotScheduler->IsSendDue(clientID, deltaTime);
+    if (bIsSendDue && interestManager->Refresh(clientID, delta)) {
+      if (!delta.left.empty())
+        SendInterestChange(clientID, PACKET::INTEREST_LEAVE, delta.left);
+      if (!delta.entered.empty())
+        SendInterestChange(clientID, PACKET::INTEREST_ENTER, delta.entered);
+    }
+
+    // Own position is corrected through CLIENT_MOVE_RES instead
+    visible.clear();
+    for (clientid_t id : interestManager->GetVisibleSubjects(clientID)) {
+      auto it = entries.find(id);
+      if (id != clientID && it != entries.end())
+        visible.push_back({id, {it->second.x, it->second.y}});
+    }
+    snapshotScheduler->Accumulate(clientID, observerPos, visible, deltaTime);
+    if (!bIsSendDue) continue;
+
+    snapshotScheduler->Select(clientID, kHeaderBytes, kRecordBytes, selected);
+    PacketWriter writer(TRANSFORM_SNAPSHOT,
+                        PayloadSize<TRANSFORM_SNAPSHOT>(selected.size()));
+    writer.WriteHeader<TRANSFORM_SNAPSHOT>(
+        snapshotTick, static_cast<uint16_t>(selected.size()));
+    for (const SnapshotScheduler::Subject& subject : selected) {
+      const Entry& e = entries.at(subject.id);
+      writer.WriteRecord<TRANSFORM_SNAPSHOT>(e.id, e.x, e.y, e.facing);
+    }
+    Unicast(clientID, writer.Finish());
   }
+}
 
-  const std::size_t packetSize =
-      sPacketHeader + sizeof(uint16_t) +
-      entries.size() * (sClientID + sizeof(float) * 2 + sizeof(uint8_t));
+void ServerNetworkSystem::FlushReplication(float deltaTime) {
+  // Chunks first, ore updates are only written for chunks a client holds
+  StreamChunks(deltaTime);
+  replicationManager->CollectDirty();
 
-  PacketPtr packet = std::make_unique<uint8_t[]>(packetSize);
-  uint8_t* wp = packet.get();
+  std::vector<PacketPtr> packets;
+  for (auto& [clientID, name] : *clientNameMap) {
+    // Host already shares the authoritative registry
+    if (clientID == 0) continue;
 
-  util::WriteHeader(wp, PACKET::TRANSFORM_SNAPSHOT, packetSize);
-  util::Write16BigEnd(wp, static_cast<uint16_t>(entries.size()));
+    replicationManager->Flush(clientID, deltaTime, packets);
+    for (PacketPtr& packet : packets) Unicast(clientID, std::move(packet));
+    packets.clear();
+  }
+}
+
+void ServerNetworkSystem::StreamChunks(float deltaTime) {
+  const ChunkStreamer::Encoder encode = [this](ChunkCoord chunk) {
+    return world->EncodeChunk(chunk);
+  };
 
-  for (auto& e : entries) {
-    util::Write64BigEnd(wp, e.id);
-    util::WriteF32BigEnd(wp, e.x);
-    util::WriteF32BigEnd(wp, e.y);
-    *wp++ = e.facing;
+  std::vector<PacketPtr> packets;
+  for (auto& [clientID, name] : *clientNameMap) {
+    // Host generates its own world
+    if (clientID == 0 || IsParked(clientID)) continue;
+
+    EntityID player = world->GetPlayerByClientID(clientID);
+    if (player == INVALID_ENTITY ||
+        !registry->HasComponent<TransformComponent>(player))
+      continue;
+    chunkStreamer->SetCenter(
+        clientID, World::GetChunkCoordFromWorldPosition(
+                      registry->GetComponent<TransformComponent>(player)
+                          .position));
+
+    chunkStreamer->Flush(clientID, deltaTime, encode, packets);
+    for (PacketPtr& packet : packets) Unicast(clientID, std::move(packet));
+    packets.clear();
   }
-  Broadcast(std::move(packet));
+}
+
+void ServerNetworkSystem::SendInterestChange(
+    clientid_t clientID, PACKET packetId,
+    const std::vector<clientid_t>& players) {
+  // INTEREST_ENTER and INTEREST_LEAVE share one layout
+  PacketWriter writer(packetId, PayloadSize<INTEREST_ENTER>(players.size()));
+  writer.WriteHeader<INTEREST_ENTER>(static_cast<uint16_t>(players.size()));
+  for (clientid_t id : players) writer.WriteRecord<INTEREST_ENTER>(id);
+
+  Unicast(clientID, writer.Finish());
 }
 
 void ServerNetworkSystem::Unicast(clientid_t clientID, PacketPtr packet) {
+  // Replays run without a server, replies have nowhere to go
+  if (packet == nullptr || server == nullptr) return;
   SendRequest request;
   request.type = ESendType::UNICAST;
   request.targetClientId = clientID;
@@ -278,7 +749,20 @@ void ServerNetworkSystem::Unicast(clientid_t clientID, PacketPtr packet) {
   server->StartSend();
 }
 
+void ServerNetworkSystem::SendSession(clientid_t clientID, uint64_t token,
+                                      PacketPtr packet) {
+  if (packet == nullptr || server == nullptr) return;
+  SendRequest request;
+  request.type = ESendType::SESSION;
+  request.targetClientId = clientID;
+  request.sessionToken = token;
+  request.packet = std::move(packet);
+  sendQueue->Push(std::move(request));
+  server->StartSend();
+}
+
 void ServerNetworkSystem::Broadcast(PacketPtr packet) {
+  if (packet == nullptr || server == nullptr) return;
   SendRequest request;
   request.type = ESendType::BROADCAST;
   request.targetClientId = 0;
@@ -1,16 +1,35 @@
 #include "System/TimerSystem.h"
 
+#include "Components/InactiveComponent.h"
 #include "Components/TimerComponent.h"
+#include "Core/Event.h"
+#include "Core/EventDispatcher.h"
 #include "Core/Registry.h"
 #include "Core/TimerManager.h"
 
 TimerSystem::TimerSystem(const SystemContext& context)
-    : registry(context.registry), timerManager(context.timerManager) {}
+    : registry(context.registry), timerManager(context.timerManager) {
+  // Published before the components are removed
+  entityDestroyedHandle =
+      context.eventDispatcher->Subscribe<EntityDestroyedEvent>(
+          [this](const EntityDestroyedEvent& e) {
+            if (!registry->HasComponent<TimerComponent>(e.entity)) return;
+            for (TimerHandle handle :
+                 registry->GetComponent<TimerComponent>(e.entity).timers) {
+              if (handle != INVALID_TIMER_HANDLE)
+                timerManager->DestroyTimer(handle);
+            }
+          });
+}
 
 void TimerSystem::Update(float deltaTime) {
+  timerManager->Advance(deltaTime);
+
   // Iterate over all entities that have a TimerComponent.
   auto view = registry->view<TimerComponent>();
   for (auto entity : view) {
+    // Off-screen machines keep their progress, their systems settle it
+    if (registry->HasComponent<InactiveComponent>(entity)) continue;
     const auto& timerComp = registry->GetComponent<TimerComponent>(entity);
 
     // Check each poFtential timer handle in the component.
@@ -476,9 +476,8 @@ void UISystem::AssemblingMachineRecipeSelection(EntityID entity) {
 
       if (ImGui::Button((const char *)recipeData.name.c_str(),
                         ImVec2(200, 0))) {
-        assemblingComp.currentRecipe = recipeId;
+        eventDispatcher->Publish(AssemblySetRecipeEvent(entity, recipeId));
         assemblingComp.bIsShowingRecipeSelection = false;
-        assemblingComp.state = AssemblingMachineState::Idle;
         showSelection = false;
       }
 
@@ -0,0 +1,68 @@
+#include "Util/InterpUtil.h"
+
+#include "Core/Packet.h"
+
+namespace util {
+
+namespace {
+inline InterpBufferComponent::Sample &At(InterpBufferComponent &buf,
+                                         uint8_t index) {
+  return buf.samples[(buf.tail + index) % InterpBufferComponent::N];
+}
+}  // namespace
+
+bool PushInterpSample(InterpBufferComponent &buf, uint32_t tick, float x,
+                      float y, uint8_t facing) {
+  if (buf.count > 0) {
+    const uint32_t newest = At(buf, buf.count - 1).tick;
+    // Far older than anything buffered means the server started over
+    if (tick + static_cast<uint32_t>(tickRate) < newest)
+      ResetInterpBuffer(buf);
+    else if (tick <= newest)
+      return false;
+  }
+
+  if (buf.count == InterpBufferComponent::N) {
+    buf.tail = static_cast<uint8_t>((buf.tail + 1) % InterpBufferComponent::N);
+    --buf.count;
+    if (buf.cursor > 0) --buf.cursor;
+  }
+  At(buf, buf.count) = {tick, x, y, facing};
+  ++buf.count;
+  return true;
+}
+
+bool SampleInterpBuffer(InterpBufferComponent &buf, double renderTick,
+                        float &outX, float &outY, uint8_t &outFacing) {
+  if (buf.count == 0) return false;
+
+  // Render time stepped back, e.g. the delay grew, start over from the oldest
+  if (buf.cursor >= buf.count || At(buf, buf.cursor).tick > renderTick)
+    buf.cursor = 0;
+  while (buf.cursor + 1 < buf.count &&
+         At(buf, buf.cursor + 1).tick <= renderTick)
+    ++buf.cursor;
+
+  const InterpBufferComponent::Sample &s0 = At(buf, buf.cursor);
+  if (buf.cursor + 1 == buf.count || renderTick <= s0.tick) {
+    outX = s0.x;
+    outY = s0.y;
+    outFacing = s0.facing;
+    return true;
+  }
+
+  const InterpBufferComponent::Sample &s1 = At(buf, buf.cursor + 1);
+  const double a = (renderTick - s0.tick) / (s1.tick - s0.tick);
+  outX = static_cast<float>(s0.x + (s1.x - s0.x) * a);
+  outY = static_cast<float>(s0.y + (s1.y - s0.y) * a);
+  outFacing = s1.facing;
+  return true;
+}
+
+void ResetInterpBuffer(InterpBufferComponent &buf) {
+  buf.tail = 0;
+  buf.count = 0;
+  buf.cursor = 0;
+}
+
+}  // namespace util
@@ -0,0 +1,22 @@
+#include "Util/ReplicationUtil.h"
+
+#include "Components/NetIdentityComponent.h"
+#include "Core/Registry.h"
+
+namespace util {
+
+void MarkReplicationDirty(Registry* registry, EntityID entity,
+                          EReplicatedComponent component) {
+  if (!registry || entity == INVALID_ENTITY) return;
+  if (!registry->HasComponent<NetIdentityComponent>(entity)) return;
+  if (!registry->GetComponent<NetIdentityComponent>(entity).bIsAuthority)
+    return;
+
+  if (!registry->HasComponent<ReplicationDirtyTag>(entity)) {
+    registry->EmplaceComponent<ReplicationDirtyTag>(entity);
+  }
+  registry->GetComponent<ReplicationDirtyTag>(entity).componentMask |=
+      ReplicationBit(component);
+}
+
+}  // namespace util
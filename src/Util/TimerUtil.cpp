@@ -47,4 +47,21 @@ void DetachTimer(Registry* registry, TimerManager* timerManager,
   }
 }
 
+bool HasTimer(Registry* registry, EntityID entity, TimerId id) {
+  if (!registry || !registry->HasComponent<TimerComponent>(entity))
+    return false;
+  return registry->GetComponent<TimerComponent>(entity)
+             .timers[static_cast<int>(id)] != INVALID_TIMER_HANDLE;
+}
+
+TimerInstance* GetTimer(Registry* registry, TimerManager* timerManager,
+                        EntityID entity, TimerId id) {
+  if (!timerManager || !registry ||
+      !registry->HasComponent<TimerComponent>(entity))
+    return nullptr;
+  return timerManager->GetTimer(
+      registry->GetComponent<TimerComponent>(entity)
+          .timers[static_cast<int>(id)]);
+}
+
 }  // namespace util
@@ -0,0 +1,157 @@
+#include <iostream>
+#include <vector>
+
+#include "Components/AnimationComponent.h"
+#include "Components/AssemblingMachineComponent.h"
+#include "Components/FrozenComponent.h"
+#include "Components/InactiveComponent.h"
+#include "Components/NetIdentityComponent.h"
+#include "Components/TimerComponent.h"
+#include "Core/Event.h"
+#include "Core/EventDispatcher.h"
+#include "Core/Item.h"
+#include "Core/Registry.h"
+#include "Core/SystemContext.h"
+#include "Core/TimerManager.h"
+#include "System/AssemblingMachineSystem.h"
+#include "SDL.h"
+
+namespace {
+constexpr EntityID kPlayer = 100;
+
+struct Fixture {
+  EventDispatcher eventDispatcher;
+  Registry registry{&eventDispatcher};
+  TimerManager timerManager;
+  std::unique_ptr<AssemblingMachineSystem> system;
+  std::unique_ptr<EventHandle> consumeHandle;
+  std::vector<int> consumed;
+  EntityID machine = INVALID_ENTITY;
+
+  Fixture() {
+    registry.RegisterComponent<AssemblingMachineComponent>();
+    registry.RegisterComponent<NetIdentityComponent>();
+    registry.RegisterComponent<ReplicationDirtyTag>();
+    registry.RegisterComponent<AnimationComponent>();
+    registry.RegisterComponent<FrozenComponent>();
+    registry.RegisterComponent<InactiveComponent>();
+    registry.RegisterComponent<TimerComponent>();
+    SystemContext context;
+    context.registry = &registry;
+    context.eventDispatcher = &eventDispatcher;
+    context.timerManager = &timerManager;
+    context.bIsServer = true;
+    system = std::make_unique<AssemblingMachineSystem>(context);
+    consumeHandle = eventDispatcher.Subscribe<ItemConsumeEvent>(
+        [this](const ItemConsumeEvent& e) { consumed.push_back(e.amount); });
+
+    machine = registry.CreateEntity();
+    registry.AddComponent<AssemblingMachineComponent>(
+        machine, AssemblingMachineComponent{});
+  }
+
+  int& Input(ItemID item) {
+    return registry.GetComponent<AssemblingMachineComponent>(machine)
+        .inputInventory[item];
+  }
+};
+}  // namespace
+
+bool test_add_input_fills_up_to_the_stack() {
+  Fixture fixture;
+  const int stack =
+      ItemDatabase::instance().get(ItemID::IronPlate).maxStackSize;
+  fixture.Input(ItemID::IronPlate) = stack - 3;
+
+  fixture.eventDispatcher.Publish(
+      AssemblyAddInputEvent{fixture.machine, kPlayer, ItemID::IronPlate, 10});
+  if (fixture.Input(ItemID::IronPlate) != stack ||
+      fixture.consumed != std::vector<int>{3}) {
+    std::cerr << "Partial add took " << fixture.Input(ItemID::IronPlate)
+              << " of " << stack << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_full_machine_takes_nothing() {
+  Fixture fixture;
+  const int stack =
+      ItemDatabase::instance().get(ItemID::IronPlate).maxStackSize;
+  fixture.Input(ItemID::IronPlate) = stack;
+
+  // A consume of -1 used to hand the player an item from nothing
+  for (int i = 0; i < 3; ++i) {
+    fixture.eventDispatcher.Publish(AssemblyAddInputEvent{
+        fixture.machine, kPlayer, ItemID::IronPlate, 1});
+  }
+  if (fixture.system->AddInputItem(fixture.machine, ItemID::IronPlate, 5) !=
+      0) {
+    std::cerr << "Full machine reported a negative amount added" << std::endl;
+    return false;
+  }
+  if (!fixture.consumed.empty() || fixture.Input(ItemID::IronPlate) != stack) {
+    std::cerr << "Full machine changed the player's inventory by "
+              << fixture.consumed.size() << " events" << std::endl;
+    return false;
+  }
+
+  // Not a machine at all
+  if (fixture.system->AddInputItem(kPlayer, ItemID::IronPlate, 5) != 0) {
+    std::cerr << "Added input to an entity without a machine" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_restored_machine_keeps_its_cycle() {
+  Fixture fixture;
+  auto& machine =
+      fixture.registry.GetComponent<AssemblingMachineComponent>(
+          fixture.machine);
+  machine.currentRecipe = RecipeID::IronGear;
+  machine.state = AssemblingMachineState::Crafting;
+  const RecipeData& recipe = RecipeDatabase::instance().get(RecipeID::IronGear);
+
+  // Evicted a tenth of a second before its craft finished
+  fixture.registry.AddComponent<FrozenComponent>(
+      fixture.machine, FrozenComponent{0.0, recipe.craftingTime - 0.1f});
+  fixture.timerManager.Advance(0.2f);
+  fixture.system->Update();
+
+  auto it = machine.outputInventory.find(recipe.outputItem);
+  if (it == machine.outputInventory.end() ||
+      it->second != recipe.outputAmount) {
+    std::cerr << "Restored machine started its cycle over" << std::endl;
+    return false;
+  }
+  if (fixture.registry.HasComponent<FrozenComponent>(fixture.machine)) {
+    std::cerr << "Restored machine was not thawed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_add_input_fills_up_to_the_stack()) {
+    all_passed = false;
+  }
+
+  if (!test_full_machine_takes_nothing()) {
+    all_passed = false;
+  }
+
+  if (!test_restored_machine_keeps_its_cycle()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All AssemblingMachine tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some AssemblingMachine tests failed!" << std::endl;
+    return 1;
+  }
+}
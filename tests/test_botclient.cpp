@@ -0,0 +1,202 @@
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Core/BotClient.h"
+#include "Core/Packet.h"
+#include "Core/PacketAssembler.h"
+#include "Core/PacketSchema.h"
+#include "SDL.h"
+#include "Util/PacketUtil.h"
+
+namespace {
+// Sends a packet from the fake server to the bot
+bool Deliver(BotClient& bot, const PacketPtr& packet, double now) {
+  const uint8_t* rp = packet.get();
+  PACKET packetId;
+  std::size_t packetSize;
+  util::GetHeader(rp, packetId, packetSize);
+  return bot.OnReceive(packet.get(), packetSize, now);
+}
+
+// Splits what the bot sent back into packets
+std::vector<PacketPtr> Collect(std::vector<uint8_t>& out) {
+  PacketAssembler assembler;
+  assembler.Feed(out.data(), out.size());
+  out.clear();
+
+  std::vector<PacketPtr> packets;
+  PacketPtr packet;
+  while (assembler.Next(packet)) packets.push_back(std::move(packet));
+  return packets;
+}
+
+bool Connect(BotClient& bot, std::vector<uint8_t>& out) {
+  bot.Start(out);
+  std::vector<PacketPtr> sent = Collect(out);
+  if (sent.size() != 1) return false;
+
+  PacketReader reader(sent[0].get());
+  auto syn = reader.ReadHeader<CONNECT_SYN>();
+  if (!syn || std::get<0>(*syn) != bot.GetName()) return false;
+
+  PacketWriter ack(CONNECT_ACK, PayloadSize<CONNECT_ACK>());
+  ack.WriteHeader<CONNECT_ACK>(clientid_t{42}, uint64_t{7}, uint16_t{0});
+  return Deliver(bot, ack.Finish(), 0.0) && bot.IsConnected();
+}
+}  // namespace
+
+bool test_percentile() {
+  std::vector<double> samples;
+  for (int i = 100; i >= 1; --i) samples.push_back(i);
+
+  if (BotStats::Percentile(samples, 50.0) != 50.0 ||
+      BotStats::Percentile(samples, 99.0) != 99.0 ||
+      BotStats::Percentile(samples, 100.0) != 100.0 ||
+      BotStats::Percentile(samples, 0.0) != 1.0) {
+    std::cerr << "Percentile is not nearest-rank" << std::endl;
+    return false;
+  }
+  std::vector<double> empty;
+  return BotStats::Percentile(empty, 50.0) == 0.0;
+}
+
+bool test_connect_and_move() {
+  BotStats stats;
+  BotClient bot(3, 1, &stats, 0.f);
+  std::vector<uint8_t> out;
+
+  bot.Tick(0.0, out);
+  if (!out.empty()) {
+    std::cerr << "Bot moved before CONNECT_ACK" << std::endl;
+    return false;
+  }
+  if (!Connect(bot, out) || bot.GetClientID() != 42 ||
+      stats.connectedCount != 1) {
+    std::cerr << "Bot did not complete the handshake" << std::endl;
+    return false;
+  }
+
+  // Every input must be covered by some CLIENT_MOVE_REQ batch
+  uint16_t newestSent = 0;
+  for (int tick = 1; tick <= 60; ++tick) {
+    bot.Tick(tick * syncDelta, out);
+    for (const PacketPtr& packet : Collect(out)) {
+      PacketReader reader(packet.get());
+      auto header = reader.ReadHeader<CLIENT_MOVE_REQ>();
+      if (!header) {
+        std::cerr << "Bot sent something other than CLIENT_MOVE_REQ"
+                  << std::endl;
+        return false;
+      }
+      const auto [newest, count] = *header;
+      const uint16_t oldest = static_cast<uint16_t>(newest - count + 1);
+      if (count == 0 || count > kMaxMoveBatch ||
+          reader.GetRemaining() != static_cast<std::size_t>((count + 1) / 2) ||
+          util::seq_gt(oldest, static_cast<uint16_t>(newestSent + 1))) {
+        std::cerr << "CLIENT_MOVE_REQ batch left a gap at " << newest
+                  << std::endl;
+        return false;
+      }
+      newestSent = newest;
+    }
+  }
+  if (util::seq_gt(bot.GetInputSequence(),
+                   static_cast<uint16_t>(newestSent + kMoveBatchTicks))) {
+    std::cerr << "Inputs were held back for too long" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_round_trip_time() {
+  BotStats stats;
+  BotClient bot(0, 7, &stats, 0.f);
+  std::vector<uint8_t> out;
+  if (!Connect(bot, out)) return false;
+
+  // Unchanged inputs wait for the batch, tick until one goes out
+  std::vector<PacketPtr> sent;
+  for (int tick = 0; tick < kMoveBatchTicks && sent.empty(); ++tick) {
+    bot.Tick(1.0, out);
+    sent = Collect(out);
+  }
+  if (sent.empty()) {
+    std::cerr << "No CLIENT_MOVE_REQ within a batch" << std::endl;
+    return false;
+  }
+  PacketReader reader(sent[0].get());
+  const uint16_t seq = std::get<0>(*reader.ReadHeader<CLIENT_MOVE_REQ>());
+
+  if (!Deliver(bot, MakePacket<CLIENT_MOVE_RES>(seq, 0.f, 0.f), 1.05)) {
+    return false;
+  }
+  // Duplicates and stale acks are not sampled again
+  Deliver(bot, MakePacket<CLIENT_MOVE_RES>(seq, 0.f, 0.f), 1.2);
+
+  if (stats.roundTripMs.size() != 1 ||
+      std::abs(stats.roundTripMs[0] - 50.0) > 1e-6) {
+    std::cerr << "RTT sample wrong: " << stats.roundTripMs.size()
+              << " samples" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_snapshot_jitter() {
+  BotStats stats;
+  BotClient bot(0, 7, &stats, 0.f);
+  std::vector<uint8_t> out;
+  if (!Connect(bot, out)) return false;
+
+  PacketWriter snapshot(TRANSFORM_SNAPSHOT, PayloadSize<TRANSFORM_SNAPSHOT>());
+  snapshot.WriteHeader<TRANSFORM_SNAPSHOT>(uint32_t{1}, uint16_t{0});
+  PacketPtr packet = snapshot.Finish();
+
+  // Perfectly regular arrivals: intervals recorded, jitter stays at 0
+  for (int i = 0; i < 5; ++i) Deliver(bot, packet, i * 0.1);
+  if (stats.snapshotIntervalMs.size() != 4 ||
+      std::abs(stats.snapshotIntervalMs.back() - 100.0) > 1e-6 ||
+      stats.snapshotJitterMs.back() > 1e-6) {
+    std::cerr << "Regular snapshots reported jitter" << std::endl;
+    return false;
+  }
+
+  // One late arrival raises the smoothed jitter by 1/16 of the deviation
+  Deliver(bot, packet, 0.4 + 0.26);
+  if (std::abs(stats.snapshotJitterMs.back() - 160.0 / 16.0) > 1e-6) {
+    std::cerr << "Late snapshot jitter: " << stats.snapshotJitterMs.back()
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_percentile()) {
+    all_passed = false;
+  }
+
+  if (!test_connect_and_move()) {
+    all_passed = false;
+  }
+
+  if (!test_round_trip_time()) {
+    all_passed = false;
+  }
+
+  if (!test_snapshot_jitter()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All BotClient tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some BotClient tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,145 @@
+#include <iostream>
+#include <vector>
+
+#include "Core/Chunk.h"
+#include "SDL.h"
+
+bool test_sparse_layers() {
+  Chunk chunk(-1, 2);
+  const int a = Chunk::GetLocalIndex(0, 0);
+  const int b = Chunk::GetLocalIndex(5, 3);
+  const int c = Chunk::kTileCount - 1;
+
+  if (chunk.HasAnyOccupant() || chunk.GetOccupyingEntity(b) != INVALID_ENTITY) {
+    std::cerr << "New chunk has occupants" << std::endl;
+    return false;
+  }
+
+  // Out of order on purpose, the layer keeps them sorted
+  chunk.SetOccupyingEntity(c, 30);
+  chunk.SetOccupyingEntity(a, 10);
+  chunk.SetOccupyingEntity(b, 20);
+  chunk.SetOreEntity(b, 99);
+  if (!chunk.HasAnyOccupant() || chunk.GetOccupyingEntity(a) != 10 ||
+      chunk.GetOccupyingEntity(b) != 20 || chunk.GetOccupyingEntity(c) != 30 ||
+      chunk.GetOreEntity(b) != 99 || chunk.GetOreEntity(a) != INVALID_ENTITY) {
+    std::cerr << "Layers returned the wrong entities" << std::endl;
+    return false;
+  }
+
+  int previous = -1;
+  int visited = 0;
+  bool bSorted = true;
+  chunk.GetOccupants().ForEach([&](uint16_t index, EntityID) {
+    bSorted = bSorted && index > previous;
+    previous = index;
+    ++visited;
+  });
+  if (!bSorted || visited != 3) {
+    std::cerr << "Occupants not visited in tile order" << std::endl;
+    return false;
+  }
+
+  chunk.SetOccupyingEntity(b, 21);
+  chunk.SetOccupyingEntity(a, INVALID_ENTITY);
+  chunk.SetOccupyingEntity(c, INVALID_ENTITY);
+  if (chunk.GetOccupyingEntity(b) != 21 || chunk.HasOccupant(a) ||
+      chunk.HasOccupant(c)) {
+    std::cerr << "Replace or clear failed" << std::endl;
+    return false;
+  }
+  chunk.SetOccupyingEntity(b, INVALID_ENTITY);
+  if (chunk.HasAnyOccupant() || chunk.GetOreEntity(b) != 99) {
+    std::cerr << "Clearing occupants touched the ore layer" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_types_and_indices() {
+  // A size that is not a multiple of 64 leaves a partial mask word
+  BasicChunk<5, 3> chunk(-2, -1);
+  for (int i = 0; i < chunk.kTileCount; ++i) {
+    if (chunk.GetType(i) != TileType::Invalid) {
+      std::cerr << "New tile is not Invalid" << std::endl;
+      return false;
+    }
+  }
+  chunk.SetType(decltype(chunk)::GetLocalIndex(4, 2), TileType::Water);
+  if (chunk.GetTypes()[14] != static_cast<uint8_t>(TileType::Water)) {
+    std::cerr << "Types are not row major" << std::endl;
+    return false;
+  }
+  chunk.SetOreEntity(14, 7);
+  if (chunk.GetOreEntity(14) != 7 || chunk.HasAnyOccupant()) return false;
+
+  // World tile -1 is the last column of chunk -1, -10 the first of chunk -2
+  const Vec2 local = chunk.GetLocalTileIndex(-6, -1);
+  if (local.x != 4 || local.y != 2) {
+    std::cerr << "Local index of a negative tile is " << local.x << ":"
+              << local.y << std::endl;
+    return false;
+  }
+  if (!decltype(chunk)::IsInside(4, 2) || decltype(chunk)::IsInside(5, 0)) {
+    std::cerr << "IsInside disagrees with the chunk size" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_dirty_tiles() {
+  // Spans two mask words
+  BasicChunk<10, 10> chunk(0, 0);
+  if (chunk.HasDirtyTiles()) {
+    std::cerr << "New chunk has dirty tiles" << std::endl;
+    return false;
+  }
+  for (int i = 0; i < chunk.kTileCount; ++i) chunk.SetType(i, TileType::Dirt);
+  int filled = 0;
+  chunk.ForEachDirtyTile([&](int) { ++filled; });
+  if (filled != chunk.kTileCount) {
+    std::cerr << "Filling flagged " << filled << " tiles" << std::endl;
+    return false;
+  }
+  chunk.ClearDirtyTiles();
+
+  // Writing the same type again is not a change
+  chunk.SetType(3, TileType::Dirt);
+  chunk.SetType(70, TileType::Stone);
+  chunk.SetType(5, TileType::Water);
+  chunk.SetType(70, TileType::Dirt);
+  std::vector<int> changed;
+  chunk.ForEachDirtyTile([&](int index) { changed.push_back(index); });
+  if (changed != std::vector<int>{5, 70}) {
+    std::cerr << "Expected tiles 5 and 70 dirty, got " << changed.size()
+              << " tiles" << std::endl;
+    return false;
+  }
+  chunk.ClearDirtyTiles();
+  if (chunk.HasDirtyTiles()) return false;
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_sparse_layers()) {
+    all_passed = false;
+  }
+
+  if (!test_types_and_indices()) {
+    all_passed = false;
+  }
+
+  if (!test_dirty_tiles()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All Chunk tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some Chunk tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,183 @@
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Core/ChunkCache.h"
+#include "SDL.h"
+
+namespace {
+constexpr std::size_t kChunkBytes = 100;
+
+std::unique_ptr<Chunk> MakeChunk(int x, int y) {
+  auto chunk = std::make_unique<Chunk>(x, y);
+  chunk->SetType(0, TileType::Water);
+  return chunk;
+}
+
+bool IsLive(ChunkCache& cache, ChunkCoord coord) {
+  return cache.Find(coord) != nullptr;
+}
+}  // namespace
+
+bool test_least_recently_used_out() {
+  ChunkCache cache(3 * kChunkBytes);
+  for (int x = 0; x < 3; ++x) cache.Insert(MakeChunk(x, 0), kChunkBytes);
+  if (cache.PopOverBudget() != nullptr) {
+    std::cerr << "Evicted while within the budget" << std::endl;
+    return false;
+  }
+
+  // Taking chunk 0 and putting it back makes chunk 1 the oldest
+  std::vector<uint8_t> blob;
+  std::unique_ptr<Chunk> touched = cache.Extract({0, 0}, blob);
+  if (touched == nullptr || touched->GetType(0) != TileType::Water) {
+    std::cerr << "Live chunk did not come back whole" << std::endl;
+    return false;
+  }
+  cache.Insert(std::move(touched), kChunkBytes);
+  cache.Insert(MakeChunk(3, 0), kChunkBytes);
+
+  std::unique_ptr<Chunk> cold = cache.PopOverBudget();
+  if (cold == nullptr || cold->chunkX != 1) {
+    std::cerr << "Expected chunk 1 out first" << std::endl;
+    return false;
+  }
+  if (cache.PopOverBudget() != nullptr) {
+    std::cerr << "Evicted more than needed to fit" << std::endl;
+    return false;
+  }
+  if (IsLive(cache, {1, 0}) || !IsLive(cache, {0, 0}) ||
+      !IsLive(cache, {3, 0})) {
+    std::cerr << "Wrong chunks left live" << std::endl;
+    return false;
+  }
+
+  // One large chunk pushes several small ones out
+  cache.Insert(MakeChunk(4, 0), 2 * kChunkBytes);
+  int evicted = 0;
+  while (cache.PopOverBudget() != nullptr) ++evicted;
+  if (evicted != 2 || !IsLive(cache, {4, 0}) ||
+      cache.GetStats().liveBytes > 3 * kChunkBytes) {
+    std::cerr << "Large chunk evicted " << evicted << " chunks" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_blobs_and_counters() {
+  ChunkCache cache(kChunkBytes);
+  cache.Insert(MakeChunk(-1, 5), kChunkBytes);
+  cache.Insert(MakeChunk(2, -3), kChunkBytes);
+  std::unique_ptr<Chunk> cold = cache.PopOverBudget();
+  if (cold == nullptr || cold->chunkX != -1) return false;
+  cache.StoreBlob({-1, 5}, {1, 2, 3, 4});
+
+  std::vector<uint8_t> blob;
+  if (cache.Extract({2, -3}, blob) == nullptr || !blob.empty()) {
+    std::cerr << "Live chunk was not a hit" << std::endl;
+    return false;
+  }
+  if (cache.Extract({-1, 5}, blob) != nullptr ||
+      blob != std::vector<uint8_t>{1, 2, 3, 4}) {
+    std::cerr << "Blob did not come back" << std::endl;
+    return false;
+  }
+  // Each entry is handed out once
+  if (cache.Extract({-1, 5}, blob) != nullptr || !blob.empty()) {
+    std::cerr << "Blob was handed out twice" << std::endl;
+    return false;
+  }
+
+  const ChunkCacheStats& stats = cache.GetStats();
+  if (stats.hits != 1 || stats.blobHits != 1 || stats.misses != 1 ||
+      stats.evictions != 1) {
+    std::cerr << "Counters hits=" << stats.hits
+              << " blobHits=" << stats.blobHits << " misses=" << stats.misses
+              << " evictions=" << stats.evictions << std::endl;
+    return false;
+  }
+  if (stats.liveCount != 0 || stats.liveBytes != 0 || stats.blobCount != 0 ||
+      stats.blobBytes != 0) {
+    std::cerr << "Empty cache still accounts for memory" << std::endl;
+    return false;
+  }
+
+  // A chunk cached again replaces its stale blob
+  cache.StoreBlob({7, 7}, std::vector<uint8_t>(10));
+  cache.Insert(MakeChunk(7, 7), kChunkBytes);
+  if (stats.blobCount != 0 || stats.blobBytes != 0 || stats.liveCount != 1) {
+    std::cerr << "Stale blob survived a newer chunk" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_blob_budget() {
+  ChunkCache cache(kChunkBytes, 3 * kChunkBytes);
+  for (int x = 0; x < 3; ++x)
+    cache.StoreBlob({x, 0}, std::vector<uint8_t>(kChunkBytes, x));
+
+  ChunkCoord coord;
+  std::vector<uint8_t> blob;
+  if (cache.PopBlobOverBudget(coord, blob)) {
+    std::cerr << "Blobs within budget were handed back" << std::endl;
+    return false;
+  }
+
+  // Storing a newer blob of {0, 0} makes {1, 0} the oldest
+  cache.StoreBlob({0, 0}, std::vector<uint8_t>(kChunkBytes, 9));
+  cache.StoreBlob({3, 0}, std::vector<uint8_t>(2 * kChunkBytes, 3));
+  std::vector<ChunkCoord> popped;
+  while (cache.PopBlobOverBudget(coord, blob)) {
+    if (blob.empty() || blob[0] != coord.x) {
+      std::cerr << "Blob of " << coord.x << " came back wrong" << std::endl;
+      return false;
+    }
+    popped.push_back(coord);
+  }
+  if (popped.size() != 2 || popped[0].x != 1 || popped[1].x != 2) {
+    std::cerr << "Handed back " << popped.size()
+              << " blobs, not the oldest two" << std::endl;
+    return false;
+  }
+
+  const ChunkCacheStats& stats = cache.GetStats();
+  if (stats.blobCount != 2 || stats.blobBytes != 3 * kChunkBytes ||
+      stats.blobEvictions != 2) {
+    std::cerr << "Blob counters count=" << stats.blobCount
+              << " bytes=" << stats.blobBytes
+              << " evictions=" << stats.blobEvictions << std::endl;
+    return false;
+  }
+  if (cache.Extract({0, 0}, blob) != nullptr ||
+      blob != std::vector<uint8_t>(kChunkBytes, 9)) {
+    std::cerr << "Newest blob of a chunk was lost" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_least_recently_used_out()) {
+    all_passed = false;
+  }
+
+  if (!test_blobs_and_counters()) {
+    all_passed = false;
+  }
+
+  if (!test_blob_budget()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All ChunkCache tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some ChunkCache tests failed!" << std::endl;
+    return 1;
+  }
+}
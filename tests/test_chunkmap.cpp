@@ -0,0 +1,131 @@
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+
+#include "Core/Chunk.h"
+#include "Core/ChunkMap.h"
+#include "SDL.h"
+
+bool test_matches_std_map() {
+  // Random inserts and extracts over a small area keep long probe clusters
+  // and exercise the backward shift
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> coord(-12, 12);
+  std::uniform_int_distribution<int> action(0, 2);
+  ChunkMap chunks;
+  std::map<ChunkCoord, EntityID> expected;
+
+  for (int i = 0; i < 20000; ++i) {
+    const ChunkCoord at{coord(rng), coord(rng)};
+    if (action(rng) == 0) {
+      std::unique_ptr<Chunk> chunk = chunks.Extract(at);
+      const bool bExpected = expected.erase(at) != 0;
+      if ((chunk != nullptr) != bExpected) {
+        std::cerr << "Extract of " << at.x << ":" << at.y << " disagrees"
+                  << std::endl;
+        return false;
+      }
+    } else {
+      Chunk& chunk = chunks.Emplace(at.x, at.y);
+      chunk.chunkEntity = static_cast<EntityID>(i + 1);
+      expected[at] = chunk.chunkEntity;
+    }
+
+    const ChunkCoord probe{coord(rng), coord(rng)};
+    const Chunk* found = chunks.Find(probe.x, probe.y);
+    auto it = expected.find(probe);
+    if ((found != nullptr) != (it != expected.end()) ||
+        (found != nullptr && found->chunkEntity != it->second)) {
+      std::cerr << "Find of " << probe.x << ":" << probe.y << " disagrees"
+                << std::endl;
+      return false;
+    }
+  }
+
+  if (chunks.Size() != expected.size()) {
+    std::cerr << "Expected " << expected.size() << " chunks, got "
+              << chunks.Size() << std::endl;
+    return false;
+  }
+  std::size_t visited = 0;
+  bool bAllKnown = true;
+  chunks.ForEach([&](const Chunk& chunk) {
+    ++visited;
+    if (!expected.count({chunk.chunkX, chunk.chunkY})) bAllKnown = false;
+  });
+  if (visited != expected.size() || !bAllKnown) {
+    std::cerr << "ForEach visited the wrong chunks" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_pointers_survive_growth() {
+  ChunkMap chunks;
+  Chunk* first = &chunks.Emplace(0, 0);
+  first->SetType(Chunk::GetLocalIndex(3, 4), TileType::Stone);
+
+  for (int i = 1; i < 1000; ++i) chunks.Emplace(i, -i);
+  if (chunks.Find(0, 0) != first ||
+      first->GetType(Chunk::GetLocalIndex(3, 4)) != TileType::Stone) {
+    std::cerr << "Chunk moved when the table grew" << std::endl;
+    return false;
+  }
+
+  // Moving a chunk to another map keeps its tiles where they are
+  ChunkMap cache;
+  cache.Insert(chunks.Extract({0, 0}));
+  if (chunks.Find(0, 0) != nullptr || cache.Find(0, 0) != first) {
+    std::cerr << "Extracted chunk was not handed over" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_last_chunk_cache_invalidated() {
+  ChunkMap chunks;
+  chunks.Emplace(-1, -1);
+  // Cached by the first lookup, must not survive the extract
+  if (chunks.Find(-1, -1) == nullptr) return false;
+  chunks.Extract({-1, -1});
+  if (chunks.Find(-1, -1) != nullptr || chunks.Contains({-1, -1})) {
+    std::cerr << "Extracted chunk still found through the cache"
+              << std::endl;
+    return false;
+  }
+
+  // Replacing a cached chunk returns the new one
+  chunks.Emplace(2, 2);
+  Chunk* old = chunks.Find(2, 2);
+  Chunk* replaced = &chunks.Emplace(2, 2);
+  if (chunks.Find(2, 2) != replaced || chunks.Size() != 1 || old == nullptr) {
+    std::cerr << "Replaced chunk still found through the cache" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_matches_std_map()) {
+    all_passed = false;
+  }
+
+  if (!test_pointers_survive_growth()) {
+    all_passed = false;
+  }
+
+  if (!test_last_chunk_cache_invalidated()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All ChunkMap tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some ChunkMap tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,180 @@
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <thread>
+#include <vector>
+
+#include "Core/ChunkPipeline.h"
+#include "Core/WorldGenerator.h"
+#include "SDL.h"
+
+namespace {
+// Waits for the pipeline to finish count chunks, gives up after a few seconds
+std::list<GeneratedChunk> Collect(ChunkPipeline& pipeline, std::size_t count) {
+  std::list<GeneratedChunk> done;
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (done.size() < count && std::chrono::steady_clock::now() < deadline) {
+    pipeline.TakeCompleted(done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return done;
+}
+
+bool SameChunk(const GeneratedChunk& a, const GeneratedChunk& b) {
+  return a.chunk.chunkX == b.chunk.chunkX && a.chunk.chunkY == b.chunk.chunkY &&
+         a.ores == b.ores && a.chunk.GetTypes() == b.chunk.GetTypes();
+}
+}  // namespace
+
+bool test_matches_synchronous_generation() {
+  const WorldGenerator generator;
+  ChunkPipeline pipeline(4);
+  for (int y = -3; y <= 3; ++y) {
+    for (int x = -3; x <= 3; ++x) pipeline.Request({x, y}, x * x + y * y);
+  }
+
+  std::list<GeneratedChunk> done = Collect(pipeline, 49);
+  if (done.size() != 49) {
+    std::cerr << "Expected 49 chunks, got " << done.size() << std::endl;
+    return false;
+  }
+  bool bHasOre = false;
+  for (const GeneratedChunk& generated : done) {
+    const ChunkCoord coord{generated.chunk.chunkX, generated.chunk.chunkY};
+    if (pipeline.IsPending(coord)) {
+      std::cerr << "Taken chunk is still pending" << std::endl;
+      return false;
+    }
+    if (!SameChunk(generated, generator.Generate(coord))) {
+      std::cerr << "Chunk " << coord.x << ":" << coord.y
+                << " differs from the synchronous one" << std::endl;
+      return false;
+    }
+    for (const auto& [index, amount] : generated.ores) {
+      if (generated.chunk.GetType(index) != TileType::Stone) return false;
+    }
+    bHasOre = bHasOre || !generated.ores.empty();
+  }
+  if (!bHasOre) {
+    std::cerr << "No ore in 49 chunks, ore generation is not exercised"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_canceled_chunks_dropped() {
+  ChunkPipeline pipeline(2);
+  for (int x = 0; x < 40; ++x) pipeline.Request({x, 0}, x);
+  // Odd chunks left the view, some may already be running or done
+  for (int x = 1; x < 40; x += 2) pipeline.Cancel({x, 0});
+  for (int x = 1; x < 40; x += 2) {
+    if (pipeline.IsPending({x, 0})) {
+      std::cerr << "Canceled chunk is still pending" << std::endl;
+      return false;
+    }
+  }
+
+  std::list<GeneratedChunk> done = Collect(pipeline, 20);
+  // Give a late worker the chance to publish a canceled chunk
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  pipeline.TakeCompleted(done);
+  if (done.size() != 20) {
+    std::cerr << "Expected 20 chunks, got " << done.size() << std::endl;
+    return false;
+  }
+  for (const GeneratedChunk& generated : done) {
+    if (generated.chunk.chunkX % 2 != 0) {
+      std::cerr << "Canceled chunk " << generated.chunk.chunkX
+                << " was delivered" << std::endl;
+      return false;
+    }
+  }
+
+  // Coming back into view after a cancel generates it again
+  pipeline.Request({1, 0}, 0);
+  done = Collect(pipeline, 1);
+  if (done.size() != 1 || done.front().chunk.chunkX != 1) {
+    std::cerr << "Re-requested chunk was not generated" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_lowest_priority_first() {
+  constexpr int kFillers = 2000;
+  // Fillers the worker may finish between two of the Request calls below
+  constexpr int kSlack = 32;
+  ChunkPipeline pipeline(1);
+  // Far chunks keep the single worker busy while the near ones are queued
+  for (int x = 0; x < kFillers; ++x) pipeline.Request({x, 5}, 1000);
+  std::list<GeneratedChunk> done;
+  pipeline.TakeCompleted(done);
+  const int before = static_cast<int>(done.size());
+  if (kFillers - before < 4 * kSlack) {
+    std::cerr << "Worker finished " << before
+              << " fillers before the near chunks were queued" << std::endl;
+    return false;
+  }
+
+  for (int x = 0; x < 10; ++x) pipeline.Request({x, 0}, x);
+  // Bumping a queued chunk moves it to the front
+  pipeline.Request({kFillers - 1, 5}, -1);
+
+  done.splice(done.end(), Collect(pipeline, kFillers + 10 - before));
+  if (done.size() != kFillers + 10) {
+    std::cerr << "Expected " << kFillers + 10 << " chunks, got "
+              << done.size() << std::endl;
+    return false;
+  }
+
+  // Near chunks overtake the fillers still queued when they were requested
+  int position = 0;
+  int lastNear = -1;
+  int bumped = -1;
+  int previousX = -1;
+  for (const GeneratedChunk& generated : done) {
+    if (generated.chunk.chunkY == 0) {
+      if (generated.chunk.chunkX < previousX) {
+        std::cerr << "Near chunks came out of priority order" << std::endl;
+        return false;
+      }
+      previousX = generated.chunk.chunkX;
+      lastNear = position;
+    } else if (generated.chunk.chunkX == kFillers - 1) {
+      bumped = position;
+    }
+    ++position;
+  }
+  if (lastNear > before + kSlack || bumped > before + kSlack) {
+    std::cerr << "Prioritized chunks waited behind the queue, near at "
+              << lastNear << " bumped at " << bumped << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_matches_synchronous_generation()) {
+    all_passed = false;
+  }
+
+  if (!test_canceled_chunks_dropped()) {
+    all_passed = false;
+  }
+
+  if (!test_lowest_priority_first()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All ChunkPipeline tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some ChunkPipeline tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,273 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Core/ChunkStreamer.h"
+#include "Core/Packet.h"
+#include "Core/PacketSchema.h"
+#include "SDL.h"
+
+namespace {
+constexpr clientid_t kClient = 3;
+constexpr int kViewDistance = 2;
+constexpr int kTiles = CHUNK_WIDTH * CHUNK_HEIGHT;
+// Checkerboard, one run per tile and no ore, the largest terrain there is
+constexpr std::size_t kChunkPacketBytes =
+    sizeof(PacketHeader) + PayloadSize<CHUNK_DATA>(kTiles) +
+    PacketSchema<CHUNK_DATA>::OreHeader::kMinSize;
+
+PacketPtr EncodeChecker(ChunkCoord chunk) {
+  PacketWriter writer(CHUNK_DATA, kChunkPacketBytes - sizeof(PacketHeader));
+  writer.WriteHeader<CHUNK_DATA>(chunk.x, chunk.y, uint16_t{kTiles});
+  for (int i = 0; i < kTiles; ++i) {
+    const TileType type = i % 2 ? TileType::Grass : TileType::Dirt;
+    writer.WriteRecord<CHUNK_DATA>(uint16_t{1}, static_cast<uint8_t>(type));
+  }
+  writer.Write<PacketSchema<CHUNK_DATA>::OreHeader>(uint16_t{0});
+  return writer.Finish();
+}
+
+struct Received {
+  std::vector<ChunkCoord> loaded;
+  std::vector<ChunkCoord> unloaded;
+};
+
+Received Read(std::vector<PacketPtr>& packets) {
+  Received received;
+  for (const PacketPtr& packet : packets) {
+    PacketReader reader(packet.get());
+    if (reader.GetPacketId() == CHUNK_DATA) {
+      const auto [x, y, runs] = *reader.ReadHeader<CHUNK_DATA>();
+      received.loaded.push_back({x, y});
+    } else if (reader.GetPacketId() == CHUNK_UNLOAD) {
+      const auto [count] = *reader.ReadHeader<CHUNK_UNLOAD>();
+      for (uint16_t i = 0; i < count; ++i) {
+        const auto [x, y] = *reader.ReadRecord<CHUNK_UNLOAD>();
+        received.unloaded.push_back({x, y});
+      }
+    }
+  }
+  packets.clear();
+  return received;
+}
+
+// Flushes until the budget had time to send everything missing
+Received FlushAll(ChunkStreamer& streamer) {
+  std::vector<PacketPtr> packets;
+  Received all;
+  for (int i = 0; i < 20; ++i) {
+    streamer.Flush(kClient, 1.f, EncodeChecker, packets);
+    Received received = Read(packets);
+    all.loaded.insert(all.loaded.end(), received.loaded.begin(),
+                      received.loaded.end());
+    all.unloaded.insert(all.unloaded.end(), received.unloaded.begin(),
+                        received.unloaded.end());
+  }
+  return all;
+}
+
+int DistanceSq(ChunkCoord chunk, ChunkCoord center) {
+  const int dx = chunk.x - center.x;
+  const int dy = chunk.y - center.y;
+  return dx * dx + dy * dy;
+}
+}  // namespace
+
+bool test_nearest_first_within_budget() {
+  ChunkStreamer streamer(kViewDistance);
+  streamer.AddClient(kClient);
+  std::vector<PacketPtr> packets;
+
+  // Nothing to aim at before the player is known
+  streamer.Flush(kClient, 1.f, EncodeChecker, packets);
+  if (!packets.empty()) {
+    std::cerr << "Streamed chunks without a center" << std::endl;
+    return false;
+  }
+
+  streamer.SetCenter(kClient, {10, -4});
+  std::vector<ChunkCoord> order;
+  int flushes = 0;
+  while (order.size() < 25 && flushes < 1000) {
+    streamer.Flush(kClient, 0.01f, EncodeChecker, packets);
+    const std::size_t sent = packets.size();
+    for (const ChunkCoord& chunk : Read(packets).loaded) order.push_back(chunk);
+    ++flushes;
+
+    // A flush stops once the budget runs out, one packet may overdraw it
+    const std::size_t allowed =
+        static_cast<std::size_t>(kChunkBurstBytes / kChunkPacketBytes) + 1;
+    if (sent > allowed) {
+      std::cerr << "Flush sent " << sent << " chunks over its budget"
+                << std::endl;
+      return false;
+    }
+  }
+
+  if (order.size() != 25 || streamer.GetChunkCount(kClient) != 25) {
+    std::cerr << "Expected the 25 chunks of the view, got " << order.size()
+              << std::endl;
+    return false;
+  }
+  if (order.front() != ChunkCoord{10, -4}) {
+    std::cerr << "Center chunk was not sent first" << std::endl;
+    return false;
+  }
+  for (std::size_t i = 1; i < order.size(); ++i) {
+    if (DistanceSq(order[i], {10, -4}) < DistanceSq(order[i - 1], {10, -4})) {
+      std::cerr << "Chunks were not sent nearest first" << std::endl;
+      return false;
+    }
+  }
+  // 25 chunks at kChunkBytesPerSecond must take several flushes
+  if (flushes < 2) {
+    std::cerr << "Whole view went out in a single flush" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_unload_past_margin() {
+  ChunkStreamer streamer(kViewDistance);
+  streamer.AddClient(kClient);
+  streamer.SetCenter(kClient, {0, 0});
+  FlushAll(streamer);
+
+  // One chunk over keeps everything, within the margin
+  streamer.SetCenter(kClient, {1, 0});
+  Received moved = FlushAll(streamer);
+  if (!moved.unloaded.empty() || moved.loaded.size() != 5) {
+    std::cerr << "Step inside the margin unloaded " << moved.unloaded.size()
+              << " chunks" << std::endl;
+    return false;
+  }
+
+  // One more and the column at x = -2 is past it
+  streamer.SetCenter(kClient, {2, 0});
+  Received far = FlushAll(streamer);
+  if (far.unloaded.size() != 5) {
+    std::cerr << "Expected 5 unloads, got " << far.unloaded.size()
+              << std::endl;
+    return false;
+  }
+  for (const ChunkCoord& chunk : far.unloaded) {
+    if (chunk.x != -2 || streamer.HasChunk(kClient, chunk)) {
+      std::cerr << "Unloaded the wrong chunk " << chunk.x << ":" << chunk.y
+                << std::endl;
+      return false;
+    }
+  }
+  if (!streamer.HasChunk(kClient, {-1, 2})) {
+    std::cerr << "Chunk inside the margin was forgotten" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_unloaded_chunk_retried() {
+  ChunkStreamer streamer(kViewDistance);
+  streamer.AddClient(kClient);
+  streamer.SetCenter(kClient, {0, 0});
+  std::vector<PacketPtr> packets;
+
+  // Server has not loaded the center yet
+  auto partial = [](ChunkCoord chunk) -> PacketPtr {
+    if (chunk == ChunkCoord{0, 0}) return nullptr;
+    return EncodeChecker(chunk);
+  };
+  for (int i = 0; i < 100; ++i) streamer.Flush(kClient, 1.f, partial, packets);
+  Read(packets);
+  if (streamer.HasChunk(kClient, {0, 0}) ||
+      streamer.GetChunkCount(kClient) != 24) {
+    std::cerr << "Chunk that failed to encode counted as sent" << std::endl;
+    return false;
+  }
+
+  streamer.Flush(kClient, 1.f, EncodeChecker, packets);
+  Received received = Read(packets);
+  if (received.loaded.size() != 1 || received.loaded[0] != ChunkCoord{0, 0}) {
+    std::cerr << "Missing chunk was not retried" << std::endl;
+    return false;
+  }
+
+  // A resumed client starts over and gets everything again
+  streamer.RemoveClient(kClient);
+  streamer.AddClient(kClient);
+  streamer.SetCenter(kClient, {0, 0});
+  for (int i = 0; i < 100; ++i)
+    streamer.Flush(kClient, 1.f, EncodeChecker, packets);
+  if (Read(packets).loaded.size() != 25) {
+    std::cerr << "Re-added client did not get its view again" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_changed_chunk_resent() {
+  constexpr clientid_t kFar = 4;
+  ChunkStreamer streamer(kViewDistance);
+  streamer.AddClient(kClient);
+  streamer.SetCenter(kClient, {0, 0});
+  streamer.AddClient(kFar);
+  streamer.SetCenter(kFar, {20, 20});
+  FlushAll(streamer);
+  std::vector<PacketPtr> packets;
+  for (int i = 0; i < 20; ++i)
+    streamer.Flush(kFar, 1.f, EncodeChecker, packets);
+  Read(packets);
+
+  // Only clients holding the chunk get it again, once
+  streamer.ResendChunk({1, -1});
+  streamer.Flush(kFar, 1.f, EncodeChecker, packets);
+  if (!Read(packets).loaded.empty()) {
+    std::cerr << "Changed chunk sent to a client without it" << std::endl;
+    return false;
+  }
+  Received resent = FlushAll(streamer);
+  if (resent.loaded.size() != 1 || resent.loaded[0] != ChunkCoord{1, -1} ||
+      streamer.GetChunkCount(kClient) != 25) {
+    std::cerr << "Expected the changed chunk resent once, got "
+              << resent.loaded.size() << " chunks" << std::endl;
+    return false;
+  }
+
+  // A chunk unloaded before its resend is not sent back
+  streamer.ResendChunk({-2, 0});
+  streamer.SetCenter(kClient, {2, 0});
+  Received moved = FlushAll(streamer);
+  for (const ChunkCoord& chunk : moved.loaded) {
+    if (chunk == ChunkCoord{-2, 0}) {
+      std::cerr << "Unloaded chunk was resent" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_nearest_first_within_budget()) {
+    all_passed = false;
+  }
+
+  if (!test_unload_past_margin()) {
+    all_passed = false;
+  }
+
+  if (!test_unloaded_chunk_retried()) {
+    all_passed = false;
+  }
+
+  if (!test_changed_chunk_resent()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All ChunkStreamer tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some ChunkStreamer tests failed!" << std::endl;
+    return 1;
+  }
+}
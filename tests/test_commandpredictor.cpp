@@ -0,0 +1,334 @@
+#include <iostream>
+
+#include "Components/MovementComponent.h"
+#include "Components/TransformComponent.h"
+#include "Core/CommandPredictor.h"
+#include "Core/EventDispatcher.h"
+#include "Core/Registry.h"
+#include "SDL.h"
+
+namespace {
+void Register(Registry& registry) {
+  registry.RegisterComponent<TransformComponent>();
+  registry.RegisterComponent<MovementComponent>();
+}
+
+// Command moving an entity along x, as a replayable prediction
+CommandPredictor::ApplyFn MoveBy(EntityID entity, float dx) {
+  return [entity, dx](PredictionScope& scope) {
+    if (auto* transform = scope.Get<TransformComponent>(entity))
+      transform->position.x += dx;
+  };
+}
+
+float PositionX(Registry& registry, EntityID entity) {
+  return registry.GetComponent<TransformComponent>(entity).position.x;
+}
+}  // namespace
+
+bool test_confirm_keeps_prediction() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  EntityID entity = registry.CreateEntity();
+  registry.AddComponent<TransformComponent>(entity, Vec2f{0.f, 0.f});
+
+  CommandPredictor predictor(&registry);
+  const uint16_t first = predictor.Predict(MoveBy(entity, 5.f));
+  const uint16_t second = predictor.Predict(MoveBy(entity, 2.f));
+  if (first == second || PositionX(registry, entity) != 7.f) {
+    std::cerr << "Prediction was not applied at once" << std::endl;
+    return false;
+  }
+
+  predictor.Confirm(first);
+  predictor.Confirm(second);
+  if (predictor.GetPendingCount() != 0 || PositionX(registry, entity) != 7.f) {
+    std::cerr << "Confirmed commands changed state or stayed pending"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_reject_restores_dirtied_only() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  EntityID entity = registry.CreateEntity();
+  registry.AddComponent<TransformComponent>(entity, Vec2f{1.f, 0.f});
+  registry.AddComponent<MovementComponent>(entity, MovementComponent{1.f});
+
+  CommandPredictor predictor(&registry);
+  const uint16_t sequence = predictor.Predict(MoveBy(entity, 10.f));
+
+  // Not part of the command, must survive its rollback
+  registry.GetComponent<MovementComponent>(entity).speed = 3.f;
+
+  predictor.Reject(sequence);
+  if (PositionX(registry, entity) != 1.f) {
+    std::cerr << "Rejected command was not rolled back" << std::endl;
+    return false;
+  }
+  if (registry.GetComponent<MovementComponent>(entity).speed != 3.f) {
+    std::cerr << "Rollback touched a component the command never used"
+              << std::endl;
+    return false;
+  }
+  return predictor.GetPendingCount() == 0;
+}
+
+bool test_reject_replays_newer() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  EntityID entity = registry.CreateEntity();
+  registry.AddComponent<TransformComponent>(entity, Vec2f{0.f, 0.f});
+
+  CommandPredictor predictor(&registry);
+  int replays = 0;
+  const uint16_t rejected = predictor.Predict(MoveBy(entity, 5.f));
+  const uint16_t kept =
+      predictor.Predict([entity, &replays](PredictionScope& scope) {
+        if (scope.IsReplay()) ++replays;
+        if (auto* transform = scope.Get<TransformComponent>(entity))
+          transform->position.x *= 2.f;
+      });
+  if (PositionX(registry, entity) != 10.f) {
+    std::cerr << "Predictions applied out of order" << std::endl;
+    return false;
+  }
+
+  predictor.Reject(rejected);
+  if (replays != 1 || PositionX(registry, entity) != 0.f) {
+    std::cerr << "Newer command was not replayed without the rejected one: "
+              << PositionX(registry, entity) << std::endl;
+    return false;
+  }
+
+  // The replayed command must roll back to its replayed shadow
+  registry.GetComponent<TransformComponent>(entity).position.x = 4.f;
+  predictor.Predict(MoveBy(entity, 1.f));
+  predictor.Reject(kept);
+  if (PositionX(registry, entity) != 1.f || predictor.GetPendingCount() != 1) {
+    std::cerr << "Second rollback restored the wrong state: "
+              << PositionX(registry, entity) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_reject_keeps_replicated_state() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  EntityID entity = registry.CreateEntity();
+  registry.AddComponent<TransformComponent>(entity, Vec2f{0.f, 0.f});
+
+  CommandPredictor predictor(&registry);
+  const uint16_t rejected = predictor.Predict(MoveBy(entity, 5.f));
+  predictor.Predict(MoveBy(entity, 1.f));
+
+  // The server moved it meanwhile and will not resend an unchanged position
+  registry.GetComponent<TransformComponent>(entity).position.x = 20.f;
+  predictor.Rebase(entity);
+
+  predictor.Reject(rejected);
+  if (PositionX(registry, entity) != 21.f) {
+    std::cerr << "Rollback went back behind the replicated state: "
+              << PositionX(registry, entity) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_rebase_keeps_pending_commands() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  EntityID entity = registry.CreateEntity();
+  registry.AddComponent<TransformComponent>(entity, Vec2f{0.f, 0.f});
+  EntityID other = registry.CreateEntity();
+  registry.AddComponent<TransformComponent>(other, Vec2f{0.f, 0.f});
+
+  CommandPredictor predictor(&registry);
+  auto moveBoth = [entity, other](PredictionScope& scope) {
+    scope.Get<TransformComponent>(entity)->position.x += 5.f;
+    scope.Get<TransformComponent>(other)->position.x += 5.f;
+  };
+  // The confirmed command stays pending behind an unconfirmed older one
+  const uint16_t first = predictor.Predict(moveBoth);
+  const uint16_t confirmed = predictor.Predict(MoveBy(entity, 100.f));
+  predictor.Predict(MoveBy(entity, 1.f));
+  predictor.Confirm(confirmed);
+
+  // Server state with the confirmed command but without the pending ones
+  registry.GetComponent<TransformComponent>(entity).position.x = 120.f;
+  predictor.Rebase(entity);
+  if (PositionX(registry, entity) != 126.f ||
+      PositionX(registry, other) != 5.f) {
+    std::cerr << "Rebase lost or doubled predictions: "
+              << PositionX(registry, entity) << ", "
+              << PositionX(registry, other) << std::endl;
+    return false;
+  }
+
+  // Rolling back afterwards lands on the server's state
+  predictor.Reject(first);
+  if (PositionX(registry, entity) != 121.f ||
+      PositionX(registry, other) != 0.f) {
+    std::cerr << "Rollback after rebase restored the wrong state: "
+              << PositionX(registry, entity) << ", "
+              << PositionX(registry, other) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_created_entities() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  EntityID player = registry.CreateEntity();
+
+  int destroyed = 0;
+  CommandPredictor predictor(&registry, [&](EntityID entity) {
+    ++destroyed;
+    registry.DestroyEntity(entity);
+  });
+
+  auto build = [&registry, player](PredictionScope& scope) {
+    EntityID building = registry.CreateEntity();
+    registry.AddComponent<TransformComponent>(building, Vec2f{8.f, 8.f});
+    scope.TrackCreated(building);
+    // Component the player did not have before the command
+    if (!scope.Get<MovementComponent>(player))
+      registry.AddComponent<MovementComponent>(player, MovementComponent{});
+  };
+
+  const uint16_t rejected = predictor.Predict(build);
+  predictor.Reject(rejected);
+  if (destroyed != 1 || registry.HasComponent<MovementComponent>(player)) {
+    std::cerr << "Rollback left created entities or components behind"
+              << std::endl;
+    return false;
+  }
+
+  const uint16_t confirmed = predictor.Predict(build);
+  predictor.Confirm(confirmed);
+  if (destroyed != 2 || !registry.HasComponent<MovementComponent>(player)) {
+    std::cerr << "Confirm did not hand over the stand-in entity" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_confirm_then_spawn() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  EntityID player = registry.CreateEntity();
+  registry.AddComponent<TransformComponent>(player, Vec2f{0.f, 0.f});
+
+  int destroyed = 0;
+  CommandPredictor predictor(&registry, [&](EntityID entity) {
+    ++destroyed;
+    registry.DestroyEntity(entity);
+  });
+
+  static constexpr uint64_t kTile = 42;
+  EntityID standIn = INVALID_ENTITY;
+  auto build = [&registry, &standIn](PredictionScope& scope) {
+    standIn = registry.CreateEntity();
+    registry.AddComponent<TransformComponent>(standIn, Vec2f{8.f, 8.f});
+    scope.TrackCreated(standIn, kTile);
+  };
+
+  // The ack comes first, the building stays until its spawn does
+  const uint16_t confirmed = predictor.Predict(build);
+  const EntityID firstStandIn = standIn;
+  predictor.Confirm(confirmed);
+  if (destroyed != 0 || predictor.GetStandInCount() != 1 ||
+      !registry.HasComponent<TransformComponent>(firstStandIn)) {
+    std::cerr << "Stand-in destroyed before the spawn arrived" << std::endl;
+    return false;
+  }
+
+  // A rejected older command replays the build, the original stand-in is
+  // kept and the replayed copy dropped
+  const uint16_t older = predictor.Predict(MoveBy(player, 1.f));
+  const uint16_t pendingBuild = predictor.Predict(build);
+  predictor.Confirm(pendingBuild);
+  predictor.Reject(older);
+  if (predictor.GetStandInCount() != 2 || destroyed != 1) {
+    std::cerr << "Replay changed the stand-ins: " << predictor.GetStandInCount()
+              << " kept, " << destroyed << " destroyed" << std::endl;
+    return false;
+  }
+
+  if (!predictor.HandOver(kTile) || destroyed != 2 ||
+      registry.HasComponent<TransformComponent>(firstStandIn)) {
+    std::cerr << "Spawn did not take over from the stand-in" << std::endl;
+    return false;
+  }
+  predictor.HandOver(kTile);
+  if (predictor.HandOver(kTile) || predictor.GetStandInCount() != 0) {
+    std::cerr << "Handed over a stand-in twice" << std::endl;
+    return false;
+  }
+
+  // The spawn overtakes the ack, the later rollback leaves it alone
+  destroyed = 0;
+  const uint16_t overtaken = predictor.Predict(build);
+  if (!predictor.HandOver(kTile) || destroyed != 1) {
+    std::cerr << "Spawn ahead of the ack kept the stand-in" << std::endl;
+    return false;
+  }
+  predictor.Reject(overtaken);
+  predictor.Confirm(overtaken);
+  if (destroyed != 1 || predictor.GetStandInCount() != 0) {
+    std::cerr << "Stand-in destroyed twice" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_confirm_keeps_prediction()) {
+    all_passed = false;
+  }
+
+  if (!test_reject_restores_dirtied_only()) {
+    all_passed = false;
+  }
+
+  if (!test_reject_replays_newer()) {
+    all_passed = false;
+  }
+
+  if (!test_reject_keeps_replicated_state()) {
+    all_passed = false;
+  }
+
+  if (!test_rebase_keeps_pending_commands()) {
+    all_passed = false;
+  }
+
+  if (!test_created_entities()) {
+    all_passed = false;
+  }
+
+  if (!test_confirm_then_spawn()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All CommandPredictor tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some CommandPredictor tests failed!" << std::endl;
+    return 1;
+  }
+}
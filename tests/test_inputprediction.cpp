@@ -0,0 +1,278 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#include "Components/BuildingComponent.h"
+#include "Components/InputStateComponent.h"
+#include "Core/Chunk.h"
+#include "Core/EventDispatcher.h"
+#include "Core/InputPrediction.h"
+#include "Core/Packet.h"
+#include "Core/Registry.h"
+#include "SDL.h"
+#include "Util/PacketUtil.h"
+
+namespace {
+PredictedInput MakeInput(uint16_t sequence) {
+  return PredictedInput{sequence, 0, static_cast<float>(sequence), 0.f,
+                        1.f / 60.f};
+}
+}  // namespace
+
+bool test_ack_across_wrap() {
+  PendingInputRing ring;
+  for (uint16_t seq = 65530; seq != 10; ++seq) ring.Push(MakeInput(seq));
+
+  const PredictedInput* acked = ring.Ack(2);
+  if (acked == nullptr || acked->sequence != 2 || ring.GetSize() != 7) {
+    std::cerr << "Ack across the sequence wrap failed" << std::endl;
+    return false;
+  }
+  if (ring.Ack(65535) != nullptr || ring.Ack(2) != nullptr ||
+      ring.Ack(200) != nullptr) {
+    std::cerr << "Stale or future ack was accepted" << std::endl;
+    return false;
+  }
+  if (ring.FromNewest(0).sequence != 9 || ring.FromNewest(6).sequence != 3) {
+    std::cerr << "Pending order is wrong" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_overflow_drops_oldest() {
+  PendingInputRing ring;
+  const uint16_t count = PendingInputRing::kCapacity + 20;
+  for (uint16_t seq = 1; seq <= count; ++seq) ring.Push(MakeInput(seq));
+
+  if (ring.GetSize() != PendingInputRing::kCapacity ||
+      ring.FromNewest(PendingInputRing::kCapacity - 1).sequence != 21) {
+    std::cerr << "Ring did not drop its oldest inputs" << std::endl;
+    return false;
+  }
+  if (ring.Ack(20) != nullptr) {
+    std::cerr << "Overwritten input was acknowledged" << std::endl;
+    return false;
+  }
+
+  // A gap in sequences restarts the ring
+  ring.Push(MakeInput(1000));
+  if (ring.GetSize() != 1 || ring.FromNewest(0).sequence != 1000) {
+    std::cerr << "Sequence gap was not handled" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_replay_with_collision() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  registry.RegisterComponent<BuildingComponent>();
+
+  // Grass chunk with a building two tiles right of the origin tile
+  Chunk chunk(0, 0);
+  for (int i = 0; i < Chunk::kTileCount; ++i)
+    chunk.SetType(i, TileType::Grass);
+  EntityID building = registry.CreateEntity();
+  registry.AddComponent<BuildingComponent>(building, BuildingComponent{});
+  chunk.SetOccupyingEntity(Chunk::GetLocalIndex(2, 0), building);
+
+  int lookups = 0;
+  TileCollisionCache collision(&registry, [&](int x, int y) -> Chunk* {
+    ++lookups;
+    return x == 0 && y == 0 ? &chunk : nullptr;
+  });
+
+  PendingInputRing ring;
+  const uint8_t right = static_cast<uint8_t>(EPlayerInput::RIGHT);
+  for (uint16_t seq = 0; seq < 60; ++seq)
+    ring.Push(PredictedInput{seq, right, 0.f, 0.f, 0.1f});
+  ring.Ack(0);
+
+  // 59 steps of 32 px from x = 10 stop in front of the building at x = 128
+  const Vec2f end = ring.Replay({10.f, 10.f}, 320.f, collision);
+  if (end.x >= 2.f * TILE_PIXEL_SIZE || end.x < TILE_PIXEL_SIZE) {
+    std::cerr << "Replay walked through the building: " << end.x << std::endl;
+    return false;
+  }
+  if (ring.FromNewest(0).predX != end.x) {
+    std::cerr << "Replay did not store the new predictions" << std::endl;
+    return false;
+  }
+  if (lookups != 1) {
+    std::cerr << "Chunk looked up " << lookups << " times" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_server_applies_each_input_once() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  registry.RegisterComponent<BuildingComponent>();
+  Chunk chunk(0, 0);
+  for (int i = 0; i < Chunk::kTileCount; ++i)
+    chunk.SetType(i, TileType::Grass);
+  TileCollisionCache collision(&registry, [&](int x, int y) -> Chunk* {
+    return x == 0 && y == 0 ? &chunk : nullptr;
+  });
+  constexpr float kSpeed = 60.f;
+  const uint8_t right = static_cast<uint8_t>(EPlayerInput::RIGHT);
+
+  // Client starts walking right: the change goes out alone, the next four
+  // unchanged inputs wait for the batch
+  PendingInputRing ring;
+  Vec2f predicted{10.f, 10.f};
+  for (uint16_t seq = 1; seq <= 5; ++seq) {
+    PredictMove(predicted, kSpeed, right, syncDelta, collision);
+    ring.Push(PredictedInput{seq, right, predicted.x, predicted.y, syncDelta});
+  }
+  auto pack = [right](uint8_t count) {
+    std::array<uint8_t, (kMaxMoveBatch + 1) / 2> packed{};
+    for (uint8_t i = 0; i < count; ++i)
+      util::WriteInputNibble(packed.data(), i, right);
+    return packed;
+  };
+
+  InputStateComponent state;
+  Vec2f server{10.f, 10.f};
+  for (int tick = 1; tick <= 8; ++tick) {
+    if (tick == 1) QueueMoveBatch(state, 1, 1, pack(1).data());
+    if (tick == 5) QueueMoveBatch(state, 5, 4, pack(4).data());
+    AdvanceInputTime(state, syncDelta);
+    if (!TakeQueuedInput(state)) continue;
+    PredictMove(server, kSpeed, state.inputBit, syncDelta, collision);
+
+    // Every ack lands where the client predicted that input
+    const PredictedInput* acked = ring.Ack(state.sequence);
+    if (acked == nullptr || acked->predX != server.x) {
+      std::cerr << "Tick " << tick << " acked " << state.sequence << " at "
+                << server.x << ", client predicted "
+                << (acked ? acked->predX : -1.f) << std::endl;
+      return false;
+    }
+  }
+  if (!ring.IsEmpty() || server.x != predicted.x) {
+    std::cerr << "Server ended at " << server.x << ", client at "
+              << predicted.x << std::endl;
+    return false;
+  }
+
+  // A batch repeating what arrived already queues nothing
+  if (QueueMoveBatch(state, 5, 4, pack(4).data()) || TakeQueuedInput(state)) {
+    std::cerr << "Redundant batch was applied again" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_server_frame_shorter_than_input_step() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  registry.RegisterComponent<BuildingComponent>();
+  Chunk chunk(0, 0);
+  for (int i = 0; i < Chunk::kTileCount; ++i)
+    chunk.SetType(i, TileType::Grass);
+  TileCollisionCache collision(&registry, [&](int x, int y) -> Chunk* {
+    return x == 0 && y == 0 ? &chunk : nullptr;
+  });
+  constexpr float kSpeed = 60.f;
+  constexpr float kFrameDelta = 1.f / 60.f;  // vsync paced server frame
+  const uint8_t right = static_cast<uint8_t>(EPlayerInput::RIGHT);
+
+  // Client predicts one input per syncDelta and sends them three at a time
+  PendingInputRing ring;
+  Vec2f predicted{10.f, 10.f};
+  InputStateComponent state;
+  Vec2f server{10.f, 10.f};
+  std::array<uint8_t, (kMaxMoveBatch + 1) / 2> packed{};
+  for (uint8_t i = 0; i < 3; ++i)
+    util::WriteInputNibble(packed.data(), i, right);
+
+  uint16_t nextSeq = 1;
+  float clientTime = 0.f;
+  int moves = 0;
+  int idleRun = 0;
+  for (int frame = 1; frame <= 60; ++frame) {
+    const float now = frame * kFrameDelta;
+    while (clientTime + syncDelta <= now + 1e-5f) {
+      clientTime += syncDelta;
+      PredictMove(predicted, kSpeed, right, syncDelta, collision);
+      ring.Push(
+          PredictedInput{nextSeq, right, predicted.x, predicted.y, syncDelta});
+      if (nextSeq % 3 == 0) QueueMoveBatch(state, nextSeq, 3, packed.data());
+      ++nextSeq;
+    }
+
+    AdvanceInputTime(state, kFrameDelta);
+    bool bMoved = false;
+    while (TakeQueuedInput(state)) {
+      PredictMove(server, kSpeed, state.inputBit, syncDelta, collision);
+      const PredictedInput* acked = ring.Ack(state.sequence);
+      if (acked == nullptr || acked->predX != server.x) {
+        std::cerr << "Frame " << frame << " acked " << state.sequence
+                  << " at " << server.x << ", client predicted "
+                  << (acked ? acked->predX : -1.f) << std::endl;
+        return false;
+      }
+      bMoved = true;
+      ++moves;
+    }
+
+    // Once walking, a batch is spread over its syncDelta steps instead of
+    // being used up in consecutive frames and then waiting for the next one
+    idleRun = bMoved ? 0 : idleRun + 1;
+    if (moves > 0 && idleRun > 1) {
+      std::cerr << "Frame " << frame << " is the " << idleRun
+                << "th frame in a row without input" << std::endl;
+      return false;
+    }
+  }
+
+  // One second of server frames applies one second of inputs, no faster
+  if (moves < 27 || moves > 30) {
+    std::cerr << "Applied " << moves << " inputs in one second" << std::endl;
+    return false;
+  }
+  // Each input covers syncDelta, not the shorter server frame
+  const float walked = server.x - 10.f;
+  if (std::abs(walked - moves * kSpeed * syncDelta) > 0.01f) {
+    std::cerr << "Walked " << walked << " px on " << moves << " inputs"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_ack_across_wrap()) {
+    all_passed = false;
+  }
+
+  if (!test_overflow_drops_oldest()) {
+    all_passed = false;
+  }
+
+  if (!test_replay_with_collision()) {
+    all_passed = false;
+  }
+
+  if (!test_server_applies_each_input_once()) {
+    all_passed = false;
+  }
+
+  if (!test_server_frame_shorter_than_input_step()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All InputPrediction tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some InputPrediction tests failed!" << std::endl;
+    return 1;
+  }
+}
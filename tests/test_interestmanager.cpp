@@ -0,0 +1,222 @@
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Core/InterestManager.h"
+#include "Core/PacketSchema.h"
+#include "SDL.h"
+
+namespace {
+constexpr int kViewDistance = 1;
+constexpr float kChunkPixels = CHUNK_WIDTH * TILE_PIXEL_SIZE;
+
+// Middle of a chunk, in pixels
+Vec2f InChunk(int x, int y) {
+  return {(x + 0.5f) * kChunkPixels, (y + 0.5f) * kChunkPixels};
+}
+
+bool Visible(const InterestManager& interest, clientid_t observer,
+             const std::vector<clientid_t>& expected) {
+  const std::vector<clientid_t>& visible =
+      interest.GetVisibleSubjects(observer);
+  if (visible == expected) return true;
+  std::cerr << "Observer " << observer << " sees";
+  for (clientid_t id : visible) std::cerr << " " << id;
+  std::cerr << std::endl;
+  return false;
+}
+}  // namespace
+
+bool test_filters_by_chunk() {
+  InterestManager interest(kViewDistance);
+  interest.UpdateSubject(1, InChunk(0, 0));
+  interest.UpdateSubject(2, InChunk(1, 1));
+  interest.UpdateSubject(3, InChunk(2, 0));
+  interest.UpdateSubject(4, InChunk(-1, -1));
+  interest.UpdateSubject(5, InChunk(3, 0));
+  interest.UpdateObserver(1, InChunk(0, 0));
+  interest.UpdateObserver(5, InChunk(3, 0));
+
+  InterestManager::ViewDelta delta;
+  if (!interest.Refresh(1, delta) || !interest.Refresh(5, delta)) {
+    std::cerr << "Known observer was not refreshed" << std::endl;
+    return false;
+  }
+  // Each client only gets the players of the chunks around its own
+  if (!Visible(interest, 1, {1, 2, 4}) || !Visible(interest, 5, {3, 5}))
+    return false;
+
+  if (!interest.IsChunkVisible(1, {1, -1}) ||
+      interest.IsChunkVisible(1, {2, 0}) ||
+      !interest.IsChunkVisible(5, {4, 1})) {
+    std::cerr << "Chunk visibility does not match the view distance"
+              << std::endl;
+    return false;
+  }
+  if (interest.Refresh(9, delta) || !interest.GetVisibleSubjects(9).empty()) {
+    std::cerr << "Unknown observer sees something" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_enter_and_leave() {
+  InterestManager interest(kViewDistance);
+  interest.UpdateObserver(1, InChunk(0, 0));
+  interest.UpdateSubject(2, InChunk(1, 0));
+  interest.UpdateSubject(3, InChunk(4, 0));
+
+  InterestManager::ViewDelta delta;
+  interest.Refresh(1, delta);
+  if (delta.entered != std::vector<clientid_t>{2} || !delta.left.empty()) {
+    std::cerr << "First refresh did not enter the nearby player" << std::endl;
+    return false;
+  }
+
+  // Moving inside the area is not an event
+  interest.UpdateSubject(2, InChunk(1, 1));
+  interest.Refresh(1, delta);
+  if (!delta.entered.empty() || !delta.left.empty()) {
+    std::cerr << "Player moving inside the area raised an event" << std::endl;
+    return false;
+  }
+
+  // One walks in while the other walks out, past the leave margin
+  interest.UpdateSubject(3, InChunk(-1, 0));
+  interest.UpdateSubject(2, InChunk(3, 1));
+  interest.Refresh(1, delta);
+  if (delta.entered != std::vector<clientid_t>{3} ||
+      delta.left != std::vector<clientid_t>{2}) {
+    std::cerr << "Crossing players raised " << delta.entered.size()
+              << " enter and " << delta.left.size() << " leave events"
+              << std::endl;
+    return false;
+  }
+
+  // The observer moving brings the other back, a disconnect drops one
+  interest.UpdateObserver(1, InChunk(2, 0));
+  interest.RemoveSubject(3);
+  interest.Refresh(1, delta);
+  if (delta.entered != std::vector<clientid_t>{2} ||
+      delta.left != std::vector<clientid_t>{3}) {
+    std::cerr << "Observer move or removal raised the wrong events"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_edge_pacing_does_not_flap() {
+  InterestManager interest(kViewDistance);
+  interest.UpdateObserver(1, InChunk(0, 0));
+
+  // Player 2 paces a few pixels either side of the border between chunk 1,
+  // inside the area, and chunk 2, just outside it
+  const float edge = 2.f * kChunkPixels;
+  InterestManager::ViewDelta delta;
+  int entered = 0;
+  int left = 0;
+  for (int step = 0; step < 20; ++step) {
+    const float x = step % 2 == 0 ? edge - 4.f : edge + 4.f;
+    interest.UpdateSubject(2, {x, 0.5f * kChunkPixels});
+    interest.Refresh(1, delta);
+    entered += static_cast<int>(delta.entered.size());
+    left += static_cast<int>(delta.left.size());
+  }
+  if (entered != 1 || left != 0) {
+    std::cerr << "Pacing along the edge raised " << entered << " enter and "
+              << left << " leave events" << std::endl;
+    return false;
+  }
+
+  // Within the margin a player that was never seen does not enter
+  interest.UpdateSubject(3, InChunk(2, -1));
+  interest.Refresh(1, delta);
+  if (!delta.entered.empty() || !Visible(interest, 1, {2})) return false;
+
+  // Past the margin it leaves once
+  interest.UpdateSubject(2, InChunk(3, 0));
+  interest.Refresh(1, delta);
+  if (delta.left != std::vector<clientid_t>{2} || !delta.entered.empty()) {
+    std::cerr << "Player past the leave margin did not leave" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_bytes_per_client_stay_flat() {
+  // Same density of players however many join, the world just grows
+  constexpr int kPlayersPerChunk = 2;
+  std::mt19937 rng(26);
+
+  double flatBytes[2] = {};
+  double broadcastBytes[2] = {};
+  const int populations[2] = {128, 8192};
+  for (int run = 0; run < 2; ++run) {
+    const int players = populations[run];
+    int side = 1;
+    while (side * side * kPlayersPerChunk < players) ++side;
+    std::uniform_real_distribution<float> spread(0.f, side * kChunkPixels);
+
+    InterestManager interest(kViewDistance);
+    std::vector<Vec2f> positions(players);
+    for (int i = 0; i < players; ++i) {
+      positions[i] = {spread(rng), spread(rng)};
+      interest.UpdateSubject(static_cast<clientid_t>(i + 1), positions[i]);
+    }
+
+    InterestManager::ViewDelta delta;
+    std::size_t total = 0;
+    for (int i = 0; i < players; ++i) {
+      const clientid_t observer = static_cast<clientid_t>(i + 1);
+      interest.UpdateObserver(observer, positions[i]);
+      interest.Refresh(observer, delta);
+      total += PayloadSize<TRANSFORM_SNAPSHOT>(
+          interest.GetVisibleSubjects(observer).size());
+    }
+    flatBytes[run] = static_cast<double>(total) / players;
+    broadcastBytes[run] =
+        static_cast<double>(PayloadSize<TRANSFORM_SNAPSHOT>(players));
+  }
+
+  std::cout << "Snapshot bytes per client: " << flatBytes[0] << " with "
+            << populations[0] << " players, " << flatBytes[1] << " with "
+            << populations[1] << " (broadcast " << broadcastBytes[0] << " / "
+            << broadcastBytes[1] << ")" << std::endl;
+  // 64 times the players, the edges of a small world make the first run a
+  // little cheaper
+  if (flatBytes[1] > 1.5 * flatBytes[0]) {
+    std::cerr << "Per client snapshots grew with the population" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_filters_by_chunk()) {
+    all_passed = false;
+  }
+
+  if (!test_enter_and_leave()) {
+    all_passed = false;
+  }
+
+  if (!test_edge_pacing_does_not_flap()) {
+    all_passed = false;
+  }
+
+  if (!test_bytes_per_client_stay_flat()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All InterestManager tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some InterestManager tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,326 @@
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Core/NetConnection.h"
+#include "Core/Packet.h"
+#include "SDL.h"
+#include "Util/PacketUtil.h"
+
+namespace {
+constexpr double kFrameTime = 1.0 / 60.0;
+
+// Stand-in for a lossy network: drops, delays and reorders datagrams
+class LinkShaper {
+ public:
+  LinkShaper(double lossRate, double latency, double jitter, uint32_t seed)
+      : lossRate(lossRate), latency(latency), jitter(jitter), rng(seed) {}
+
+  void Push(std::vector<uint8_t> datagram, double now) {
+    if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < lossRate)
+      return;
+    const double delay =
+        latency + std::uniform_real_distribution<double>(-jitter, jitter)(rng);
+    inFlight.emplace(now + std::max(0.0, delay), std::move(datagram));
+  }
+
+  bool Pop(double now, std::vector<uint8_t>& outDatagram) {
+    auto it = inFlight.begin();
+    if (it == inFlight.end() || it->first > now) return false;
+    outDatagram = std::move(it->second);
+    inFlight.erase(it);
+    return true;
+  }
+
+ private:
+  double lossRate;
+  double latency;
+  double jitter;
+  std::mt19937 rng;
+  std::multimap<double, std::vector<uint8_t>> inFlight;
+};
+
+// Two connections joined by one shaper per direction
+struct Loopback {
+  NetConnection a;
+  NetConnection b;
+  LinkShaper aToB;
+  LinkShaper bToA;
+  double now = 0.0;
+
+  Loopback(double lossRate, double latency, double jitter)
+      : aToB(lossRate, latency, jitter, 1234),
+        bToA(lossRate, latency, jitter, 5678) {}
+
+  void Step() {
+    now += kFrameTime;
+    std::vector<std::vector<uint8_t>> datagrams;
+    a.Flush(now, datagrams);
+    for (auto& d : datagrams) aToB.Push(std::move(d), now);
+    datagrams.clear();
+    b.Flush(now, datagrams);
+    for (auto& d : datagrams) bToA.Push(std::move(d), now);
+
+    std::vector<uint8_t> datagram;
+    while (aToB.Pop(now, datagram)) b.Receive(datagram.data(), datagram.size(), now);
+    while (bToA.Pop(now, datagram)) a.Receive(datagram.data(), datagram.size(), now);
+  }
+};
+
+std::vector<uint8_t> MakePacket(PACKET packetId, uint16_t index) {
+  std::vector<uint8_t> packet(sPacketHeader + sizeof(uint16_t));
+  uint8_t* wp = packet.data();
+  util::WriteHeader(wp, packetId, packet.size());
+  util::Write16BigEnd(wp, index);
+  return packet;
+}
+
+uint16_t ReadIndex(const PacketPtr& packet) {
+  const uint8_t* rp = packet.get() + sPacketHeader;
+  return util::Read16BigEnd(rp);
+}
+}  // namespace
+
+bool test_reliable_ordered() {
+  Loopback link(0.2, 0.05, 0.02);
+  constexpr uint16_t kCount = 500;
+
+  std::vector<uint16_t> received;
+  uint16_t sent = 0;
+  for (int frame = 0; frame < 60 * 20; ++frame) {
+    for (int i = 0; i < 5 && sent < kCount; ++i, ++sent) {
+      auto packet = MakePacket(CHAT_CLIENT, sent);
+      link.a.Send(packet.data(), packet.size());
+    }
+    link.Step();
+
+    PacketPtr packet;
+    while (link.b.Next(packet)) received.push_back(ReadIndex(packet));
+  }
+
+  if (received.size() != kCount) {
+    std::cerr << "Reliable delivery failed: expected " << kCount << ", got "
+              << received.size() << std::endl;
+    return false;
+  }
+  for (uint16_t i = 0; i < kCount; ++i) {
+    if (received[i] != i) {
+      std::cerr << "Reliable order failed at " << i << ": got " << received[i]
+                << std::endl;
+      return false;
+    }
+  }
+  if (link.a.GetUnackedCount() != 0) {
+    std::cerr << "Reliable messages left unacked: "
+              << link.a.GetUnackedCount() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_reliable_burst() {
+  // More than the receive window queued at once, with the oldest ones lost
+  // repeatedly: the sender has to hold the rest back instead of having them
+  // dropped by the receiver after they were acked
+  Loopback link(0.3, 0.05, 0.02);
+  constexpr uint16_t kCount = 3000;
+
+  for (uint16_t i = 0; i < kCount; ++i) {
+    auto packet = MakePacket(CHAT_CLIENT, i);
+    link.a.Send(packet.data(), packet.size());
+  }
+
+  std::vector<uint16_t> received;
+  for (int frame = 0; frame < 60 * 30 && received.size() < kCount; ++frame) {
+    link.Step();
+    PacketPtr packet;
+    while (link.b.Next(packet)) received.push_back(ReadIndex(packet));
+  }
+
+  if (received.size() != kCount) {
+    std::cerr << "Reliable burst stalled: expected " << kCount << ", got "
+              << received.size() << std::endl;
+    return false;
+  }
+  for (uint16_t i = 0; i < kCount; ++i) {
+    if (received[i] != i) {
+      std::cerr << "Reliable burst order failed at " << i << ": got "
+                << received[i] << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool test_fragmented_packets() {
+  Loopback link(0.2, 0.05, 0.02);
+  constexpr uint16_t kCount = 40;
+
+  // Every third packet spans several datagrams, the rest fit in one
+  std::vector<std::vector<uint8_t>> sent;
+  for (uint16_t i = 0; i < kCount; ++i) {
+    const std::size_t size =
+        i % 3 == 0 ? 3 * kMaxDatagramPacketSize + i : sPacketHeader + 2 + i;
+    std::vector<uint8_t> packet(size);
+    uint8_t* wp = packet.data();
+    util::WriteHeader(wp, CHAT_CLIENT, size);
+    for (std::size_t b = sPacketHeader; b < size; ++b)
+      packet[b] = static_cast<uint8_t>(b * 7 + i);
+    if (!link.a.Send(packet.data(), packet.size())) {
+      std::cerr << "Packet of " << size << " bytes rejected" << std::endl;
+      return false;
+    }
+    sent.push_back(std::move(packet));
+  }
+
+  std::vector<std::vector<uint8_t>> received;
+  for (int frame = 0; frame < 60 * 10 && received.size() < kCount; ++frame) {
+    link.Step();
+    PacketPtr packet;
+    while (link.b.Next(packet)) {
+      const uint8_t* rp = packet.get();
+      PACKET packetId;
+      std::size_t packetSize;
+      util::GetHeader(rp, packetId, packetSize);
+      received.emplace_back(packet.get(), packet.get() + packetSize);
+    }
+  }
+
+  if (received != sent) {
+    std::cerr << "Fragmented packets not delivered intact and in order: got "
+              << received.size() << " of " << kCount << std::endl;
+    return false;
+  }
+
+  // Unreliable packets are never fragmented
+  std::vector<uint8_t> snapshot(kMaxDatagramPacketSize + 1);
+  uint8_t* wp = snapshot.data();
+  util::WriteHeader(wp, TRANSFORM_SNAPSHOT, snapshot.size());
+  if (link.a.Send(snapshot.data(), snapshot.size())) {
+    std::cerr << "Oversized unreliable packet accepted" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_unreliable_sequenced() {
+  Loopback link(0.2, 0.05, 0.03);
+  constexpr uint16_t kCount = 300;
+
+  std::vector<uint16_t> received;
+  for (uint16_t i = 0; i < kCount; ++i) {
+    auto packet = MakePacket(TRANSFORM_SNAPSHOT, i);
+    link.a.Send(packet.data(), packet.size());
+    link.Step();
+
+    PacketPtr out;
+    while (link.b.Next(out)) received.push_back(ReadIndex(out));
+  }
+  for (int frame = 0; frame < 60; ++frame) {
+    link.Step();
+    PacketPtr out;
+    while (link.b.Next(out)) received.push_back(ReadIndex(out));
+  }
+
+  for (std::size_t i = 1; i < received.size(); ++i) {
+    if (received[i] <= received[i - 1]) {
+      std::cerr << "Sequenced delivery went backwards: " << received[i - 1]
+                << " then " << received[i] << std::endl;
+      return false;
+    }
+  }
+  // 20% loss plus reordering drops, most should still arrive
+  if (received.size() < kCount / 2 || received.size() >= kCount) {
+    std::cerr << "Unexpected sequenced delivery count: " << received.size()
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_round_trip_time() {
+  Loopback link(0.0, 0.04, 0.0);
+
+  for (int frame = 0; frame < 120; ++frame) {
+    auto packet = MakePacket(CHAT_CLIENT, static_cast<uint16_t>(frame));
+    link.a.Send(packet.data(), packet.size());
+    link.b.Send(packet.data(), packet.size());
+    link.Step();
+  }
+
+  // 80 ms on the wire plus up to a frame of flush delay on each side
+  const double rtt = link.a.GetRoundTripTime();
+  if (rtt < 0.075 || rtt > 0.125) {
+    std::cerr << "Round trip estimate off: " << rtt << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_malformed_datagram() {
+  NetConnection connection;
+
+  const uint8_t truncated[3] = {0, 1, 0};
+  if (connection.Receive(truncated, sizeof(truncated), 0.0)) {
+    std::cerr << "Truncated datagram accepted" << std::endl;
+    return false;
+  }
+
+  // Message announcing a packet larger than the datagram
+  std::vector<uint8_t> datagram(sDatagramHeader + sMessageHeader +
+                                sPacketHeader);
+  uint8_t* wp = datagram.data() + sDatagramHeader;
+  *wp++ = static_cast<uint8_t>(EDeliveryMode::ReliableOrdered);
+  util::Write16BigEnd(wp, 0);
+  util::WriteHeader(wp, CHAT_CLIENT, 200);
+  if (connection.Receive(datagram.data(), datagram.size(), 0.0)) {
+    std::cerr << "Oversized packet accepted" << std::endl;
+    return false;
+  }
+
+  PacketPtr packet;
+  if (connection.Next(packet)) {
+    std::cerr << "Malformed datagram delivered a packet" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_reliable_ordered()) {
+    all_passed = false;
+  }
+
+  if (!test_reliable_burst()) {
+    all_passed = false;
+  }
+
+  if (!test_fragmented_packets()) {
+    all_passed = false;
+  }
+
+  if (!test_unreliable_sequenced()) {
+    all_passed = false;
+  }
+
+  if (!test_round_trip_time()) {
+    all_passed = false;
+  }
+
+  if (!test_malformed_datagram()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All NetConnection tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some NetConnection tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,186 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "Core/NoiseGrid.h"
+#include "Core/WorldGenerator.h"
+#include "FastNoiseLite.h"
+#include "SDL.h"
+
+namespace {
+// Identical unless a compiler fuses multiply-adds on one side
+constexpr float kTolerance = 1e-5f;
+
+FastNoiseLite MakeReference(FastNoiseLite::NoiseType type, float frequency,
+                            int seed = 1337) {
+  FastNoiseLite noise(seed);
+  noise.SetNoiseType(type);
+  noise.SetFrequency(frequency);
+  return noise;
+}
+
+bool NearThreshold(float value, float threshold) {
+  return std::fabs(value - threshold) <= kTolerance;
+}
+
+// Compares a grid against FastNoiseLite, counts bit identical values
+bool CheckGrid(const char* name, const FastNoiseLite& reference,
+               const std::vector<float>& grid, int originX, int originY,
+               int width, int& identical) {
+  for (std::size_t i = 0; i < grid.size(); ++i) {
+    const int x = originX + static_cast<int>(i) % width;
+    const int y = originY + static_cast<int>(i) / width;
+    const float expected =
+        reference.GetNoise(static_cast<float>(x), static_cast<float>(y));
+    if (std::memcmp(&expected, &grid[i], sizeof(float)) == 0) {
+      ++identical;
+    } else if (!(std::fabs(expected - grid[i]) <= kTolerance)) {
+      std::cerr << name << " noise at " << x << ":" << y << " is " << grid[i]
+                << ", expected " << expected << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+bool test_matches_fastnoiselite() {
+  const FastNoiseLite perlin =
+      MakeReference(FastNoiseLite::NoiseType_Perlin, 0.05f);
+  const FastNoiseLite simplex =
+      MakeReference(FastNoiseLite::NoiseType_OpenSimplex2, 0.02f);
+  const NoiseGrid perlinGrid(ENoiseType::Perlin, 0.05f);
+  const NoiseGrid simplexGrid(ENoiseType::OpenSimplex2, 0.02f);
+
+  // Negative and far origins, and widths that leave a scalar tail
+  const int origins[][2] = {{0, 0}, {-16, -16}, {-37, 5}, {123457, -98765}};
+  const int widths[] = {16, 13, 1};
+  int identical = 0;
+  int total = 0;
+  for (const auto& origin : origins) {
+    for (int width : widths) {
+      const int height = 9;
+      std::vector<float> grid(static_cast<std::size_t>(width * height));
+      const struct {
+        const char* name;
+        const FastNoiseLite& reference;
+        const NoiseGrid& noise;
+      } cases[] = {{"Perlin", perlin, perlinGrid},
+                   {"OpenSimplex2", simplex, simplexGrid}};
+      for (const auto& c : cases) {
+        c.noise.Generate(origin[0], origin[1], width, height, grid.data());
+        if (!CheckGrid(c.name, c.reference, grid, origin[0], origin[1], width,
+                       identical))
+          return false;
+        c.noise.GenerateScalar(origin[0], origin[1], width, height,
+                               grid.data());
+        if (!CheckGrid(c.name, c.reference, grid, origin[0], origin[1], width,
+                       identical))
+          return false;
+        total += 2 * width * height;
+      }
+    }
+  }
+  std::cout << NoiseGrid::GetSimdName() << ": " << identical << " of "
+            << total << " values bit identical" << std::endl;
+  return true;
+}
+
+bool test_classification_matches_scalar() {
+  const WorldGenerator generator;
+  const FastNoiseLite terrain =
+      MakeReference(FastNoiseLite::NoiseType_Perlin, 0.05f,
+                    generator.GetTerrainNoise().GetSeed());
+  const FastNoiseLite ore =
+      MakeReference(FastNoiseLite::NoiseType_OpenSimplex2, 0.02f,
+                    generator.GetOreNoise().GetSeed());
+
+  int oreTiles = 0;
+  for (int chunkY = -6; chunkY <= 6; ++chunkY) {
+    for (int chunkX = -6; chunkX <= 6; ++chunkX) {
+      const GeneratedChunk generated = generator.Generate({chunkX, chunkY});
+      std::size_t nextOre = 0;
+
+      // The branchy classification WorldGenerator used to run per tile
+      for (int index = 0; index < Chunk::kTileCount; ++index) {
+        const float x = static_cast<float>(chunkX * CHUNK_WIDTH +
+                                           index % CHUNK_WIDTH);
+        const float y = static_cast<float>(chunkY * CHUNK_HEIGHT +
+                                           index / CHUNK_WIDTH);
+        const float terrainValue = terrain.GetNoise(x, y);
+        const float oreValue = ore.GetNoise(x, y);
+        TileType expected = TileType::Grass;
+        if (terrainValue < -0.2f) {
+          expected = TileType::Water;
+        } else if (terrainValue < 0.3f) {
+          expected = TileType::Dirt;
+        }
+        const bool bIsOre =
+            oreValue > kOreThreshold && expected != TileType::Water;
+        if (bIsOre) expected = TileType::Stone;
+
+        // Values this close to a threshold may land either side
+        if (NearThreshold(terrainValue, -0.2f) ||
+            NearThreshold(terrainValue, 0.3f) ||
+            NearThreshold(oreValue, kOreThreshold)) {
+          if (nextOre < generated.ores.size() &&
+              generated.ores[nextOre].first == index)
+            ++nextOre;
+          continue;
+        }
+
+        if (generated.chunk.GetType(index) != expected) {
+          std::cerr << "Tile " << index << " of chunk " << chunkX << ":"
+                    << chunkY << " classified differently" << std::endl;
+          return false;
+        }
+        if (!bIsOre) continue;
+
+        // Before the per chunk jitter
+        const float amount = static_cast<float>(kMaxIronOreAmount) * oreValue;
+        const float jitter = amount * kOreAmountJitter + 1.f;
+        if (nextOre >= generated.ores.size() ||
+            generated.ores[nextOre].first != index ||
+            std::fabs(static_cast<float>(generated.ores[nextOre].second) -
+                      amount) > jitter) {
+          std::cerr << "Ore of tile " << index << " of chunk " << chunkX
+                    << ":" << chunkY << " is missing or differs" << std::endl;
+          return false;
+        }
+        ++nextOre;
+        ++oreTiles;
+      }
+      if (nextOre != generated.ores.size()) {
+        std::cerr << "Chunk " << chunkX << ":" << chunkY
+                  << " has ore on non ore tiles" << std::endl;
+        return false;
+      }
+    }
+  }
+  if (oreTiles == 0) {
+    std::cerr << "No ore generated, the ore checks did not run" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_matches_fastnoiselite()) {
+    all_passed = false;
+  }
+
+  if (!test_classification_matches_scalar()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All NoiseGrid tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some NoiseGrid tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,186 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Core/Packet.h"
+#include "Core/PacketCapture.h"
+#include "Core/PacketSchema.h"
+#include "Core/ThreadSafeQueue.h"
+#include "SDL.h"
+
+namespace {
+std::string CapturePath(const char* name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::size_t Drain(ThreadSafeQueue<RecvPacket>& queue,
+                  std::vector<RecvPacket>& out) {
+  std::size_t count = 0;
+  RecvPacket recv;
+  while (queue.TryPop(recv)) {
+    out.push_back(std::move(recv));
+    ++count;
+  }
+  return count;
+}
+
+// Three ticks of traffic from two clients, ending with a disconnect
+bool WriteSampleCapture(const std::string& path) {
+  PacketRecorder recorder;
+  if (!recorder.Open(path)) return false;
+
+  recorder.Record(
+      1, 0, {7, MakePacket<CONNECT_SYN>(std::string("alice"), uint32_t{8192})});
+  recorder.Record(1, 0,
+                  {9, MakePacket<CLIENT_MOVE_RES>(uint16_t{1}, 2.f, 3.f)});
+  recorder.Record(2, 33, {7, MakePacket<CHAT_CLIENT>(std::string("hello"))});
+  recorder.Record(3, 100, {9, nullptr});
+  return recorder.GetRecordCount() == 4;
+}
+}  // namespace
+
+bool test_round_trip() {
+  const std::string path = CapturePath("factorygame_capture_round_trip.bin");
+  if (!WriteSampleCapture(path)) {
+    std::cerr << "Could not write capture" << std::endl;
+    return false;
+  }
+
+  ThreadSafeQueue<RecvPacket> queue;
+  PacketReplayer replayer(&queue, 0.f);
+  if (!replayer.Open(path)) return false;
+
+  std::vector<RecvPacket> received;
+  while (!replayer.IsFinished()) replayer.Update(0.f);
+  Drain(queue, received);
+  std::filesystem::remove(path);
+
+  if (received.size() != 4 || replayer.GetReplayedCount() != 4) {
+    std::cerr << "Replayed " << received.size() << " of 4 records"
+              << std::endl;
+    return false;
+  }
+
+  PacketReader name(received[0].packet.get());
+  auto syn = name.ReadHeader<CONNECT_SYN>();
+  if (received[0].senderClientId != 7 || !syn ||
+      std::get<0>(*syn) != "alice" || std::get<1>(*syn) != 8192) {
+    std::cerr << "CONNECT_SYN differs after replay" << std::endl;
+    return false;
+  }
+
+  PacketReader move(received[1].packet.get());
+  auto res = move.ReadHeader<CLIENT_MOVE_RES>();
+  if (received[1].senderClientId != 9 || !res || std::get<1>(*res) != 2.f) {
+    std::cerr << "CLIENT_MOVE_RES differs after replay" << std::endl;
+    return false;
+  }
+
+  if (received[3].senderClientId != 9 || received[3].packet != nullptr) {
+    std::cerr << "Disconnect was not replayed as a null packet" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_tick_and_time_pacing() {
+  const std::string path = CapturePath("factorygame_capture_pacing.bin");
+  if (!WriteSampleCapture(path)) return false;
+
+  std::vector<RecvPacket> received;
+
+  // One recorded tick per step, regardless of time
+  {
+    ThreadSafeQueue<RecvPacket> queue;
+    PacketReplayer replayer(&queue, 0.f);
+    if (!replayer.Open(path)) return false;
+    if (replayer.StepTick() != 2 || replayer.StepTick() != 1 ||
+        replayer.StepTick() != 1 || !replayer.IsFinished()) {
+      std::cerr << "StepTick did not follow recorded ticks" << std::endl;
+      return false;
+    }
+  }
+
+  // Recorded time at double speed: 33 ms is due after 20 ms
+  {
+    ThreadSafeQueue<RecvPacket> queue;
+    PacketReplayer replayer(&queue, 2.f);
+    if (!replayer.Open(path)) return false;
+    if (replayer.Advance(0.01f) != 2) {
+      std::cerr << "Records at time 0 were not released" << std::endl;
+      return false;
+    }
+    if (replayer.Advance(0.01f) != 1) {
+      std::cerr << "Playback rate was not applied" << std::endl;
+      return false;
+    }
+    if (replayer.Advance(0.01f) != 0 || replayer.Advance(0.03f) != 1) {
+      std::cerr << "Disconnect released at the wrong time" << std::endl;
+      return false;
+    }
+    Drain(queue, received);
+  }
+
+  std::filesystem::remove(path);
+  return received.size() == 4;
+}
+
+bool test_rejects_bad_files() {
+  const std::string path = CapturePath("factorygame_capture_bad.bin");
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "not a capture";
+  }
+
+  ThreadSafeQueue<RecvPacket> queue;
+  PacketReplayer replayer(&queue);
+  if (replayer.Open(path)) {
+    std::cerr << "Opened a file without the capture magic" << std::endl;
+    return false;
+  }
+
+  // Cut the last packet in half, replay must stop before it
+  if (!WriteSampleCapture(path)) return false;
+  const auto size = std::filesystem::file_size(path);
+  std::filesystem::resize_file(path, size - sCaptureRecordHeader - 4);
+
+  PacketReplayer truncated(&queue, 0.f);
+  if (!truncated.Open(path)) return false;
+  while (!truncated.IsFinished()) truncated.StepTick();
+  std::filesystem::remove(path);
+
+  if (truncated.GetReplayedCount() != 2) {
+    std::cerr << "Truncated capture replayed "
+              << truncated.GetReplayedCount() << " records" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_round_trip()) {
+    all_passed = false;
+  }
+
+  if (!test_tick_and_time_pacing()) {
+    all_passed = false;
+  }
+
+  if (!test_rejects_bad_files()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All PacketCapture tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some PacketCapture tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,280 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "Core/Packet.h"
+#include "Core/PacketPool.h"
+#include "Core/PacketSchema.h"
+#include "SDL.h"
+#include "Util/PacketUtil.h"
+
+namespace {
+std::size_t GetPacketSize(const PacketPtr& packet) {
+  const uint8_t* rp = packet.get();
+  PACKET packetId;
+  std::size_t packetSize;
+  util::GetHeader(rp, packetId, packetSize);
+  return packetSize;
+}
+
+// Rewrites packet_size to simulate a truncated packet
+void SetPacketSize(PacketPtr& packet, std::size_t size) {
+  uint8_t* wp = packet.get() + sizeof(uint16_t);
+  util::Write16BigEnd(wp, static_cast<uint16_t>(size));
+}
+}  // namespace
+
+bool test_fixed_round_trip() {
+  PacketPtr packet = MakePacket<CLIENT_MOVE_RES>(uint16_t{513}, 1.5f, -2.25f);
+  if (packet == nullptr) {
+    std::cerr << "CLIENT_MOVE_RES was not built" << std::endl;
+    return false;
+  }
+  if (GetPacketSize(packet) !=
+      sPacketHeader + PayloadSize<CLIENT_MOVE_RES>()) {
+    std::cerr << "CLIENT_MOVE_RES size mismatch: " << GetPacketSize(packet)
+              << std::endl;
+    return false;
+  }
+
+  PacketReader reader(packet.get());
+  auto fields = reader.ReadHeader<CLIENT_MOVE_RES>();
+  if (!fields || reader.GetPacketId() != CLIENT_MOVE_RES) {
+    std::cerr << "CLIENT_MOVE_RES could not be read back" << std::endl;
+    return false;
+  }
+  const auto [seq, x, y] = *fields;
+  if (seq != 513 || x != 1.5f || y != -2.25f) {
+    std::cerr << "CLIENT_MOVE_RES fields differ: " << seq << " " << x << " "
+              << y << std::endl;
+    return false;
+  }
+  if (reader.GetRemaining() != 0) {
+    std::cerr << "CLIENT_MOVE_RES left unread bytes" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_record_round_trip() {
+  const std::string names[] = {"alice", "", "bob"};
+  std::size_t payloadSize = PacketSchema<CONNECT_ACK>::Header::kMinSize;
+  for (const std::string& name : names)
+    payloadSize +=
+        PacketSchema<CONNECT_ACK>::Record::SizeOf(clientid_t{0}, name);
+
+  PacketWriter writer(CONNECT_ACK, payloadSize);
+  writer.WriteHeader<CONNECT_ACK>(clientid_t{42}, uint64_t{0xABCDEF0123},
+                                  uint16_t{3});
+  for (std::size_t i = 0; i < 3; ++i)
+    writer.WriteRecord<CONNECT_ACK>(clientid_t{100 + i}, names[i]);
+  PacketPtr packet = writer.Finish();
+  if (packet == nullptr) {
+    std::cerr << "CONNECT_ACK was not built" << std::endl;
+    return false;
+  }
+
+  PacketReader reader(packet.get());
+  auto header = reader.ReadHeader<CONNECT_ACK>();
+  if (!header || std::get<0>(*header) != 42 ||
+      std::get<1>(*header) != 0xABCDEF0123 || std::get<2>(*header) != 3) {
+    std::cerr << "CONNECT_ACK header differs" << std::endl;
+    return false;
+  }
+  for (std::size_t i = 0; i < 3; ++i) {
+    auto record = reader.ReadRecord<CONNECT_ACK>();
+    if (!record) {
+      std::cerr << "CONNECT_ACK record " << i << " missing" << std::endl;
+      return false;
+    }
+    const auto [id, name] = *record;
+    if (id != 100 + i || name != names[i]) {
+      std::cerr << "CONNECT_ACK record " << i << " differs: " << id << " "
+                << name << std::endl;
+      return false;
+    }
+  }
+  return reader.GetRemaining() == 0;
+}
+
+bool test_truncated_reads() {
+  PacketPtr packet = MakePacket<BUILD_REQ>(uint16_t{1}, uint8_t{3}, -7, 9);
+  SetPacketSize(packet, sPacketHeader + PayloadSize<BUILD_REQ>() - 1);
+
+  PacketReader reader(packet.get());
+  if (reader.ReadHeader<BUILD_REQ>() || reader.IsOk()) {
+    std::cerr << "Truncated BUILD_REQ accepted" << std::endl;
+    return false;
+  }
+
+  // Name length pointing past the end of the packet
+  PacketPtr named =
+      MakePacket<PLAYER_CONNECTED_BROADCAST>(clientid_t{7}, std::string("eve"));
+  SetPacketSize(named, GetPacketSize(named) - 1);
+  PacketReader namedReader(named.get());
+  if (namedReader.ReadHeader<PLAYER_CONNECTED_BROADCAST>()) {
+    std::cerr << "Name running past the packet accepted" << std::endl;
+    return false;
+  }
+
+  // Record count larger than the records present
+  PacketWriter writer(INTEREST_ENTER, PayloadSize<INTEREST_ENTER>(1));
+  writer.WriteHeader<INTEREST_ENTER>(uint16_t{2});
+  writer.WriteRecord<INTEREST_ENTER>(clientid_t{5});
+  PacketPtr interest = writer.Finish();
+  PacketReader interestReader(interest.get());
+  auto header = interestReader.ReadHeader<INTEREST_ENTER>();
+  if (!header || !interestReader.ReadRecord<INTEREST_ENTER>() ||
+      interestReader.ReadRecord<INTEREST_ENTER>()) {
+    std::cerr << "Missing INTEREST_ENTER record not detected" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_writer_size_mismatch() {
+  // Payload declared one record short
+  PacketWriter overflow(TRANSFORM_SNAPSHOT,
+                        PayloadSize<TRANSFORM_SNAPSHOT>(1));
+  overflow.WriteHeader<TRANSFORM_SNAPSHOT>(uint32_t{1}, uint16_t{2});
+  overflow.WriteRecord<TRANSFORM_SNAPSHOT>(clientid_t{1}, 0.f, 0.f,
+                                           uint8_t{0});
+  if (overflow.WriteRecord<TRANSFORM_SNAPSHOT>(clientid_t{2}, 0.f, 0.f,
+                                               uint8_t{0}) ||
+      overflow.Finish() != nullptr) {
+    std::cerr << "Writer overflow not detected" << std::endl;
+    return false;
+  }
+
+  // Payload declared one record too long
+  PacketWriter underflow(TRANSFORM_SNAPSHOT,
+                         PayloadSize<TRANSFORM_SNAPSHOT>(2));
+  underflow.WriteHeader<TRANSFORM_SNAPSHOT>(uint32_t{1}, uint16_t{1});
+  underflow.WriteRecord<TRANSFORM_SNAPSHOT>(clientid_t{1}, 0.f, 0.f,
+                                            uint8_t{0});
+  if (underflow.Finish() != nullptr) {
+    std::cerr << "Short payload not detected" << std::endl;
+    return false;
+  }
+
+  // packet_size would wrap past 16 bits
+  const uint16_t count = 9000;
+  PacketWriter oversize(INTEREST_ENTER, PayloadSize<INTEREST_ENTER>(count));
+  oversize.WriteHeader<INTEREST_ENTER>(count);
+  for (uint16_t i = 0; i < count; ++i)
+    oversize.WriteRecord<INTEREST_ENTER>(clientid_t{i});
+  if (oversize.Finish() != nullptr) {
+    std::cerr << "Payload past the packet size limit not detected"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_pool_reuse() {
+  PacketPool& pool = PacketPool::instance();
+
+  PacketPtr packet = MakePacket<UDP_BIND>(clientid_t{1}, uint64_t{1});
+  uint8_t* first = packet.get();
+  const std::size_t idleBefore = pool.GetIdleCount(40);
+  packet.reset();
+  if (pool.GetIdleCount(40) != idleBefore + 1) {
+    std::cerr << "Released packet was not pooled" << std::endl;
+    return false;
+  }
+
+  PacketPtr again = MakePacket<PLAYER_DISCONNECTED_BROADCAST>(clientid_t{1});
+  if (again.get() != first || pool.GetIdleCount(40) != idleBefore) {
+    std::cerr << "Pooled buffer was not reused" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_move_input_nibbles() {
+  // Odd and even counts, every mask value in both nibbles
+  for (uint8_t count = 1; count <= kMaxMoveBatch; ++count) {
+    uint8_t inputs[kMaxMoveBatch];
+    for (uint8_t i = 0; i < count; ++i)
+      inputs[i] = static_cast<uint8_t>((count * 5 + i * 3) & 0x0F);
+
+    PacketWriter writer(CLIENT_MOVE_REQ,
+                        PayloadSize<CLIENT_MOVE_REQ>() + (count + 1) / 2);
+    writer.WriteHeader<CLIENT_MOVE_REQ>(uint16_t{100}, count);
+    uint8_t*& wp = writer.Cursor();
+    std::memset(wp, 0, (count + 1) / 2);
+    for (uint8_t i = 0; i < count; ++i)
+      util::WriteInputNibble(wp, i, inputs[i]);
+    wp += (count + 1) / 2;
+    PacketPtr packet = writer.Finish();
+    if (!packet) {
+      std::cerr << "Move batch of " << int{count} << " did not fill the packet"
+                << std::endl;
+      return false;
+    }
+
+    PacketReader reader(packet.get());
+    auto header = reader.ReadHeader<CLIENT_MOVE_REQ>();
+    if (!header || std::get<1>(*header) != count ||
+        reader.GetRemaining() != static_cast<std::size_t>(count + 1) / 2) {
+      std::cerr << "Move batch header did not round trip" << std::endl;
+      return false;
+    }
+    for (uint8_t i = 0; i < count; ++i) {
+      const uint8_t input = util::ReadInputNibble(reader.Cursor(), i);
+      if (input != inputs[i]) {
+        std::cerr << "Input " << int{i} << " of " << int{count}
+                  << " read back " << int{input} << std::endl;
+        return false;
+      }
+    }
+  }
+
+  // Bits above the mask never leak into the neighbouring entry
+  uint8_t packed = 0;
+  util::WriteInputNibble(&packed, 0, 0xFF);
+  util::WriteInputNibble(&packed, 1, 0x03);
+  if (packed != 0x3F) {
+    std::cerr << "Packed byte " << int{packed} << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_fixed_round_trip()) {
+    all_passed = false;
+  }
+
+  if (!test_record_round_trip()) {
+    all_passed = false;
+  }
+
+  if (!test_truncated_reads()) {
+    all_passed = false;
+  }
+
+  if (!test_writer_size_mismatch()) {
+    all_passed = false;
+  }
+
+  if (!test_pool_reuse()) {
+    all_passed = false;
+  }
+
+  if (!test_move_input_nibbles()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All PacketSchema tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some PacketSchema tests failed!" << std::endl;
+    return 1;
+  }
+}
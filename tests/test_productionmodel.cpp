@@ -0,0 +1,121 @@
+#include <cmath>
+#include <iostream>
+
+#include "Core/ProductionModel.h"
+#include "SDL.h"
+
+namespace {
+// What the timers would do, one small step at a time
+ProductionProjection Tick(bool bRunning, float progress, float elapsed,
+                          float cycleTime, int startable) {
+  constexpr float kStep = 1.f / 256.f;
+  ProductionProjection result;
+  if (!bRunning && startable > 0) {
+    --startable;
+    ++result.started;
+    bRunning = true;
+    progress = 0.f;
+  }
+  for (float t = 0.f; t < elapsed && bRunning; t += kStep) {
+    progress += kStep;
+    if (progress < cycleTime) continue;
+    ++result.completed;
+    progress -= cycleTime;
+    if (startable > 0) {
+      --startable;
+      ++result.started;
+    } else {
+      bRunning = false;
+      progress = 0.f;
+    }
+  }
+  result.bRunning = bRunning;
+  result.progress = bRunning ? progress : 0.f;
+  return result;
+}
+
+bool Same(const ProductionProjection& a, const ProductionProjection& b) {
+  return a.completed == b.completed && a.started == b.started &&
+         a.bRunning == b.bRunning && std::abs(a.progress - b.progress) < 1e-3f;
+}
+}  // namespace
+
+bool test_matches_ticking() {
+  const float cycleTimes[] = {0.5f, 1.f, 3.f};
+  const float progresses[] = {0.f, 0.25f};
+  const float elapsed[] = {0.f, 0.125f, 1.f, 2.75f, 10.f, 60.f};
+  const int startables[] = {0, 1, 4, 100};
+
+  for (float cycleTime : cycleTimes) {
+    for (bool bRunning : {false, true}) {
+      for (float progress : progresses) {
+        for (float seconds : elapsed) {
+          for (int startable : startables) {
+            const ProductionProjection expected =
+                Tick(bRunning, progress, seconds, cycleTime, startable);
+            const ProductionProjection projected = ProjectProduction(
+                bRunning, progress, seconds, cycleTime, startable);
+            if (!Same(expected, projected)) {
+              std::cerr << "cycle " << cycleTime << " running " << bRunning
+                        << " progress " << progress << " elapsed " << seconds
+                        << " startable " << startable << ": projected "
+                        << projected.completed << "/" << projected.started
+                        << "/" << projected.progress << ", ticked "
+                        << expected.completed << "/" << expected.started << "/"
+                        << expected.progress << std::endl;
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool test_long_intervals() {
+  // A day off screen costs the same as a second
+  const ProductionProjection day =
+      ProjectProduction(true, 0.5f, 86400.f, 1.f, 1'000'000);
+  if (day.completed != 86400 || !day.bRunning ||
+      std::abs(day.progress - 0.5f) > 1e-3f) {
+    std::cerr << "A day projected " << day.completed << " cycles"
+              << std::endl;
+    return false;
+  }
+
+  // Limited by what the machine can start, not by time
+  const ProductionProjection limited =
+      ProjectProduction(true, 0.f, 86400.f, 2.f, 49);
+  if (limited.completed != 50 || limited.started != 49 || limited.bRunning) {
+    std::cerr << "Projected past the inputs" << std::endl;
+    return false;
+  }
+
+  const ProductionProjection idle = ProjectProduction(false, 0.f, 60.f, 1.f, 0);
+  if (idle.completed != 0 || idle.started != 0 || idle.bRunning) {
+    std::cerr << "Idle machine produced" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_matches_ticking()) {
+    all_passed = false;
+  }
+
+  if (!test_long_intervals()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All ProductionModel tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some ProductionModel tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,316 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Core/RegionFile.h"
+#include "SDL.h"
+
+namespace {
+std::string SavePath(const char* name) {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(path);
+  return path.string();
+}
+
+// Distinct bytes per chunk so a payload read from the wrong slot shows
+std::vector<uint8_t> MakePayload(ChunkCoord coord, std::size_t size) {
+  std::vector<uint8_t> payload(size);
+  for (std::size_t i = 0; i < size; ++i)
+    payload[i] = static_cast<uint8_t>(coord.x * 31 + coord.y * 17 + i);
+  return payload;
+}
+
+bool Matches(RegionStore& store, ChunkCoord coord,
+             const std::vector<uint8_t>& expected) {
+  const uint8_t* data = nullptr;
+  std::size_t size = 0;
+  return store.Load(coord, data, size) && size == expected.size() &&
+         std::memcmp(data, expected.data(), size) == 0;
+}
+
+ChunkRecord MakeRecord() {
+  ChunkRecord record;
+  for (int i = 0; i < Chunk::kTileCount; ++i) {
+    const TileType type = i < 40                ? TileType::Water
+                          : i >= 100 && i < 140 ? TileType::Dirt
+                                                : TileType::Grass;
+    record.types[i] = static_cast<uint8_t>(type);
+  }
+  record.ores.push_back({uint16_t{3}, OreType::Iron, 9000});
+  record.ores.push_back({uint16_t{200}, OreType::Copper, 12});
+  record.buildings.push_back(
+      {ENetArchetype::MiningDrill, Vec2(-5, 17), {1, 1, 2, 0, 40}, 0.0, 0.75f});
+  record.buildings.push_back({ENetArchetype::AssemblingMachine, Vec2(3, 4),
+                              std::vector<uint8_t>(20, 7), 3600.25, 1.5f});
+  return record;
+}
+}  // namespace
+
+bool test_store_round_trip() {
+  const std::string directory = SavePath("factorygame_region_round_trip");
+  const std::vector<ChunkCoord> coords = {
+      {0, 0}, {31, 31}, {32, 0}, {-1, -1}, {-32, 5}, {-33, -64}, {100, -7}};
+
+  {
+    RegionStore store;
+    if (!store.Open(directory, 42)) return false;
+    if (store.Contains({0, 0})) {
+      std::cerr << "Empty save claims to hold a chunk" << std::endl;
+      return false;
+    }
+    for (std::size_t i = 0; i < coords.size(); ++i) {
+      if (!store.Save(coords[i], MakePayload(coords[i], 100 + i * 150))) {
+        std::cerr << "Could not save chunk " << i << std::endl;
+        return false;
+      }
+    }
+    for (std::size_t i = 0; i < coords.size(); ++i) {
+      if (!Matches(store, coords[i], MakePayload(coords[i], 100 + i * 150))) {
+        std::cerr << "Chunk " << coords[i].x << ":" << coords[i].y
+                  << " did not read back" << std::endl;
+        return false;
+      }
+    }
+  }
+
+  // Survives a restart, game clock included
+  uint64_t seed = 0;
+  if (!RegionStore::ReadSeed(directory, seed) || seed != 42) {
+    std::cerr << "World seed was not saved" << std::endl;
+    return false;
+  }
+  {
+    RegionStore store;
+    if (!store.Open(directory, 42) || store.GetGameTime() != 0.0 ||
+        !store.SaveGameTime(1234.5)) {
+      std::cerr << "Could not save the game time" << std::endl;
+      return false;
+    }
+  }
+  RegionStore reopened;
+  if (!reopened.Open(directory, 42)) return false;
+  if (reopened.GetGameTime() != 1234.5) {
+    std::cerr << "Game time read back as " << reopened.GetGameTime()
+              << std::endl;
+    return false;
+  }
+  for (std::size_t i = 0; i < coords.size(); ++i) {
+    if (!Matches(reopened, coords[i], MakePayload(coords[i], 100 + i * 150))) {
+      std::cerr << "Chunk " << coords[i].x << ":" << coords[i].y
+                << " lost after reopening" << std::endl;
+      return false;
+    }
+  }
+  if (reopened.Contains({1, 0}) || reopened.Contains({-2, -1})) {
+    std::cerr << "Unsaved neighbour reported as saved" << std::endl;
+    return false;
+  }
+
+  RegionStore otherSeed;
+  if (otherSeed.Open(directory, 43)) {
+    std::cerr << "Save was opened for another seed" << std::endl;
+    return false;
+  }
+  std::filesystem::remove_all(directory);
+  return true;
+}
+
+bool test_rewrite_reuses_sectors() {
+  const std::string directory = SavePath("factorygame_region_rewrite");
+  std::filesystem::create_directories(directory);
+  const std::string path = directory + "/r.0.0.fgr";
+
+  RegionFile region;
+  if (!region.Open(path)) return false;
+  const uint32_t headerSectors = region.GetSectorCount();
+  if (headerSectors != kRegionHeaderSectors) {
+    std::cerr << "New region spans " << headerSectors << " sectors"
+              << std::endl;
+    return false;
+  }
+
+  // Three chunks of two sectors each, back to back
+  const std::vector<uint8_t> large(kRegionSectorSize + 10, 1);
+  for (int i = 0; i < 3; ++i) {
+    if (!region.Write(i, large)) return false;
+  }
+  const uint32_t threeChunks = region.GetSectorCount();
+
+  // Growing past its sectors moves the chunk to the end
+  const std::vector<uint8_t> huge(kRegionSectorSize * 3, 3);
+  if (!region.Write(1, huge)) return false;
+  const uint32_t afterMove = region.GetSectorCount();
+  if (afterMove != threeChunks + 3) {
+    std::cerr << "Expected the grown chunk at the end, file spans "
+              << afterMove << " sectors" << std::endl;
+    return false;
+  }
+
+  // The hole it left behind is reused, shrinking stays in place
+  const std::vector<uint8_t> small(20, 2);
+  if (!region.Write(3, large) || !region.Write(0, small)) return false;
+  if (region.GetSectorCount() != afterMove) {
+    std::cerr << "Freed sectors were not reused" << std::endl;
+    return false;
+  }
+
+  // Rewriting the same chunks over and over settles, the file stops growing
+  auto churn = [&](int count) {
+    for (int i = 0; i < count; ++i) {
+      if (!region.Write(i % 3, i % 2 ? small : huge)) return false;
+    }
+    return true;
+  };
+  if (!churn(50)) return false;
+  const uint32_t settled = region.GetSectorCount();
+  if (!churn(500)) return false;
+  if (region.GetSectorCount() != settled) {
+    std::cerr << "Rewrites grew the file from " << settled << " to "
+              << region.GetSectorCount() << " sectors" << std::endl;
+    return false;
+  }
+
+  if (!region.Write(2, huge)) return false;
+  region.Close();
+  if (std::filesystem::file_size(path) % kRegionSectorSize != 0) {
+    std::cerr << "Region does not end on a sector" << std::endl;
+    return false;
+  }
+
+  RegionFile reopened;
+  if (!reopened.Open(path)) return false;
+  const uint8_t* data = nullptr;
+  std::size_t size = 0;
+  if (!reopened.Read(2, data, size) || size != huge.size() ||
+      std::memcmp(data, huge.data(), size) != 0) {
+    std::cerr << "Last rewrite did not read back" << std::endl;
+    return false;
+  }
+  if (reopened.Contains(4)) {
+    std::cerr << "Unwritten chunk reported as saved" << std::endl;
+    return false;
+  }
+  reopened.Close();
+  std::filesystem::remove_all(directory);
+  return true;
+}
+
+bool test_rejects_foreign_file() {
+  const std::string directory = SavePath("factorygame_region_foreign");
+  std::filesystem::create_directories(directory);
+  const std::string path = directory + "/r.0.0.fgr";
+  {
+    std::ofstream file(path, std::ios::binary);
+    const std::vector<char> junk(kRegionHeaderSectors * kRegionSectorSize,
+                                 'x');
+    file.write(junk.data(), junk.size());
+  }
+
+  RegionFile region;
+  if (region.Open(path)) {
+    std::cerr << "Opened a file without the region magic" << std::endl;
+    return false;
+  }
+  RegionStore store;
+  if (!store.Open(directory, 1)) return false;
+  const uint8_t* data = nullptr;
+  std::size_t size = 0;
+  if (store.Contains({0, 0}) || store.Load({0, 0}, data, size)) {
+    std::cerr << "Loaded a chunk from a foreign file" << std::endl;
+    return false;
+  }
+  std::filesystem::remove_all(directory);
+  return true;
+}
+
+bool test_chunk_record_round_trip() {
+  const ChunkRecord record = MakeRecord();
+  std::vector<uint8_t> payload;
+  record.Encode(payload);
+
+  // Runs of terrain, not a byte per tile
+  if (payload.size() >= static_cast<std::size_t>(Chunk::kTileCount)) {
+    std::cerr << "Record took " << payload.size() << " bytes" << std::endl;
+    return false;
+  }
+
+  ChunkRecord decoded;
+  if (!decoded.Decode(payload.data(), payload.size())) {
+    std::cerr << "Could not decode a record" << std::endl;
+    return false;
+  }
+  if (decoded.types != record.types ||
+      decoded.ores.size() != record.ores.size() ||
+      decoded.buildings.size() != record.buildings.size()) {
+    std::cerr << "Record changed in the round trip" << std::endl;
+    return false;
+  }
+  for (std::size_t i = 0; i < record.ores.size(); ++i) {
+    if (decoded.ores[i].index != record.ores[i].index ||
+        decoded.ores[i].type != record.ores[i].type ||
+        decoded.ores[i].amount != record.ores[i].amount) {
+      std::cerr << "Ore " << i << " changed in the round trip" << std::endl;
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i < record.buildings.size(); ++i) {
+    if (decoded.buildings[i].archetype != record.buildings[i].archetype ||
+        decoded.buildings[i].tileIndex.x != record.buildings[i].tileIndex.x ||
+        decoded.buildings[i].tileIndex.y != record.buildings[i].tileIndex.y ||
+        decoded.buildings[i].state != record.buildings[i].state ||
+        decoded.buildings[i].settledAt != record.buildings[i].settledAt ||
+        decoded.buildings[i].progress != record.buildings[i].progress) {
+      std::cerr << "Building " << i << " changed in the round trip"
+                << std::endl;
+      return false;
+    }
+  }
+
+  // Every truncation is caught, as is trailing garbage
+  for (std::size_t size = 0; size < payload.size(); ++size) {
+    if (decoded.Decode(payload.data(), size)) {
+      std::cerr << "Decoded a record cut at " << size << " bytes"
+                << std::endl;
+      return false;
+    }
+  }
+  payload.push_back(0);
+  if (decoded.Decode(payload.data(), payload.size())) {
+    std::cerr << "Decoded a record with trailing bytes" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_store_round_trip()) {
+    all_passed = false;
+  }
+
+  if (!test_rewrite_reuses_sectors()) {
+    all_passed = false;
+  }
+
+  if (!test_rejects_foreign_file()) {
+    all_passed = false;
+  }
+
+  if (!test_chunk_record_round_trip()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All RegionFile tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some RegionFile tests failed!" << std::endl;
+    return 1;
+  }
+}
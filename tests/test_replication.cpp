@@ -0,0 +1,197 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Components/AssemblingMachineComponent.h"
+#include "Components/InventoryComponent.h"
+#include "Components/MiningDrillComponent.h"
+#include "Components/NetIdentityComponent.h"
+#include "Components/ResourceNodeComponent.h"
+#include "Core/ComponentReplicator.h"
+#include "Core/EventDispatcher.h"
+#include "Core/Registry.h"
+#include "Core/ReplicationManager.h"
+#include "Util/PacketUtil.h"
+#include "Util/ReplicationUtil.h"
+#include "SDL.h"
+
+namespace {
+constexpr clientid_t kClient = 3;
+
+void Register(Registry& registry) {
+  registry.RegisterComponent<NetIdentityComponent>();
+  registry.RegisterComponent<ReplicationDirtyTag>();
+  registry.RegisterComponent<InventoryComponent>();
+  registry.RegisterComponent<ResourceNodeComponent>();
+  registry.RegisterComponent<AssemblingMachineComponent>();
+  registry.RegisterComponent<MiningDrillComponent>();
+}
+
+// Entity carrying every replicated component, as a client would build it
+EntityID MakeBlank(Registry& registry) {
+  EntityID entity = registry.CreateEntity();
+  registry.AddComponent<ResourceNodeComponent>(entity, ResourceNodeComponent{});
+  registry.AddComponent<AssemblingMachineComponent>(
+      entity, AssemblingMachineComponent{});
+  registry.AddComponent<MiningDrillComponent>(entity, MiningDrillComponent{});
+  registry.AddComponent<InventoryComponent>(entity, InventoryComponent{});
+  return entity;
+}
+
+std::size_t PacketSize(const PacketPtr& packet) {
+  const uint8_t* rp = packet.get();
+  PACKET id;
+  std::size_t size;
+  util::GetHeader(rp, id, size);
+  return size;
+}
+}  // namespace
+
+bool test_component_round_trip() {
+  EventDispatcher eventDispatcher;
+  Registry server(&eventDispatcher);
+  Registry client(&eventDispatcher);
+  Register(server);
+  Register(client);
+
+  EntityID source = MakeBlank(server);
+  server.GetComponent<ResourceNodeComponent>(source).LeftResource = 123456;
+  auto& machine = server.GetComponent<AssemblingMachineComponent>(source);
+  machine.currentRecipe = RecipeID::IronGear;
+  machine.state = AssemblingMachineState::Crafting;
+  machine.bIsAnimating = true;
+  machine.inputInventory = {{ItemID::IronPlate, 7}};
+  machine.outputInventory = {{ItemID::IronPlate, 1}, {ItemID::CopperPlate, 2}};
+  auto& drill = server.GetComponent<MiningDrillComponent>(source);
+  drill.state = MiningDrillState::OutputFull;
+  server.GetComponent<InventoryComponent>(source).items = {
+      {ItemID::CopperOre, 50}};
+
+  const auto& replicator = ComponentReplicator::instance();
+  const uint8_t mask = replicator.GetMask(&server, source);
+  const uint8_t expectedMask =
+      ReplicationBit(EReplicatedComponent::ResourceNode) |
+      ReplicationBit(EReplicatedComponent::AssemblingMachine) |
+      ReplicationBit(EReplicatedComponent::MiningDrill);
+  if (mask != expectedMask) {
+    std::cerr << "Mask " << int{mask} << ", expected " << int{expectedMask}
+              << std::endl;
+    return false;
+  }
+
+  std::vector<uint8_t> buffer(replicator.GetSize(&server, source, mask));
+  uint8_t* wp = buffer.data();
+  replicator.Write(&server, source, mask, wp);
+  if (wp != buffer.data() + buffer.size()) {
+    std::cerr << "Wrote " << wp - buffer.data() << " bytes, GetSize said "
+              << buffer.size() << std::endl;
+    return false;
+  }
+
+  EntityID target = MakeBlank(client);
+  const uint8_t* rp = buffer.data();
+  const uint8_t* end = buffer.data() + buffer.size();
+  if (!replicator.Read(&client, target, rp, end) || rp != end) {
+    std::cerr << "Read did not consume the payload" << std::endl;
+    return false;
+  }
+  const auto& readMachine =
+      client.GetComponent<AssemblingMachineComponent>(target);
+  const auto& readDrill = client.GetComponent<MiningDrillComponent>(target);
+  if (client.GetComponent<ResourceNodeComponent>(target).LeftResource !=
+          123456 ||
+      readMachine.currentRecipe != machine.currentRecipe ||
+      readMachine.state != machine.state || !readMachine.bIsAnimating ||
+      readMachine.inputInventory != machine.inputInventory ||
+      readMachine.outputInventory != machine.outputInventory ||
+      readDrill.state != drill.state) {
+    std::cerr << "Read back a different state" << std::endl;
+    return false;
+  }
+
+  // Unknown entities skip the payload, truncated payloads are rejected
+  rp = buffer.data();
+  if (!replicator.Read(&client, INVALID_ENTITY, rp, end) || rp != end) {
+    std::cerr << "Skipping did not consume the payload" << std::endl;
+    return false;
+  }
+  rp = buffer.data();
+  if (replicator.Read(&client, target, rp, end - 1)) {
+    std::cerr << "Read a truncated payload" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_flush_respects_budget() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  ReplicationManager replication(&registry);
+
+  // Far more than one second of budget
+  constexpr int kEntities = 20'000;
+  for (int i = 0; i < kEntities; ++i) {
+    EntityID entity = registry.CreateEntity();
+    registry.AddComponent<MiningDrillComponent>(entity, MiningDrillComponent{});
+    replication.RegisterEntity(entity, ENetArchetype::MiningDrill, {i, 0});
+  }
+  replication.AddClient(kClient);
+
+  constexpr float kDeltaTime = 1.f / 60.f;
+  constexpr int kFrames = 120;
+  double sent = 0.0;
+  std::vector<PacketPtr> packets;
+  for (int frame = 1; frame <= kFrames; ++frame) {
+    packets.clear();
+    replication.CollectDirty();
+    replication.Flush(kClient, kDeltaTime, packets);
+    for (const PacketPtr& packet : packets) {
+      const std::size_t size = PacketSize(packet);
+      if (size > kMaxReplicationPacketSize) {
+        std::cerr << "Packet of " << size << " bytes" << std::endl;
+        return false;
+      }
+      sent += static_cast<double>(size);
+    }
+
+    // The bucket may go one packet into debt, never more
+    const double allowed = kReplicationBurstBytes +
+                           kReplicationBytesPerSecond * kDeltaTime * frame +
+                           kMaxReplicationPacketSize;
+    if (sent > allowed) {
+      std::cerr << "Sent " << sent << " bytes by frame " << frame
+                << ", budget allows " << allowed << std::endl;
+      return false;
+    }
+  }
+
+  // The link was kept busy rather than starved
+  const double rate = kReplicationBytesPerSecond * kDeltaTime * kFrames;
+  if (sent < rate) {
+    std::cerr << "Sent only " << sent << " of " << rate << " bytes"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_component_round_trip()) {
+    all_passed = false;
+  }
+
+  if (!test_flush_respects_budget()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All Replication tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some Replication tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,182 @@
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+#include "Components/AssemblingMachineComponent.h"
+#include "Components/MiningDrillComponent.h"
+#include "Components/NetIdentityComponent.h"
+#include "Components/ResourceNodeComponent.h"
+#include "Core/EventDispatcher.h"
+#include "Core/PacketSchema.h"
+#include "Core/Registry.h"
+#include "Core/ReplicationManager.h"
+#include "Util/PacketUtil.h"
+#include "Util/ReplicationUtil.h"
+#include "SDL.h"
+
+namespace {
+constexpr clientid_t kClient = 7;
+
+struct Received {
+  std::vector<netid_t> spawned;
+  std::vector<netid_t> despawned;
+  std::vector<netid_t> updated;
+  std::optional<uint32_t> syncVersion;
+};
+
+void Register(Registry& registry) {
+  registry.RegisterComponent<NetIdentityComponent>();
+  registry.RegisterComponent<ReplicationDirtyTag>();
+  registry.RegisterComponent<ResourceNodeComponent>();
+  registry.RegisterComponent<AssemblingMachineComponent>();
+  registry.RegisterComponent<MiningDrillComponent>();
+}
+
+EntityID MakeDrill(Registry& registry) {
+  EntityID entity = registry.CreateEntity();
+  registry.AddComponent<MiningDrillComponent>(entity, MiningDrillComponent{});
+  return entity;
+}
+
+// Flushes everything queued for the client and lists what it would receive
+Received Drain(ReplicationManager& replication) {
+  Received received;
+  std::vector<PacketPtr> packets;
+  replication.CollectDirty();
+  replication.Flush(kClient, 1.f, packets);
+
+  for (const PacketPtr& packet : packets) {
+    PacketReader reader(packet.get());
+    if (reader.GetPacketId() == REPLICATION_SYNC) {
+      received.syncVersion = std::get<0>(*reader.ReadHeader<REPLICATION_SYNC>());
+      continue;
+    }
+    // Every replication packet starts with entity_cnt
+    auto header = reader.ReadHeader<COMPONENT_UPDATE>();
+    if (!header) continue;
+    const uint16_t count = std::get<0>(*header);
+
+    if (reader.GetPacketId() == ENTITY_DESPAWN) {
+      for (uint16_t i = 0; i < count; ++i)
+        received.despawned.push_back(util::Read32BigEnd(reader.Cursor()));
+      continue;
+    }
+    // Records are variable sized, only the leading net_id is decoded and the
+    // rest are counted as 0
+    std::vector<netid_t>& list = reader.GetPacketId() == ENTITY_SPAWN
+                                     ? received.spawned
+                                     : received.updated;
+    list.push_back(util::Read32BigEnd(reader.Cursor()));
+    list.resize(list.size() + count - 1, 0);
+  }
+  return received;
+}
+}  // namespace
+
+bool test_resume_sends_only_changes() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  ReplicationManager replication(&registry);
+
+  EntityID kept = MakeDrill(registry);
+  EntityID removed = MakeDrill(registry);
+  const netid_t keptID =
+      replication.RegisterEntity(kept, ENetArchetype::MiningDrill, {0, 0});
+  const netid_t removedID =
+      replication.RegisterEntity(removed, ENetArchetype::MiningDrill, {4, 0});
+  replication.AddClient(kClient);
+
+  const Received first = Drain(replication);
+  if (first.spawned.size() != 2 || !first.syncVersion) {
+    std::cerr << "Initial stream did not end with REPLICATION_SYNC"
+              << std::endl;
+    return false;
+  }
+  const uint32_t known = *first.syncVersion;
+
+  // Connection drops, the world moves on
+  replication.RemoveClient(kClient);
+  replication.UnregisterEntity(removed);
+  EntityID added = MakeDrill(registry);
+  const netid_t addedID =
+      replication.RegisterEntity(added, ENetArchetype::MiningDrill, {8, 0});
+  EntityID shortLived = MakeDrill(registry);
+  replication.RegisterEntity(shortLived, ENetArchetype::MiningDrill, {12, 0});
+  replication.UnregisterEntity(shortLived);
+  util::MarkReplicationDirty(&registry, kept,
+                             EReplicatedComponent::MiningDrill);
+  replication.CollectDirty();
+
+  if (!replication.ResumeClient(kClient, known)) {
+    std::cerr << "Resume fell back to a full resync" << std::endl;
+    return false;
+  }
+  const Received resumed = Drain(replication);
+  if (resumed.spawned != std::vector<netid_t>{addedID} ||
+      resumed.despawned != std::vector<netid_t>{removedID} ||
+      resumed.updated != std::vector<netid_t>{keptID}) {
+    std::cerr << "Resume sent " << resumed.spawned.size() << " spawns, "
+              << resumed.despawned.size() << " despawns, "
+              << resumed.updated.size() << " updates" << std::endl;
+    return false;
+  }
+  if (resumed.syncVersion != replication.GetVersion()) {
+    std::cerr << "Resumed stream did not report the new version" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_forgotten_version_resyncs() {
+  EventDispatcher eventDispatcher;
+  Registry registry(&eventDispatcher);
+  Register(registry);
+  ReplicationManager replication(&registry);
+
+  EntityID kept = MakeDrill(registry);
+  replication.RegisterEntity(kept, ENetArchetype::MiningDrill, {0, 0});
+  const uint32_t known = replication.GetVersion();
+
+  for (std::size_t i = 0; i <= kMaxTombstones; ++i) {
+    EntityID entity = MakeDrill(registry);
+    replication.RegisterEntity(entity, ENetArchetype::MiningDrill, {4, 0});
+    replication.UnregisterEntity(entity);
+    registry.DestroyEntity(entity);
+  }
+
+  if (replication.ResumeClient(kClient, known)) {
+    std::cerr << "Resumed past forgotten despawns" << std::endl;
+    return false;
+  }
+  if (Drain(replication).spawned.size() != 1) {
+    std::cerr << "Full resync did not carry every entity" << std::endl;
+    return false;
+  }
+  if (replication.ResumeClient(kClient, replication.GetVersion() + 10)) {
+    std::cerr << "Version from another server run was trusted" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_resume_sends_only_changes()) {
+    all_passed = false;
+  }
+
+  if (!test_forgotten_version_resyncs()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All ReplicationResume tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some ReplicationResume tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,297 @@
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Components/ChunkComponent.h"
+#include "Components/MiningDrillComponent.h"
+#include "Components/ResourceNodeComponent.h"
+#include "Components/TransformComponent.h"
+#include "Core/AssetManager.h"
+#include "Core/CommandQueue.h"
+#include "Core/EntityFactory.h"
+#include "Core/EventDispatcher.h"
+#include "Core/Item.h"
+#include "Core/PacketSchema.h"
+#include "Core/Registry.h"
+#include "Core/SystemContext.h"
+#include "Core/ThreadSafeQueue.h"
+#include "Core/TimerManager.h"
+#include "Core/World.h"
+#include "Core/WorldAssetManager.h"
+#include "GameState/ServerState.h"
+#include "System/MiningDrillSystem.h"
+#include "System/ServerNetworkSystem.h"
+#include "System/TimerExpireSystem.h"
+#include "System/TimerSystem.h"
+#include "SDL.h"
+
+namespace {
+constexpr clientid_t kHost = 0;
+constexpr clientid_t kRemote = 1;
+
+// Middle of a tile, in pixels
+Vec2f OnTile(int x, int y) {
+  return {(x + 0.5f) * TILE_PIXEL_SIZE, (y + 0.5f) * TILE_PIXEL_SIZE};
+}
+
+// CHUNK_DATA of chunk (0, 0) covered in ground, with an optional ore node
+PacketPtr MakeChunk(TileType ground, int oreTile = -1, uint32_t oreAmount = 0) {
+  using Schema = PacketSchema<CHUNK_DATA>;
+  const uint16_t oreCount = oreTile < 0 ? 0 : 1;
+  PacketWriter writer(CHUNK_DATA,
+                      PayloadSize<CHUNK_DATA>(1) + Schema::OreHeader::kMinSize +
+                          oreCount * Schema::OreRecord::kMinSize);
+  writer.WriteHeader<CHUNK_DATA>(0, 0, uint16_t{1});
+  writer.WriteRecord<CHUNK_DATA>(
+      static_cast<uint16_t>(CHUNK_WIDTH * CHUNK_HEIGHT),
+      static_cast<uint8_t>(ground));
+  writer.Write<Schema::OreHeader>(oreCount);
+  if (oreCount != 0)
+    writer.Write<Schema::OreRecord>(static_cast<uint16_t>(oreTile),
+                                    static_cast<uint8_t>(OreType::Iron),
+                                    oreAmount);
+  return writer.Finish();
+}
+
+// World that only holds what it was sent, like a remote client's
+class TestClientWorld {
+ public:
+  TestClientWorld()
+      : registry(&eventDispatcher),
+        assetManager(nullptr),
+        worldAssetManager(nullptr),
+        factory(&registry, &assetManager) {
+    ServerState::RegisterComponent(&registry);
+    world = std::make_unique<World>(&registry, &worldAssetManager, &factory,
+                                    &eventDispatcher, &timerManager, nullptr,
+                                    false);
+  }
+
+  bool Apply(const PacketPtr& packet) {
+    PacketReader reader(packet.get());
+    return world->ApplyChunkData(reader);
+  }
+
+  ChunkComponent& GetChunkComponent() {
+    return registry.GetComponent<ChunkComponent>(
+        world->GetActiveChunk(0, 0)->chunkEntity);
+  }
+
+  std::unique_ptr<World> world;
+
+ private:
+  TimerManager timerManager;
+  EventDispatcher eventDispatcher;
+  Registry registry;
+  AssetManager assetManager;
+  WorldAssetManager worldAssetManager;
+  EntityFactory factory;
+};
+
+// Server without sockets or window, like a replay. Chunk (0, 0) is loaded
+// from chunk, all dirt by default.
+class TestServer {
+ public:
+  explicit TestServer(PacketPtr chunk = MakeChunk(TileType::Dirt))
+      : registry(&eventDispatcher),
+        assetManager(nullptr),
+        worldAssetManager(nullptr),
+        factory(&registry, &assetManager) {
+    ServerState::RegisterComponent(&registry);
+    world = std::make_unique<World>(&registry, &worldAssetManager, &factory,
+                                    &eventDispatcher, &timerManager, nullptr,
+                                    true);
+    clientNameMap[kHost] = "Server";
+
+    SystemContext context;
+    context.registry = &registry;
+    context.eventDispatcher = &eventDispatcher;
+    context.commandQueue = &commandQueue;
+    context.world = world.get();
+    context.entityFactory = &factory;
+    context.timerManager = &timerManager;
+    context.serverRecvQueue = &recvQueue;
+    context.serverSendQueue = &sendQueue;
+    context.pendingMoves = &pendingMoves;
+    context.clientNameMap = &clientNameMap;
+    context.bIsServer = true;
+    network = std::make_unique<ServerNetworkSystem>(context);
+    timerSystem = std::make_unique<TimerSystem>(context);
+    timerExpireSystem = std::make_unique<TimerExpireSystem>(context);
+    miningDrillSystem = std::make_unique<MiningDrillSystem>(context);
+
+    PacketReader reader(chunk.get());
+    world->ApplyChunkData(reader);
+  }
+
+  // Runs one frame: received packets, then the commands they queued
+  void Update() {
+    network->Update(tickDelta);
+    RunCommands();
+  }
+
+  // Runs the machines for deltaTime, in one step
+  void Simulate(float deltaTime) {
+    timerSystem->Update(deltaTime);
+    timerExpireSystem->Update();
+    RunCommands();
+    miningDrillSystem->Update();
+  }
+
+  EntityID BuildDrill(Vec2 tileIndex) {
+    return factory.CreateMiningDrill(world.get(), tileIndex);
+  }
+
+  bool IsDrillExhausted(EntityID drill) {
+    return registry.GetComponent<MiningDrillComponent>(drill).state ==
+           MiningDrillState::TileEmpty;
+  }
+
+  void Receive(clientid_t clientID, PacketPtr packet) {
+    recvQueue.Push(RecvPacket{clientID, std::move(packet)});
+  }
+
+  void MovePlayer(clientid_t clientID, Vec2f position) {
+    auto& transform = registry.GetComponent<TransformComponent>(
+        world->GetPlayerByClientID(clientID));
+    transform.position = position;
+    transform.bIsDirty = true;
+  }
+
+  bool IsOccupied(int tileX, int tileY) {
+    TileRef tile = world->GetTileAtTileIndex(tileX, tileY);
+    return tile && tile.GetOccupyingEntity() != INVALID_ENTITY;
+  }
+
+  std::unique_ptr<World> world;
+
+ private:
+  void RunCommands() {
+    while (!commandQueue.IsEmpty()) {
+      std::unique_ptr<Command> command = commandQueue.Dequeue();
+      if (command) command->Execute(&registry, &eventDispatcher, world.get());
+    }
+  }
+
+  TimerManager timerManager;
+  EventDispatcher eventDispatcher;
+  Registry registry;
+  CommandQueue commandQueue;
+  ThreadSafeQueue<RecvPacket> recvQueue;
+  ThreadSafeQueue<SendRequest> sendQueue;
+  ThreadSafeQueue<MoveApplied> pendingMoves;
+  std::unordered_map<clientid_t, std::string> clientNameMap;
+  AssetManager assetManager;
+  WorldAssetManager worldAssetManager;
+  EntityFactory factory;
+  std::unique_ptr<ServerNetworkSystem> network;
+  std::unique_ptr<TimerSystem> timerSystem;
+  std::unique_ptr<TimerExpireSystem> timerExpireSystem;
+  std::unique_ptr<MiningDrillSystem> miningDrillSystem;
+};
+}  // namespace
+
+bool test_build_checks_requester_tile() {
+  TestServer server;
+  server.world->GeneratePlayer(kHost, OnTile(5, 2), true);
+  server.Receive(kRemote,
+                 MakePacket<CONNECT_SYN>(std::string("remote"), uint32_t{0}));
+  server.Update();
+  if (server.world->GetPlayerByClientID(kRemote) == INVALID_ENTITY) {
+    std::cerr << "CONNECT_SYN did not spawn the remote player" << std::endl;
+    return false;
+  }
+  server.MovePlayer(kRemote, OnTile(2, 2));
+
+  // The requester cannot build on the tile it stands on
+  server.Receive(kRemote,
+                 MakePacket<BUILD_REQ>(uint16_t{1},
+                                       static_cast<uint8_t>(ItemID::MiningDrill),
+                                       int32_t{2}, int32_t{2}));
+  server.Update();
+  if (server.IsOccupied(2, 2)) {
+    std::cerr << "Building placed on the requester's own tile" << std::endl;
+    return false;
+  }
+
+  // The host standing somewhere else does not block the requester
+  server.Receive(kRemote,
+                 MakePacket<BUILD_REQ>(uint16_t{2},
+                                       static_cast<uint8_t>(ItemID::MiningDrill),
+                                       int32_t{5}, int32_t{2}));
+  server.Update();
+  if (!server.IsOccupied(5, 2)) {
+    std::cerr << "Building on the host's tile was refused for a remote client"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_exhausted_tile_redrawn() {
+  constexpr int kOreX = 3;
+  constexpr int kOreY = 4;
+  constexpr int kOreIndex = kOreY * CHUNK_WIDTH + kOreX;
+  TestServer server(MakeChunk(TileType::Grass, kOreIndex, 2));
+  TestClientWorld client;
+  if (!client.Apply(server.world->EncodeChunk({0, 0})) ||
+      client.GetChunkComponent().bNeedsRedraw) {
+    std::cerr << "Client could not load the chunk" << std::endl;
+    return false;
+  }
+
+  const EntityID drill = server.BuildDrill({kOreX, kOreY});
+  for (int tick = 0; tick < 600 && !server.IsDrillExhausted(drill); ++tick)
+    server.Simulate(tickDelta);
+  if (!server.IsDrillExhausted(drill)) {
+    std::cerr << "Drill never mined out its ore" << std::endl;
+    return false;
+  }
+  if (server.world->GetTileAtTileIndex(kOreX, kOreY).GetType() !=
+      TileType::Dirt) {
+    std::cerr << "Mined out tile was not turned into dirt" << std::endl;
+    return false;
+  }
+
+  // The resent chunk redraws only the tile that changed
+  if (!client.Apply(server.world->EncodeChunk({0, 0})) ||
+      !client.GetChunkComponent().bNeedsRedraw) {
+    std::cerr << "Resent chunk was not marked for redraw" << std::endl;
+    return false;
+  }
+  Chunk& chunk = *client.world->GetActiveChunk(0, 0);
+  int redrawn = 0;
+  bool bIsOreTile = true;
+  chunk.ForEachDirtyTile([&](int index) {
+    ++redrawn;
+    bIsOreTile = bIsOreTile && index == kOreIndex;
+  });
+  if (redrawn != 1 || !bIsOreTile) {
+    std::cerr << "Expected only the mined out tile redrawn, got " << redrawn
+              << " tiles" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_build_checks_requester_tile()) {
+    all_passed = false;
+  }
+
+  if (!test_exhausted_tile_redrawn()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All ServerBuild tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some ServerBuild tests failed!" << std::endl;
+    return 1;
+  }
+}
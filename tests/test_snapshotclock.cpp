@@ -0,0 +1,178 @@
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#include "Components/InterpBufferComponent.h"
+#include "Core/Packet.h"
+#include "Core/SnapshotClock.h"
+#include "Util/InterpUtil.h"
+#include "SDL.h"
+
+namespace {
+constexpr uint32_t kTicksPerSnapshot =
+    static_cast<uint32_t>(tickRate / syncRate);
+constexpr double kLatency = 0.04;
+constexpr double kStart = 1000.0;
+
+// Entity walking +1 x per server tick
+float PositionAt(uint32_t tick) { return static_cast<float>(tick); }
+}  // namespace
+
+bool test_sample_with_cursor() {
+  InterpBufferComponent buf;
+  for (uint32_t tick = 10; tick <= 40; tick += 2)
+    util::PushInterpSample(buf, tick, PositionAt(tick), 0.f, 0);
+
+  float x, y;
+  uint8_t facing;
+  if (!util::SampleInterpBuffer(buf, 15.5, x, y, facing) ||
+      std::abs(x - 15.5f) > 1e-4f) {
+    std::cerr << "Interpolation between samples is wrong: " << x << std::endl;
+    return false;
+  }
+  util::SampleInterpBuffer(buf, 100.0, x, y, facing);
+  if (x != 40.f) {
+    std::cerr << "Render tick past the newest sample was not clamped"
+              << std::endl;
+    return false;
+  }
+  // Stepping back resets the cursor instead of sampling the wrong pair
+  util::SampleInterpBuffer(buf, 12.0, x, y, facing);
+  if (std::abs(x - 12.f) > 1e-4f) {
+    std::cerr << "Backward render tick sampled " << x << std::endl;
+    return false;
+  }
+
+  if (util::PushInterpSample(buf, 40, 0.f, 0.f, 0)) {
+    std::cerr << "Duplicate tick was buffered" << std::endl;
+    return false;
+  }
+  // Overflow keeps the cursor on the same sample
+  util::SampleInterpBuffer(buf, 39.0, x, y, facing);
+  for (uint32_t tick = 42; tick <= 50; tick += 2)
+    util::PushInterpSample(buf, tick, PositionAt(tick), 0.f, 0);
+  util::SampleInterpBuffer(buf, 39.0, x, y, facing);
+  if (std::abs(x - 39.f) > 1e-4f) {
+    std::cerr << "Cursor drifted when old samples were dropped" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_steady_stream() {
+  SnapshotClock clock;
+  for (uint32_t i = 0; i < 300; ++i) {
+    const uint32_t tick = i * kTicksPerSnapshot;
+    clock.OnSnapshot(tick, kStart + tick * tickDelta + kLatency);
+  }
+
+  if (clock.GetDelay() < SnapshotClock::kMinDelay ||
+      clock.GetDelay() > syncDelta + 0.02) {
+    std::cerr << "Steady stream delay did not settle: " << clock.GetDelay()
+              << std::endl;
+    return false;
+  }
+  // Drawn one delay behind the newest tick at its arrival
+  const uint32_t newest = 299 * kTicksPerSnapshot;
+  const double arrival = kStart + newest * tickDelta + kLatency;
+  const double behind = newest - clock.GetRenderTick(arrival);
+  if (std::abs(behind - clock.GetDelay() * tickRate) > 0.5) {
+    std::cerr << "Render tick is " << behind << " ticks behind" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_bunched_delivery_is_smooth() {
+  SnapshotClock clock;
+  InterpBufferComponent buf;
+
+  // Snapshots arrive in pairs, every other one held back a full interval as
+  // TCP does after a lost segment. Render at 120 fps and check that motion
+  // never stalls or jumps backwards.
+  float lastX = -1.f;
+  int stalls = 0;
+  uint32_t nextSnapshot = 0;
+  for (int frame = 0; frame < 1200; ++frame) {
+    const double now = kStart + frame / 120.0;
+    while (true) {
+      const uint32_t tick = nextSnapshot * kTicksPerSnapshot;
+      const double sent = kStart + tick * tickDelta;
+      const double late = (nextSnapshot % 2 == 0) ? syncDelta : 0.0;
+      if (sent + kLatency + late > now) break;
+      clock.OnSnapshot(tick, now);
+      util::PushInterpSample(buf, tick, PositionAt(tick), 0.f, 0);
+      ++nextSnapshot;
+    }
+    if (frame < 240) continue;  // let the delay adapt
+
+    float x, y;
+    uint8_t facing;
+    if (!util::SampleInterpBuffer(buf, clock.GetRenderTick(now), x, y,
+                                  facing))
+      continue;
+    if (lastX >= 0.f && x <= lastX) ++stalls;
+    lastX = x;
+  }
+
+  if (stalls > 0) {
+    std::cerr << "Bunched delivery stalled " << stalls << " frames, delay "
+              << clock.GetDelay() << std::endl;
+    return false;
+  }
+  if (clock.GetDelay() <= syncDelta) {
+    std::cerr << "Delay did not grow with jitter" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_server_restart() {
+  SnapshotClock clock;
+  InterpBufferComponent buf;
+  for (uint32_t tick = 1000; tick < 1100; tick += 2) {
+    clock.OnSnapshot(tick, kStart + tick * tickDelta);
+    util::PushInterpSample(buf, tick, 0.f, 0.f, 0);
+  }
+
+  clock.OnSnapshot(2, kStart + 1100 * tickDelta);
+  if (!util::PushInterpSample(buf, 2, 0.f, 0.f, 0) || buf.count != 1) {
+    std::cerr << "Restarted server ticks were dropped" << std::endl;
+    return false;
+  }
+  const double renderTick = clock.GetRenderTick(kStart + 1100 * tickDelta);
+  if (renderTick > 2.0) {
+    std::cerr << "Clock kept the old server timeline: " << renderTick
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_sample_with_cursor()) {
+    all_passed = false;
+  }
+
+  if (!test_steady_stream()) {
+    all_passed = false;
+  }
+
+  if (!test_bunched_delivery_is_smooth()) {
+    all_passed = false;
+  }
+
+  if (!test_server_restart()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All SnapshotClock tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some SnapshotClock tests failed!" << std::endl;
+    return 1;
+  }
+}
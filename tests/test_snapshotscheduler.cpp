@@ -0,0 +1,177 @@
+#include <cstddef>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Packet.h"
+#include "Core/PacketSchema.h"
+#include "Core/SnapshotScheduler.h"
+#include "SDL.h"
+
+namespace {
+constexpr std::size_t kHeaderBytes =
+    sizeof(PacketHeader) + PayloadSize<TRANSFORM_SNAPSHOT>();
+constexpr std::size_t kRecordBytes =
+    PayloadSize<TRANSFORM_SNAPSHOT>(1) - PayloadSize<TRANSFORM_SNAPSHOT>();
+
+// Runs one second of network ticks and counts how often each player is sent
+std::unordered_map<clientid_t, int> RunSecond(
+    SnapshotScheduler& scheduler, clientid_t client,
+    std::vector<SnapshotScheduler::Subject>& subjects, bool bMove,
+    int& snapshots) {
+  std::unordered_map<clientid_t, int> sent;
+  std::vector<SnapshotScheduler::Subject> selected;
+  for (int tick = 0; tick < static_cast<int>(tickRate); ++tick) {
+    if (bMove)
+      for (auto& subject : subjects) subject.position.x += 1.f;
+    const bool bIsDue = scheduler.IsSendDue(client, tickDelta);
+    scheduler.Accumulate(client, {0.f, 0.f}, subjects, tickDelta);
+    if (!bIsDue) continue;
+
+    ++snapshots;
+    scheduler.Select(client, kHeaderBytes, kRecordBytes, selected);
+    if (kHeaderBytes + selected.size() * kRecordBytes >
+            scheduler.GetWindowBudget(client) &&
+        selected.size() > 1) {
+      std::cerr << "Snapshot went over its byte budget" << std::endl;
+      sent.clear();
+      return sent;
+    }
+    for (const auto& subject : selected) ++sent[subject.id];
+  }
+  return sent;
+}
+}  // namespace
+
+bool test_send_rate() {
+  SnapshotScheduler scheduler;
+  scheduler.AddClient(1, {20.f, 64 * 1024});
+  std::vector<SnapshotScheduler::Subject> subjects{{2, {10.f, 0.f}}};
+
+  int snapshots = 0;
+  auto sent = RunSecond(scheduler, 1, subjects, true, snapshots);
+  if (snapshots != 20 || sent[2] != 20) {
+    std::cerr << "Expected 20 snapshots per second, got " << snapshots
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_near_players_sent_more_often() {
+  // Room for four records per snapshot, sixteen players to share it
+  const std::size_t windowBytes = kHeaderBytes + 4 * kRecordBytes;
+  SnapshotScheduler scheduler;
+  scheduler.AddClient(1, {syncRate, static_cast<std::size_t>(
+                                        windowBytes * syncRate)});
+
+  std::vector<SnapshotScheduler::Subject> subjects;
+  for (clientid_t id = 2; id < 18; ++id)
+    subjects.push_back({id, {(id < 6 ? 32.f : 2000.f), 0.f}});
+
+  int snapshots = 0;
+  RunSecond(scheduler, 1, subjects, true, snapshots);
+  auto sent = RunSecond(scheduler, 1, subjects, true, snapshots);
+  if (sent.empty()) return false;
+
+  int nearCount = 0;
+  int farCount = 0;
+  for (auto& [id, count] : sent) (id < 6 ? nearCount : farCount) += count;
+  if (nearCount <= farCount / 3) {
+    std::cerr << "Near players sent " << nearCount / 4 << " times, far "
+              << farCount / 12 << " times" << std::endl;
+    return false;
+  }
+  for (clientid_t id = 6; id < 18; ++id) {
+    if (sent[id] == 0) {
+      std::cerr << "Far player " << id << " starved" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool test_idle_players_yield() {
+  const std::size_t windowBytes = kHeaderBytes + 1 * kRecordBytes;
+  SnapshotScheduler scheduler;
+  scheduler.AddClient(1, {syncRate, static_cast<std::size_t>(
+                                        windowBytes * syncRate)});
+
+  // Same distance, only player 3 keeps walking
+  std::vector<SnapshotScheduler::Subject> subjects{{2, {100.f, 0.f}},
+                                                   {3, {100.f, 0.f}}};
+  std::vector<SnapshotScheduler::Subject> selected;
+  int idle = 0;
+  int moving = 0;
+  for (int tick = 0; tick < 120; ++tick) {
+    subjects[1].position.y += 1.f;
+    const bool bIsDue = scheduler.IsSendDue(1, tickDelta);
+    scheduler.Accumulate(1, {0.f, 0.f}, subjects, tickDelta);
+    if (!bIsDue) continue;
+    scheduler.Select(1, kHeaderBytes, kRecordBytes, selected);
+    for (const auto& subject : selected) (subject.id == 2 ? idle : moving)++;
+  }
+  if (moving <= idle * 3) {
+    std::cerr << "Idle player sent " << idle << " times, moving " << moving
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_server_budget_is_shared() {
+  SnapshotScheduler scheduler(30 * 1024);
+  scheduler.AddClient(1, {syncRate, 16 * 1024});
+  const std::size_t alone = scheduler.GetWindowBudget(1);
+  scheduler.AddClient(2, {syncRate, 16 * 1024});
+  scheduler.AddClient(3, {syncRate, 16 * 1024});
+  const std::size_t shared = scheduler.GetWindowBudget(1);
+  if (alone != static_cast<std::size_t>(16 * 1024 / syncRate) ||
+      shared != static_cast<std::size_t>(10 * 1024 / syncRate)) {
+    std::cerr << "Window budgets " << alone << " and " << shared << std::endl;
+    return false;
+  }
+
+  // A player entering view goes out at once, one leaving is forgotten
+  scheduler.RemoveClient(3);
+  std::vector<SnapshotScheduler::Subject> selected;
+  scheduler.Accumulate(1, {0.f, 0.f}, {{2, {5000.f, 0.f}}}, tickDelta);
+  scheduler.Select(1, kHeaderBytes, kRecordBytes, selected);
+  scheduler.Accumulate(1, {0.f, 0.f}, {}, tickDelta);
+  scheduler.Accumulate(1, {0.f, 0.f}, {{2, {5000.f, 0.f}}}, tickDelta);
+  std::vector<SnapshotScheduler::Subject> again;
+  scheduler.Select(1, kHeaderBytes, kRecordBytes, again);
+  if (selected.size() != 1 || again.size() != 1) {
+    std::cerr << "Entering player was not sent right away" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_send_rate()) {
+    all_passed = false;
+  }
+
+  if (!test_near_players_sent_more_often()) {
+    all_passed = false;
+  }
+
+  if (!test_idle_players_yield()) {
+    all_passed = false;
+  }
+
+  if (!test_server_budget_is_shared()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All SnapshotScheduler tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some SnapshotScheduler tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Core/ByteRing.h"
+#include "Core/Socket.h"
+#include "SDL.h"
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double MillisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+uint8_t PatternByte(std::size_t index) {
+  return static_cast<uint8_t>((index * 31 + 7) & 0xFF);
+}
+
+#ifdef __linux__
+// Loopback listener standing in for a server that stops reading
+struct SlowServer {
+  int listenFd = -1;
+  int clientFd = -1;
+  int port = 0;
+
+  bool Listen() {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) return false;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    // Small receive buffer so the kernel queues fill up quickly
+    const int recvBufferSize = 4096;
+    setsockopt(listenFd, SOL_SOCKET, SO_RCVBUF, &recvBufferSize,
+               sizeof(recvBufferSize));
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listenFd, 1) < 0 ||
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len) < 0)
+      return false;
+    port = ntohs(addr.sin_port);
+    return true;
+  }
+
+  bool Accept() {
+    clientFd = accept(listenFd, nullptr, nullptr);
+    return clientFd >= 0;
+  }
+
+  ~SlowServer() {
+    if (clientFd >= 0) close(clientFd);
+    if (listenFd >= 0) close(listenFd);
+  }
+};
+#endif
+}  // namespace
+
+bool test_byte_ring_wrap() {
+  ByteRing ring(8);
+  const uint8_t first[6] = {1, 2, 3, 4, 5, 6};
+  const uint8_t second[5] = {7, 8, 9, 10, 11};
+
+  if (!ring.Write(first, 6)) return false;
+  ring.Consume(4);
+  if (!ring.Write(second, 5) || ring.GetSize() != 7) {
+    std::cerr << "ByteRing rejected a write that fits" << std::endl;
+    return false;
+  }
+  if (ring.Write(first, 2)) {
+    std::cerr << "ByteRing accepted a write past capacity" << std::endl;
+    return false;
+  }
+
+  std::vector<uint8_t> out;
+  while (!ring.IsEmpty()) {
+    const uint8_t* data;
+    const std::size_t size = ring.Peek(data);
+    out.insert(out.end(), data, data + size);
+    ring.Consume(size);
+  }
+  const std::vector<uint8_t> expected = {5, 6, 7, 8, 9, 10, 11};
+  if (out != expected) {
+    std::cerr << "ByteRing returned bytes out of order" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+#ifdef __linux__
+// The game thread keeps sending every frame while the server reads nothing.
+// Send must stay cheap, the backlog must build up in the ring, and every
+// byte must arrive in order once the server catches up.
+bool test_frame_time_with_slow_server() {
+  SlowServer server;
+  if (!server.Listen()) {
+    std::cerr << "Could not open loopback listener" << std::endl;
+    return false;
+  }
+
+  SocketOptions options;
+  options.sendBufferSize = 4096;
+  options.sendRingSize = 4 << 20;
+  Socket socket;
+  socket.Init(options);
+  if (socket.Connect("127.0.0.1", server.port) == 0 || !server.Accept()) {
+    std::cerr << "Could not connect to loopback listener" << std::endl;
+    return false;
+  }
+
+  constexpr int kFrames = 600;
+  constexpr std::size_t kPacketSize = 1000;
+  constexpr double kMaxSendMs = 4.0;
+
+  std::vector<uint8_t> packet(kPacketSize);
+  std::size_t sent = 0;
+  double worstMs = 0.0;
+  for (int frame = 0; frame < kFrames; ++frame) {
+    for (std::size_t i = 0; i < kPacketSize; ++i)
+      packet[i] = PatternByte(sent + i);
+
+    const auto start = Clock::now();
+    if (socket.Send(packet.data(), packet.size()) !=
+        static_cast<int>(kPacketSize)) {
+      std::cerr << "Send failed at frame " << frame << std::endl;
+      return false;
+    }
+    worstMs = std::max(worstMs, MillisecondsSince(start));
+    sent += kPacketSize;
+  }
+
+  if (worstMs > kMaxSendMs) {
+    std::cerr << "Send stalled the frame for " << worstMs << " ms"
+              << std::endl;
+    return false;
+  }
+  if (socket.GetPendingSendBytes() == 0) {
+    std::cerr << "Server kept up, the test did not exercise back pressure"
+              << std::endl;
+    return false;
+  }
+
+  // Server catches up
+  std::vector<uint8_t> received;
+  std::vector<uint8_t> chunk(64 * 1024);
+  const auto drainStart = Clock::now();
+  while (received.size() < sent && MillisecondsSince(drainStart) < 5000.0) {
+    ssize_t res = recv(server.clientFd, chunk.data(), chunk.size(), 0);
+    if (res <= 0) break;
+    received.insert(received.end(), chunk.begin(), chunk.begin() + res);
+  }
+  if (received.size() != sent) {
+    std::cerr << "Server received " << received.size() << " of " << sent
+              << " bytes" << std::endl;
+    return false;
+  }
+  for (std::size_t i = 0; i < received.size(); ++i) {
+    if (received[i] != PatternByte(i)) {
+      std::cerr << "Stream corrupted at byte " << i << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool test_receive_and_close() {
+  SlowServer server;
+  Socket socket;
+  socket.Init();
+  if (!server.Listen() || socket.Connect("127.0.0.1", server.port) == 0 ||
+      !server.Accept()) {
+    std::cerr << "Could not connect to loopback listener" << std::endl;
+    return false;
+  }
+
+  const uint8_t message[4] = {1, 2, 3, 4};
+  send(server.clientFd, message, sizeof(message), 0);
+
+  uint8_t buffer[16];
+  std::size_t total = 0;
+  while (total < sizeof(message)) {
+    int res = socket.Receive(buffer + total, sizeof(buffer) - total);
+    if (res <= 0) {
+      std::cerr << "Receive failed before the message arrived" << std::endl;
+      return false;
+    }
+    total += static_cast<std::size_t>(res);
+  }
+  if (total != sizeof(message) || buffer[0] != 1 || buffer[3] != 4) {
+    std::cerr << "Received bytes differ" << std::endl;
+    return false;
+  }
+
+  close(server.clientFd);
+  server.clientFd = -1;
+  if (socket.Receive(buffer, sizeof(buffer)) != 0) {
+    std::cerr << "Server close was not reported" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_connect_timeout() {
+  SocketOptions options;
+  options.connectTimeoutMs = 200;
+  Socket socket;
+  socket.Init(options);
+
+  const auto start = Clock::now();
+  // Reserved TEST-NET-1 address, unroutable or refused depending on the host
+  const uint64_t res = socket.Connect("192.0.2.1", 27015);
+  const double elapsedMs = MillisecondsSince(start);
+  if (res != 0) {
+    std::cerr << "Connected to an unreachable address" << std::endl;
+    return false;
+  }
+  if (elapsedMs > 1000.0) {
+    std::cerr << "Connect ignored its timeout: " << elapsedMs << " ms"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+#endif
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_byte_ring_wrap()) {
+    all_passed = false;
+  }
+
+#ifdef __linux__
+  if (!test_frame_time_with_slow_server()) {
+    all_passed = false;
+  }
+
+  if (!test_receive_and_close()) {
+    all_passed = false;
+  }
+
+  if (!test_connect_timeout()) {
+    all_passed = false;
+  }
+#endif
+
+  if (all_passed) {
+    std::cout << "All Socket tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some Socket tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/SpatialIndex.h"
+#include "SDL.h"
+
+namespace {
+using Positions = std::unordered_map<EntityID, Vec2f>;
+
+std::vector<EntityID> Sorted(std::vector<EntityID> entities) {
+  std::sort(entities.begin(), entities.end());
+  return entities;
+}
+
+std::vector<EntityID> ScanRect(const Positions& positions, Vec2f min,
+                               Vec2f max) {
+  std::vector<EntityID> found;
+  for (const auto& [entity, pos] : positions) {
+    if (pos.x >= min.x && pos.x <= max.x && pos.y >= min.y && pos.y <= max.y)
+      found.push_back(entity);
+  }
+  return Sorted(found);
+}
+
+std::vector<EntityID> ScanRadius(const Positions& positions, Vec2f center,
+                                 float radius) {
+  std::vector<EntityID> found;
+  for (const auto& [entity, pos] : positions) {
+    const float dx = pos.x - center.x;
+    const float dy = pos.y - center.y;
+    if (dx * dx + dy * dy <= radius * radius) found.push_back(entity);
+  }
+  return Sorted(found);
+}
+
+float Distance(Vec2f a, Vec2f b) {
+  return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+}
+}  // namespace
+
+bool test_queries_match_scan() {
+  // Small cells so entities cross borders and negative cells all the time
+  SpatialIndex index(100.f);
+  Positions positions;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> spread(-1000.f, 1000.f);
+  std::uniform_real_distribution<float> step(-60.f, 60.f);
+
+  for (EntityID entity = 1; entity <= 2000; ++entity) {
+    positions[entity] = {spread(rng), spread(rng)};
+    index.Update(entity, positions[entity]);
+  }
+
+  for (int frame = 0; frame < 20; ++frame) {
+    for (auto& [entity, pos] : positions) {
+      pos = pos + Vec2f(step(rng), step(rng));
+      index.Update(entity, pos);
+    }
+    // Some leave for good
+    const EntityID firstGone = static_cast<EntityID>(frame) * 10 + 1;
+    for (EntityID entity = firstGone; entity < firstGone + 10; ++entity) {
+      index.Remove(entity);
+      positions.erase(entity);
+    }
+
+    const Vec2f min{spread(rng), spread(rng)};
+    const Vec2f max{min.x + 400.f, min.y + 250.f};
+    std::vector<EntityID> found;
+    index.QueryRect(min, max, found);
+    if (Sorted(found) != ScanRect(positions, min, max)) {
+      std::cerr << "Rect query disagrees with a scan on frame " << frame
+                << std::endl;
+      return false;
+    }
+
+    const Vec2f center{spread(rng), spread(rng)};
+    found.clear();
+    index.QueryRadius(center, 180.f, found);
+    if (Sorted(found) != ScanRadius(positions, center, 180.f)) {
+      std::cerr << "Radius query disagrees with a scan on frame " << frame
+                << std::endl;
+      return false;
+    }
+
+    const EntityID nearest = index.Nearest(center, 3000.f);
+    float bestDist = 1e9f;
+    for (const auto& [entity, pos] : positions)
+      bestDist = std::min(bestDist, Distance(pos, center));
+    if (nearest == INVALID_ENTITY ||
+        Distance(positions[nearest], center) != bestDist) {
+      std::cerr << "Nearest query missed the closest entity on frame "
+                << frame << std::endl;
+      return false;
+    }
+  }
+
+  if (index.GetSize() != positions.size()) {
+    std::cerr << "Index holds " << index.GetSize() << " entities, expected "
+              << positions.size() << std::endl;
+    return false;
+  }
+
+  // A rect wider than the filled cells takes the other path
+  std::vector<EntityID> everything;
+  index.QueryRect({-1e7f, -1e7f}, {1e7f, 1e7f}, everything);
+  if (everything.size() != positions.size()) {
+    std::cerr << "Huge rect found " << everything.size() << " entities"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_nearest_filter_and_radius() {
+  SpatialIndex index(64.f);
+  if (index.Nearest({0.f, 0.f}, 1000.f) != INVALID_ENTITY) {
+    std::cerr << "Empty index found an entity" << std::endl;
+    return false;
+  }
+
+  index.Update(1, {10.f, 0.f});
+  index.Update(2, {-300.f, 0.f});
+  index.Update(3, {0.f, 900.f});
+
+  if (index.Nearest({0.f, 0.f}, 1000.f) != 1) {
+    std::cerr << "Closest entity not found" << std::endl;
+    return false;
+  }
+  auto notOne = [](EntityID entity) { return entity != 1; };
+  if (index.Nearest({0.f, 0.f}, 1000.f, notOne) != 2) {
+    std::cerr << "Filter was not applied" << std::endl;
+    return false;
+  }
+  if (index.Nearest({0.f, 0.f}, 200.f, notOne) != INVALID_ENTITY) {
+    std::cerr << "Entity found past the radius" << std::endl;
+    return false;
+  }
+
+  // Moving far away and back keeps one entry
+  index.Update(1, {5000.f, 5000.f});
+  index.Update(1, {20.f, 0.f});
+  std::vector<EntityID> found;
+  index.QueryRadius({0.f, 0.f}, 20.f, found);
+  if (found != std::vector<EntityID>{1} || index.GetSize() != 3) {
+    std::cerr << "Entity moved back and forth is filed wrong" << std::endl;
+    return false;
+  }
+
+  index.Remove(1);
+  index.Remove(1);
+  index.Remove(2);
+  index.Remove(3);
+  if (index.GetSize() != 0 || index.GetCellCount() != 0) {
+    std::cerr << "Empty cells were kept" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_queries_match_scan()) {
+    all_passed = false;
+  }
+
+  if (!test_nearest_filter_and_radius()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All SpatialIndex tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some SpatialIndex tests failed!" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,221 @@
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#include "Core/Entity.h"
+#include "Core/TransformHistory.h"
+#include "Core/Type.h"
+#include "SDL.h"
+
+namespace {
+constexpr EntityID kPlayer = 1;
+constexpr EntityID kOther = 2;
+
+bool Near(const std::optional<Vec2f>& pos, float x, float y) {
+  return pos && std::abs(pos->x - x) < 1e-4f && std::abs(pos->y - y) < 1e-4f;
+}
+
+// Snapshot every other server tick, player walking +10 x per snapshot
+void Fill(TransformHistory& history, uint32_t firstTick, int count) {
+  for (int i = 0; i < count; ++i) {
+    const uint32_t tick = firstTick + 2 * i;
+    history.BeginSnapshot(tick);
+    history.Store(kPlayer, {10.f * i, 0.f});
+  }
+}
+}  // namespace
+
+bool test_sample_interpolates() {
+  TransformHistory history;
+  Fill(history, 100, 4);  // ticks 100, 102, 104, 106
+
+  if (!Near(history.Sample(kPlayer, 102), 10.f, 0.f)) {
+    std::cerr << "Exact tick sample wrong" << std::endl;
+    return false;
+  }
+  if (!Near(history.Sample(kPlayer, 103), 15.f, 0.f)) {
+    std::cerr << "Tick between snapshots was not interpolated" << std::endl;
+    return false;
+  }
+  if (!Near(history.Sample(kPlayer, 50), 0.f, 0.f) ||
+      !Near(history.Sample(kPlayer, 500), 30.f, 0.f)) {
+    std::cerr << "Out of range ticks were not clamped" << std::endl;
+    return false;
+  }
+  if (history.Sample(kOther, 102)) {
+    std::cerr << "Unknown entity produced a sample" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_ring_wraps() {
+  TransformHistory history;
+  const int count = static_cast<int>(TransformHistory::kCapacity) + 10;
+  Fill(history, 1, count);
+
+  if (history.GetSnapshotCount() != TransformHistory::kCapacity) {
+    std::cerr << "History grew past its capacity" << std::endl;
+    return false;
+  }
+  // The oldest 10 snapshots were overwritten, rewinding clamps to snapshot 10
+  if (!Near(history.Sample(kPlayer, 1), 100.f, 0.f)) {
+    std::cerr << "Overwritten snapshot was still readable" << std::endl;
+    return false;
+  }
+  const uint32_t newest = history.GetNewestTick();
+  if (!Near(history.Sample(kPlayer, newest - 1), 10.f * (count - 1) - 5.f,
+            0.f)) {
+    std::cerr << "Sample across the ring seam is wrong" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_gaps_and_reuse() {
+  TransformHistory history;
+  history.BeginSnapshot(10);
+  history.Store(kPlayer, {0.f, 0.f});
+  history.Store(kOther, {5.f, 5.f});
+  history.BeginSnapshot(12);
+  history.Store(kPlayer, {2.f, 0.f});  // kOther missing from this snapshot
+
+  if (!Near(history.Sample(kOther, 11), 5.f, 5.f)) {
+    std::cerr << "Missing snapshot did not fall back to the known one"
+              << std::endl;
+    return false;
+  }
+
+  // A new entity taking the freed slot must not inherit old positions
+  history.Remove(kOther);
+  history.BeginSnapshot(14);
+  history.Store(kPlayer, {4.f, 0.f});
+  history.Store(3, {7.f, 7.f});
+  if (history.Sample(kOther, 10) || history.Sample(3, 10) ||
+      !Near(history.Sample(3, 14), 7.f, 7.f)) {
+    std::cerr << "Reused slot leaked the previous owner's history"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_reach_uses_view_tick() {
+  TransformHistory history;
+  Fill(history, 100, 10);  // player at x = 0 .. 90 over ticks 100 .. 118
+  constexpr EntityID kBuilding = 3;
+  constexpr float kReach = 25.f;
+
+  // The player acted at tick 104 standing at x = 20, next to a building at
+  // x = 40, and has walked on to x = 90 since
+  const Vec2f current{90.f, 0.f};
+  const Vec2f building{40.f, 0.f};
+  if (!history.IsWithinReach(kPlayer, current, kBuilding, building, 104,
+                             kReach)) {
+    std::cerr << "Rewound view rejected a target in reach" << std::endl;
+    return false;
+  }
+  if (history.IsWithinReach(kPlayer, current, kBuilding, building, 118,
+                            kReach)) {
+    std::cerr << "Current view accepted an out of reach target" << std::endl;
+    return false;
+  }
+  // The position at viewTick is checked, not whichever one reaches
+  if (history.IsWithinReach(kPlayer, {40.f, 0.f}, kBuilding, building, 100,
+                            kReach)) {
+    std::cerr << "Current position overrode the rewound one" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_reach_rewinds_target() {
+  TransformHistory history;
+  // Player walks +10 x and kOther -10 x per snapshot, passing at tick 110
+  for (int i = 0; i < 10; ++i) {
+    history.BeginSnapshot(100 + 2 * i);
+    history.Store(kPlayer, {10.f * i, 0.f});
+    history.Store(kOther, {100.f - 10.f * i, 0.f});
+  }
+  constexpr float kReach = 25.f;
+  const Vec2f player{90.f, 0.f};
+  const Vec2f other{10.f, 0.f};
+
+  if (!history.IsWithinReach(kPlayer, player, kOther, other, 110, kReach)) {
+    std::cerr << "Target was not rewound with the player" << std::endl;
+    return false;
+  }
+  // Player at x = 0 and kOther at x = 100, though each has been near where
+  // the other is now
+  if (history.IsWithinReach(kPlayer, player, kOther, other, 100, kReach)) {
+    std::cerr << "Player and target were read at different ticks"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_reach_caps_rewind() {
+  TransformHistory history;
+  Fill(history, 100, 40);  // player at x = 0 .. 390 over ticks 100 .. 178
+  constexpr EntityID kBuilding = 3;
+  constexpr float kReach = 25.f;
+  const Vec2f current{390.f, 0.f};
+
+  // The history still holds tick 100, but the view stops kMaxRewindTicks
+  // back at tick 148, x = 240
+  if (history.IsWithinReach(kPlayer, current, kBuilding, {0.f, 0.f}, 100,
+                            kReach)) {
+    std::cerr << "Claimed view tick rewound past the cap" << std::endl;
+    return false;
+  }
+  if (!history.IsWithinReach(kPlayer, current, kBuilding, {240.f, 0.f}, 100,
+                             kReach)) {
+    std::cerr << "Old view was not clamped to the cap" << std::endl;
+    return false;
+  }
+  // A view from the future stops at the newest snapshot
+  if (!history.IsWithinReach(kPlayer, current, kBuilding, current, 1000,
+                             kReach)) {
+    std::cerr << "Future view was not clamped to the newest snapshot"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_sample_interpolates()) {
+    all_passed = false;
+  }
+
+  if (!test_ring_wraps()) {
+    all_passed = false;
+  }
+
+  if (!test_gaps_and_reuse()) {
+    all_passed = false;
+  }
+
+  if (!test_reach_uses_view_tick()) {
+    all_passed = false;
+  }
+
+  if (!test_reach_rewinds_target()) {
+    all_passed = false;
+  }
+
+  if (!test_reach_caps_rewind()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All TransformHistory tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some TransformHistory tests failed!" << std::endl;
+    return 1;
+  }
+}
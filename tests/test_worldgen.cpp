@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Core/ChunkPipeline.h"
+#include "Core/WorldGenerator.h"
+#include "SDL.h"
+
+namespace {
+// Hash of the region below with kDefaultWorldSeed. Changes only when world
+// generation itself changes, update it together with the generator.
+constexpr uint64_t kDefaultRegionHash = 0x7ffc4c153c9d38e3ull;
+constexpr int kRegionMin = -4;
+constexpr int kRegionMax = 3;
+
+// FNV-1a over the coordinate, tile types and ores of a chunk
+uint64_t HashChunk(const GeneratedChunk& generated, uint64_t hash) {
+  auto add = [&hash](uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+      hash ^= (value >> (8 * i)) & 0xFF;
+      hash *= 0x100000001B3ull;
+    }
+  };
+  add(static_cast<uint32_t>(generated.chunk.chunkX), 4);
+  add(static_cast<uint32_t>(generated.chunk.chunkY), 4);
+  for (uint8_t type : generated.chunk.GetTypes()) add(type, 1);
+  for (const auto& [index, amount] : generated.ores) {
+    add(static_cast<uint32_t>(index), 4);
+    add(amount, 4);
+  }
+  return hash;
+}
+
+std::vector<ChunkCoord> Region() {
+  std::vector<ChunkCoord> region;
+  for (int y = kRegionMin; y <= kRegionMax; ++y) {
+    for (int x = kRegionMin; x <= kRegionMax; ++x) region.push_back({x, y});
+  }
+  return region;
+}
+
+uint64_t HashRegion(const WorldGenerator& generator) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (const ChunkCoord& coord : Region())
+    hash = HashChunk(generator.Generate(coord), hash);
+  return hash;
+}
+}  // namespace
+
+bool test_region_hash_is_stable() {
+  const uint64_t hash = HashRegion(WorldGenerator(kDefaultWorldSeed));
+  if (hash != kDefaultRegionHash) {
+    std::cerr << "Default world changed, region hash is 0x" << std::hex
+              << hash << std::dec << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_seed_selects_world() {
+  const uint64_t first = HashRegion(WorldGenerator(42));
+  const uint64_t second = HashRegion(WorldGenerator(42));
+  const uint64_t other = HashRegion(WorldGenerator(43));
+  if (first != second) {
+    std::cerr << "Same seed generated different worlds" << std::endl;
+    return false;
+  }
+  if (first == other) {
+    std::cerr << "Neighboring seeds generated the same world" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool test_order_independent() {
+  const WorldGenerator generator(7);
+  std::vector<ChunkCoord> region = Region();
+  std::vector<uint64_t> expected;
+  for (const ChunkCoord& coord : region)
+    expected.push_back(HashChunk(generator.Generate(coord), 0));
+
+  // Shuffled, on a fresh generator that already generated other chunks
+  const WorldGenerator shuffledGenerator(7);
+  shuffledGenerator.Generate({100, 100});
+  std::vector<std::size_t> order(region.size());
+  for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::shuffle(order.begin(), order.end(), std::mt19937(99));
+  for (std::size_t i : order) {
+    if (HashChunk(shuffledGenerator.Generate(region[i]), 0) != expected[i]) {
+      std::cerr << "Chunk " << region[i].x << ":" << region[i].y
+                << " depends on generation order" << std::endl;
+      return false;
+    }
+  }
+
+  // Any number of threads, in whatever order they finish
+  ChunkPipeline pipeline(4, 7);
+  for (const ChunkCoord& coord : region) pipeline.Request(coord, 0);
+  std::list<GeneratedChunk> done;
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (done.size() < region.size() &&
+         std::chrono::steady_clock::now() < deadline) {
+    pipeline.TakeCompleted(done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (done.size() != region.size()) {
+    std::cerr << "Pipeline generated " << done.size() << " chunks"
+              << std::endl;
+    return false;
+  }
+  for (const GeneratedChunk& generated : done) {
+    const ChunkCoord coord{generated.chunk.chunkX, generated.chunk.chunkY};
+    const std::size_t i =
+        std::find(region.begin(), region.end(), coord) - region.begin();
+    if (HashChunk(generated, 0) != expected[i]) {
+      std::cerr << "Chunk " << coord.x << ":" << coord.y
+                << " differs when generated on a worker" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool test_chunk_random_streams() {
+  ChunkRandom first(HashChunkSeed(1, 3, {5, -6}));
+  ChunkRandom second(HashChunkSeed(1, 3, {5, -6}));
+  ChunkRandom neighbor(HashChunkSeed(1, 3, {5, -5}));
+  ChunkRandom otherStream(HashChunkSeed(1, 4, {5, -6}));
+  int sameAsNeighbor = 0;
+  int sameAsStream = 0;
+  for (int i = 0; i < 1000; ++i) {
+    const uint64_t value = first.Next();
+    if (value != second.Next()) {
+      std::cerr << "Same key drew a different sequence" << std::endl;
+      return false;
+    }
+    sameAsNeighbor += value == neighbor.Next();
+    sameAsStream += value == otherStream.Next();
+  }
+  if (sameAsNeighbor != 0 || sameAsStream != 0) {
+    std::cerr << "Neighboring chunks or streams share numbers" << std::endl;
+    return false;
+  }
+
+  double sum = 0;
+  for (int i = 0; i < 10000; ++i) {
+    const float value = first.NextFloat();
+    if (value < 0.f || value >= 1.f) {
+      std::cerr << "NextFloat out of range: " << value << std::endl;
+      return false;
+    }
+    sum += value;
+  }
+  if (sum / 10000 < 0.45 || sum / 10000 > 0.55) {
+    std::cerr << "NextFloat averages " << sum / 10000 << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool all_passed = true;
+
+  if (!test_region_hash_is_stable()) {
+    all_passed = false;
+  }
+
+  if (!test_seed_selects_world()) {
+    all_passed = false;
+  }
+
+  if (!test_order_independent()) {
+    all_passed = false;
+  }
+
+  if (!test_chunk_random_streams()) {
+    all_passed = false;
+  }
+
+  if (all_passed) {
+    std::cout << "All WorldGenerator tests passed!" << std::endl;
+    return 0;
+  } else {
+    std::cerr << "Some WorldGenerator tests failed!" << std::endl;
+    return 1;
+  }
+}